@@ -45,6 +45,7 @@
 
 #include "MaskFunctions.h"
 #include "GlobalDefaultsForBkgModel.h"
+#include "WorkerInfoQueue.h"
 
 //! @brief    Print Analysis usage.
 //! @ingroup  Analysis
@@ -515,6 +516,9 @@ int main (int argc, char *argv[])
   //clean up the mess we created
   BkgModelObj.FinalizeThreadedSignalProcessing();
 
+  // contention of the work queues feeding the signal processing and image loading threads
+  WorkerInfoQueue::WriteMetricsJson(string(inception_state.sys_context.GetResultsFolder()) + "/queue_metrics.json");
+
   my_progress.ReportState ("Analysis (wells file only) Complete");
 
   exit (ExitCode::GetExitCode());
@@ -211,7 +211,7 @@ public:
     {
 
       ar &
-	    sliced_chip &
+	    // sliced_chip &          // one blob per region in the restart checkpoint
 	    global_defaults &      // serialize out before signal_proc_fitters as ref'd
 	    // signal_proc_fitters &  // rebuilt in ThreadedInitialization
 	    numFitters &
@@ -223,6 +223,7 @@ public:
 	    // bkinfo;         // rebuilt in ThreadedInitialization
 
       signal_proc_fitters.resize(numFitters); // see constructor
+      sliced_chip.resize(numFitters);         // filled by RestartCheckpoint
 
       // fprintf(stdout, "done BkgFitterTracker\n");
     }
@@ -231,7 +232,7 @@ public:
     {
       // fprintf(stdout, "Serialization: save BkgFitterTracker ... ");
       ar &
-	sliced_chip &
+	// sliced_chip &          // one blob per region in the restart checkpoint
 	global_defaults &      // serialize out before signal_proc_fitters as ref'd
 	// signal_proc_fitters &  //
 	numFitters &
@@ -0,0 +1,188 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#include "DatPrefetcher.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/prctl.h>
+#include "Utils.h"
+
+#define PREFETCH_READ_SIZE (4*1024*1024)
+
+DatPrefetcher::DatPrefetcher (const std::vector<std::string> &_file_names, int _depth, int _num_threads)
+{
+  file_names = _file_names;
+  state.assign (file_names.size(), NotRead);
+  io_time.assign (file_names.size(), 0.0);
+  io_bytes.assign (file_names.size(), 0);
+
+  depth = _depth < 1 ? 1 : _depth;
+  num_threads = _num_threads < 1 ? 1 : _num_threads;
+  next_ndx = 0;
+  wanted_ndx = -1;
+  stop = false;
+
+  pthread_mutex_init (&lock, NULL);
+  pthread_cond_init (&window_moved, NULL);
+  pthread_cond_init (&file_done, NULL);
+}
+
+DatPrefetcher::~DatPrefetcher()
+{
+  Stop();
+  pthread_cond_destroy (&file_done);
+  pthread_cond_destroy (&window_moved);
+  pthread_mutex_destroy (&lock);
+}
+
+void DatPrefetcher::Start()
+{
+  for (int i=0; i<num_threads; i++)
+  {
+    pthread_t t;
+    if (pthread_create (&t, NULL, PrefetchThread, this) == 0)
+      threads.push_back (t);
+    else
+      fprintf (stderr, "DatPrefetcher: error starting thread\n");
+  }
+}
+
+void DatPrefetcher::Stop()
+{
+  pthread_mutex_lock (&lock);
+  stop = true;
+  pthread_cond_broadcast (&window_moved);
+  pthread_cond_broadcast (&file_done);
+  pthread_mutex_unlock (&lock);
+
+  for (unsigned int i=0; i<threads.size(); i++)
+    pthread_join (threads[i], NULL);
+  threads.clear();
+}
+
+double DatPrefetcher::WaitForFile (int ndx)
+{
+  if (ndx < 0 || ndx >= (int) file_names.size())
+    return 0.0;
+
+  pthread_mutex_lock (&lock);
+  if (ndx > wanted_ndx)
+  {
+    wanted_ndx = ndx;
+    pthread_cond_broadcast (&window_moved);
+  }
+  while (!stop && !threads.empty() && (state[ndx] == NotRead || state[ndx] == Reading))
+    pthread_cond_wait (&file_done, &lock);
+  // a file that failed to read is loaded from storage by the decode, none of the time was saved
+  double t = state[ndx] == Read ? io_time[ndx] : 0.0;
+  pthread_mutex_unlock (&lock);
+  return t;
+}
+
+void *DatPrefetcher::PrefetchThread (void *arg)
+{
+  DatPrefetcher *me = (DatPrefetcher *) arg;
+  prctl (PR_SET_NAME, "DatPrefetch", 0, 0, 0);
+
+  int num_files = me->file_names.size();
+  while (true)
+  {
+    pthread_mutex_lock (&me->lock);
+    while (!me->stop && me->next_ndx < num_files && me->next_ndx > me->wanted_ndx + me->depth)
+      pthread_cond_wait (&me->window_moved, &me->lock);
+    if (me->stop || me->next_ndx >= num_files)
+    {
+      pthread_mutex_unlock (&me->lock);
+      break;
+    }
+    int ndx = me->next_ndx++;
+    me->state[ndx] = Reading;
+    pthread_mutex_unlock (&me->lock);
+
+    me->ReadOneFile (ndx);
+  }
+  return NULL;
+}
+
+void DatPrefetcher::ReadOneFile (int ndx)
+{
+  Timer tmr;
+  size_t total = 0;
+  int result = Missed;
+
+  int fd = open (file_names[ndx].c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    struct stat file_stat;
+    char *buf = (char *) malloc (PREFETCH_READ_SIZE);
+    if (buf == NULL || fstat (fd, &file_stat) != 0)
+    {
+      fprintf (stderr, "DatPrefetcher: cannot read %s: %s\n", file_names[ndx].c_str(), strerror (errno));
+      result = Failed;
+    }
+    else
+    {
+      posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      ssize_t len;
+      while ((len = pread (fd, buf, PREFETCH_READ_SIZE, total)) != 0)
+      {
+        if (len < 0 && errno == EINTR)
+          continue;
+        if (len < 0)
+          break;
+        total += len;
+      }
+      if (len < 0)
+      {
+        fprintf (stderr, "DatPrefetcher: error reading %s at byte %lu: %s\n",
+                 file_names[ndx].c_str(), (unsigned long) total, strerror (errno));
+        result = Failed;
+      }
+      else if (total < (size_t) file_stat.st_size)
+      {
+        fprintf (stderr, "DatPrefetcher: short read of %s, %lu of %lu bytes\n",
+                 file_names[ndx].c_str(), (unsigned long) total, (unsigned long) file_stat.st_size);
+        result = Failed;
+      }
+      else
+        result = Read;
+    }
+    free (buf);
+    close (fd);
+  }
+  double t = tmr.elapsed();
+
+  pthread_mutex_lock (&lock);
+  io_time[ndx] = t;
+  io_bytes[ndx] = total;
+  state[ndx] = result;
+  pthread_cond_broadcast (&file_done);
+  pthread_mutex_unlock (&lock);
+}
+
+void DatPrefetcher::PrintSummary (FILE *fp)
+{
+  pthread_mutex_lock (&lock);
+  int num_read = 0, num_missed = 0, num_failed = 0;
+  double total_time = 0.0;
+  size_t total_bytes = 0;
+  for (unsigned int i=0; i<file_names.size(); i++)
+  {
+    if (state[i] == Read)
+      num_read++;
+    else if (state[i] == Missed)
+      num_missed++;
+    else if (state[i] == Failed)
+      num_failed++;
+    total_time += io_time[i];
+    total_bytes += io_bytes[i];
+  }
+  pthread_mutex_unlock (&lock);
+
+  double mb = total_bytes / (1024.0*1024.0);
+  fprintf (fp, "DatPrefetcher: read %d files (%d not yet present, %d failed), %.1f MB in %.2f sec of io, %.1f MB/s per reader, depth %d, %d readers\n",
+           num_read, num_missed, num_failed, mb, total_time, total_time > 0 ? mb/total_time : 0.0, depth, num_threads);
+  fflush (fp);
+}
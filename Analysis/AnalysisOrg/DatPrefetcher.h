@@ -0,0 +1,53 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef DATPREFETCHER_H
+#define DATPREFETCHER_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+// Reads the acquisition files of upcoming flows into the page cache ahead of the image loader.
+// deInterlace decodes a dat through mmap, so on network storage every page fault is a round trip;
+// once the file is cached the decode runs at memory speed.
+// Files are read by a small pool of threads, so several reads are in flight at once, and never
+// more than depth files past the last one the loader has asked for.
+class DatPrefetcher
+{
+  public:
+    DatPrefetcher (const std::vector<std::string> &_file_names, int _depth, int _num_threads);
+    ~DatPrefetcher();
+
+    void   Start();
+    void   Stop();
+
+    // wait until file ndx has been read and return the seconds spent reading it
+    // files that do not exist yet or could not be read are skipped, the loader reads them itself
+    double WaitForFile (int ndx);
+
+    void   PrintSummary (FILE *fp);
+
+  private:
+    enum FileState { NotRead, Reading, Read, Missed, Failed };
+
+    static void *PrefetchThread (void *arg);
+    void   ReadOneFile (int ndx);
+
+    std::vector<std::string> file_names;
+    std::vector<int>         state;
+    std::vector<double>      io_time;
+    std::vector<size_t>      io_bytes;
+
+    int depth;
+    int num_threads;
+    int next_ndx;     // next file to be claimed by a prefetch thread
+    int wanted_ndx;   // last file the loader asked for
+    bool stop;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  window_moved;
+    pthread_cond_t  file_done;
+    std::vector<pthread_t> threads;
+};
+
+#endif // DATPREFETCHER_H
@@ -15,6 +15,7 @@ using namespace std;
 SignalProcessingBlockControl::SignalProcessingBlockControl(){
   save_wells_flow = 60;
   wellsCompression = 0;
+  wellsCompressionThreads = 0;
   restart = false;
   restart_from = "";
   restart_next = "";
@@ -29,6 +30,7 @@ void SignalProcessingBlockControl::PrintHelp()
 	printf ("     SignalProcessingBlockControl\n");
     printf ("     --numcputhreads         INT               number of CPU threads [0]\n");
     printf ("     --wells-compression     INT               set wells compression level [0]\n");
+    printf ("     --wells-compression-threads INT           compress wells chunks on a thread pool, 0 to compress on the writer thread [0]\n");
     printf ("     --wells-save-freq       INT               set saveWellsFrequency []\n");
     printf ("     --wells-save-flow       INT               set save_wells_flow (=saveWellsFrequency*20) [60]\n");
     printf ("     --sigproc-compute-flow  STRING            set flow block sequence []\n");
@@ -44,6 +46,7 @@ void SignalProcessingBlockControl::SetOpts(OptArgs &opts, Json::Value& json_para
 	wellsCompression = RetrieveParameterInt(opts, json_params, '-', "wells-compression", 0);
     ION_ASSERT(wellsCompression >= 0 && wellsCompression <= 10, "--wells-compression must be between (0,10) inclusive.");
 	fprintf(stdout, "wells compression: %d\n", wellsCompression);
+	wellsCompressionThreads = RetrieveParameterInt(opts, json_params, '-', "wells-compression-threads", 0);
 	int saveWellsFrequency = RetrieveParameterInt(opts, json_params, '-', "wells-save-freq", -1);
 	if(saveWellsFrequency > 0)
 	{
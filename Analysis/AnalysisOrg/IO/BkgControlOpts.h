@@ -36,6 +36,7 @@ public:
   bool restart_check;   // if set, only restart with the same build number
   int save_wells_flow;        // New parameter, which defaults to saveWellsFrequency * 20.
   int wellsCompression;  // compression level to use in hdf5 for wells data, 3 by default 0 for no compression
+  int wellsCompressionThreads;  // compress wells chunks on this many threads and write them directly, 0 to leave it to hdf5
   int numCpuThreads;
   bool updateMaskAfterBkgModel;
   FlowBlockSequence   flow_block_sequence;    // Every 20 flows, 0:15,15:1, etc.
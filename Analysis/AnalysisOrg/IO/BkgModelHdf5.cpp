@@ -21,6 +21,131 @@ BkgParamH5::BkgParamH5()
 
 
 
+CubeRangeWriter::CubeRangeWriter()
+{
+  pending = 0;
+  running = false;
+  stop = false;
+  ranges_written = 0;
+  bytes_written = 0.0;
+  write_time = 0.0;
+  wait_time = 0.0;
+  pthread_mutex_init ( &lock, NULL );
+  pthread_cond_init ( &staged, NULL );
+  pthread_cond_init ( &written, NULL );
+}
+
+CubeRangeWriter::~CubeRangeWriter()
+{
+  Stop();
+  pthread_cond_destroy ( &written );
+  pthread_cond_destroy ( &staged );
+  pthread_mutex_destroy ( &lock );
+}
+
+void CubeRangeWriter::Stage ( DataCube<float> &cube, H5DataSet *set )
+{
+  StagedRange *range = new StagedRange;
+  range->set = set;
+  cube.SetStartsEnds ( range->starts, range->ends );
+  cube.SwapBuffer ( range->float_data );
+  Queue ( range );
+}
+
+void CubeRangeWriter::Stage ( DataCube<int> &cube, H5DataSet *set )
+{
+  StagedRange *range = new StagedRange;
+  range->set = set;
+  cube.SetStartsEnds ( range->starts, range->ends );
+  cube.SwapBuffer ( range->int_data );
+  Queue ( range );
+}
+
+void CubeRangeWriter::Queue ( StagedRange *range )
+{
+  pthread_mutex_lock ( &lock );
+  if ( !running )
+  {
+    stop = false;
+    int t = pthread_create ( &thread, NULL, WriterThread, this );
+    ION_ASSERT ( t == 0, "Unable to start hdf5 parameter writer thread" );
+    running = true;
+  }
+  queue.push_back ( range );
+  pending++;
+  pthread_cond_signal ( &staged );
+  pthread_mutex_unlock ( &lock );
+}
+
+void *CubeRangeWriter::WriterThread ( void *arg )
+{
+  CubeRangeWriter *writer = ( CubeRangeWriter * ) arg;
+  pthread_mutex_lock ( &writer->lock );
+  while ( true )
+  {
+    while ( writer->queue.empty() && !writer->stop )
+      pthread_cond_wait ( &writer->staged, &writer->lock );
+    if ( writer->queue.empty() )
+      break;
+    StagedRange *range = writer->queue.front();
+    writer->queue.pop_front();
+    pthread_mutex_unlock ( &writer->lock );
+
+    Timer timer;
+    size_t bytes = 0;
+    if ( !range->float_data.empty() )
+    {
+      range->set->WriteRangeData ( range->starts, range->ends, &range->float_data[0] );
+      bytes = range->float_data.size() * sizeof ( float );
+    }
+    else if ( !range->int_data.empty() )
+    {
+      range->set->WriteRangeData ( range->starts, range->ends, &range->int_data[0] );
+      bytes = range->int_data.size() * sizeof ( int );
+    }
+    delete range;
+    double elapsed = timer.elapsed();
+
+    pthread_mutex_lock ( &writer->lock );
+    writer->pending--;
+    writer->ranges_written++;
+    writer->bytes_written += bytes;
+    writer->write_time += elapsed;
+    pthread_cond_broadcast ( &writer->written );
+  }
+  pthread_mutex_unlock ( &writer->lock );
+  return NULL;
+}
+
+void CubeRangeWriter::Wait()
+{
+  Timer timer;
+  pthread_mutex_lock ( &lock );
+  while ( pending > 0 )
+    pthread_cond_wait ( &written, &lock );
+  pthread_mutex_unlock ( &lock );
+  wait_time += timer.elapsed();
+}
+
+void CubeRangeWriter::Stop()
+{
+  if ( !running )
+    return;
+  pthread_mutex_lock ( &lock );
+  stop = true;
+  pthread_cond_signal ( &staged );
+  pthread_mutex_unlock ( &lock );
+  pthread_join ( thread, NULL );
+  running = false;
+}
+
+void CubeRangeWriter::PrintSummary ( FILE *fp )
+{
+  fprintf ( fp, "bgParamH5 writer: %d ranges, %0.1f MB, %0.2f sec writing, %0.2f sec waited for by the flow loop\n",
+            ranges_written, bytes_written / ( 1024.0 * 1024.0 ), write_time, wait_time );
+}
+
+
 MatchedCube::MatchedCube()
 {
   h5_set = NULL;
@@ -34,14 +159,22 @@ MatchedCubeInt::MatchedCubeInt()
 
 // set up a basic data cube + matched h5 set
 void MatchedCube::InitBasicCube ( H5File &h5_local_ref, int col, int row, int maxflows, 
-                                  const char *set_name, const char *set_description, const char *param_root )
+                                  const char *set_name, const char *set_description, const char *param_root, int flow_chunk )
 {
   //printf ( "%s\n",set_name );
   string str;
   source.Init ( col, row, maxflows );
   source.SetRange ( 0,col, 0, row, 0, maxflows );
   source.AllocateBuffer();
-  h5_set = h5_local_ref.CreateDataSet ( set_name, source, 3 );
+  if ( flow_chunk > 0 )
+  {
+    // same chunks as H5File picks for a cube, except along flows
+    hsize_t dims[3] = { ( hsize_t ) col, ( hsize_t ) row, ( hsize_t ) maxflows };
+    hsize_t chunking[3] = { ( hsize_t ) min ( col,60 ), ( hsize_t ) min ( row,60 ), ( hsize_t ) min ( maxflows,flow_chunk ) };
+    h5_set = h5_local_ref.CreateDataSet ( set_name, 3, dims, chunking, 3, h5_local_ref.GetH5Type ( source.GetExampleType() ) );
+  }
+  else
+    h5_set = h5_local_ref.CreateDataSet ( set_name, source, 3 );
   h5_local_ref.CreateAttribute ( h5_set->getDataSetId(),"description",set_description );
   // either we're just using the axis for nothing special
   if ( strlen ( param_root ) <1 )
@@ -175,15 +308,15 @@ void BkgParamH5::TryInitBeads ( H5File &h5_local_ref, int verbosity )
 
     if( verbosity>2 ){ //per flow parameters are only included when debug flag is set
       Amplitude.InitBasicCube ( h5_local_ref, bead_col, bead_row, datacube_numflows,
-                                "/bead/amplitude", "mean hydrogens per molecule per flow", "" );
+                                "/bead/amplitude", "mean hydrogens per molecule per flow", "", flow_block_size );
       krate_multiplier.InitBasicCube ( h5_local_ref, bead_col, bead_row, datacube_numflows,
-                                       "/bead/kmult", "adjustment to krate", "" );
+                                       "/bead/kmult", "adjustment to krate", "", flow_block_size );
       // less important?
       bead_dc.InitBasicCube ( h5_local_ref, bead_col, bead_row, datacube_numflows,
-                              "/bead/trace_dc_offset", "additive factor for trace", "" );
+                              "/bead/trace_dc_offset", "additive factor for trace", "", flow_block_size );
 
       residual_error.InitBasicCube ( h5_local_ref, bead_col, bead_row, datacube_numflows,
-                                     "/bead/residual_error", "residual_error", "" );
+                                     "/bead/residual_error", "residual_error", "", flow_block_size );
     }
 
     // still less important?
@@ -593,34 +726,26 @@ void BkgParamH5::Init2 (int write_params_flag, int nBeads_live, const Region *re
 void BkgParamH5::WriteOneFlowBlock ( DataCube<float> &cube, H5DataSet *set, int flow, int chunksize )
 {
   //  fprintf ( stdout, "Writing incremental H5-diagnostics at flow: %d\n", flow );
-  MemUsage ( "BeforeWrite" );
-  size_t starts[3];
-  size_t ends[3];
-  cube.SetStartsEnds ( starts, ends );
-  // here's the actual write
-  set->WriteRangeData ( starts, ends, cube.GetMemPtr() );
+  // here's the actual write, done by the writer thread
+  range_writer.Stage ( cube, set );
   // set for next iteration
   int nextflow = flow+1;
   int nextchunk = min ( chunksize,datacube_numflows- ( flow+1 ) );
   cube.SetRange ( 0, cube.GetNumX(), 0, cube.GetNumY(), nextflow, nextflow+nextchunk );
-  MemUsage ( "AfterWrite" );
+  cube.AllocateBuffer();
 }
 
 
 void BkgParamH5::WriteOneFlowBlock ( DataCube<int> &cube, H5DataSet *set, int flow, int chunksize )
 {
   //  fprintf ( stdout, "Writing incremental H5-diagnostics at flow: %d\n", flow );
-  MemUsage ( "BeforeWrite" );
-  size_t starts[3];
-  size_t ends[3];
-  cube.SetStartsEnds ( starts, ends );
-  // here's the actual write
-  set->WriteRangeData ( starts, ends, cube.GetMemPtr() );
+  // here's the actual write, done by the writer thread
+  range_writer.Stage ( cube, set );
   // set for next iteration
   int nextflow = flow+1;
   int nextchunk = min ( chunksize,datacube_numflows- ( flow+1 ) );
   cube.SetRange ( 0, cube.GetNumX(), 0, cube.GetNumY(), nextflow, nextflow+nextchunk );
-  MemUsage ( "AfterWrite" );
+  cube.AllocateBuffer();
 }
 
 
@@ -656,17 +781,13 @@ void BkgParamH5::WriteOneBlock ( DataCube<float> &cube, H5DataSet *set, int iBlk
   if ( set!=NULL )
   {
     //   fprintf ( stdout, "Writing incremental H5-diagnostics at compute block: %d\n", iBlk );
-    MemUsage ( "BeforeWrite" );
-    size_t starts[3];
-    size_t ends[3];
-    cube.SetStartsEnds ( starts, ends );
-    // here's the actual write
-    set->WriteRangeData ( starts, ends, cube.GetMemPtr() );
+    // here's the actual write, done by the writer thread
+    range_writer.Stage ( cube, set );
     // set for next iteration
     int nextBlk = iBlk+1;
     int nextChunk = min ( 1,nFlowBlks-nextBlk );
     cube.SetRange ( 0, cube.GetNumX(), 0, cube.GetNumY(), nextBlk, nextBlk+nextChunk );
-    MemUsage ( "AfterWrite" );
+    cube.AllocateBuffer();
   }
 }
 
@@ -676,17 +797,13 @@ void BkgParamH5::WriteOneBlock ( DataCube<int> &cube, H5DataSet *set, int iBlk )
   if ( set!=NULL )
   {
     //   fprintf ( stdout, "Writing incremental H5-diagnostics at compute block: %d\n", iBlk );
-    MemUsage ( "BeforeWrite" );
-    size_t starts[3];
-    size_t ends[3];
-    cube.SetStartsEnds ( starts, ends );
-    // here's the actual write
-    set->WriteRangeData ( starts, ends, cube.GetMemPtr() );
+    // here's the actual write, done by the writer thread
+    range_writer.Stage ( cube, set );
     // set for next iteration
     int nextBlk = iBlk+1;
     int nextChunk = min ( 1,nFlowBlks-nextBlk );
     cube.SetRange ( 0, cube.GetNumX(), 0, cube.GetNumY(), nextBlk, nextBlk+nextChunk );
-    MemUsage ( "AfterWrite" );
+    cube.AllocateBuffer();
   }
 }
 
@@ -816,11 +933,15 @@ void BkgParamH5::IncrementalWrite ( int flow, bool last_flow, FlowBlockSequence:
 
   if ( last_flow || flow == flow_block->end() - 1 )
   {
+    // keep no more than one flow block in flight, the writer has to be done with the last one
+    range_writer.Wait();
+    MemUsage ( "BeforeWrite" );
     IncrementalWriteBeads ( flow, flow_block_id );
     IncrementalWriteRegions ( flow, flow_block_id );
     IncrementalWriteBestRegion ( flow, last_flow );
     IncrementalWriteRegionSamples ( flow, last_flow );
     IncrementalWrite_xyflow ( last_flow );
+    MemUsage ( "AfterWrite" );
   }
 }
 
@@ -937,6 +1058,12 @@ void BkgParamH5::CloseTraceXYFlow()
 
 void BkgParamH5::Close()
 {
+  // staged ranges go out before their sets are closed
+  if ( range_writer.IsRunning() )
+  {
+    range_writer.Stop();
+    range_writer.PrintSummary ( stdout );
+  }
   //bead_param.h5
   CloseBeads();
   //region_param.h5
@@ -3,6 +3,8 @@
 #define BKGMODELHDF5_H
 
 #include <vector>
+#include <deque>
+#include <pthread.h>
 #include "CommandLineOpts.h"
 #include "ImageSpecClass.h"
 #include "DataCube.h"
@@ -21,7 +23,8 @@ class MatchedCube
     H5DataSet *h5_set;
 
     // build a basic matched cube
-    void InitBasicCube ( H5File &h5_local_ref, int col, int row, int maxflows, const char *set_name, const char *set_description, const char *param_root );
+    // flow_chunk > 0 chunks the set by that many flows, so writing one flow block fills whole chunks
+    void InitBasicCube ( H5File &h5_local_ref, int col, int row, int maxflows, const char *set_name, const char *set_description, const char *param_root, int flow_chunk=0 );
     void Close();
     DataCube<float> *Ptr()
     {
@@ -77,6 +80,53 @@ class RotatingCube{
     void SafeWrite(int iBlk);
 };
 
+// Writes the filled ranges of the cubes on a thread of its own, so the fitters go on with
+// the next flow block while hdf5 compresses and writes the previous one. A cube hands over
+// its buffer and starts the next range in a fresh one; nothing is copied.
+class CubeRangeWriter
+{
+  public:
+    CubeRangeWriter();
+    ~CubeRangeWriter();
+
+    // take over the current range of the cube and queue it for writing to set
+    void Stage ( DataCube<float> &cube, H5DataSet *set );
+    void Stage ( DataCube<int> &cube, H5DataSet *set );
+
+    // block until everything staged so far is on disk
+    void Wait();
+    void Stop();
+    bool IsRunning() const { return running; }
+    void PrintSummary ( FILE *fp );
+
+  private:
+    struct StagedRange
+    {
+      H5DataSet *set;
+      size_t starts[3];
+      size_t ends[3];
+      std::vector<float> float_data;
+      std::vector<int> int_data;
+    };
+
+    static void *WriterThread ( void *arg );
+    void Queue ( StagedRange *range );
+
+    std::deque<StagedRange *> queue;
+    int pending;              // staged and not yet written
+    bool running;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t staged;
+    pthread_cond_t written;
+
+    int ranges_written;
+    double bytes_written;
+    double write_time;
+    double wait_time;
+};
+
 class BkgParamH5
 {
   public:
@@ -258,6 +308,8 @@ class BkgParamH5
     void ConstructOneFile ( H5File &h5_local_ref, std::string &hgLocalFile, std::string &local_results, const char *my_name );
 
   private:
+    CubeRangeWriter range_writer;
+
     H5File h5BeadDbg;
     std::string hgBeadDbgFile;
     // two files to control size
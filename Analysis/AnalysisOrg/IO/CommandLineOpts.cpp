@@ -198,6 +198,7 @@ ValidateOpts::ValidateOpts()
 
 	// SignalProcessingBlockControl
 	m_opts["wells-compression"] = VT_INT;
+	m_opts["wells-compression-threads"] = VT_INT;
 	m_opts["wells-save-freq"] = VT_INT;
 	m_opts["wells-save-flow"] = VT_INT;
 	m_opts["restart-from"] = VT_STRING;
@@ -286,6 +287,8 @@ ValidateOpts::ValidateOpts()
 	m_opts["readaheaddat"] = VT_INT;
 	m_opts["readaheadDat"] = VT_INT;
 	m_opts["no-threaded-file-access"] = VT_BOOL;
+	m_opts["img-prefetch-depth"] = VT_INT;
+	m_opts["img-load-threads"] = VT_INT;
 	m_opts["f"] = VT_INT;
 	m_opts["frames"] = VT_INT;
 	m_opts["col-doubles-xtalk-correct"] = VT_BOOL;
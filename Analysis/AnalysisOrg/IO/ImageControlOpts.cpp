@@ -42,6 +42,8 @@ void ImageControlOpts::DefaultImageOpts()
   acqPrefix = strdup("acq_");
   datPostfix = strdup("dat"); // standard value
   threaded_file_access = true;
+  dat_prefetch_depth = 4;
+  image_load_threads = 0;
   PCATest[0]=0;
   readaheadDat = 0;
 }
@@ -87,6 +89,8 @@ void ImageControlOpts::PrintHelp()
     printf ("     --ignore-checksum-errors            BOOL  ignore checksum errors [false]\n");
     printf ("     --ignore-checksum-errors-1frame     BOOL  ignore checksum errors 1 frame [false]\n");
     printf ("     --no-threaded-file-access           BOOL  no threaded file access [false]\n");
+    printf ("     --img-prefetch-depth    INT               number of dat files read ahead of image processing, 0 to disable [4]\n");
+    printf ("     --img-load-threads      INT               number of image processing threads, 0 for a quarter of the cores but at least 4 [0]\n");
     printf ("     --col-doubles-xtalk-correct         BOOL  enable col pair pixel xtalk correction [false]\n");
     printf ("     --nnmask                INT VECTOR OF 2   setup NN inner and outer [1,3]\n");
     printf ("     --nnMask                INT VECTOR OF 2   same as --nnmask [1,3]\n");
@@ -165,6 +169,8 @@ void ImageControlOpts::SetOpts(OptArgs &opts, Json::Value& json_params)
 	readaheadDat = RetrieveParameterInt(opts, json_params, '-', "readaheaddat", 0);
 	bool no_threaded_file_access = RetrieveParameterBool(opts, json_params, '-', "no-threaded-file-access", false);
 	threaded_file_access = !no_threaded_file_access;
+	dat_prefetch_depth = RetrieveParameterInt(opts, json_params, '-', "img-prefetch-depth", 4);
+	image_load_threads = RetrieveParameterInt(opts, json_params, '-', "img-load-threads", 0);
 	//jz the following comes from CommandLineOpts::GetOpts
 	int maxFramesInput = RetrieveParameterInt(opts, json_params, 'f', "frames", -1);
 	if(maxFramesInput > 0)
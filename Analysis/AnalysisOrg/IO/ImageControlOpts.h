@@ -41,6 +41,8 @@ class ImageControlOpts{
   char tikSmoothingInternal[32];  // parameter for internal smoothing matrix (APB)
   int total_timeout; // optional arg for image class, when set will cause the image class to wait this many seconds before giving up
   bool threaded_file_access; // read DAT files for signal processing in image processing threads
+  int dat_prefetch_depth; // read this many DAT files into the page cache ahead of the image loader, 0 to disable
+  int image_load_threads; // image processing threads, 0 to pick from the number of cores
 
   // naming scheme for files
     char *acqPrefix;
@@ -140,6 +140,8 @@ void ImageTracker::SetUpImageLoaderInfo (const CommandLineOpts &inception_state,
   master_img_loader.hasWashFlow = inception_state.img_control.has_wash_flow;  
   
   master_img_loader.finished = false;
+  master_img_loader.io_time = 0.0;
+  master_img_loader.decode_time = 0.0;
   master_img_loader.lead = ( inception_state.img_control.readaheadDat != 0 ) ? inception_state.img_control.readaheadDat : my_image_spec.LeadTimeForChipSize();
   master_img_loader.inception_state = &inception_state;  // why must we pass globals around everywhere?
   
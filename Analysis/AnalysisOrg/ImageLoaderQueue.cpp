@@ -12,6 +12,7 @@
 #include <sys/prctl.h>
 #include "crop/Acq.h"
 #include "ChipIdDecoder.h"
+#include "DatPrefetcher.h"
 
 typedef struct {
   int threadNum;
@@ -75,6 +76,7 @@ void *FileLoadWorker ( void *arg )
       }
 
       T1=tmr.elapsed();
+      one_img_loader->decode_time = T1;
       tmr.restart();
       if(img->raw->imageState & IMAGESTATE_QuickPinnedPixelDetect)
         one_img_loader->pinnedInFlow->QuickUpdate ( one_img_loader->flow, img);
@@ -83,6 +85,8 @@ void *FileLoadWorker ( void *arg )
 
       T2=tmr.elapsed();
     }
+    else
+      T1 = one_img_loader->decode_time;
 
     tmr.restart();
 
@@ -248,8 +252,8 @@ void *FileLoadWorker ( void *arg )
     localtime_r(&ltime, &newtime);
     strftime(dateStr,sizeof(dateStr),"%H:%M:%S", &newtime);
 
-    fprintf ( stdout, "FileLoadWorker: ImageProcessing time for flow %d: %0.2lf(ld=%.2f pin=%.2f cnc=%.2f xt=%.2f sem=%.2lf cache=%.2lf) sec %s\n",
-              one_img_loader->flow , usec / 1.0e6, T1, T2, T3, T4, img->SemaphoreWaitTime, img->CacheAccessTime, dateStr);
+    fprintf ( stdout, "FileLoadWorker: ImageProcessing time for flow %d: %0.2lf(io=%.2f ld=%.2f pin=%.2f cnc=%.2f xt=%.2f sem=%.2lf cache=%.2lf) sec %s\n",
+              one_img_loader->flow , usec / 1.0e6, one_img_loader->io_time, T1, T2, T3, T4, img->SemaphoreWaitTime, img->CacheAccessTime, dateStr);
     fflush(stdout);
     fprintf(stdout, "File: %s\n", one_img_loader->name);
     fflush(stdout);
@@ -342,10 +346,12 @@ void JustCacheOneImage(ImageLoadWorkInfo *cur_image_loader)
 void JustLoadOneImageWithPinnedUpdate(ImageLoadWorkInfo *cur_image_loader)
 {
 
+  Timer tmr;
   if ( !cur_image_loader->img[cur_image_loader->cur_buffer].LoadRaw ( cur_image_loader->name) )
   {
     exit ( EXIT_FAILURE );
   }
+  cur_image_loader->decode_time = tmr.elapsed();
   //tikSMoother is a no-op if there was no tikSmoothFile entered on command line
   // cur_image_loader->img[cur_image_loader->cur_buffer].SmoothMeTikhonov ( NULL,false,cur_image_loader->name);
   // if gain correction has been calculated, apply it
@@ -365,17 +371,33 @@ void *FileLoader ( void *arg )
   prctl(PR_SET_NAME,"FileLoader",0,0,0);
 
 
-  WorkerInfoQueue *loadWorkQ = new WorkerInfoQueue ( master_img_loader->flow_buffer_size );
+  WorkerInfoQueue *loadWorkQ = new WorkerInfoQueue ( master_img_loader->flow_buffer_size, "ImageLoader" );
 
 
   ImageLoadWorkInfo *n_image_loaders = new ImageLoadWorkInfo[master_img_loader->flow_buffer_size];
   SetUpIndividualImageLoaders ( n_image_loaders,master_img_loader );
 
 
-  //   int numWorkers = 1;
-  int numWorkers = numCores() /4; // @TODO - this should be subject to inception_state options
-  numWorkers = ( numWorkers < 4 ? 4:numWorkers );
+  int numWorkers = master_img_loader->inception_state->img_control.image_load_threads;
+  if ( numWorkers <= 0 )
+  {
+    numWorkers = numCores() /4;
+    numWorkers = ( numWorkers < 4 ? 4:numWorkers );
+  }
   fprintf ( stdout, "FileLoader: numWorkers threads = %d\n", numWorkers );
+
+  // reads for upcoming flows are issued ahead of time, so the decode below finds its file in the page cache
+  DatPrefetcher *prefetcher = NULL;
+  int prefetch_depth = master_img_loader->inception_state->img_control.dat_prefetch_depth;
+  if ( prefetch_depth > 0 )
+  {
+    std::vector<std::string> dat_names;
+    for ( int i_buffer = 0; i_buffer < master_img_loader->flow_buffer_size; i_buffer++ )
+      dat_names.push_back ( n_image_loaders[i_buffer].name );
+    prefetcher = new DatPrefetcher ( dat_names, prefetch_depth, std::min ( prefetch_depth, 8 ) );
+    prefetcher->Start();
+    fprintf ( stdout, "FileLoader: prefetching %d dat files ahead\n", prefetch_depth );
+  }
   WqInfo_t wq_info[numWorkers];
 
   {
@@ -406,6 +428,9 @@ void *FileLoader ( void *arg )
 
     int cur_flow = cur_image_loader->flow;  // each job is an n_image_loaders item
 
+    if ( prefetcher != NULL )
+      cur_image_loader->io_time = prefetcher->WaitForFile ( i_buffer );
+
     DontReadAheadOfSignalProcessing (cur_image_loader, master_img_loader->lead);
     //***We are doing this on this thread so we >load< in sequential order that pinned in Flow updates in sequential order
     if (!cur_image_loader->inception_state->img_control.threaded_file_access) {
@@ -425,6 +450,11 @@ void *FileLoader ( void *arg )
   loadWorkQ->WaitTillDone();
   KillQueue ( loadWorkQ,numWorkers );
 
+  if ( prefetcher != NULL )
+  {
+    prefetcher->PrintSummary ( stdout );
+    delete prefetcher;
+  }
   delete loadWorkQ;
   delete[] n_image_loaders;
 
@@ -90,6 +90,9 @@ struct ImageLoadWorkInfo
   bool doRawBkgSubtract;
   bool doEmptyWellNormalization;
   const CommandLineOpts *inception_state;
+
+  double io_time;     // seconds spent reading this flow's file ahead of decoding
+  double decode_time; // seconds spent in LoadRaw
 };
 
 
@@ -18,10 +18,9 @@
 #include "Serialization.h"
 #include "GpuMultiFlowFitControl.h"
 #include "ChipIdDecoder.h"
+#include "RestartCheckpoint.h"
 
 #include <boost/serialization/vector.hpp>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/binary_oarchive.hpp>
 
 #include <fenv.h>
 
@@ -222,27 +221,15 @@ void ImageToWells::GetRestartData(Json::Value &json_params){
 
     string filePath = inception_state.sys_context.analysisLocation + inception_state.bkg_control.signal_chunks.restart_from;
 
-    time_t begin_load_time;
-    time ( &begin_load_time );
-
-    ifstream ifs(filePath.c_str(), ifstream::in);
-    assert(ifs.good());
-
-    //boost::archive::text_iarchive in_archive(ifs);
-    boost::archive::binary_iarchive in_archive(ifs);
+    Timer load_timer;
 
     string saved_git_hash;
-    in_archive >> saved_git_hash
-    >> my_prequel_setup
-    >> FromBeadfindMask
-    >> GlobalFitter;
-
-    ifs.close();
+    RestartCheckpoint checkpoint ( filePath, inception_state.bkg_control.signal_chunks.numCpuThreads );
+    checkpoint.Load ( saved_git_hash, my_prequel_setup, FromBeadfindMask, GlobalFitter );
 
-    time_t finish_load_time;
-    time ( &finish_load_time );
     fprintf ( stdout, "Loading restart state from archive %s took %0.1f sec\n",
-        filePath.c_str(), difftime ( finish_load_time, begin_load_time ));
+        filePath.c_str(), load_timer.elapsed());
+    checkpoint.PrintSummary ( stdout );
 
     if ( inception_state.bkg_control.signal_chunks.restart_check ){
       string git_hash = IonVersion::GetGitHash();
@@ -272,34 +259,21 @@ void ImageToWells::StoreRestartData(){
 
   if ( doSerialize() ){
     string filePath = inception_state.sys_context.analysisLocation + inception_state.bkg_control.signal_chunks.restart_next;
-    ofstream outStream(filePath.c_str(), ios_base::trunc);
-    assert(outStream.good());
-    //boost::archive::text_oarchive outArchive(outStream);
-    boost::archive::binary_oarchive outArchive(outStream);
-
 
     // get region associated objects on disk first
 
-    time_t begin_save_time;
-    time ( &begin_save_time );
+    Timer save_timer;
 
-    //const ComplexMask *from_beadfind_mask_ptr = &from_beadfind_mask;
-    //BkgFitterTracker *GlobalFitter_ptr = &GlobalFitter;
     string git_hash = IonVersion::GetGitHash();
 
     GlobalFitter.GpuQueueControl.mirrorDeviceBuffersToHostForSerialization();
 
-    outArchive
-    << git_hash
-    << my_prequel_setup
-    << FromBeadfindMask
-    << GlobalFitter;
-    outStream.close();
-
-    time_t finish_save_time;
-    time ( &finish_save_time );
-    fprintf ( stdout, "Writing restart state to archive %s took %0.1f secs",
-        filePath.c_str(), difftime ( finish_save_time, begin_save_time ));
+    RestartCheckpoint checkpoint ( filePath, inception_state.bkg_control.signal_chunks.numCpuThreads );
+    checkpoint.Save ( git_hash, my_prequel_setup, FromBeadfindMask, GlobalFitter );
+
+    fprintf ( stdout, "Writing restart state to archive %s took %0.1f secs\n",
+        filePath.c_str(), save_timer.elapsed());
+    checkpoint.PrintSummary ( stdout );
   }
 
 }
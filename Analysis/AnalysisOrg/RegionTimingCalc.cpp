@@ -128,7 +128,7 @@ void threadedFillRegionalTimingParameters(std::vector<RegionTiming>& region_time
   if (numThreads > 0) numWorkers = numThreads; 
   if (numWorkers>4) numWorkers = 4;
   
-    threadWorkQ = new WorkerInfoQueue(std::max(numRegions,numWorkers)+1);
+    threadWorkQ = new WorkerInfoQueue(std::max(numRegions,numWorkers)+1, "RegionTiming");
   // spawn threads
   {
     int cworker;
@@ -0,0 +1,287 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#include "RestartCheckpoint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <streambuf>
+#include <sstream>
+#include "BkgFitterTracker.h"
+#include "SlicedPrequel.h"
+#include "ComplexMask.h"
+#include "IonErr.h"
+#include "Utils.h"
+#include "Serialization.h"
+
+#include <boost/serialization/vector.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// read-only stream over one blob of the mapped checkpoint, nothing is copied
+class CheckpointBlobBuffer : public std::streambuf
+{
+  public:
+    CheckpointBlobBuffer (const char *data, uint64_t size)
+    {
+      char *start = const_cast<char *> (data);
+      setg (start, start, start + size);
+    }
+};
+
+static uint64_t AlignedSize (uint64_t size)
+{
+  return (size + 7) & ~ (uint64_t) 7;
+}
+
+RestartCheckpoint::RestartCheckpoint (const std::string &_file_path, int _num_threads)
+{
+  file_path = _file_path;
+  num_threads = _num_threads > 0 ? _num_threads : numCores();
+  prequel = NULL;
+  fitter = NULL;
+  handle = -1;
+  map_start = NULL;
+  map_size = 0;
+  file_size = 0;
+  next_region = 0;
+  next_offset = 0;
+  saving = false;
+  write_failed = false;
+  global_time = 0.0;
+  region_time = 0.0;
+  threads_used = 0;
+}
+
+RestartCheckpoint::~RestartCheckpoint()
+{
+  Unmap();
+}
+
+void RestartCheckpoint::Unmap()
+{
+  if (map_start != NULL)
+    munmap (map_start, map_size);
+  if (handle >= 0)
+    close (handle);
+  map_start = NULL;
+  map_size = 0;
+  handle = -1;
+}
+
+void *RestartCheckpoint::RegionThread (void *arg)
+{
+  RestartCheckpoint *checkpoint = (RestartCheckpoint *) arg;
+  int num_regions = (int) checkpoint->region_table.size();
+  int r;
+  while ((r = __sync_fetch_and_add (&checkpoint->next_region, 1)) < num_regions)
+  {
+    if (checkpoint->saving)
+      checkpoint->SaveOneRegion (r);
+    else
+      checkpoint->LoadOneRegion (r);
+  }
+  return NULL;
+}
+
+void RestartCheckpoint::RunRegionThreads()
+{
+  int num_regions = (int) region_table.size();
+  if (num_regions == 0)
+    return;
+
+  // region 0 on this thread first: boost builds its per-type tables the first time a
+  // type goes through an archive, the workers only ever find them built
+  if (saving)
+    SaveOneRegion (0);
+  else
+    LoadOneRegion (0);
+  next_region = 1;
+  threads_used = std::min (num_threads, num_regions - 1);
+
+  std::vector<pthread_t> threads (threads_used);
+  for (int i=0; i<threads_used; i++)
+  {
+    int t = pthread_create (&threads[i], NULL, RegionThread, this);
+    ION_ASSERT (t == 0, "Unable to start restart checkpoint thread");
+  }
+  for (int i=0; i<threads_used; i++)
+    pthread_join (threads[i], NULL);
+}
+
+// ---------------------------------------------------------------------------------------
+
+void RestartCheckpoint::WriteAt (const void *data, uint64_t size, uint64_t offset)
+{
+  const char *bytes = (const char *) data;
+  while (size > 0)
+  {
+    ssize_t written = pwrite (handle, bytes, size, offset);
+    if (written <= 0)
+    {
+      if (written < 0 && errno == EINTR)
+        continue;
+      write_failed = true;
+      return;
+    }
+    bytes += written;
+    size -= written;
+    offset += written;
+  }
+}
+
+void RestartCheckpoint::SaveOneRegion (int r)
+{
+  std::stringbuf blob;
+  {
+    boost::archive::binary_oarchive out_archive (blob);
+    const RegionalizedData &region_data = *fitter->sliced_chip[r];
+    out_archive << region_data;
+  }
+  const std::string &bytes = blob.str();
+
+  uint64_t offset = __sync_fetch_and_add (&next_offset, AlignedSize (bytes.size()));
+  WriteAt (bytes.data(), bytes.size(), offset);
+
+  region_table[r].offset = offset;
+  region_table[r].size = bytes.size();
+  const Region *region = fitter->sliced_chip[r]->get_region();
+  region_table[r].region = region ? region - &prequel->region_list[0] : -1;
+}
+
+void RestartCheckpoint::Save (const std::string &git_hash, SlicedPrequel &my_prequel_setup,
+                              ComplexMask &from_beadfind_mask, BkgFitterTracker &global_fitter)
+{
+  prequel = &my_prequel_setup;
+  fitter = &global_fitter;
+  region_table.assign (global_fitter.sliced_chip.size(), RestartCheckpointRegion());
+
+  handle = open (file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ION_ASSERT (handle >= 0, "Unable to open restart checkpoint " + file_path + " for writing: " + strerror (errno));
+
+  Timer global_timer;
+  RestartCheckpointHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, RESTART_CHECKPOINT_MAGIC, sizeof (header.magic));
+  header.version = RESTART_CHECKPOINT_VERSION;
+  header.num_regions = region_table.size();
+  header.global_offset = AlignedSize (sizeof (header) + region_table.size() * sizeof (RestartCheckpointRegion));
+  {
+    std::stringbuf blob;
+    {
+      boost::archive::binary_oarchive out_archive (blob);
+      out_archive
+      << git_hash
+      << my_prequel_setup
+      << from_beadfind_mask
+      << global_fitter;
+    }
+    const std::string &bytes = blob.str();
+    header.global_size = bytes.size();
+    WriteAt (bytes.data(), bytes.size(), header.global_offset);
+  }
+  next_offset = header.global_offset + AlignedSize (header.global_size);
+  global_time = global_timer.elapsed();
+
+  Timer region_timer;
+  saving = true;
+  RunRegionThreads();
+  region_time = region_timer.elapsed();
+
+  // the header goes last, a checkpoint cut short has no valid magic
+  WriteAt (region_table.empty() ? NULL : &region_table[0], region_table.size() * sizeof (RestartCheckpointRegion), sizeof (header));
+  WriteAt (&header, sizeof (header), 0);
+  file_size = next_offset;
+  if (close (handle) != 0)
+    write_failed = true;
+  handle = -1;
+  ION_ASSERT (!write_failed, "Failed writing restart checkpoint " + file_path);
+}
+
+// ---------------------------------------------------------------------------------------
+
+void RestartCheckpoint::LoadOneRegion (int r)
+{
+  const RestartCheckpointRegion &entry = region_table[r];
+  const char *blob = map_start + entry.offset;
+
+  RegionalizedData *region_data = new RegionalizedData();
+  {
+    CheckpointBlobBuffer buffer (blob, entry.size);
+    boost::archive::binary_iarchive in_archive (buffer);
+    in_archive >> *region_data;
+  }
+  region_data->RelinkSharedState (&prequel->region_list[entry.region], fitter->all_emptytrace_track);
+  fitter->sliced_chip[r] = region_data;
+
+  // this region is decoded, give its pages back
+  uintptr_t page_mask = getpagesize() - 1;
+  uintptr_t page_start = (uintptr_t) blob & ~page_mask;
+  madvise ((void *) page_start, (uintptr_t) blob + entry.size - page_start, MADV_DONTNEED);
+}
+
+void RestartCheckpoint::Load (std::string &git_hash, SlicedPrequel &my_prequel_setup,
+                              ComplexMask &from_beadfind_mask, BkgFitterTracker &global_fitter)
+{
+  prequel = &my_prequel_setup;
+  fitter = &global_fitter;
+
+  handle = open (file_path.c_str(), O_RDONLY);
+  ION_ASSERT (handle >= 0, "Unable to open restart checkpoint " + file_path + ": " + strerror (errno));
+  struct stat file_stat;
+  ION_ASSERT (fstat (handle, &file_stat) == 0 && file_stat.st_size >= (off_t) sizeof (RestartCheckpointHeader),
+              "Restart checkpoint " + file_path + " is truncated");
+  map_size = file_size = file_stat.st_size;
+  map_start = (char *) mmap (0, map_size, PROT_READ, MAP_PRIVATE, handle, 0);
+  if (map_start == MAP_FAILED)
+    map_start = NULL;
+  ION_ASSERT (map_start != NULL, "Unable to map restart checkpoint " + file_path + ": " + strerror (errno));
+  madvise (map_start, map_size, MADV_SEQUENTIAL);
+
+  const RestartCheckpointHeader *header = (const RestartCheckpointHeader *) map_start;
+  ION_ASSERT (memcmp (header->magic, RESTART_CHECKPOINT_MAGIC, sizeof (header->magic)) == 0
+              && header->version == RESTART_CHECKPOINT_VERSION,
+              file_path + " is not a restart checkpoint this version of Analysis can read");
+  uint64_t table_end = sizeof (*header) + (uint64_t) header->num_regions * sizeof (RestartCheckpointRegion);
+  ION_ASSERT (table_end <= map_size && header->global_offset + header->global_size <= map_size,
+              "Restart checkpoint " + file_path + " is truncated");
+  const RestartCheckpointRegion *table = (const RestartCheckpointRegion *) (map_start + sizeof (*header));
+  region_table.assign (table, table + header->num_regions);
+
+  Timer global_timer;
+  {
+    CheckpointBlobBuffer buffer (map_start + header->global_offset, header->global_size);
+    boost::archive::binary_iarchive in_archive (buffer);
+    in_archive
+    >> git_hash
+    >> my_prequel_setup
+    >> from_beadfind_mask
+    >> global_fitter;
+  }
+  global_time = global_timer.elapsed();
+
+  ION_ASSERT (global_fitter.sliced_chip.size() == region_table.size(),
+              "Restart checkpoint " + file_path + " region table does not match its fitters");
+  for (size_t r=0; r<region_table.size(); r++)
+  {
+    ION_ASSERT (region_table[r].offset + region_table[r].size <= map_size
+                && region_table[r].region >= 0 && region_table[r].region < (int64_t) my_prequel_setup.region_list.size(),
+                "Restart checkpoint " + file_path + " is truncated");
+  }
+
+  Timer region_timer;
+  saving = false;
+  RunRegionThreads();
+  region_time = region_timer.elapsed();
+
+  Unmap();
+}
+
+void RestartCheckpoint::PrintSummary (FILE *fp)
+{
+  fprintf (fp, "Restart checkpoint %s: %d regions, %0.1f MB, shared state %0.2f sec, regions %0.2f sec on %d threads\n",
+           file_path.c_str(), (int) region_table.size(), file_size / (1024.0 * 1024.0), global_time, region_time, threads_used + 1);
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef RESTARTCHECKPOINT_H
+#define RESTARTCHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+class SlicedPrequel;
+class ComplexMask;
+class BkgFitterTracker;
+
+// The state a restarted Analysis picks up from, in one flat file:
+//
+//   header | region table | global blob | region blob | region blob | ...
+//
+// The global blob is a boost archive of everything shared across the chip (git hash,
+// SlicedPrequel, ComplexMask, BkgFitterTracker without its regions). Every region's
+// RegionalizedData is a boost archive of its own, so regions are serialized and written
+// by several threads at once, and on restart they are decoded in parallel straight out
+// of the mapped file, without reading the whole checkpoint into one stream first.
+// Blobs start on 8 byte boundaries.
+
+#define RESTART_CHECKPOINT_MAGIC    "ANLRSTRT"
+#define RESTART_CHECKPOINT_VERSION  1
+
+struct RestartCheckpointHeader {
+  char      magic[8];
+  uint32_t  version;
+  uint32_t  num_regions;
+  uint64_t  global_offset;    // bytes from start of file
+  uint64_t  global_size;
+};
+
+struct RestartCheckpointRegion {
+  uint64_t  offset;           // bytes from start of file
+  uint64_t  size;
+  int64_t   region;           // index into SlicedPrequel::region_list
+};
+
+class RestartCheckpoint
+{
+  public:
+    // regions are handled by _num_threads threads, one per core if 0
+    RestartCheckpoint (const std::string &_file_path, int _num_threads);
+    ~RestartCheckpoint();
+
+    void Save (const std::string &git_hash, SlicedPrequel &my_prequel_setup,
+               ComplexMask &from_beadfind_mask, BkgFitterTracker &global_fitter);
+    void Load (std::string &git_hash, SlicedPrequel &my_prequel_setup,
+               ComplexMask &from_beadfind_mask, BkgFitterTracker &global_fitter);
+
+    void PrintSummary (FILE *fp);
+
+  private:
+    static void *RegionThread (void *arg);
+    void   RunRegionThreads();
+    void   SaveOneRegion (int r);
+    void   LoadOneRegion (int r);
+    void   WriteAt (const void *data, uint64_t size, uint64_t offset);
+    void   Unmap();
+
+    std::string file_path;
+    int    num_threads;
+
+    SlicedPrequel    *prequel;
+    BkgFitterTracker *fitter;
+    std::vector<RestartCheckpointRegion> region_table;
+
+    int    handle;
+    char  *map_start;
+    size_t map_size;
+    uint64_t file_size;
+
+    bool     saving;
+    int      next_region;     // next region to be claimed by a worker
+    uint64_t next_offset;     // end of the file while saving
+    std::atomic<bool> write_failed;   // set by any region thread whose write fails
+
+    double global_time;
+    double region_time;
+    int    threads_used;
+};
+
+#endif // RESTARTCHECKPOINT_H
@@ -472,7 +472,7 @@ void ProcessorQueue::WaitForRegionsToFinishProcessing()
 void ProcessorQueue::createWorkQueue(int numRegions)
 {
   if(workQueue == NULL)
-    workQueue = new WorkerInfoQueue(numRegions*getNumWorkers()+1);
+    workQueue = new WorkerInfoQueue(numRegions*getNumWorkers()+1, "SignalProcessingCpu");
 }
 
 void ProcessorQueue::destroyWorkQueue()
@@ -3,6 +3,7 @@
 #include "Mask.h"
 #include "IonErr.h"
 #include "ImageSpecClass.h"
+#include "RawWellsChunkWriter.h"
 
 using namespace std;
 
@@ -78,7 +79,7 @@ void CreateWellsFileForWriting (RawWells &rawWells, Mask *maskPtr,
 //
 
 WriteFlowDataClass::WriteFlowDataClass(unsigned int saveQueueSize, CommandLineOpts &inception_state, ImageSpecClass &my_image_spec, const RawWells & rawWells)
-:queueSize(0),packQueuePtr(NULL),writeQueuePtr(NULL)
+:compressionThreads(0),queueSize(0),packQueuePtr(NULL),writeQueuePtr(NULL)
 {
   queueSize = saveQueueSize;
 
@@ -101,6 +102,7 @@ WriteFlowDataClass::WriteFlowDataClass(unsigned int saveQueueSize, CommandLineOp
     filePath = rawWells.GetHdf5FilePath();
     numCols = my_image_spec.cols;
     saveAsUShort = inception_state.sys_context.well_convert;
+    compressionThreads = inception_state.bkg_control.signal_chunks.wellsCompressionThreads;
 
   }
 }
@@ -148,6 +150,17 @@ void WriteFlowDataClass::InternalThreadFunction()
 
   RawWellsWriter writer;
 
+  // with compression threads the writer hands hdf5 whole chunks that were deflated in parallel
+  RawWellsChunkWriter *chunkWriter = NULL;
+  if ( compressionThreads > 0 ) {
+    chunkWriter = new RawWellsChunkWriter ( compressionThreads );
+    if ( !chunkWriter->Init ( wells ) ) {
+      fprintf ( stdout, "SaveWells: wells dataset can not take precompressed chunks, compressing on the writer thread\n");
+      delete chunkWriter;
+      chunkWriter = NULL;
+    }
+  }
+
   bool quit = false;
   while(!quit) {
     ChunkFlowData* chunkData = (writeQueuePtr)->deQueue();
@@ -157,51 +170,23 @@ void WriteFlowDataClass::InternalThreadFunction()
 
     quit = chunkData->lastFlow;
 
-    uint32_t currentRowStart = chunkData->wellChunk.rowStart,
-        currentRowEnd = chunkData->wellChunk.rowStart + min ( chunkData->wellChunk.rowHeight, stepSize );
-    uint32_t currentColStart = chunkData->wellChunk.colStart,
-        currentColEnd = chunkData->wellChunk.colStart + min ( chunkData->wellChunk.colWidth, stepSize );
-
-    for ( currentRowStart = 0, currentRowEnd = stepSize;
-        currentRowStart < chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight;
-        currentRowStart = currentRowEnd, currentRowEnd += stepSize ) {
-      currentRowEnd = min ( ( uint32_t ) ( chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight ), currentRowEnd );
-      for ( currentColStart = 0, currentColEnd = stepSize;
-          currentColStart < chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth;
-          currentColStart = currentColEnd, currentColEnd += stepSize ) {
-        currentColEnd = min ( ( uint32_t ) ( chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth ), currentColEnd );
-
-        chunkData->clearBuffer();
-        chunkData->bufferChunk.rowStart = currentRowStart;
-        chunkData->bufferChunk.rowHeight = currentRowEnd - currentRowStart;
-        chunkData->bufferChunk.colStart = currentColStart;
-        chunkData->bufferChunk.colWidth = currentColEnd - currentColStart;
-        chunkData->bufferChunk.flowStart = chunkData->wellChunk.flowStart;
-        chunkData->bufferChunk.flowDepth = chunkData->wellChunk.flowDepth;
-
-        int idxCount = 0;
-        for ( size_t row = currentRowStart; row < currentRowEnd; row++ ) {
-          for ( size_t col = currentColStart; col < currentColEnd; col++ ) {
-            int idx = row * numCols + col;
-            for ( size_t fIx = chunkData->wellChunk.flowStart; fIx < chunkData->wellChunk.flowStart + chunkData->wellChunk.flowDepth; fIx++ ) {
-              uint64_t ii = idxCount * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
-              uint64_t nn = ( uint64_t ) chunkData->indexes[idx] * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
-              chunkData->dsBuffer[ii] = chunkData->flowData[nn];
-            }
-            idxCount++;
-          }
-        }
-        if(writer.WriteWellsData(wells, chunkData->bufferChunk, chunkData->dsBuffer) < 0 ) {
-          ION_ABORT ( "ERROR - Unsuccessful write to HDF5 file: " +
-              ToStr ( chunkData->bufferChunk.rowStart ) + "," + ToStr ( chunkData->bufferChunk.colStart ) + "," +
-              ToStr ( chunkData->bufferChunk.rowHeight ) + "," + ToStr ( chunkData->bufferChunk.colWidth ) + " x " +
-              ToStr ( chunkData->bufferChunk.flowStart ) + "," + ToStr ( chunkData->bufferChunk.flowDepth ));
-        }
+    if ( chunkWriter != NULL && chunkWriter->CanWrite ( chunkData->wellChunk ) ) {
+      if ( chunkWriter->Write ( wells, *chunkData, numCols ) != 0 ) {
+        ION_ABORT ( "ERROR - Unsuccessful write to HDF5 file: " +
+            ToStr ( chunkData->wellChunk.flowStart ) + "," + ToStr ( chunkData->wellChunk.flowDepth ));
       }
     }
+    else {
+      WriteChunkFlowData ( writer, wells, chunkData );
+    }
     (packQueuePtr)->enQueue(chunkData);
   }
 
+  if ( chunkWriter != NULL ) {
+    chunkWriter->PrintSummary ( stdout );
+    delete chunkWriter;
+  }
+
   wells.Close();
   if ( hFile != RWH5DataSet::EMPTY ) {
     H5Fclose ( hFile );
@@ -213,6 +198,53 @@ void WriteFlowDataClass::InternalThreadFunction()
 }
 
 
+// pads the block out to the write step size and writes it through the hdf5 filter pipeline
+void WriteFlowDataClass::WriteChunkFlowData(RawWellsWriter &writer, RWH5DataSet &wells, ChunkFlowData *chunkData)
+{
+  uint32_t currentRowStart = chunkData->wellChunk.rowStart,
+      currentRowEnd = chunkData->wellChunk.rowStart + min ( chunkData->wellChunk.rowHeight, stepSize );
+  uint32_t currentColStart = chunkData->wellChunk.colStart,
+      currentColEnd = chunkData->wellChunk.colStart + min ( chunkData->wellChunk.colWidth, stepSize );
+
+  for ( currentRowStart = 0, currentRowEnd = stepSize;
+      currentRowStart < chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight;
+      currentRowStart = currentRowEnd, currentRowEnd += stepSize ) {
+    currentRowEnd = min ( ( uint32_t ) ( chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight ), currentRowEnd );
+    for ( currentColStart = 0, currentColEnd = stepSize;
+        currentColStart < chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth;
+        currentColStart = currentColEnd, currentColEnd += stepSize ) {
+      currentColEnd = min ( ( uint32_t ) ( chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth ), currentColEnd );
+
+      chunkData->clearBuffer();
+      chunkData->bufferChunk.rowStart = currentRowStart;
+      chunkData->bufferChunk.rowHeight = currentRowEnd - currentRowStart;
+      chunkData->bufferChunk.colStart = currentColStart;
+      chunkData->bufferChunk.colWidth = currentColEnd - currentColStart;
+      chunkData->bufferChunk.flowStart = chunkData->wellChunk.flowStart;
+      chunkData->bufferChunk.flowDepth = chunkData->wellChunk.flowDepth;
+
+      int idxCount = 0;
+      for ( size_t row = currentRowStart; row < currentRowEnd; row++ ) {
+        for ( size_t col = currentColStart; col < currentColEnd; col++ ) {
+          int idx = row * numCols + col;
+          for ( size_t fIx = chunkData->wellChunk.flowStart; fIx < chunkData->wellChunk.flowStart + chunkData->wellChunk.flowDepth; fIx++ ) {
+            uint64_t ii = idxCount * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
+            uint64_t nn = ( uint64_t ) chunkData->indexes[idx] * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
+            chunkData->dsBuffer[ii] = chunkData->flowData[nn];
+          }
+          idxCount++;
+        }
+      }
+      if(writer.WriteWellsData(wells, chunkData->bufferChunk, chunkData->dsBuffer) < 0 ) {
+        ION_ABORT ( "ERROR - Unsuccessful write to HDF5 file: " +
+            ToStr ( chunkData->bufferChunk.rowStart ) + "," + ToStr ( chunkData->bufferChunk.colStart ) + "," +
+            ToStr ( chunkData->bufferChunk.rowHeight ) + "," + ToStr ( chunkData->bufferChunk.colWidth ) + " x " +
+            ToStr ( chunkData->bufferChunk.flowStart ) + "," + ToStr ( chunkData->bufferChunk.flowDepth ));
+      }
+    }
+  }
+}
+
 bool WriteFlowDataClass::start(){
 
   if(packQueuePtr == NULL || writeQueuePtr == NULL || queueSize == 0) return false;
@@ -35,6 +35,7 @@ class WriteFlowDataClass : public pThreadWrapper {
   int numCols;
   size_t stepSize;
   bool saveAsUShort;
+  int compressionThreads;
   unsigned int queueSize;
   SemQueue* packQueuePtr;
   SemQueue* writeQueuePtr;
@@ -42,6 +43,7 @@ class WriteFlowDataClass : public pThreadWrapper {
 protected:
 
   virtual void InternalThreadFunction();
+  void WriteChunkFlowData(RawWellsWriter &writer, RWH5DataSet &wells, ChunkFlowData *chunkData);
 
 public:
 
@@ -548,7 +548,7 @@ void cudaWrapper::configureGpu(BkgModelControlOpts &bkg_control)
 void cudaWrapper::createQueue(int numRegions)
 {
   if(useGpuAcceleration()){ //assume that we will have one worker per valid device
-    workQueue = new WorkerInfoQueue (numRegions * getNumValidDevices() + 1 );  // where the +1 comes from nobody remembers but ehre probably was a reason for it once
+    workQueue = new WorkerInfoQueue (numRegions * getNumValidDevices() + 1, "SignalProcessingGpu" );  // where the +1 comes from nobody remembers but ehre probably was a reason for it once
     //testSerial = float((int64_t)workQueue/12345.6f);
   }
 }
@@ -148,6 +148,33 @@ void SaveBaseCallerProgress(int percent_complete, const string& output_directory
     SaveJson(progress_json, filename_json);
 }
 
+// ----------------------------------------------------------------
+//! @brief    Print the region progress map for all regions finished since the last call, in row-major order.
+//! @return   True once every region has been reported.
+
+bool ReportBasecallingProgress(BaseCallerContext & bc, int & next_region)
+{
+    int num_regions_x = bc.chip_subset.GetNumRegionsX();
+    while (next_region < bc.chip_subset.NumRegions() and bc.wells_prefetcher->IsRegionDone(next_region)) {
+        int begin_x = (next_region % num_regions_x) * bc.chip_subset.GetRegionSizeX();
+        int begin_y = (next_region / num_regions_x) * bc.chip_subset.GetRegionSizeY();
+        int num_usable_wells = bc.wells_prefetcher->NumUsableWells(next_region);
+
+        if      (begin_x == 0)            printf("\n% 5d/% 5d: ", begin_y, bc.chip_subset.GetChipSizeY());
+        if      (num_usable_wells ==   0) printf("  ");
+        else if (num_usable_wells <  750) printf(". ");
+        else if (num_usable_wells < 1500) printf("o ");
+        else if (num_usable_wells < 2250) printf("# ");
+        else                              printf("##");
+        fflush(NULL);
+
+        if (begin_x == 0)
+            SaveBaseCallerProgress(10 + (80*begin_y)/bc.chip_subset.GetChipSizeY(), bc.output_directory);
+        next_region++;
+    }
+    return next_region >= bc.chip_subset.NumRegions();
+}
+
 
 // --------------------------------------------------------------------------
 // Function sets the read class for each well and sub-samples if desired
@@ -440,6 +467,9 @@ int main (int argc, const char *argv[])
     bc.lib_writer.Open(bc_params.GetFiles().output_directory, datasets, 0, bc.chip_subset.NumRegions(),
                  bc.flow_order, bc.keys[0].bases(), filters.GetLibBeadAdapters(), bc_params.NumBamWriterThreads(),
                  basecaller_json, bam_comments, tag_trimmer, barcodes.TrimBarcodes(), bc_params.CompressOutputBam());
+    // ionstats basecaller without reading the BAMs back in
+    if (bc_params.IonstatsHistogramLength() > 0)
+      bc.lib_writer.EnableIonstats(bc_params.IonstatsHistogramLength());
 
     // Calibration reads data set writer - if applicable
     if (bc.have_calibration_panel)
@@ -475,6 +505,13 @@ int main (int argc, const char *argv[])
 
     pthread_mutex_init(&bc.mutex, NULL);
 
+    // Regions are handed out in HDF5 chunk order and their wells are read ahead by a dedicated thread
+    WellsPrefetcher wells_prefetcher;
+    wells_prefetcher.Open(bc.filename_wells, bc.chip_subset, bc.class_map, bc.flow_order.num_flows(),
+                          chunk_rows, chunk_cols, bc_params.NumThreads());
+    bc.wells_prefetcher = &wells_prefetcher;
+    wells_prefetcher.Start();
+
     pthread_t worker_id[bc_params.NumThreads()];
     for (int worker = 0; worker < bc_params.NumThreads(); worker++)
         if (pthread_create(&worker_id[worker], NULL, BasecallerWorker, &bc)) {
@@ -482,9 +519,16 @@ int main (int argc, const char *argv[])
             exit (EXIT_FAILURE);
         }
 
+    // Progress reporting is done here rather than by the workers
+    int next_region_reported = 0;
+    while (not ReportBasecallingProgress(bc, next_region_reported))
+        usleep(100000);
+
     for (int worker = 0; worker < bc_params.NumThreads(); worker++)
         pthread_join(worker_id[worker], NULL);
 
+    wells_prefetcher.Close();
+    bc.wells_prefetcher = NULL;
     pthread_mutex_destroy(&bc.mutex);
 
     time_t basecall_end_time;
@@ -570,13 +614,7 @@ void * BasecallerWorker(void *input)
 {
     BaseCallerContext& bc = *static_cast<BaseCallerContext*>(input);
 
-    RawWells wells ("", bc.filename_wells.c_str());
-    pthread_mutex_lock(&bc.mutex);
-    wells.OpenForIncrementalRead();
-    pthread_mutex_unlock(&bc.mutex);
-
     WellsNormalization wells_norm(&bc.flow_order, bc.wells_norm_method);
-    wells_norm.SetWells(&wells, bc.mask);
     int num_flows =  bc.flow_order.num_flows();
 
     vector<float>     residual(num_flows, 0);
@@ -605,39 +643,27 @@ void * BasecallerWorker(void *input)
 #endif
 
 
+    int batch_begin = 0, batch_end = 0, position = 0;
+
     while (true) {
 
         //
-        // Step 1. Retrieve next unprocessed region
+        // Step 1. Retrieve next unprocessed region, claiming a new batch of regions when needed
         //
 
-        pthread_mutex_lock(&bc.mutex);
-
-        int current_region, begin_x, begin_y, end_x, end_y;
-        if (not bc.chip_subset.GetCurrentRegionAndIncrement(current_region, begin_x, end_x, begin_y, end_y)) {
-           wells.Close();
-           pthread_mutex_unlock(&bc.mutex);
-           return NULL;
+        if (position >= batch_end) {
+            if (not bc.wells_prefetcher->GetNextBatch(batch_begin, batch_end))
+                return NULL;
+            position = batch_begin;
         }
 
-        int num_usable_wells = 0;
-        for (int y = begin_y; y < end_y; ++y)
-            for (int x = begin_x; x < end_x; ++x)
-                if (bc.class_map[x + y * bc.chip_subset.GetChipSizeX()] >= 0)
-                    num_usable_wells++;
-
-        if      (begin_x == 0)            printf("\n% 5d/% 5d: ", begin_y, bc.chip_subset.GetChipSizeY());
-        if      (num_usable_wells ==   0) printf("  ");
-        else if (num_usable_wells <  750) printf(". ");
-        else if (num_usable_wells < 1500) printf("o ");
-        else if (num_usable_wells < 2250) printf("# ");
-        else                              printf("##");
-        fflush(NULL);
-
-        if (begin_x == 0)
-            SaveBaseCallerProgress(10 + (80*begin_y)/bc.chip_subset.GetChipSizeY(), bc.output_directory);
-
-        pthread_mutex_unlock(&bc.mutex);
+        const WellsRegion& region = bc.wells_prefetcher->GetRegion(position);
+        int current_region   = region.region;
+        int begin_x          = region.begin_x;
+        int end_x            = region.end_x;
+        int begin_y          = region.begin_y;
+        int end_y            = region.end_y;
+        int num_usable_wells = region.num_usable_wells;
 
         // Process the data
         deque<ProcessedRead> lib_reads;                // Collection of template library reads
@@ -656,11 +682,13 @@ void * BasecallerWorker(void *input)
                 bc.unfiltered_writer.WriteRegion(current_region,unfiltered_reads);
                 bc.unfiltered_trimmed_writer.WriteRegion(current_region,unfiltered_trimmed_reads);
             }
+            bc.wells_prefetcher->ReleaseWells(position++);
             continue;
         }
 
-        wells.SetChunk(begin_y, end_y-begin_y, begin_x, end_x-begin_x, 0, num_flows);
-        wells.ReadWells();
+        // Wells of this region were read ahead by the prefetch thread
+        RawWells& wells = *bc.wells_prefetcher->AcquireWells(position);
+        wells_norm.SetWells(&wells, bc.mask);
         wells_norm.CorrectSignalBias(bc.keys);
         wells_norm.DoKeyNormalization(bc.keys);
 
@@ -1112,6 +1140,8 @@ void * BasecallerWorker(void *input)
                 }
             }
 
+        bc.wells_prefetcher->ReleaseWells(position++);
+
         bc.lib_writer.WriteRegion(current_region, lib_reads);
         if (bc.have_calibration_panel)
             bc.calib_writer.WriteRegion(current_region, calib_reads);
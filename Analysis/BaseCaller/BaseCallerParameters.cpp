@@ -117,6 +117,8 @@ void BaseCallerParameters::PrintHelp()
     printf ("     --run-id                STRING     read name prefix [hashed input dir name]\n");
     printf ("  -n,--num-threads           INT        number of worker threads [2*numcores]\n");
     printf ("     --compress-bam          BOOL       Output compressed / uncompressed BAM [true]\n");
+    printf ("     --ionstats-histogram-length INT    also write <file_prefix>.ionstats_basecaller.json for the library BAMs,\n");
+    printf ("                                        with this read length histogram cutoff. 0: do not write them [0]\n");
     printf ("  -f,--flowlimit             INT        basecall only first n flows [all flows]\n");
     printf ("     --keynormalizer         STRING     key normalization algorithm [gain]\n");
     printf ("     --wells-normalization   STRING     normalize wells signal and correct for signal bias [off]/on/keyOnly/signalBiasOnly/pinZero\n");
@@ -229,6 +231,7 @@ bool BaseCallerParameters::InitContextVarsFromOptArgs(OptArgs& opts){
 	num_threads_                             = opts.GetFirstInt    ('n', "num-threads", max(2*numCores(), 4));
 	num_bamwriter_threads_                   = opts.GetFirstInt    ('-', "num-threads-bamwriter", 0);
 	compress_output_bam_                     = opts.GetFirstBoolean('-', "compress-bam", true);
+	ionstats_histogram_length_               = opts.GetFirstInt    ('-', "ionstats-histogram-length", 0);
 
     context_vars.flow_signals_type           = opts.GetFirstString ('-', "flow-signals-type", "none");
     context_vars.only_process_unfiltered_set = opts.GetFirstBoolean('-', "only-process-unfiltered-set", false);
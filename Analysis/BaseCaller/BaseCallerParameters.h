@@ -42,6 +42,7 @@
 #include "PerBaseQual.h"
 #include "BaseCallerFilters.h"
 #include "BaseCallerMetricSaver.h"
+#include "WellsPrefetcher.h"
 //#include "LinearCalibrationModel.h"
 
 using namespace std;
@@ -174,6 +175,7 @@ struct BaseCallerContext {
 
     // Threaded processing
     pthread_mutex_t           mutex;                  //!< Shared read/write mutex for BaseCaller worker threads
+    WellsPrefetcher           *wells_prefetcher;      //!< Region dispenser and wells read-ahead for worker threads
 
     // Basecalling results saved here
     OrderedDatasetWriter      lib_writer;                 //!< Writer object for library BAMs
@@ -197,6 +199,7 @@ public:
       num_threads_              = 1;
       num_bamwriter_threads_    = 1;
       compress_output_bam_      = true;
+      ionstats_histogram_length_ = 0;
       bc_files.options_set      = false;
       sampling_opts.options_set = false;
       context_vars.options_set  = false;
@@ -238,12 +241,14 @@ public:
 
     int NumThreads()          const { return num_threads_; };
     int NumBamWriterThreads() const { return num_bamwriter_threads_; };
+    int IonstatsHistogramLength() const { return ionstats_histogram_length_; };
 
 private:
 
     int                 num_threads_;              //!< Number of worker threads to do base calling
     int                 num_bamwriter_threads_;    //!< Number of threads one bam writer object uses
     bool                compress_output_bam_;      //!< Switch to output compressed / uncompressed BAM
+    int                 ionstats_histogram_length_; //!< Library BAMs get ionstats basecaller json if > 0
 
     BaseCallerFiles     bc_files;
     BCcontextVars       context_vars;
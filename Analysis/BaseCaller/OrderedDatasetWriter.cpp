@@ -9,6 +9,7 @@
 #include <stddef.h>
 #include <algorithm>
 #include <sstream>
+#include <fstream>
 #include <stdio.h>
 
 #include "BarcodeDatasets.h"
@@ -30,6 +31,7 @@ OrderedDatasetWriter::OrderedDatasetWriter()
   save_filtered_reads_   = false;
   compress_bam_          = true;
   num_bamwriter_threads_ = 0;
+  save_ionstats_         = false;
   pthread_mutex_init(&dropbox_mutex_, NULL);
   pthread_mutex_init(&write_mutex_, NULL);
   pthread_mutex_init(&delete_mutex_, NULL);
@@ -62,6 +64,7 @@ void OrderedDatasetWriter::Open(const string& base_directory, BarcodeDatasets& d
   num_read_groups_ = datasets.num_read_groups();
   num_reads_.resize(num_datasets_,0);
   bam_filename_.resize(num_datasets_);
+  ionstats_filename_.resize(num_datasets_);
   compress_bam_ = compress_bam;
 
   // A negative read group index indicates untrimmed/unfiltered bam files (w. library key) and we save all reads
@@ -105,6 +108,7 @@ void OrderedDatasetWriter::Open(const string& base_directory, BarcodeDatasets& d
     // Set up BAM header
 
     bam_filename_[ds] = base_directory + "/" + datasets.dataset(ds)["basecaller_bam"].asString();
+    ionstats_filename_[ds] = base_directory + "/" + datasets.dataset(ds)["file_prefix"].asString() + ".ionstats_basecaller.json";
 
     SamHeader& sam_header = sam_header_[ds];
     sam_header.Version = "1.4";
@@ -157,6 +161,27 @@ void OrderedDatasetWriter::Open(const string& base_directory, BarcodeDatasets& d
 
 // ----------------------------------------------------------------------------
 
+void OrderedDatasetWriter::EnableIonstats(int histogram_length)
+{
+  save_ionstats_ = true;
+  ionstats_.assign(num_datasets_, IonstatsBasecallerStats());
+
+  // Same key and flow order that ionstats takes from the header of the finished BAM
+  for (int ds = 0; ds < num_datasets_; ++ds) {
+    string flow_order;
+    string key;
+    for (SamReadGroupIterator rg = sam_header_[ds].ReadGroups.Begin(); rg != sam_header_[ds].ReadGroups.End(); ++rg) {
+      if(rg->HasFlowOrder())
+        flow_order = rg->FlowOrder;
+      if(rg->HasKeySequence())
+        key = rg->KeySequence;
+    }
+    ionstats_[ds].Initialize(histogram_length, key, flow_order);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
 void  OrderedDatasetWriter::AddCustomReadGroupTag (SamReadGroup & read_group, const string& tag_name, const string& tag_body)
 {
   // Nothing to do if body is empty
@@ -186,6 +211,16 @@ void OrderedDatasetWriter::Close(BarcodeDatasets& datasets, const string& datase
         printf("%s: Generated %s with %d reads\n", dataset_nickname.c_str(), bam_filename_[ds].c_str(), num_reads_[ds]);
       bam_writer_[ds]->Close();
       delete bam_writer_[ds];
+
+      if (save_ionstats_) {
+        Json::Value ionstats_json(Json::objectValue);
+        ionstats_[ds].SaveToJson(ionstats_json);
+        ofstream out(ionstats_filename_[ds].c_str(), ios::out);
+        if (out.good())
+          out << ionstats_json.toStyledString();
+        else
+          cerr << "BaseCaller IO error: Failed to write " << ionstats_filename_[ds] << endl;
+      }
     }
     else {
       if (!dataset_nickname.empty())
@@ -331,6 +366,8 @@ void OrderedDatasetWriter::PhysicalWriteRegion(int region)
       cerr << "BaseCaller IO error: Failed to write to bam file " << bam_filename_[target_file_idx] << endl;
       exit(EXIT_FAILURE);
     }
+    if (save_ionstats_)
+      ionstats_[target_file_idx].AddRead(entry->bam);
   }
 }
 
@@ -21,6 +21,7 @@
 
 #include "BaseCallerUtils.h"
 #include "MolecularTagTrimmer.h"
+#include "../ionstats/ionstats.h"
 
 class  BarcodeDatasets;
 
@@ -184,6 +185,11 @@ public:
        int num_bamwriter_threads, const Json::Value & basecaller_json, vector<string>& comments,
        MolecularTagTrimmer& tag_trimmer, bool trim_barcodes, bool compress_bam);
 
+  //! @brief  Collect the "ionstats basecaller" metrics of every written read, call after Open.
+  //!         Close saves them as <file_prefix>.ionstats_basecaller.json next to each BAM.
+  //! @param  histogram_length      Read length histogram cutoff, as ionstats --histogram-length
+  void EnableIonstats(int histogram_length);
+
   //! @brief  Drop off a region-worth of reads for writing. Write opportunistically.
   //! @param  region          Index of the region being dropped off.
   //! @param  region_reads    SFF entries from this region.
@@ -228,6 +234,7 @@ private:
 
   vector<int>               num_reads_;             //!< Number of reads written, per dataset
   vector<string>            bam_filename_;
+  vector<string>            ionstats_filename_;
 
   bool                      save_filtered_reads_;
   bool                      compress_bam_;
@@ -244,6 +251,9 @@ private:
   vector<BamWriter *>       bam_writer_;
   vector<SamHeader>         sam_header_;
 
+  bool                      save_ionstats_;         //!< Accumulate ionstats metrics while writing?
+  vector<IonstatsBasecallerStats>  ionstats_;       //!< ionstats basecaller metrics, per dataset
+
   vector<ReadFilteringStats>  read_group_stats_;
   ReadFilteringStats        combined_stats_;
 
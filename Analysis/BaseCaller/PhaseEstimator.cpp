@@ -33,6 +33,8 @@ int        PhaseEstimator::phasing_end_flow_        = 150;
 float      PhaseEstimator::inclusion_threshold_     = 1.4;
 float      PhaseEstimator::maxfrac_negative_flows_  = 0.2;
 
+// How many chunks the region loader may read ahead of a worker
+static const size_t kPrefetchRegions = 4;
 
 // ---------------------------------------------------------------------------
 
@@ -83,6 +85,10 @@ PhaseEstimator::PhaseEstimator()
   wells_ = NULL;
   mask_ = NULL;
   jobs_in_progress_ = 0;
+  region_loader_stop_ = false;
+  num_regions_loaded_ = 0;
+  region_load_time_ = 0;
+  next_worker_id_ = 0;
   result_regions_x_ = 1;
   result_regions_y_ = 1;
   residual_threshold_ = 1.0;
@@ -564,10 +570,18 @@ void PhaseEstimator::SpatialRefiner(RawWells *wells, Mask *mask, int num_workers
 
   region_reads_.clear();
   region_reads_.resize(num_regions_);
+  region_state_.assign(num_regions_, 0);
+  prefetch_jobs_.clear();
+  region_loader_stop_ = false;
+  num_regions_loaded_ = 0;
+  region_load_time_ = 0;
+  next_worker_id_ = 0;
   action_map_.assign(num_regions_,0);
   subblock_map_.assign(num_regions_,' ');
 
   pthread_mutex_init(&region_loader_mutex_, NULL);
+  pthread_cond_init(&region_loader_cond_, NULL);
+  pthread_cond_init(&region_ready_cond_, NULL);
   pthread_mutex_init(&job_queue_mutex_, NULL);
   pthread_cond_init(&job_queue_cond_, NULL);
 
@@ -580,6 +594,10 @@ void PhaseEstimator::SpatialRefiner(RawWells *wells, Mask *mask, int num_workers
   job_queue_.push_back(&subblocks[0]);
   jobs_in_progress_ = 0;
 
+  pthread_t loader_id;
+  if (pthread_create(&loader_id, NULL, RegionLoaderWrapper, this))
+    ION_ABORT("*Error* - problem starting thread");
+
   pthread_t worker_id[num_workers];
 
   for (int worker = 0; worker < num_workers; worker++)
@@ -589,8 +607,19 @@ void PhaseEstimator::SpatialRefiner(RawWells *wells, Mask *mask, int num_workers
   for (int worker = 0; worker < num_workers; worker++)
     pthread_join(worker_id[worker], NULL);
 
+  pthread_mutex_lock(&region_loader_mutex_);
+  region_loader_stop_ = true;
+  pthread_cond_signal(&region_loader_cond_);
+  pthread_mutex_unlock(&region_loader_mutex_);
+  pthread_join(loader_id, NULL);
+
+  printf("PhaseEstimator: region loader read %d regions in %5.2lf sec\n",
+      num_regions_loaded_, (double)region_load_time_/1000000.0);
+
   pthread_cond_destroy(&job_queue_cond_);
   pthread_mutex_destroy(&job_queue_mutex_);
+  pthread_cond_destroy(&region_ready_cond_);
+  pthread_cond_destroy(&region_loader_cond_);
   pthread_mutex_destroy(&region_loader_mutex_);
 
 
@@ -659,9 +688,7 @@ size_t PhaseEstimator::LoadRegion(int region)
   int end_x = min(begin_x + region_size_x_, chip_size_x_);
   int end_y = min(begin_y + region_size_y_, chip_size_y_);
 
-  // Mutex needed for wells access, but not needed for region_reads access
-  pthread_mutex_lock(&region_loader_mutex_);
-
+  // Only the region loader thread gets here, so wells access needs no lock
   wells_->SetChunk(begin_y, end_y-begin_y, begin_x, end_x-begin_x, 0, flow_order_.num_flows());
   wells_->ReadWells();
   wells_norm_->CorrectSignalBias(keys_);
@@ -768,13 +795,107 @@ size_t PhaseEstimator::LoadRegion(int region)
     }
   }
 
+  region_num_reads_[region] = region_reads_[region].size();
+
+  return timer.GetMicroSec();
+}
+
+// ---------------------------------------------------------------------------
+
+void *PhaseEstimator::RegionLoaderWrapper(void *arg)
+{
+  static_cast<PhaseEstimator*>(arg)->RegionLoader();
+  return NULL;
+}
+
+void PhaseEstimator::RegionLoader()
+{
+  pthread_mutex_lock(&region_loader_mutex_);
+  while (true) {
+
+    // Pick the next chunk: first for a worker that is already waiting, otherwise
+    // the one furthest behind its read-ahead limit.
+    Subblock *job = NULL;
+    for (vector<Subblock*>::iterator J = prefetch_jobs_.begin(); J != prefetch_jobs_.end(); ++J) {
+      Subblock &s = **J;
+      while (s.next_load < s.sorted_regions.size() and region_state_[s.sorted_regions[s.next_load]] != 0)
+        s.next_load++;
+      if (s.next_load >= s.sorted_regions.size() or s.next_load >= s.next_use + kPrefetchRegions)
+        continue;
+      if (job == NULL or s.next_load + job->next_use < job->next_load + s.next_use)
+        job = &s;
+    }
+
+    if (job == NULL) {
+      if (region_loader_stop_)
+        break;
+      pthread_cond_wait(&region_loader_cond_, &region_loader_mutex_);
+      continue;
+    }
+
+    int region = job->sorted_regions[job->next_load++];
+    region_state_[region] = 1;
+    job->loads_in_flight++;
+    pthread_mutex_unlock(&region_loader_mutex_);
+
+    size_t load_time = LoadRegion(region);
+
+    pthread_mutex_lock(&region_loader_mutex_);
+    region_state_[region] = 2;
+    job->loads_in_flight--;
+    if (load_time > 0)
+      num_regions_loaded_++;
+    region_load_time_ += load_time;
+    pthread_cond_broadcast(&region_ready_cond_);
+  }
   pthread_mutex_unlock(&region_loader_mutex_);
+}
 
-  region_num_reads_[region] = region_reads_[region].size();
+void PhaseEstimator::StartPrefetch(Subblock& s)
+{
+  pthread_mutex_lock(&region_loader_mutex_);
+  s.next_load = 0;
+  s.next_use = 0;
+  s.loads_in_flight = 0;
+  prefetch_jobs_.push_back(&s);
+  pthread_cond_signal(&region_loader_cond_);
+  pthread_mutex_unlock(&region_loader_mutex_);
+}
+
+size_t PhaseEstimator::WaitForRegion(Subblock& s, size_t idx)
+{
+  int region = s.sorted_regions[idx];
+  ClockTimer timer;
+  timer.StartTimer();
+
+  pthread_mutex_lock(&region_loader_mutex_);
+  s.next_use = idx;
+  // never leave the worker waiting for a chunk the loader has already gone past
+  if (s.next_load > idx and region_state_[region] == 0)
+    s.next_load = idx;
+  pthread_cond_signal(&region_loader_cond_);
+  while (region_state_[region] != 2)
+    pthread_cond_wait(&region_ready_cond_, &region_loader_mutex_);
+  pthread_mutex_unlock(&region_loader_mutex_);
 
   return timer.GetMicroSec();
 }
 
+void PhaseEstimator::StopPrefetch(Subblock& s, bool release_regions)
+{
+  pthread_mutex_lock(&region_loader_mutex_);
+  prefetch_jobs_.erase(find(prefetch_jobs_.begin(), prefetch_jobs_.end(), &s));
+  while (s.loads_in_flight > 0)
+    pthread_cond_wait(&region_ready_cond_, &region_loader_mutex_);
+  if (release_regions) {
+    for (vector<int>::iterator region = s.sorted_regions.begin(); region != s.sorted_regions.end(); ++region) {
+      region_reads_[*region].clear();
+      region_state_[*region] = 0;
+    }
+  }
+  pthread_mutex_unlock(&region_loader_mutex_);
+}
+
 // ---------------------------------------------------------------------------
 
 void PhaseEstimator::NormalizeBasecallerRead(DPTreephaser& treephaser, BasecallerRead& read, int start_flow, int end_flow)
@@ -821,12 +942,19 @@ void PhaseEstimator::EstimatorWorker()
   vector<BasecallerRead *>  useful_reads;
   useful_reads.reserve(10000);
 
+  int worker_id = __sync_fetch_and_add(&next_worker_id_, 1);
+  int num_jobs = 0;
+  size_t job_time = 0;
+  size_t load_wait_time = 0;
+
   while (true) {
 
     pthread_mutex_lock(&job_queue_mutex_);
     while (job_queue_.empty()) {
       if (jobs_in_progress_ == 0) {
         pthread_mutex_unlock(&job_queue_mutex_);
+        printf("PhaseEstimator: worker %d estimated %d subblocks, compute time %5.2lf sec, load wait %5.2lf sec\n",
+            worker_id, num_jobs, (double)(job_time-load_wait_time)/1000000.0, (double)load_wait_time/1000000.0);
         return;
       }
       // No jobs available now, but more may come, so stick around
@@ -837,6 +965,10 @@ void PhaseEstimator::EstimatorWorker()
     jobs_in_progress_++;
     pthread_mutex_unlock(&job_queue_mutex_);
 
+    ClockTimer job_timer;
+    job_timer.StartTimer();
+    num_jobs++;
+    StartPrefetch(s);
 
     // Processing
 
@@ -856,7 +988,7 @@ void PhaseEstimator::EstimatorWorker()
       for (vector<int>::iterator region = s.sorted_regions.begin(); region != s.sorted_regions.end(); ++region) {
 
 
-        iotimer += LoadRegion(*region);
+        iotimer += WaitForRegion(s, region - s.sorted_regions.begin());
         // Ensure region loaded.
         // Grab reads, filter
         // Enough reads? Stop.
@@ -903,6 +1035,7 @@ void PhaseEstimator::EstimatorWorker()
         if (useful_reads.size() >= num_reads_per_region_)
           break;
       }
+      load_wait_time += iotimer;
 
       if (s.level > 1 and useful_reads.size() < min_reads_per_region_) // Not enough reads to even try
         break;
@@ -918,7 +1051,7 @@ void PhaseEstimator::EstimatorWorker()
       s.ie = parameters[1];
       s.dr = parameters[2];
 
-      printf("Completed (%d,%d,%d) :(%2d-%2d)x(%2d-%2d), total time %5.2lf sec, i/o time %5.2lf sec, %d reads, CF=%1.2f%% IE=%1.2f%% DR=%1.2f%%\n",
+      printf("Completed (%d,%d,%d) :(%2d-%2d)x(%2d-%2d), total time %5.2lf sec, load wait %5.2lf sec, %d reads, CF=%1.2f%% IE=%1.2f%% DR=%1.2f%%\n",
           s.level, s.pos_x, s.pos_y, s.begin_x, s.end_x, s.begin_y, s.end_y,
           (double)timer.GetMicroSec()/1000000.0, (double)iotimer/1000000.0, (int)useful_reads.size(),
           100.0*s.cf, 100.0*s.ie, 100.0*s.dr);
@@ -951,11 +1084,13 @@ void PhaseEstimator::EstimatorWorker()
     }
 
 
-    if (s.subblocks[0] == NULL or useful_reads.size() < 4*min_reads_per_region_) {
-      // Do not subdivide this block
-      for (vector<int>::iterator region = s.sorted_regions.begin(); region != s.sorted_regions.end(); ++region)
-        region_reads_[*region].clear();
+    bool subdivide = s.subblocks[0] != NULL and useful_reads.size() >= 4*min_reads_per_region_;
+    // Subblocks keep the reads of their superblock, only the final ones release them
+    StopPrefetch(s, not subdivide);
+    job_time += job_timer.GetMicroSec();
 
+    if (not subdivide) {
+      // Do not subdivide this block
       pthread_mutex_lock(&job_queue_mutex_);
       jobs_in_progress_--;
       if (jobs_in_progress_ == 0)  // No more work, let everyone know
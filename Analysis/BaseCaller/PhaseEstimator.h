@@ -109,8 +109,19 @@ protected:
   //! @details  Upon fetching the next available Subblock from the job queue,
   //!           performs solving and Nelder-Mead-based phasing estimation
   //!           and possibly adds the further-partitioned subblocks to the queue.
+  //!           Reads come from the region loader, workers never touch the wells file.
   void EstimatorWorker();
 
+  //! @brief    Pthread wrapper for calling RegionLoader
+  //! @param    arg                 Pointer to PhaseEstimator
+  static void *RegionLoaderWrapper(void *arg);
+
+  //! @brief    Region loader thread.
+  //! @details  Reads and key-normalizes the regions of the subblocks being estimated,
+  //!           in their order of fetching preference, staying at most kPrefetchRegions
+  //!           regions ahead of each worker.
+  void RegionLoader();
+
   //! @brief    Makes sure the reads in specified region are loaded into memory
   //! @param    region              Requested region index
   //! @return   Time in microseconds to complete the I/O
@@ -155,11 +166,30 @@ protected:
     float               ie;                       //!< Incomplete extension estimate
     float               dr;                       //!< Droop estimate
     vector<int>         sorted_regions;           //!< Chunks comprising this subblock, in the order of fetching preference
+    // Region loader bookkeeping, under region_loader_mutex_
+    size_t              next_load;                //!< Index into sorted_regions of the next chunk to load
+    size_t              next_use;                 //!< Index into sorted_regions of the chunk the worker waits for
+    int                 loads_in_flight;          //!< Chunks of this subblock being loaded right now
     // Partition tree
     Subblock*           subblocks[4];             //!< Subblocks resulting from partitioning this block
     Subblock*           superblock;               //!< Parent block
   };
 
+  //! @brief    Hand the regions of a subblock to the region loader
+  //! @param    s                   Subblock a worker is about to estimate
+  void StartPrefetch(Subblock& s);
+
+  //! @brief    Block until a region of the subblock is loaded
+  //! @param    s                   Subblock being estimated
+  //! @param    idx                 Index into s.sorted_regions
+  //! @return   Time in microseconds spent waiting
+  size_t WaitForRegion(Subblock& s, size_t idx);
+
+  //! @brief    Withdraw a subblock from the region loader, waiting for its load in progress
+  //! @param    s                   Subblock done with estimation
+  //! @param    release_regions     Also free the reads of all its regions
+  void StopPrefetch(Subblock& s, bool release_regions);
+
   // Parameters needed by the static EvaluateParameters() function
 
   static bool           norm_during_param_eval_;  //!< Turn normalization during parameter estimation step off.
@@ -208,7 +238,15 @@ protected:
   int                   num_regions_;             //!< Total number of chunks on the chip
   vector<unsigned int>  region_num_reads_;        //!< Number of usable reads for each chunk
   vector<vector<BasecallerRead> > region_reads_;  //!< Storage for loaded reads for each chunk
-  pthread_mutex_t       region_loader_mutex_;     //!< Wells reading mutex
+  vector<char>          region_state_;            //!< Per chunk: 0 = not loaded, 1 = loading, 2 = loaded
+  vector<Subblock*>     prefetch_jobs_;           //!< Subblocks whose chunks the region loader is fetching
+  bool                  region_loader_stop_;      //!< Tells the region loader to exit
+  int                   num_regions_loaded_;      //!< Number of chunks read by the region loader
+  size_t                region_load_time_;        //!< Microseconds the region loader spent reading and normalizing
+  int                   next_worker_id_;          //!< Numbers the estimator workers for their timing report
+  pthread_mutex_t       region_loader_mutex_;     //!< Protects region_state_, prefetch_jobs_ and subblock loader bookkeeping
+  pthread_cond_t        region_loader_cond_;      //!< Wakes up the region loader when a worker needs more chunks
+  pthread_cond_t        region_ready_cond_;       //!< Wakes up workers when a chunk has been loaded
   pthread_mutex_t       job_queue_mutex_;         //!< Job queue access mutex
   pthread_cond_t        job_queue_cond_;          //!< Signaling variable to wake up workers
   deque<Subblock*>      job_queue_;               //!< Queue of subblocks awaiting estimation
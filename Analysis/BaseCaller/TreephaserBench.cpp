@@ -0,0 +1,118 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+
+//! @file     TreephaserBench.cpp
+//! @ingroup  BaseCaller
+//! @brief    Single-core throughput of the BaseCaller treephasers on simulated reads
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "DPTreephaser.h"
+#include "TreephaserSSE.h"
+
+using namespace std;
+
+namespace {
+
+void PrintHelp()
+{
+  printf ("Usage: TreephaserBench [options]\n");
+  printf ("  -n num_reads     Number of simulated reads (default 20000)\n");
+  printf ("  -f num_flows     Number of flows per read (default 400)\n");
+  printf ("  -s seed          Random seed (default 1)\n");
+  exit (EXIT_SUCCESS);
+}
+
+float Gaussian()
+{
+  float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+  return sqrt(-2.0f * log(u1)) * cos(2.0f * M_PI * u2);
+}
+
+double Seconds(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+};
+
+
+int main(int argc, char *argv[])
+{
+  int num_reads = 20000;
+  int num_flows = 400;
+  int seed = 1;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-n" and i+1 < argc)
+      num_reads = atoi(argv[++i]);
+    else if (arg == "-f" and i+1 < argc)
+      num_flows = atoi(argv[++i]);
+    else if (arg == "-s" and i+1 < argc)
+      seed = atoi(argv[++i]);
+    else
+      PrintHelp();
+  }
+  if (num_reads <= 0 or num_flows <= 0)
+    PrintHelp();
+  srand(seed);
+
+  ion::FlowOrder flow_order("TACGTACGTCTGAGCATCGATCGATGTACAGC", num_flows);
+  const int window_size = DPTreephaser::kWindowSizeDefault_;
+
+  // Simulate reads with random sequence, phasing and noise
+  printf("Simulating %d reads of %d flows\n", num_reads, num_flows);
+  DPTreephaser simulator(flow_order, window_size);
+  vector<BasecallerRead> reads(num_reads);
+  vector<float> cf(num_reads), ie(num_reads);
+  for (int r = 0; r < num_reads; ++r) {
+    static const char nucs[5] = "ACGT";
+    BasecallerRead& read = reads[r];
+    read.sequence.clear();
+    for (int base = 0; base < 2*num_flows; ++base)
+      read.sequence.push_back(nucs[rand() % 4]);
+    read.prediction.assign(num_flows, 0);
+    read.state_inphase.assign(num_flows, 0);
+    cf[r] = 0.005f + 0.01f * rand() / RAND_MAX;
+    ie[r] = 0.005f + 0.01f * rand() / RAND_MAX;
+    simulator.SetModelParameters(cf[r], ie[r], 0.0);
+    simulator.Simulate(read, num_flows);
+    vector<float> signal(num_flows);
+    for (int flow = 0; flow < num_flows; ++flow)
+      signal[flow] = (0.1f + 0.95f * read.prediction[flow] + 0.08f * Gaussian()) * (1.0f + 0.001f * flow);
+    read.SetData(signal, num_flows);
+  }
+
+  // One solver per thread, as used by a BaseCaller worker
+  vector<BasecallerRead> dp_reads = reads;
+  DPTreephaser treephaser_dp(flow_order, window_size);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int r = 0; r < num_reads; ++r) {
+    treephaser_dp.SetModelParameters(cf[r], ie[r], 0.0);
+    treephaser_dp.NormalizeAndSolve_SWnorm(dp_reads[r], num_flows);
+  }
+  double dp_seconds = Seconds(start);
+  printf("DPTreephaser  : %10.0f reads/sec\n", num_reads / dp_seconds);
+
+  vector<BasecallerRead> sse_reads = reads;
+  TreephaserSSE treephaser_sse(flow_order, window_size);
+  start = chrono::steady_clock::now();
+  for (int r = 0; r < num_reads; ++r) {
+    treephaser_sse.SetModelParameters(cf[r], ie[r]);
+    treephaser_sse.NormalizeAndSolve(sse_reads[r]);
+  }
+  double sse_seconds = Seconds(start);
+
+  int same_sequence = 0;
+  for (int r = 0; r < num_reads; ++r)
+    if (sse_reads[r].sequence == dp_reads[r].sequence)
+      same_sequence++;
+  printf("TreephaserSSE : %10.0f reads/sec  speedup %.2fx  same sequence as DPTreephaser %d/%d\n",
+         num_reads / sse_seconds, dp_seconds / sse_seconds, same_sequence, num_reads);
+  return EXIT_SUCCESS;
+}
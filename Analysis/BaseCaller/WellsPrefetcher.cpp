@@ -0,0 +1,205 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+
+//! @file     WellsPrefetcher.cpp
+//! @ingroup  BaseCaller
+//! @brief    WellsPrefetcher. Lock-free region dispenser and read-ahead of wells data for BaseCaller workers
+
+#include "WellsPrefetcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+using namespace std;
+
+
+WellsPrefetcher::WellsPrefetcher()
+  : num_flows_(0), next_batch_(0), started_(false)
+{
+  pthread_mutex_init(&slot_mutex_, NULL);
+  pthread_cond_init(&slot_loaded_cond_, NULL);
+  pthread_cond_init(&slot_free_cond_, NULL);
+}
+
+WellsPrefetcher::~WellsPrefetcher()
+{
+  Close();
+  pthread_cond_destroy(&slot_free_cond_);
+  pthread_cond_destroy(&slot_loaded_cond_);
+  pthread_mutex_destroy(&slot_mutex_);
+}
+
+// ----------------------------------------------------------------------------
+
+void WellsPrefetcher::Open(const string& filename_wells, const ion::ChipSubset& chip_subset, const vector<int>& class_map,
+                           int num_flows, int chunk_rows, int chunk_cols, int num_workers)
+{
+  filename_wells_ = filename_wells;
+  num_flows_ = num_flows;
+
+  int chip_size_x   = chip_subset.GetChipSizeX();
+  int chip_size_y   = chip_subset.GetChipSizeY();
+  int region_size_x = chip_subset.GetRegionSizeX();
+  int region_size_y = chip_subset.GetRegionSizeY();
+  int num_regions_x = chip_subset.GetNumRegionsX();
+  int num_regions_y = chip_subset.GetNumRegionsY();
+
+  // A batch is a tile of regions covering one HDF5 chunk of the wells file.
+  // With the default region size every batch holds exactly one region.
+  int tile_x = max(1, chunk_cols / max(1, region_size_x));
+  int tile_y = max(1, chunk_rows / max(1, region_size_y));
+
+  schedule_.clear();
+  batch_begin_.clear();
+  position_of_region_.assign(num_regions_x * num_regions_y, -1);
+  int max_batch_size = 1;
+
+  for (int tile_begin_y = 0; tile_begin_y < num_regions_y; tile_begin_y += tile_y) {
+    for (int tile_begin_x = 0; tile_begin_x < num_regions_x; tile_begin_x += tile_x) {
+      batch_begin_.push_back(schedule_.size());
+      for (int region_y = tile_begin_y; region_y < min(tile_begin_y + tile_y, num_regions_y); ++region_y) {
+        for (int region_x = tile_begin_x; region_x < min(tile_begin_x + tile_x, num_regions_x); ++region_x) {
+          WellsRegion r;
+          r.region  = region_x + region_y * num_regions_x;
+          r.begin_x = region_x * region_size_x;
+          r.begin_y = region_y * region_size_y;
+          r.end_x   = min(r.begin_x + region_size_x, chip_size_x);
+          r.end_y   = min(r.begin_y + region_size_y, chip_size_y);
+          r.num_usable_wells = 0;
+          for (int y = r.begin_y; y < r.end_y; ++y)
+            for (int x = r.begin_x; x < r.end_x; ++x)
+              if (class_map[x + y * chip_size_x] >= 0)
+                r.num_usable_wells++;
+          position_of_region_[r.region] = schedule_.size();
+          schedule_.push_back(r);
+        }
+      }
+      max_batch_size = max(max_batch_size, (int)schedule_.size() - batch_begin_.back());
+    }
+  }
+  batch_begin_.push_back(schedule_.size());
+  next_batch_.store(0);
+
+  vector<atomic<int> > region_done(schedule_.size());
+  region_done_.swap(region_done);
+  for (unsigned int region = 0; region < region_done_.size(); ++region)
+    region_done_[region].store(0);
+
+  // Enough slots for every worker to hold a full batch while the next one is read.
+  // Capped so that tiny regions do not lead to an excessive number of open wells files.
+  int num_slots = min((num_workers + 1) * max_batch_size, 4 * (num_workers + 1));
+  num_slots = max(1, min(num_slots, (int)schedule_.size()));
+
+  slots_.resize(num_slots, NULL);
+  for (int slot = 0; slot < num_slots; ++slot) {
+    slots_[slot] = new RawWells("", filename_wells_.c_str());
+    slots_[slot]->OpenForIncrementalRead();
+  }
+  slot_position_.assign(num_slots, -1);
+  slot_loaded_.assign(num_slots, false);
+}
+
+// ----------------------------------------------------------------------------
+
+void WellsPrefetcher::Start()
+{
+  if (pthread_create(&prefetch_thread_, NULL, PrefetchThread, this)) {
+    printf("*Error* - problem starting wells prefetch thread\n");
+    exit (EXIT_FAILURE);
+  }
+  started_ = true;
+}
+
+// ----------------------------------------------------------------------------
+
+void WellsPrefetcher::Close()
+{
+  if (started_) {
+    pthread_join(prefetch_thread_, NULL);
+    started_ = false;
+  }
+  for (unsigned int slot = 0; slot < slots_.size(); ++slot) {
+    slots_[slot]->Close();
+    delete slots_[slot];
+  }
+  slots_.clear();
+}
+
+// ----------------------------------------------------------------------------
+
+bool WellsPrefetcher::GetNextBatch(int& first, int& last)
+{
+  int batch = next_batch_.fetch_add(1, memory_order_relaxed);
+  if (batch + 1 >= (int)batch_begin_.size())
+    return false;
+  first = batch_begin_[batch];
+  last  = batch_begin_[batch+1];
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+
+RawWells * WellsPrefetcher::AcquireWells(int position)
+{
+  if (schedule_[position].num_usable_wells == 0)
+    return NULL;
+
+  int slot = position % slots_.size();
+  pthread_mutex_lock(&slot_mutex_);
+  while (slot_position_[slot] != position or not slot_loaded_[slot])
+    pthread_cond_wait(&slot_loaded_cond_, &slot_mutex_);
+  pthread_mutex_unlock(&slot_mutex_);
+  return slots_[slot];
+}
+
+// ----------------------------------------------------------------------------
+
+void WellsPrefetcher::ReleaseWells(int position)
+{
+  if (schedule_[position].num_usable_wells > 0) {
+    int slot = position % slots_.size();
+    pthread_mutex_lock(&slot_mutex_);
+    slot_position_[slot] = -1;
+    slot_loaded_[slot] = false;
+    pthread_cond_signal(&slot_free_cond_);
+    pthread_mutex_unlock(&slot_mutex_);
+  }
+  region_done_[schedule_[position].region].store(1, memory_order_release);
+}
+
+// ----------------------------------------------------------------------------
+
+void * WellsPrefetcher::PrefetchThread(void *input)
+{
+  static_cast<WellsPrefetcher*>(input)->PrefetchLoop();
+  return NULL;
+}
+
+// Walks the schedule in claim order. A slot is reused only after the earlier position held in it is
+// released, and workers process their batches in schedule order, so the reader can never deadlock them.
+
+void WellsPrefetcher::PrefetchLoop()
+{
+  for (int position = 0; position < (int)schedule_.size(); ++position) {
+    const WellsRegion& r = schedule_[position];
+    if (r.num_usable_wells == 0)
+      continue;
+
+    int slot = position % slots_.size();
+    pthread_mutex_lock(&slot_mutex_);
+    while (slot_position_[slot] != -1)
+      pthread_cond_wait(&slot_free_cond_, &slot_mutex_);
+    slot_position_[slot] = position;
+    pthread_mutex_unlock(&slot_mutex_);
+
+    RawWells *wells = slots_[slot];
+    wells->SetChunk(r.begin_y, r.end_y - r.begin_y, r.begin_x, r.end_x - r.begin_x, 0, num_flows_);
+    wells->ReadWells();
+
+    pthread_mutex_lock(&slot_mutex_);
+    slot_loaded_[slot] = true;
+    pthread_cond_broadcast(&slot_loaded_cond_);
+    pthread_mutex_unlock(&slot_mutex_);
+  }
+}
+
@@ -0,0 +1,116 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+
+//! @file     WellsPrefetcher.h
+//! @ingroup  BaseCaller
+//! @brief    WellsPrefetcher. Lock-free region dispenser and read-ahead of wells data for BaseCaller workers
+
+#ifndef WELLSPREFETCHER_H
+#define WELLSPREFETCHER_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <pthread.h>
+
+#include "RawWells.h"
+#include "BaseCallerUtils.h"
+
+using namespace std;
+
+
+//! @brief    Coordinates and bookkeeping of a single BaseCaller region
+//! @ingroup  BaseCaller
+
+struct WellsRegion {
+  int   region;           //!< Region index in row-major order, as expected by OrderedDatasetWriter
+  int   begin_x;          //!< First column of the region
+  int   end_x;            //!< One past the last column of the region
+  int   begin_y;          //!< First row of the region
+  int   end_y;            //!< One past the last row of the region
+  int   num_usable_wells; //!< Number of wells in the region with a valid class_map entry
+};
+
+
+//! @brief    Hands out regions to BaseCaller worker threads and reads their wells data ahead of time
+//! @ingroup  BaseCaller
+//! @details  Regions are scheduled in batches of neighbours that share the same HDF5 chunk of the wells
+//!           file, and batches are claimed with a single atomic increment. A dedicated prefetch thread
+//!           walks the schedule in the same order and loads the wells of each non-empty region into a
+//!           ring of RawWells objects, so workers only block when they get ahead of the reader.
+//!           Workers flag finished regions so that progress can be reported from the main thread.
+
+class WellsPrefetcher {
+public:
+  //! Constructor.
+  WellsPrefetcher();
+  //! Destructor.
+  ~WellsPrefetcher();
+
+  //! @brief  Build the region schedule and open the wells readers.
+  //! @param  filename_wells  Name of the wells file
+  //! @param  chip_subset     Chip and region dimensions
+  //! @param  class_map       Per-well read class, negative values are not processed
+  //! @param  num_flows       Number of flows to read for every well
+  //! @param  chunk_rows      Number of rows of an HDF5 chunk of the wells file
+  //! @param  chunk_cols      Number of columns of an HDF5 chunk of the wells file
+  //! @param  num_workers     Number of worker threads that will consume regions
+  void Open(const string& filename_wells, const ion::ChipSubset& chip_subset, const vector<int>& class_map,
+            int num_flows, int chunk_rows, int chunk_cols, int num_workers);
+
+  //! @brief  Start the prefetch thread.
+  void Start();
+
+  //! @brief  Wait for the prefetch thread to finish and close all wells readers.
+  void Close();
+
+  //! @brief  Claim the next batch of schedule positions. Lock-free and safe to call from any worker.
+  //! @param  first           First claimed schedule position
+  //! @param  last            One past the last claimed schedule position
+  //! @return False once the schedule is exhausted.
+  bool GetNextBatch(int& first, int& last);
+
+  //! @brief  Region at a given schedule position.
+  const WellsRegion& GetRegion(int position) const { return schedule_[position]; }
+
+  //! @brief  Wait until the wells of a scheduled region are loaded.
+  //! @param  position        Schedule position claimed through GetNextBatch
+  //! @return Loaded wells object, or NULL if the region has no usable wells and was not read.
+  RawWells * AcquireWells(int position);
+
+  //! @brief  Return the wells object of a scheduled region and mark the region as done.
+  //! @param  position        Schedule position previously passed to AcquireWells
+  void ReleaseWells(int position);
+
+  //! @brief  Number of usable wells of a region, addressed by its row-major index.
+  int  NumUsableWells(int region) const { return schedule_[position_of_region_[region]].num_usable_wells; }
+
+  //! @brief  True once ReleaseWells was called for a region, addressed by its row-major index.
+  bool IsRegionDone(int region) const { return region_done_[region].load(memory_order_acquire) != 0; }
+
+  //! @brief  Total number of regions in the schedule.
+  int  NumRegions() const { return (int)schedule_.size(); }
+
+private:
+  static void * PrefetchThread(void *input);
+  void          PrefetchLoop();
+
+  string                  filename_wells_;      //!< Name of the wells file, kept alive for the RawWells objects
+  int                     num_flows_;           //!< Number of flows to read for every well
+  vector<WellsRegion>     schedule_;            //!< Regions in chunk-friendly processing order
+  vector<int>             batch_begin_;         //!< Schedule position of the first region of every batch, plus end marker
+  vector<int>             position_of_region_;  //!< Schedule position of every row-major region index
+  atomic<int>             next_batch_;          //!< Index of the next unclaimed batch
+  vector<atomic<int> >    region_done_;         //!< Per-region completion flags, indexed by row-major region
+
+  vector<RawWells*>       slots_;               //!< Ring of wells readers; position p always lives in slot p % size
+  vector<int>             slot_position_;       //!< Schedule position held by each slot, -1 if free
+  vector<bool>            slot_loaded_;         //!< Whether the data of the held position has been read
+  pthread_mutex_t         slot_mutex_;          //!< Protects the slot bookkeeping
+  pthread_cond_t          slot_loaded_cond_;    //!< Signalled when the prefetcher finishes a slot
+  pthread_cond_t          slot_free_cond_;      //!< Signalled when a worker releases a slot
+  pthread_t               prefetch_thread_;     //!< Prefetch thread handle
+  bool                    started_;             //!< Whether the prefetch thread is running
+};
+
+
+#endif // WELLSPREFETCHER_H
@@ -0,0 +1,37 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#include "BeadParamsColumns.h"
+
+// planes are padded to a whole number of 512 bit vectors
+#define BEAD_STRIDE_ALIGN 16
+
+void BeadParamsColumns::Allocate(int _num_beads, int _flow_block_size)
+{
+  num_beads = _num_beads;
+  flow_block_size = _flow_block_size;
+  bead_stride = ((num_beads + BEAD_STRIDE_ALIGN - 1) / BEAD_STRIDE_ALIGN) * BEAD_STRIDE_ALIGN;
+  values.resize((size_t)(NUM_BEAD_PLANES + flow_block_size) * bead_stride);
+}
+
+void BeadParamsColumns::Gather(const BeadParams *params, int _num_beads, int _flow_block_size)
+{
+  Allocate(_num_beads, _flow_block_size);
+
+  float *copies = Plane(Copies);
+  float *R_     = Plane(R);
+  float *phi    = Plane(Phi);
+  for (int ibd=0; ibd<num_beads; ibd++)
+  {
+    const BeadParams &p = params[ibd];
+    copies[ibd] = p.Copies;
+    R_[ibd]     = p.R;
+    phi[ibd]    = p.phi;
+  }
+
+  // walk the Ampl planes one flow at a time, each bead record stays in cache for a few flows
+  for (int fnum=0; fnum<flow_block_size; fnum++)
+  {
+    float *ampl = Ampl(fnum);
+    for (int ibd=0; ibd<num_beads; ibd++)
+      ampl[ibd] = params[ibd].Ampl[fnum];
+  }
+}
@@ -0,0 +1,47 @@
+/* Copyright (C) 2012 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef BEADPARAMSCOLUMNS_H
+#define BEADPARAMSCOLUMNS_H
+
+#include <vector>
+#include "BeadParams.h"
+
+// Structure-of-arrays copy of the bead parameters that RefineFit reads to precompute the
+// per-flow constants of the single flow fits of a region: Copies, R, phi and every flow of Ampl.
+// Each is one contiguous plane indexed by bead, so that loops over beads run at unit stride
+// and can be vectorized. BeadParams stays the canonical per-bead record that the fitters work
+// on; Gather takes a read-only snapshot of a region.
+class BeadParamsColumns
+{
+  public:
+    enum BeadPlanes {
+      Copies = 0,
+      R,
+      Phi,
+      NUM_BEAD_PLANES
+    };
+
+    BeadParamsColumns() : num_beads(0), bead_stride(0), flow_block_size(0) {}
+
+    // Size the planes for a region, contents are undefined until the next Gather
+    void  Allocate(int _num_beads, int _flow_block_size);
+
+    // Copy the parameters of beads [0, num_beads) into the planes
+    void  Gather(const BeadParams *params, int _num_beads, int _flow_block_size);
+
+    int   NumBeads() const      { return num_beads; }
+    int   FlowBlockSize() const { return flow_block_size; }
+
+    // Planes hold NumBeads() values, padded to a multiple of the widest SIMD vector
+    float *       Plane(int plane)       { return &values[plane*bead_stride]; }
+    const float * Plane(int plane) const { return &values[plane*bead_stride]; }
+    float *       Ampl(int fnum)         { return Plane(NUM_BEAD_PLANES + fnum); }
+    const float * Ampl(int fnum) const   { return Plane(NUM_BEAD_PLANES + fnum); }
+
+  private:
+    int num_beads;
+    int bead_stride;
+    int flow_block_size;
+    std::vector<float> values;
+};
+
+#endif // BEADPARAMSCOLUMNS_H
@@ -514,6 +514,13 @@ void BeadTracker::CompensateAmplitudeForEmptyWellNormalization(float *my_scale_b
 }
 
 //for all bead
+void BeadTracker::GatherColumns(int flow_block_size)
+{
+  columns.Allocate(numLBeads, flow_block_size);
+  if (numLBeads > 0)
+    columns.Gather(&params_nn[0], numLBeads, flow_block_size);
+}
+
 void BeadTracker::AssignEmphasisForAllBeads (int _max_emphasis)
 {
   max_emphasis = _max_emphasis;
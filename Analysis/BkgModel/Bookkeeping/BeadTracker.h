@@ -6,6 +6,7 @@
 #include <vector>
 #include "BkgMagicDefines.h"
 #include "BeadParams.h"
+#include "BeadParamsColumns.h"
 #include "Mask.h"
 #include "Region.h"
 #include "SpecialDataTypes.h"
@@ -32,6 +33,8 @@ public:
     bound_params params_high;
     bound_params params_low;
     std::vector<BeadParams>  params_nn;
+    // columnar copy of the params_nn values RefineFit precomputes flow constants from, not serialized
+    BeadParamsColumns columns;
     std::vector<SequenceItem> seqList;
     int numSeqListItems;
 
@@ -153,6 +156,9 @@ public:
     void CorruptedBeadsAreLowQuality ();
     void TypicalBeadParams(BeadParams *p);
 
+    // refresh columns from params_nn
+    void  GatherColumns(int flow_block_size);
+
     void CompensateAmplitudeForEmptyWellNormalization(float *my_scale_buffer, int flow_block_size);
     //void DumpHits(int offset_col, int offset_row, int flow);
     void AssignBarcodeState(bool do_all, float basic_threshold, float tie_threshold, int flow_block_size, int flow_block_start);
@@ -171,6 +171,31 @@ float reg_params::AdjustEmptyToBeadRatioForFlow(float etbR_original, float Ampl,
     return(xAdjustEmptyToBeadRatioForFlow(etbR_original, Ampl, Copy, phi, NucModifyRatio[nuc_id], RatioDrift, flow, use_alternative_etbR_equation));
 }
 
+// The model is chosen once per column so that the loops over beads inline and vectorize.
+// Gives the same values as AdjustEmptyToBeadRatioForFlow and ComputeTauBfromEmptyUsingRegionLinearModel.
+void reg_params::BeadRatioAndTauBForFlow(const float *R, const float *Ampl, const float *Copy, const float *phi, int num_beads,
+                                         int nuc_id, int flow, float *etbR, float *tauB) const
+{
+  if (safe_model){
+    for (int ibd=0; ibd<num_beads; ibd++){
+      etbR[ibd] = xSafeEmptyToBeadRatioForFlow(R[ibd],NucModifyRatio[nuc_id],RatioDrift,flow);
+      tauB[ibd] = xSafeTauBFromRegionLinearModel(tau_R_m,tau_R_o,etbR[ibd],min_tauB,max_tauB);
+    }
+  }
+  else if (fit_taue){
+    for (int ibd=0; ibd<num_beads; ibd++){
+      etbR[ibd] = xAdjustEmptyToBeadRatioForFlowWithAdjR(R[ibd],NucModifyRatio[nuc_id],RatioDrift,flow);
+      tauB[ibd] = xComputeTauBfromEmptyUsingRegionLinearModelWithAdjR(tauE,etbR[ibd],min_tauB,max_tauB);
+    }
+  }
+  else {
+    for (int ibd=0; ibd<num_beads; ibd++){
+      etbR[ibd] = xAdjustEmptyToBeadRatioForFlow(R[ibd],Ampl[ibd],Copy[ibd],phi[ibd],NucModifyRatio[nuc_id],RatioDrift,flow,use_alternative_etbR_equation);
+      tauB[ibd] = xComputeTauBfromEmptyUsingRegionLinearModel(tau_R_m,tau_R_o,etbR[ibd],min_tauB,max_tauB);
+    }
+  }
+}
+
 
 void reg_params::SetStandardHigh( float t0_start, int flow_block_size)
 {
@@ -154,6 +154,9 @@ struct reg_params
   // Region level models dependent only on regional parameters
   float ComputeTauBfromEmptyUsingRegionLinearModel(float etbR) const;
   float AdjustEmptyToBeadRatioForFlow(float etbR_original, float Ampl, float Copy, float phi, int nuc_id, int flow) const;
+  // both of the above for a column of beads in one flow
+  void  BeadRatioAndTauBForFlow(const float *R, const float *Ampl, const float *Copy, const float *phi, int num_beads,
+                                int nuc_id, int flow, float *etbR, float *tauB) const;
   float CalculateCopyDrift(int absolute_flow) const;
 
   float * AccessD()                   { return d; }
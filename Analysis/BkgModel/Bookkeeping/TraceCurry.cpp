@@ -59,6 +59,22 @@ float TraceCurry::GuessAmplitude(float *red_obs)
 void TraceCurry::SetWellRegionParams (struct BeadParams *_p,struct reg_params *_rp,int _fnum,
                                       int _nnum,int _flow,
                                       int _i_start,float *_c_dntp_top)
+{
+    BeadFlowConstants bead_flow;
+
+    // since this uses a library function..and the parameters involved aren't fit
+    // it's helpful to compute this once and not in the model function
+    bead_flow.SP = (float) (COPYMULTIPLIER * _p->Copies) *_rp->CalculateCopyDrift(_flow);
+
+    bead_flow.etbR = _rp->AdjustEmptyToBeadRatioForFlow (_p->R, _p->Ampl[_fnum], _p->Copies, _p->phi, _nnum, _flow);
+    bead_flow.tauB = _rp->ComputeTauBfromEmptyUsingRegionLinearModel (bead_flow.etbR);
+
+    SetWellRegionParams (_p, _rp, _fnum, _nnum, _flow, _i_start, _c_dntp_top, bead_flow);
+}
+
+void TraceCurry::SetWellRegionParams (struct BeadParams *_p,struct reg_params *_rp,int _fnum,
+                                      int _nnum,int _flow,
+                                      int _i_start,float *_c_dntp_top, const BeadFlowConstants &bead_flow)
 {
     p = _p;
     reg_p = _rp;
@@ -66,13 +82,9 @@ void TraceCurry::SetWellRegionParams (struct BeadParams *_p,struct reg_params *_
     NucID = _nnum;
     flow = _flow;
 
-
-    // since this uses a library function..and the parameters involved aren't fit
-    // it's helpful to compute this once and not in the model function
-    SP = (float) (COPYMULTIPLIER * p->Copies) *reg_p->CalculateCopyDrift(flow);
-
-    etbR = reg_p->AdjustEmptyToBeadRatioForFlow (p->R, p->Ampl[fnum], p->Copies, p->phi, NucID, flow);
-    tauB = reg_p->ComputeTauBfromEmptyUsingRegionLinearModel (etbR);
+    SP = bead_flow.SP;
+    etbR = bead_flow.etbR;
+    tauB = bead_flow.tauB;
 
     sens = reg_p->sens*SENSMULTIPLIER;
     molecules_to_micromolar_conversion = reg_p->molecules_to_micromolar_conversion;
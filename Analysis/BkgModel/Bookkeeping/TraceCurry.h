@@ -8,6 +8,15 @@
 #include "Region.h"
 #include "MathOptim.h"
 #include "DiffEqModel.h"
+// per bead, per flow constants of the incorporation trace that do not depend on the fitted values
+// computed ahead for a whole region by RefineFit
+struct BeadFlowConstants
+{
+  float SP;
+  float etbR;
+  float tauB;
+};
+
 // this object will "curry" a compute trace command by holding parameters that aren't being actively changed
 
 class TraceCurry
@@ -55,6 +64,9 @@ class TraceCurry
     void SetWellRegionParams (struct BeadParams *_p,struct reg_params *_rp,int _fnum,
                               int _nnum,int _flow,
                               int _i_start,float *_c_dntp_top);
+    void SetWellRegionParams (struct BeadParams *_p,struct reg_params *_rp,int _fnum,
+                              int _nnum,int _flow,
+                              int _i_start,float *_c_dntp_top, const BeadFlowConstants &bead_flow);
 
     void  SetContextParams(int _i_start, float *c_dntp_top, int _sub_steps, float _C,
                            float _SP, float _region_kr, float _kmax, float _d, float _sens, float _gain, float _tauB);
@@ -67,10 +67,16 @@ void RefineFit::FitAmplitudePerBeadPerFlow (int ibd, NucStep &cache_step, int fl
     float *signal_corrected = &block_signal_corrected[fnum*bkg.region_data->time_c.npts()];
     float *signal_predicted = &block_signal_predicted[fnum*bkg.region_data->time_c.npts()];
     int NucID = bkg.region_data_extras.my_flow->flow_ndx_map[fnum];
+    int ndx = fnum*bkg.region_data->my_beads.numLBeads + ibd;
+    BeadFlowConstants bead_flow;
+    bead_flow.SP = flow_SP[ndx];
+    bead_flow.etbR = flow_etbR[ndx];
+    bead_flow.tauB = flow_tauB[ndx];
     err_t.fit_type[fnum] =
         my_single_fit.FitOneFlow (fnum,evect,p,&err_t, signal_corrected,signal_predicted,
                                   NucID,cache_step.NucFineStep (fnum),cache_step.i_start_fine_step[fnum],
-                                  flow_block_start,bkg.region_data->emphasis_data,bkg.region_data->my_regions);
+                                  flow_block_start,bkg.region_data->emphasis_data,bkg.region_data->my_regions,
+                                  &bead_flow);
     err_t.t_mid_nuc_actual[fnum] = cache_step.t_mid_nuc_actual[fnum];
     err_t.t_sigma_actual[fnum] = cache_step.t_sigma_actual[fnum];
   }
@@ -236,6 +242,40 @@ void RefineFit::CrazyDumpRegionSamples(BeadParams *p, int ibd, float * block_sig
 
 
 
+// The bead and region parameters that set up each single flow fit are fixed while the amplitudes are fit,
+// so compute SP, etbR and tauB for the whole region up front, one flow at a time across the bead columns.
+// The fit of a flow only moves the amplitude of that flow, so these match what each fit would compute itself.
+void RefineFit::ComputeBeadFlowConstants (int flow_block_size, int flow_block_start)
+{
+  BeadTracker &my_beads = bkg.region_data->my_beads;
+  reg_params &rp = bkg.region_data->my_regions.rp;
+  int numLBeads = my_beads.numLBeads;
+
+  my_beads.GatherColumns (flow_block_size);
+  const BeadParamsColumns &columns = my_beads.columns;
+
+  flow_SP.resize (flow_block_size*numLBeads);
+  flow_etbR.resize (flow_block_size*numLBeads);
+  flow_tauB.resize (flow_block_size*numLBeads);
+  if (numLBeads == 0)
+    return;
+
+  for (int fnum=0; fnum<flow_block_size; fnum++)
+  {
+    int flow = flow_block_start + fnum;
+    float copy_drift = rp.CalculateCopyDrift (flow);
+    const float *copies = columns.Plane (BeadParamsColumns::Copies);
+    float *SP = &flow_SP[fnum*numLBeads];
+    for (int ibd=0; ibd<numLBeads; ibd++)
+      SP[ibd] = (float) (COPYMULTIPLIER * copies[ibd]) *copy_drift;
+
+    rp.BeadRatioAndTauBForFlow (columns.Plane (BeadParamsColumns::R), columns.Ampl (fnum), copies,
+                                columns.Plane (BeadParamsColumns::Phi), numLBeads,
+                                bkg.region_data_extras.my_flow->flow_ndx_map[fnum], flow,
+                                &flow_etbR[fnum*numLBeads], &flow_tauB[fnum*numLBeads]);
+  }
+}
+
 // fits all wells one flow at a time, using a LevMarFitter derived class
 // only the amplitude term is fit
 void RefineFit::FitAmplitudePerFlow ( int flow_block_size, int flow_block_start )
@@ -253,6 +293,7 @@ void RefineFit::FitAmplitudePerFlow ( int flow_block_size, int flow_block_start
 
   
   my_single_fit.SetUpEmphasisForLevMarOptimizer(&(bkg.region_data->emphasis_data));
+  ComputeBeadFlowConstants (flow_block_size, flow_block_start);
 
   for (int ibd = 0;ibd < bkg.region_data->my_beads.numLBeads;ibd++)
   {
@@ -19,6 +19,7 @@ class RefineFit
     void InitSingleFlowFit();
     void FitAmplitudePerFlow ( int flow_block_size, int flow_block_start );
     void FitAmplitudePerBeadPerFlow (int ibd, NucStep &cache_step, int flow_block_size, int flow_block_start);
+    void ComputeBeadFlowConstants (int flow_block_size, int flow_block_start);
     void SetupLocalEmphasis();
 
     void CrazyDumpToHDF5(BeadParams *p, int ibd, float * block_signal_predicted, float *block_signal_corrected, float *block_signal_original, float *block_signal_sbg,error_track &err_t, int flow_block_start );
@@ -27,6 +28,12 @@ class RefineFit
     void CrazyDumpXyFlow(BeadParams *p, int ibd, float * block_signal_predicted, float *block_signal_corrected, float *block_signal_original, float *block_signal_sbg,error_track &err_t, int flow_block_start );
     void CrazyDumpRegionSamples(BeadParams *p, int ibd, float * block_signal_predicted, float *block_signal_corrected, float *block_signal_original, float *block_signal_sbg,error_track &err_t, int flow_block_start );
       ~RefineFit();
+
+  private:
+    // trace constants that do not change during the single flow fit, one plane per flow indexed by bead
+    std::vector<float> flow_SP;
+    std::vector<float> flow_etbR;
+    std::vector<float> flow_tauB;
 };
 
 #endif // REFINEFIT_H
@@ -113,12 +113,18 @@ void single_flow_optimizer::AllocLevMar (TimeCompression &time_c, PoissonCDFAppr
 }
 
 void single_flow_optimizer::BringUpOptimizer(BkgModSingleFlowFit *OneFit, int fnum, float *evect, BeadParams *p,  int NucID, float *lnucRise, int l_i_start,
-                                             int flow_block_start, RegionTracker &my_regions){
+                                             int flow_block_start, RegionTracker &my_regions,
+                                             const BeadFlowConstants *bead_flow){
   OneFit->SetWeightVector (evect);
   OneFit->SetLambdaStart (1E-20);
-  OneFit->calc_trace.SetWellRegionParams (p,&my_regions.rp,fnum,
-                                          NucID, flow_block_start + fnum,
-                                          l_i_start,lnucRise);
+  if (bead_flow)
+    OneFit->calc_trace.SetWellRegionParams (p,&my_regions.rp,fnum,
+                                            NucID, flow_block_start + fnum,
+                                            l_i_start,lnucRise,*bead_flow);
+  else
+    OneFit->calc_trace.SetWellRegionParams (p,&my_regions.rp,fnum,
+                                            NucID, flow_block_start + fnum,
+                                            l_i_start,lnucRise);
   OneFit->SetFvalCacheEnable (use_fval_cache);
 
   // fills in starting guesses from the bead-param pointer(which is the worst possible way to init?
@@ -172,10 +178,11 @@ void single_flow_optimizer::SpecialStartChooseKmult(int fnum, BeadParams *p, err
 
 
 int single_flow_optimizer::FitKrateOneFlow(int fnum, float *evect, BeadParams *p, error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                                           int flow_block_start, EmphasisClass &emphasis_data,RegionTracker &my_regions)
+                                           int flow_block_start, EmphasisClass &emphasis_data,RegionTracker &my_regions,
+                                           const BeadFlowConstants *bead_flow)
 {
 
-  BringUpOptimizer(oneFlowFitKrate,fnum,evect,p,NucID,lnucRise,l_i_start,flow_block_start, my_regions);
+  BringUpOptimizer(oneFlowFitKrate,fnum,evect,p,NucID,lnucRise,l_i_start,flow_block_start, my_regions, bead_flow);
   SpecialStartChooseKmult(fnum, p, err_t, signal_corrected);
 
   int max_fit_iter = gauss_newton_fit ? NUMSINGLEFLOWITER_GAUSSNEWTON : NUMSINGLEFLOWITER_LEVMAR;
@@ -189,11 +196,12 @@ int single_flow_optimizer::FitKrateOneFlow(int fnum, float *evect, BeadParams *p
 
 
 int single_flow_optimizer::FitThisOneFlow (int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                                           int flow_block_start, EmphasisClass &emphasis_data,RegionTracker &my_regions)
+                                           int flow_block_start, EmphasisClass &emphasis_data,RegionTracker &my_regions,
+                                           const BeadFlowConstants *bead_flow)
 {
   // modify kmult =1 here guarantee
   p->kmult[fnum] = 1.0f; // might start not at kmult=1 even although that is what we are fitting
-  BringUpOptimizer(oneFlowFit,fnum,evect,p,NucID,lnucRise,l_i_start,flow_block_start, my_regions);
+  BringUpOptimizer(oneFlowFit,fnum,evect,p,NucID,lnucRise,l_i_start,flow_block_start, my_regions, bead_flow);
 
   int max_fit_iter = gauss_newton_fit ? NUMSINGLEFLOWITER_GAUSSNEWTON : NUMSINGLEFLOWITER_LEVMAR;
   oneFlowFit->Fit (gauss_newton_fit, max_fit_iter, signal_corrected); // Not enough evidence to warrant krate fitting to this flow, do the simple thing.
@@ -230,7 +238,8 @@ void single_flow_optimizer::ReturnTrackedData(BkgModSingleFlowFit *OneFit,int fn
 
 
 int single_flow_optimizer::FitStandardPath (int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                                            int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions)
+                                            int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions,
+                                            const BeadFlowConstants *bead_flow)
 {
 
   int fitType = FITAMPONLY;
@@ -248,11 +257,11 @@ int single_flow_optimizer::FitStandardPath (int fnum, float *evect, BeadParams *
 
   if (krate_fit)
   {
-    fitType=FitKrateOneFlow (fnum,evect,p,err_t, signal_corrected,signal_predicted, NucID, lnucRise, l_i_start,flow_block_start,emphasis_data,my_regions);
+    fitType=FitKrateOneFlow (fnum,evect,p,err_t, signal_corrected,signal_predicted, NucID, lnucRise, l_i_start,flow_block_start,emphasis_data,my_regions,bead_flow);
   }
   else
   {
-    fitType=FitThisOneFlow (fnum,evect,p, err_t, signal_corrected,signal_predicted, NucID, lnucRise, l_i_start,flow_block_start,emphasis_data,my_regions);
+    fitType=FitThisOneFlow (fnum,evect,p, err_t, signal_corrected,signal_predicted, NucID, lnucRise, l_i_start,flow_block_start,emphasis_data,my_regions,bead_flow);
   }
 
 
@@ -260,11 +269,12 @@ int single_flow_optimizer::FitStandardPath (int fnum, float *evect, BeadParams *
 }
 
 int single_flow_optimizer::FitOneFlow (int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                                       int flow_block_start,EmphasisClass &emphasis_data,RegionTracker &my_regions)
+                                       int flow_block_start,EmphasisClass &emphasis_data,RegionTracker &my_regions,
+                                       const BeadFlowConstants *bead_flow)
 {
   int fitType = 0;
 
-  fitType = FitStandardPath(fnum,evect,p,err_t,signal_corrected, signal_predicted,NucID, lnucRise,l_i_start,flow_block_start, emphasis_data,my_regions);
+  fitType = FitStandardPath(fnum,evect,p,err_t,signal_corrected, signal_predicted,NucID, lnucRise,l_i_start,flow_block_start, emphasis_data,my_regions,bead_flow);
 
   return (fitType);
 }
@@ -69,22 +69,24 @@ class single_flow_optimizer
     void Delete();
 
     // picks from the below options
+    // bead_flow holds precomputed trace constants for this bead and flow, NULL to compute them from p
     int FitOneFlow (int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                    int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions);
+                    int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions,
+                    const BeadFlowConstants *bead_flow = NULL);
     // my different optimizers
     int FitStandardPath (int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-        int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions);
+        int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions, const BeadFlowConstants *bead_flow);
     int FitKrateOneFlow(int fnum, float *evect, BeadParams *p, error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                         int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions);
+                         int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions, const BeadFlowConstants *bead_flow);
     int FitThisOneFlow(int fnum, float *evect, BeadParams *p,  error_track *err_t, float *signal_corrected, float *signal_predicted, int NucID, float *lnucRise, int l_i_start,
-                        int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions);
+                        int flow_block_start,  EmphasisClass &emphasis_data,RegionTracker &my_regions, const BeadFlowConstants *bead_flow);
                                     
     void FillDecisionThreshold(float nuc_threshold);
     int SpecialReFitSlowIncorporations(int fnum, float *evect, BeadParams *p, float *signal_corrected, EmphasisClass &emphasis_data);
     void SpecialStartChooseKmult(int fnum, BeadParams *p, error_track *err_t, float *signal_corrected);
     // initialize relevant concerns
     void BringUpOptimizer(BkgModSingleFlowFit *OneFit, int fnum, float *evect, BeadParams *p,  int NucID, float *lnucRise, int l_i_start,
-                                                 int flow_block_start, RegionTracker &my_regions);
+                                                 int flow_block_start, RegionTracker &my_regions, const BeadFlowConstants *bead_flow);
     void ReturnTrackedData(BkgModSingleFlowFit *OneFit,int fnum,  BeadParams *p, error_track *err_t, float *signal_corrected, float *signal_predicted, EmphasisClass &emphasis_data);
 
 
@@ -6,6 +6,13 @@
 namespace MathModel {
 
 /* Vectorized Routine declarations */
+
+// Every flow of the block is solved, several flows at a time: 16 on CPUs with AVX-512,
+// 8 with AVX2 and 4 otherwise.
+int  DiffEqVecWidth();
+// Solve width flows at a time from now on, or the widest this CPU supports if width is 0.
+// False if the CPU cannot run that width. For tests and benchmarks, not thread safe.
+bool SetDiffEqVecWidth (int width);
  
 void PurpleSolveTotalTrace_Vec( float **vb_out, float **blue_hydrogen, 
     float **red_hydrogen, int len, const float *deltaFrame, float *tauB, float *etbR, 
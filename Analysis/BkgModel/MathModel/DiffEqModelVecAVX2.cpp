@@ -0,0 +1,10 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+
+// 8-wide DiffEqModelVec kernels. Compiled with -mavx2 and only called on CPUs that support it.
+
+#include "DiffEqModelVec.h"
+#include "DiffEqModelVecKernel.h"
+
+const MathModel::DiffEqVecKernels MathModel::diffeq_vec_kernels8 = {
+  8, SolveFlowBlock<8,true,true>, SolveFlowBlock<8,true,false>, SolveFlowBlock<8,false,true>
+};
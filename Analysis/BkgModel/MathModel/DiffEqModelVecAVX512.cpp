@@ -0,0 +1,10 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+
+// 16-wide DiffEqModelVec kernels. Compiled with -mavx512f and only called on CPUs that support it.
+
+#include "DiffEqModelVec.h"
+#include "DiffEqModelVecKernel.h"
+
+const MathModel::DiffEqVecKernels MathModel::diffeq_vec_kernels16 = {
+  16, SolveFlowBlock<16,true,true>, SolveFlowBlock<16,true,false>, SolveFlowBlock<16,false,true>
+};
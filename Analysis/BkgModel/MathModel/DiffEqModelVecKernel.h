@@ -0,0 +1,149 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+
+#ifndef DIFFEQMODELVECKERNEL_H
+#define DIFFEQMODELVECKERNEL_H
+
+// Width-generic kernels behind the *_Vec routines of DiffEqModelVec.h.
+// Only to be included by the translation units that instantiate them, each of them
+// compiled for the instruction set its width needs.
+
+#include "DiffEqModelVec.h"
+
+namespace MathModel {
+
+typedef void (*DiffEqVecSolve) (float * const *vb_out, const float * const *red_hydrogen,
+    const float * const *blue_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, int flow_block_size);
+
+// One set of kernels, all solving W flows of a block at a time. Each instantiating
+// translation unit defines its set as { W, SolveFlowBlock<W,true,true>,
+// SolveFlowBlock<W,true,false>, SolveFlowBlock<W,false,true> }.
+struct DiffEqVecKernels {
+  int            width;
+  DiffEqVecSolve solve_total;   // red and blue hydrogen
+  DiffEqVecSolve solve_red;     // blue_hydrogen and etbR unused
+  DiffEqVecSolve solve_blue;    // red_hydrogen unused
+};
+
+extern const DiffEqVecKernels diffeq_vec_kernels4;
+extern const DiffEqVecKernels diffeq_vec_kernels8;    // DiffEqModelVecAVX2.cpp
+extern const DiffEqVecKernels diffeq_vec_kernels16;   // DiffEqModelVecAVX512.cpp
+
+} // namespace
+
+// Anonymous, so that instantiations built for different instruction sets never get merged
+namespace {
+
+template<int W> struct DiffEqVec {
+  typedef float F __attribute__ ( (vector_size (4*W)));
+};
+
+template<int W>
+inline __attribute__ ( (always_inline)) typename DiffEqVec<W>::F SplatFlows (float val)
+{
+  typename DiffEqVec<W>::F v;
+  for (int l=0; l<W; l++)
+    v[l] = val;
+  return v;
+}
+
+// value of frame i for flows fb..fb+n-1, unused lanes are zero
+template<int W>
+inline __attribute__ ( (always_inline)) typename DiffEqVec<W>::F LoadFlows (const float * const *src, int fb, int n, int i)
+{
+  typename DiffEqVec<W>::F v = SplatFlows<W> (0.0f);
+  for (int l=0; l<n; l++)
+    v[l] = src[fb+l][i];
+  return v;
+}
+
+template<int W>
+inline __attribute__ ( (always_inline)) typename DiffEqVec<W>::F LoadFlowParam (const float *param, int fb, int n)
+{
+  typename DiffEqVec<W>::F v = SplatFlows<W> (1.0f);
+  for (int l=0; l<n; l++)
+    v[l] = param[fb+l];
+  return v;
+}
+
+template<int W>
+inline __attribute__ ( (always_inline)) void StoreFlows (float * const *dst, typename DiffEqVec<W>::F v, int fb, int n, int i)
+{
+  for (int l=0; l<n; l++)
+    dst[fb+l][i] = v[l];
+}
+
+// Red and blue hydrogen in, total trace out, for n <= W flows starting at fb.
+// Either hydrogen source can be compiled out: kRed alone is RedSolveHydrogenFlowInWell,
+// kBlue alone is BlueSolveBackgroundTrace and both is PurpleSolveTotalTrace.
+// The arithmetic is that of the 4-wide SSE code, in the same order.
+template<int W, bool kRed, bool kBlue>
+void SolveFlowGroup (float * const *vb_out, const float * const *red_hydrogen, const float * const *blue_hydrogen,
+    int len, const float *deltaFrame, const float *tauB, const float *etbR, int fb, int n)
+{
+  typedef typename DiffEqVec<W>::F F;
+  const F zero = SplatFlows<W> (0.0f);
+  const F one = SplatFlows<W> (1.0f);
+  const F two = SplatFlows<W> (2.0f);
+
+  // unused lanes compute on tauB=1 and zero hydrogen, and are never stored
+  F tauBV = LoadFlowParam<W> (tauB, fb, n);
+  F etbR_vec = kBlue ? LoadFlowParam<W> (etbR, fb, n) : zero;
+  F one_over_two_tauBV = one/ (two*tauBV);
+
+  F rh_new = zero, bh_new = zero, out_new = zero;
+  for (int i=0; i<len; i++)
+  {
+    F out_old = out_new;
+    F rh_old = rh_new;
+    F bh_old = bh_new;
+
+    F xt = SplatFlows<W> (deltaFrame[i]) *one_over_two_tauBV;
+    F one_over_one_plus_xt = one/ (one+xt);
+
+    if (kRed && kBlue)
+    {
+      rh_new = LoadFlows<W> (red_hydrogen, fb, n, i);
+      bh_new = LoadFlows<W> (blue_hydrogen, fb, n, i);
+      out_new = ( (rh_new-rh_old) + (etbR_vec+xt) *bh_new- (etbR_vec-xt) *bh_old + (one-xt) *out_old) *one_over_one_plus_xt;
+    }
+    else if (kRed)
+    {
+      rh_new = LoadFlows<W> (red_hydrogen, fb, n, i);
+      out_new = ( (rh_new-rh_old) + (one-xt) *out_old) *one_over_one_plus_xt;
+    }
+    else
+    {
+      bh_new = LoadFlows<W> (blue_hydrogen, fb, n, i);
+      out_new = ( (etbR_vec+xt) *bh_new- (etbR_vec-xt) *bh_old + (one-xt) *out_old) *one_over_one_plus_xt;
+    }
+    StoreFlows<W> (vb_out, out_new, fb, n, i);
+  }
+}
+
+// Whole groups of W flows first, what is left over goes to the next narrower width
+// instead of filling a mostly empty wide vector.
+template<int W, bool kRed, bool kBlue>
+void SolveFlows (float * const *vb_out, const float * const *red_hydrogen, const float * const *blue_hydrogen,
+    int len, const float *deltaFrame, const float *tauB, const float *etbR, int fb, int flow_block_size)
+{
+  for (; fb+W <= flow_block_size; fb+=W)
+    SolveFlowGroup<W,kRed,kBlue> (vb_out, red_hydrogen, blue_hydrogen, len, deltaFrame, tauB, etbR, fb, W);
+  if (fb >= flow_block_size)
+    return;
+  if (W > 4)
+    SolveFlows< (W>4 ? W/2 : 4),kRed,kBlue> (vb_out, red_hydrogen, blue_hydrogen, len, deltaFrame, tauB, etbR, fb, flow_block_size);
+  else
+    SolveFlowGroup<W,kRed,kBlue> (vb_out, red_hydrogen, blue_hydrogen, len, deltaFrame, tauB, etbR, fb, flow_block_size-fb);
+}
+
+template<int W, bool kRed, bool kBlue>
+void SolveFlowBlock (float * const *vb_out, const float * const *red_hydrogen, const float * const *blue_hydrogen,
+    int len, const float *deltaFrame, const float *tauB, const float *etbR, int flow_block_size)
+{
+  SolveFlows<W,kRed,kBlue> (vb_out, red_hydrogen, blue_hydrogen, len, deltaFrame, tauB, etbR, 0, flow_block_size);
+}
+
+} // namespace
+
+#endif // DIFFEQMODELVECKERNEL_H
@@ -558,6 +558,13 @@ RegionalizedData::~RegionalizedData()
 {
 }
 
+void RegionalizedData::RelinkSharedState( Region *_region, EmptyTraceTracker *_emptyTraceTracker )
+{
+  region = _region;
+  emptyTraceTracker = _emptyTraceTracker;
+  emptytrace = emptyTraceTracker->GetEmptyTrace (*region);
+}
+
 
 
 
@@ -129,6 +129,9 @@ public:
   RegionalizedData( const CommandLineOpts * inception_state );
   ~RegionalizedData();
 
+  // restore the links to shared state after loading this region from a restart checkpoint
+  void RelinkSharedState( Region *_region, EmptyTraceTracker *_emptyTraceTracker );
+
   void AllocTraceBuffers(int flow_block_size);
   void AllocFitBuffers(int flow_block_size);
   void SetTimeAndEmphasis (GlobalDefaultsForBkgModel &global_defaults, float tmid, float t0_offset);
@@ -171,18 +174,18 @@ public:
 private:
   // Serialization section
   friend class boost::serialization::access;
+  // region, emptyTraceTracker and emptytrace are shared with the rest of the chip and are
+  // not part of a region's state; the restart checkpoint stores each region on its own
+  // and puts them back with RelinkSharedState.
   template<typename Archive>
   void save(Archive& ar, const unsigned version) const
   {
     //fprintf(stdout, "Serialization: save RegionalizedData...");
     ar &
-        region &
         time_c &
         emphasis_data &
         std_time_comp_emphasis &
         my_trace &
-        emptyTraceTracker &
-        emptytrace &
         my_beads &
         my_regions &
         sigma_start &
@@ -198,13 +201,10 @@ private:
   {
     // fprintf(stdout, "Serialization: load RegionalizedData...");
     ar &
-        region &
         time_c &
         emphasis_data &
         std_time_comp_emphasis &
         my_trace &
-        emptyTraceTracker &
-        emptytrace &
         my_beads &
         my_regions &
         sigma_start &
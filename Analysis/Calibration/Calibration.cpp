@@ -19,7 +19,18 @@
 using namespace std;
 using namespace BamTools;
 
+// Private training data of one worker thread for one pass through the BAM files
+struct CalibrationShard
+{
+  CalibrationContext *       calib_context;
+  HistogramCalibration *     hist_calibration;
+  LinearCalibrationModel *   linear_model;
+  unsigned long              num_useful_reads;
+  CalibrationShard *         merge_from;                 //!< Shard to be added to this one by the reduction
+};
+
 void * CalibrationWorker(void *input);
+void * CalibrationShardReducer(void *input);
 int ExecuteThreadedCalibrationTraining(CalibrationContext &calib_context);
 
 // ----------------------------------------------------------------
@@ -183,9 +194,23 @@ int ExecuteThreadedCalibrationTraining(CalibrationContext &calib_context){
   pthread_cond_init(&calib_context.model_read_cond, NULL);
   pthread_cond_init(&calib_context.model_write_cond, NULL);
 
+  // Every worker trains into its own shard for the whole pass, so the workers only meet at the BAM reader.
+  // The blind fit linear model is the exception, it is handed to the master after every batch.
+  vector<HistogramCalibration>   hist_shards(calib_context.num_threads, *calib_context.hist_calibration_master);
+  vector<LinearCalibrationModel> linear_shards(calib_context.num_threads, *calib_context.linear_model_master);
+  vector<CalibrationShard>       shards(calib_context.num_threads);
+  for (unsigned int worker = 0; worker < calib_context.num_threads; worker++) {
+    hist_shards[worker].CleanSlate();
+    linear_shards[worker].CleanSlate();
+    shards[worker].calib_context    = &calib_context;
+    shards[worker].hist_calibration = &hist_shards[worker];
+    shards[worker].linear_model     = &linear_shards[worker];
+    shards[worker].num_useful_reads = 0;
+  }
+
   pthread_t worker_id[calib_context.num_threads];
   for (unsigned int worker = 0; worker < calib_context.num_threads; worker++)
-    if (pthread_create(&worker_id[worker], NULL, CalibrationWorker, &calib_context)) {
+    if (pthread_create(&worker_id[worker], NULL, CalibrationWorker, &shards[worker])) {
       cerr << "Calibration ERROR: Problem starting thread" << endl;
       exit (EXIT_FAILURE);
     }
@@ -193,6 +218,30 @@ int ExecuteThreadedCalibrationTraining(CalibrationContext &calib_context){
   for (unsigned int worker = 0; worker < calib_context.num_threads; worker++)
     pthread_join(worker_id[worker], NULL);
 
+  // Pairwise tree reduction of the shards, the pairs of one level are merged concurrently.
+  // Shard 0 ends up holding the data of the pass and is the only one touching the master.
+  for (unsigned int step = 1; step < calib_context.num_threads; step *= 2) {
+    vector<pthread_t> reduce_id;
+    for (unsigned int worker = 0; worker + step < calib_context.num_threads; worker += 2*step) {
+      shards[worker].merge_from = &shards[worker+step];
+      reduce_id.push_back(pthread_t());
+      if (pthread_create(&reduce_id.back(), NULL, CalibrationShardReducer, &shards[worker])) {
+        cerr << "Calibration ERROR: Problem starting thread" << endl;
+        exit (EXIT_FAILURE);
+      }
+    }
+    for (unsigned int i = 0; i < reduce_id.size(); i++)
+      pthread_join(reduce_id[i], NULL);
+  }
+
+  if (calib_context.num_threads > 0) {
+    calib_context.num_useful_reads += shards[0].num_useful_reads;
+    if (calib_context.local_fit_polish_model)
+      calib_context.hist_calibration_master->AccumulateHistData(hist_shards[0]);
+    if (calib_context.local_fit_linear_model and not calib_context.blind_fit)
+      calib_context.linear_model_master->AccumulateTrainingData(linear_shards[0]);
+  }
+
   pthread_mutex_destroy(&calib_context.read_mutex);
   pthread_mutex_destroy(&calib_context.write_mutex);
   pthread_cond_destroy(&calib_context.model_read_cond);
@@ -204,6 +253,22 @@ int ExecuteThreadedCalibrationTraining(CalibrationContext &calib_context){
 }
 
 
+// --------------------------------------------------------------------------
+// Adds the training data of shard.merge_from to shard
+
+void * CalibrationShardReducer(void *input)
+{
+  CalibrationShard& shard = *static_cast<CalibrationShard*>(input);
+  CalibrationContext& calib_context = *shard.calib_context;
+
+  shard.num_useful_reads += shard.merge_from->num_useful_reads;
+  if (calib_context.local_fit_polish_model)
+    shard.hist_calibration->AccumulateHistData(*shard.merge_from->hist_calibration);
+  if (calib_context.local_fit_linear_model and not calib_context.blind_fit)
+    shard.linear_model->AccumulateTrainingData(*shard.merge_from->linear_model);
+  return NULL;
+}
+
 
 // --------------------------------------------------------------------------
 
@@ -211,12 +276,15 @@ int ExecuteThreadedCalibrationTraining(CalibrationContext &calib_context){
 void * CalibrationWorker(void *input)
 {
 
-  CalibrationContext& calib_context = *static_cast<CalibrationContext*>(input);
+  CalibrationShard& shard = *static_cast<CalibrationShard*>(input);
+  CalibrationContext& calib_context = *shard.calib_context;
+  bool blind_linear_fit = calib_context.blind_fit and calib_context.local_fit_linear_model;
 
   // *** Initialize Modules
 
-  vector<BamAlignment> bam_alignments;
-  bam_alignments.reserve(calib_context.num_reads_per_thread);
+  // Alignments are read straight into their slot, there is no copy while the reader is locked
+  vector<BamAlignment> bam_alignments(calib_context.num_reads_per_thread);
+  unsigned int num_alignments = 0;
   ReadAlignmentInfo read_alignment;
   read_alignment.SetSize(calib_context.max_num_flows);
   bool update_bam_stats = (calib_context.bam_reader.NumPasses() == 0);
@@ -233,8 +301,8 @@ void * CalibrationWorker(void *input)
     treephaser_vector.push_back(dpTreephaser);
   }
 
-  HistogramCalibration    hist_calibration_local(*calib_context.hist_calibration_master);
-  LinearCalibrationModel  linear_cal_model_local(*calib_context.linear_model_master); // Training data for current batch
+  HistogramCalibration&   hist_calibration_local = *shard.hist_calibration;
+  LinearCalibrationModel& linear_cal_model_local = *shard.linear_model;     // Training data for whole pass, or current batch for blind
   LinearCalibrationModel  linear_model_cal_sim  (*calib_context.linear_model_master); // state of master to date (changing for blind)
 
 
@@ -242,14 +310,13 @@ void * CalibrationWorker(void *input)
 
   while (true) {
 
-    hist_calibration_local.CleanSlate();
-    linear_cal_model_local.CleanSlate();
     unsigned long num_useful_reads = 0;
 
     // Step 0 *** Wait for permission to read most recent master model
     //            Blind fit only! Non-blind is limited to one training iteration.
 
-    if (calib_context.blind_fit and calib_context.local_fit_linear_model){
+    if (blind_linear_fit){
+      linear_cal_model_local.CleanSlate();
       pthread_mutex_lock(&calib_context.write_mutex);
 
       while(calib_context.wait_to_read_model)
@@ -275,15 +342,15 @@ void * CalibrationWorker(void *input)
 
     // Step 1 *** load a number of reads from the BAM files
 
-    bam_alignments.clear();
-    BamAlignment new_alignment;
+    num_alignments = 0;
     bool have_alignment = true;
 
     pthread_mutex_lock(&calib_context.read_mutex);
 
     // we may have an unsorted BAM with a large chunk of unmapped reads somewhere in the middle
-    while((bam_alignments.size() < calib_context.num_reads_per_thread) and have_alignment) {
+    while((num_alignments < calib_context.num_reads_per_thread) and have_alignment) {
 
+      BamAlignment& new_alignment = bam_alignments[num_alignments];
       have_alignment = calib_context.bam_reader.GetNextAlignmentCore(new_alignment);
       // Only log read stats during first pass through BAM
       if (have_alignment) {
@@ -297,18 +364,18 @@ void * CalibrationWorker(void *input)
           if(new_alignment.MapQuality >= calib_context.min_mapping_qv) {
             if (update_bam_stats)
               calib_context.num_loaded_reads++;
-            bam_alignments.push_back(new_alignment);
+            num_alignments++;
           }
         }
         else if (calib_context.load_unmapped) {
           if (update_bam_stats)
             calib_context.num_loaded_reads++;
-          bam_alignments.push_back(new_alignment);
+          num_alignments++;
         }
       }
     }
 
-    if ((not have_alignment) and (bam_alignments.size() == 0)) {
+    if ((not have_alignment) and (num_alignments == 0)) {
 
       pthread_mutex_unlock(&calib_context.read_mutex);
 
@@ -330,10 +397,10 @@ void * CalibrationWorker(void *input)
 
     // Step 2 *** Iterate over individual reads and extract information
 
-    for (unsigned int idx=0; idx<bam_alignments.size(); idx++) {
+    for (unsigned int idx=0; idx<num_alignments; idx++) {
 
       unsigned int iRead = index_vec.at(idx);
-      if (iRead >= bam_alignments.size())
+      if (iRead >= num_alignments)
         continue;
 
       // Unpack alignment related information & generate predictions
@@ -359,24 +426,23 @@ void * CalibrationWorker(void *input)
       }
     }
 
+    if (update_bam_stats)
+      shard.num_useful_reads += num_useful_reads;
 
-    // Step 3 *** After read processing finished, aggregate the collected information.
 
-    pthread_mutex_lock(&calib_context.write_mutex);
+    // Step 3 *** Blind fit only: hand the batch to the master model once every thread has read it.
+    //            Everything else stays in the shard until the end of the pass.
 
-    if (calib_context.blind_fit and calib_context.local_fit_linear_model){
-      while(calib_context.wait_to_write_model)
-        pthread_cond_wait (&calib_context.model_write_cond, &calib_context.write_mutex);
+    if (not blind_linear_fit)
+      continue;
 
-      calib_context.num_model_writes++;
-    }
+    pthread_mutex_lock(&calib_context.write_mutex);
 
-    if (update_bam_stats)
-      calib_context.num_useful_reads += num_useful_reads;
-    if (calib_context.local_fit_polish_model)
-      calib_context.hist_calibration_master->AccumulateHistData(hist_calibration_local);
-    if (calib_context.local_fit_linear_model)
-      calib_context.linear_model_master->AccumulateTrainingData(linear_cal_model_local);
+    while(calib_context.wait_to_write_model)
+      pthread_cond_wait (&calib_context.model_write_cond, &calib_context.write_mutex);
+
+    calib_context.num_model_writes++;
+    calib_context.linear_model_master->AccumulateTrainingData(linear_cal_model_local);
 
     if (calib_context.num_model_writes == calib_context.num_threads){
       calib_context.num_model_writes = 0;
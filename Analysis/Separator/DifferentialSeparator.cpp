@@ -527,6 +527,180 @@ public:
   struct FitTauEParams *mDefaultParam;
 };
 
+/**
+ * Job class for fitting tauE for one region of the emptyEstimates mesh
+ * and, if asked for, taub of every well in it. Both fits read the region's
+ * traces back to back while they are still in cache. A job only writes the
+ * wells and mesh item of its own region, so regions run in parallel.
+ */
+class FitTauEJob : public PJob {
+
+public:
+  FitTauEJob() {
+    mBinIx = 0;
+    mRowStart = mRowEnd = mColStart = mColEnd = 0;
+    mChipCol = mChipWells = 0;
+    mTraceStore = NULL;
+    mEmptyEstimates = NULL;
+    mFilteredWells = NULL;
+    mFTime = NULL;
+    mAllZeroFlows = NULL;
+    mTaubEst = NULL;
+    mConverged = mNoWells = 0;
+  }
+
+  void Init(size_t binIx, int chipCol, int chipWells, TraceStoreCol *traceStore,
+            GridMesh<struct FitTauEParams> *emptyEstimates,
+            std::vector<char> *filteredWells, std::vector<float> *ftime,
+            std::vector<int> *allZeroFlows, float *taubEst) {
+    mBinIx = binIx;
+    emptyEstimates->GetBinCoords (binIx, mRowStart, mRowEnd, mColStart, mColEnd);
+    mChipCol = chipCol;
+    mChipWells = chipWells;
+    mTraceStore = traceStore;
+    mEmptyEstimates = emptyEstimates;
+    mFilteredWells = filteredWells;
+    mFTime = ftime;
+    mAllZeroFlows = allZeroFlows;
+    mTaubEst = taubEst;
+    mConverged = mNoWells = 0;
+  }
+
+  virtual void Run() {
+    ZeromerMatDiff z_diff;
+    std::vector<char> &filteredWells = *mFilteredWells;
+    std::vector<int> &allZeroFlows = *mAllZeroFlows;
+    z_diff.SetUpMatricesClean(*mTraceStore, &filteredWells[0], &(*mFTime)[0], 2, 3,
+                              mChipCol, mChipWells,
+                              mRowStart, mRowEnd, mColStart, mColEnd,
+                              &allZeroFlows[0], allZeroFlows.size(),
+                              0, mTraceStore->GetNumFrames());
+    struct FitTauEParams &param = mEmptyEstimates->GetItem(mBinIx);
+    if (z_diff.m_num_wells < MIN_SAMPLE_TAUE_STATS) {
+      param.taue = std::numeric_limits<float>::quiet_NaN();
+      param.ref_shift = std::numeric_limits<float>::quiet_NaN();
+      param.converged = false;
+      mNoWells++;
+    }
+    else {
+      // @todo cws - expose these magic params somewhere
+      struct FitTauEParams taue_param;
+      taue_param.ref_shift = 0;
+      taue_param.taue = 3.0f;
+      taue_param.converged = 0.0f;
+      struct FitTauEParams taue_param_min;
+      taue_param_min.taue = 1;
+      taue_param_min.ref_shift = -.05;
+      taue_param_min.converged = 0.0f;
+      struct FitTauEParams taue_param_max;
+      taue_param_max.taue = 8;
+      taue_param_max.ref_shift = .05f;
+      taue_param_max.converged = 0.0f;
+      TauEFitter taue_fitter(z_diff.m_total_size, z_diff.m_trace_data, &z_diff);
+      taue_fitter.SetParamMax(taue_param_max);
+      taue_fitter.SetParamMin(taue_param_min);
+      taue_fitter.SetInitialParam(taue_param);
+      taue_fitter.Fit(true, 100, z_diff.m_trace_data);
+      taue_param.ref_shift = taue_fitter.m_params.ref_shift;
+      taue_param.taue = taue_fitter.m_params.taue;
+ 
+      taue_param.converged = taue_fitter.IsConverged() ? 1.0f : 0.0f;
+      param = taue_param;
+      if (param.converged) {
+        mConverged++;
+      }
+    }
+    if (mTaubEst != NULL) {
+      int zero_flows[1] = {0};
+      ZeromerMatDiff z_diff_big;
+      z_diff_big.SetUpMatrices(*mTraceStore, &filteredWells[0], &(*mFTime)[0], 1, 1,
+                               mChipCol, mChipWells,
+                               mRowStart, mRowEnd, mColStart, mColEnd,
+                               allZeroFlows[0], allZeroFlows[0] + 1,
+                               0, mTraceStore->GetNumFrames());
+      z_diff_big.FitTauB(zero_flows, 1,
+                         z_diff_big.m_trace_data, z_diff_big.m_ref_data,
+                         z_diff_big.m_num_wells, z_diff_big.m_num_flows, z_diff_big.m_num_well_flows,
+                         z_diff_big.m_total_size / z_diff_big.m_num_well_flows,
+                         param.taue, z_diff_big.m_taub);
+      float *__restrict local_taub = z_diff_big.m_taub;
+      for (int row_ix = mRowStart; row_ix < mRowEnd; row_ix++) {
+        for (int col_ix = mColStart; col_ix < mColEnd; col_ix++) {
+          int well_ix = row_ix * mChipCol + col_ix;
+          float value = *local_taub++;
+          if (value > 0) {
+            mTaubEst[well_ix] = value;
+          }
+          else {
+            filteredWells[well_ix] = DifferentialSeparator::LowTraceSd;
+          }
+        }
+      }
+    }
+  }
+
+  size_t mBinIx;
+  int mRowStart, mRowEnd, mColStart, mColEnd;
+  int mChipCol, mChipWells;
+  TraceStoreCol *mTraceStore;
+  GridMesh<struct FitTauEParams> *mEmptyEstimates;
+  std::vector<char> *mFilteredWells;
+  std::vector<float> *mFTime;
+  std::vector<int> *mAllZeroFlows;
+  float *mTaubEst;
+  int mConverged, mNoWells;
+};
+
+/**
+ * Job class for fitting the dual gaussian mixture model of one region
+ * of the clustering mesh.
+ */
+class ClusterRegionJob : public PJob {
+
+public:
+  ClusterRegionJob() {
+    mSeparator = NULL;
+    mRowStart = mRowEnd = mColStart = mColEnd = 0;
+    mMadThreshold = mMinBeadSnr = 0;
+    mMinGoodWells = 0;
+    mBfMetric = NULL;
+    mWells = NULL;
+    mTrim = 0;
+    mModel = NULL;
+  }
+
+  void Init(DifferentialSeparator *separator, int rowStart, int rowEnd, int colStart, int colEnd,
+            float madThreshold, float minBeadSnr, size_t minGoodWells,
+            std::vector<float> *bfMetric, std::vector<KeyFit> *wells, double trim, MixModel *model) {
+    mSeparator = separator;
+    mRowStart = rowStart;
+    mRowEnd = rowEnd;
+    mColStart = colStart;
+    mColEnd = colEnd;
+    mMadThreshold = madThreshold;
+    mMinBeadSnr = minBeadSnr;
+    mMinGoodWells = minGoodWells;
+    mBfMetric = bfMetric;
+    mWells = wells;
+    mTrim = trim;
+    mModel = model;
+  }
+
+  virtual void Run() {
+    mSeparator->ClusterRegion (mRowStart, mRowEnd, mColStart, mColEnd, mMadThreshold, mMinBeadSnr,
+                               mMinGoodWells, *mBfMetric, *mWells, mTrim, false, *mModel);
+  }
+
+  DifferentialSeparator *mSeparator;
+  int mRowStart, mRowEnd, mColStart, mColEnd;
+  float mMadThreshold, mMinBeadSnr;
+  size_t mMinGoodWells;
+  std::vector<float> *mBfMetric;
+  std::vector<KeyFit> *mWells;
+  double mTrim;
+  MixModel *mModel;
+};
+
 /** 
  * Job class for multithreading reading dat files from disk, processing them and 
  * loading them into data structure.
@@ -2654,6 +2828,7 @@ void DifferentialSeparator::FitKeys(PJobQueue &jQueue, DifSepOpt &opts, GridMesh
                      std::min (128,mask.W()), std::min (128,mask.H()), keys);
   AvgKeyReporter<double> avgReport(keys, opts.outData, opts.flowOrder, opts.analysisDir, 
                                    usable_flows, traceStore.GetNumFrames());
+  Timer stageTimer;
   std::vector<EvalKeyJob> evalJobs(emptyEstimates.GetNumBin());
   for (size_t binIx = 0; binIx < emptyEstimates.GetNumBin(); binIx++) {
     int rowStart = -1, rowEnd = -1, colStart = -1, colEnd = -1;
@@ -2665,95 +2840,34 @@ void DifferentialSeparator::FitKeys(PJobQueue &jQueue, DifSepOpt &opts, GridMesh
     jQueue.AddJob(evalJobs[binIx]);
   }
   jQueue.WaitUntilDone();
+  fprintf(stdout, "Beadfind stage FitKeys: %.2f seconds on %d threads\n", stageTimer.elapsed(), (int)jQueue.NumThreads());
   avgReport.Finish();
   keySumReport.Finish();
 
 }
 
 
-void DifferentialSeparator::FitTauE(DifSepOpt &opts, TraceStoreCol &traceStore, GridMesh<struct FitTauEParams> &emptyEstimates,
+void DifferentialSeparator::FitTauE(PJobQueue &jQueue, DifSepOpt &opts, TraceStoreCol &traceStore, GridMesh<struct FitTauEParams> &emptyEstimates,
                                     std::vector<char> &filteredWells, std::vector<float> &ftime, std::vector<int> &allZeroFlows, float *taub_est) {
   mTotalTimer.PrintMicroSecondsUpdate(stdout, "Total Timer: Before Zeromers.");
+  Timer stageTimer;
   emptyEstimates.Init (mMask.H(), mMask.W(), opts.tauEEstimateStepY, opts.tauEEstimateStepX);
-  ZeromerMatDiff z_diff;
-  ZeromerMatDiff z_diff_big;
-  int converged = 0;
-  int no_wells = 0;
-  int zero_flows[1] = {0};
   if (taub_est != NULL) {  memset(taub_est, 0, sizeof(float) * filteredWells.size()); }
+  std::vector<FitTauEJob> fitJobs(emptyEstimates.GetNumBin());
   for (size_t binIx = 0; binIx < emptyEstimates.GetNumBin(); binIx++) {
-    int rowStart = -1, rowEnd = -1, colStart = -1, colEnd = -1;
-    emptyEstimates.GetBinCoords (binIx, rowStart, rowEnd, colStart, colEnd);
-    z_diff.SetUpMatricesClean(traceStore, &filteredWells[0], &ftime[0], 2, 3, 
-                              mMask.W(), mMask.W() * mMask.H(),
-                              rowStart, rowEnd, colStart, colEnd,
-                              &allZeroFlows[0], allZeroFlows.size(),
-                              0, traceStore.GetNumFrames());
-    struct FitTauEParams &param = emptyEstimates.GetItem(binIx);
-    if (z_diff.m_num_wells < MIN_SAMPLE_TAUE_STATS) {
-      param.taue = std::numeric_limits<float>::quiet_NaN();
-      param.ref_shift = std::numeric_limits<float>::quiet_NaN();
-      param.converged = false;
-      no_wells++;
-    }
-    else {
-      // @todo cws - expose these magic params somewhere
-      struct FitTauEParams taue_param;
-      taue_param.ref_shift = 0;
-      taue_param.taue = 3.0f;
-      taue_param.converged = 0.0f;
-      struct FitTauEParams taue_param_min;
-      taue_param_min.taue = 1;
-      taue_param_min.ref_shift = -.05;
-      taue_param_min.converged = 0.0f;
-      struct FitTauEParams taue_param_max;
-      taue_param_max.taue = 8;
-      taue_param_max.ref_shift = .05f;
-      taue_param_max.converged = 0.0f;
-      TauEFitter taue_fitter(z_diff.m_total_size, z_diff.m_trace_data, &z_diff);
-      taue_fitter.SetParamMax(taue_param_max);
-      taue_fitter.SetParamMin(taue_param_min);
-      taue_fitter.SetInitialParam(taue_param);
-      taue_fitter.Fit(true, 100, z_diff.m_trace_data);
-      taue_param.ref_shift = taue_fitter.m_params.ref_shift;
-      taue_param.taue = taue_fitter.m_params.taue;
- 
-      taue_param.converged = taue_fitter.IsConverged() ? 1.0f : 0.0f;
-      param = taue_param;
-      // fprintf(stdout, "Fitted params: %d %d %.2f %.2f %f\n", rowStart, colStart,
-      //        param.taue, param.ref_shift, param.converged);
-      if (param.converged) {
-        converged++;
-      }
-    }
-    if (taub_est != NULL) {
-      z_diff_big.SetUpMatrices(traceStore, &filteredWells[0], &ftime[0], 1, 1, 
-                               mMask.W(), mMask.W() * mMask.H(),
-                               rowStart, rowEnd, colStart, colEnd,
-                               allZeroFlows[0], allZeroFlows[0] + 1,
-                               0, traceStore.GetNumFrames());
-      z_diff_big.FitTauB(zero_flows, 1,
-                         z_diff_big.m_trace_data, z_diff_big.m_ref_data,
-                         z_diff_big.m_num_wells, z_diff_big.m_num_flows, z_diff_big.m_num_well_flows,
-                         z_diff_big.m_total_size / z_diff_big.m_num_well_flows,
-                         param.taue, z_diff_big.m_taub);
-      int chip_col = mMask.W();
-      float *__restrict local_taub = z_diff_big.m_taub;
-      for (int row_ix = rowStart; row_ix < rowEnd; row_ix++) {
-        for (int col_ix = colStart; col_ix < colEnd; col_ix++) {
-          int well_ix = row_ix * chip_col + col_ix;
-          float value = *local_taub++;
-          if (value > 0) {
-            taub_est[well_ix] = value;
-          }
-          else {
-            filteredWells[well_ix] = LowTraceSd;
-          }
-        }
-      }
-    }
+    fitJobs[binIx].Init(binIx, mMask.W(), mMask.W() * mMask.H(), &traceStore, &emptyEstimates,
+                        &filteredWells, &ftime, &allZeroFlows, taub_est);
+    jQueue.AddJob(fitJobs[binIx]);
+  }
+  jQueue.WaitUntilDone();
+  int converged = 0;
+  int no_wells = 0;
+  for (size_t binIx = 0; binIx < fitJobs.size(); binIx++) {
+    converged += fitJobs[binIx].mConverged;
+    no_wells += fitJobs[binIx].mNoWells;
   }
   fprintf(stdout, "FitTauE() - %d %d %d\n", converged, no_wells, (int)emptyEstimates.GetNumBin());
+  fprintf(stdout, "Beadfind stage FitTauE: %.2f seconds on %d threads\n", stageTimer.elapsed(), (int)jQueue.NumThreads());
   mTotalTimer.PrintMicroSecondsUpdate(stdout, "Total Timer: After well Zeromers.");
 }
 
@@ -2785,6 +2899,9 @@ void DifferentialSeparator::DoRegionClustering(DifSepOpt &opts, Mask &mask, vect
     }
   }
 
+  // Regions are fit in parallel, then summarized in mesh order
+  Timer stageTimer;
+  std::vector<ClusterRegionJob> clusterJobs(modelMesh.GetNumBin());
   for (size_t binIx = 0; binIx < modelMesh.GetNumBin(); binIx++)
     {
       int rowStart = -1, rowEnd = -1, colStart = -1, colEnd = -1;
@@ -2816,8 +2933,19 @@ void DifferentialSeparator::DoRegionClustering(DifSepOpt &opts, Mask &mask, vect
       //   }
       // }
       int minBfGoodWells = max (200, (int) (goodCount * .5));
-      ClusterRegion (rowStart, rowEnd, colStart, colEnd, madThreshold, opts.minTauESnr,
-		     minBfGoodWells, bfMetric, wells, opts.clusterTrim, false,  model);
+      clusterJobs[binIx].Init(this, rowStart, rowEnd, colStart, colEnd, madThreshold, opts.minTauESnr,
+                              minBfGoodWells, &bfMetric, &wells, opts.clusterTrim, &model);
+      mQueue.AddJob(clusterJobs[binIx]);
+    }
+  mQueue.WaitUntilDone();
+  fprintf(stdout, "Beadfind stage ClusterRegion: %.2f seconds on %d threads\n", stageTimer.elapsed(), (int)mQueue.NumThreads());
+
+  for (size_t binIx = 0; binIx < modelMesh.GetNumBin(); binIx++)
+    {
+      int rowStart = -1, rowEnd = -1, colStart = -1, colEnd = -1;
+      modelMesh.GetBinCoords (binIx, rowStart, rowEnd, colStart, colEnd);
+      MixModel &model = modelMesh.GetItem (binIx);
+      int minBfGoodWells = clusterJobs[binIx].mMinGoodWells;
       if ( model.count > minBfGoodWells) {
         double bf = ( (model.mu2 - model.mu1) / ( (sqrt (model.var2) + sqrt (model.var1)) /2));
         if (isfinite (bf) && bf > 0)  {
@@ -3828,7 +3956,7 @@ int DifferentialSeparator::Run(DifSepOpt opts) {
     mEmptyMetrics.resize(metric_size + 1);
     mEmptyMetrics[metric_size].resize(mFilteredWells.size());
     float *taub_est = &mEmptyMetrics[metric_size][0];
-    FitTauE(opts,traceStore, emptyEstimates, mFilteredWells, 
+    FitTauE(mQueue, opts,traceStore, emptyEstimates, mFilteredWells, 
             ftime, flowsAllZero, taub_est);
     
     PickCombinedRank(mEmptyMetrics, opts.referenceStep, opts.referenceStep, 
@@ -3844,7 +3972,7 @@ int DifferentialSeparator::Run(DifSepOpt opts) {
   for (size_t i = 0; i < loadMinFlows; i++) { traceStore.PrepareReference (i, mFilteredWells); }
 
   // Fit a global tauE for each region
-  FitTauE(opts,traceStore, emptyEstimates, mFilteredWells, 
+  FitTauE(mQueue, opts,traceStore, emptyEstimates, mFilteredWells, 
           ftime, flowsAllZero, NULL);
 
   // See which keys are the best match for wells.
@@ -303,7 +303,7 @@ class DifferentialSeparator : public AvgKeyIncorporation
     static void PrintVec(arma::Col<float> &vec);
     static void PrintWell(TraceStore &store, int well, int flow);    
     /** Do a beadfind/bead classification based on options passed in. */
-    void FitTauE(DifSepOpt &opts, TraceStoreCol &traceStore, GridMesh<struct FitTauEParams> &emptyEstimates,
+    void FitTauE(PJobQueue &jQueue, DifSepOpt &opts, TraceStoreCol &traceStore, GridMesh<struct FitTauEParams> &emptyEstimates,
                  std::vector<char> &filteredWells, std::vector<float> &ftime, std::vector<int> &allZeroFlows, float *taub_est);
     void FitKeys(DifSepOpt &opts, GridMesh<struct FitTauEParams> &emptyEstimates, 
                  TraceStoreCol &traceStore, std::vector<KeySeq> &keys, 
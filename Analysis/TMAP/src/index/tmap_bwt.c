@@ -33,11 +33,16 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <getopt.h>
+#include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_progress.h"
 #include "../util/tmap_definitions.h"
+#include "../util/tmap_time.h"
 #include "../io/tmap_file.h"
 #include "tmap_bwt_gen.h"
 #include "tmap_bwt.h"
@@ -477,8 +482,10 @@ tmap_bwt_gen_cnt_table(tmap_bwt_t *bwt)
 #endif
 }
 
+// fills the len-mer hash for the k-mers starting with the given prefix of prefix_len bases,
+// levels up to prefix_len must be complete
 static void
-tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
+tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len, int32_t prefix_len, uint64_t prefix)
 {
   tmap_bwt_sint_t i;
   // tmap_bwt_sint_t n;
@@ -489,8 +496,11 @@ tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
   
   seq = tmap_calloc(len, sizeof(uint8_t), "seq");
 
-  i = 0; // length of the current k-mer
-  hash_i = 0;
+  for(i=0;i<prefix_len;i++) {
+      seq[i] = (prefix >> ((prefix_len - 1 - i) << 1)) & 3;
+  }
+  i = prefix_len; // length of the current k-mer
+  hash_i = prefix;
   while(1) {
       if(len < i) {
           tmap_error("ABORT", Exit, OutOfRange);
@@ -507,12 +517,12 @@ tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
 
           // find the next base
           i--;
-          while(0 <= i && 3 == seq[i]) {
+          while(prefix_len <= i && 3 == seq[i]) {
               seq[i] = 0;
               hash_i >>= 2;
               i--;
           }
-          if(i < 0) break;
+          if(i < prefix_len) break;
           seq[i]++;
           hash_i++;
           i++;
@@ -530,12 +540,12 @@ tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
               }
               // find the next base
               i--;
-              while(0 <= i && 3 == seq[i]) {
+              while(prefix_len <= i && 3 == seq[i]) {
                   seq[i] = 0;
                   hash_i >>= 2;
                   i--;
               }
-              if(i < 0) break;
+              if(i < prefix_len) break;
               seq[i]++;
               hash_i++;
               i++;
@@ -550,10 +560,71 @@ tmap_bwt_gen_hash_helper(tmap_bwt_t *bwt, uint32_t len)
   free(seq);
 }
 
-void
-tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
+#ifdef HAVE_LIBPTHREAD
+typedef struct {
+    tmap_bwt_t *bwt;
+    uint32_t len;
+    int32_t prefix_len;
+    uint64_t next_prefix;
+    pthread_mutex_t *mutex;
+} tmap_bwt_gen_hash_thread_data_t;
+
+static void *
+tmap_bwt_gen_hash_thread_worker(void *arg)
+{
+  tmap_bwt_gen_hash_thread_data_t *data = (tmap_bwt_gen_hash_thread_data_t*)arg;
+  uint64_t prefix, num_prefixes = tmap_bwt_get_hash_length(data->prefix_len);
+
+  while(1) {
+      pthread_mutex_lock(data->mutex);
+      prefix = data->next_prefix++;
+      pthread_mutex_unlock(data->mutex);
+      if(num_prefixes <= prefix) break;
+      tmap_bwt_gen_hash_helper(data->bwt, data->len, data->prefix_len, prefix);
+  }
+
+  return arg;
+}
+
+// the k-mers of one level are split by their first bases, each prefix is a task
+static void
+tmap_bwt_gen_hash_threads(tmap_bwt_t *bwt, uint32_t len, int32_t prefix_len, int32_t num_threads)
 {
   int32_t i;
+  pthread_attr_t attr;
+  pthread_t *threads = NULL;
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  tmap_bwt_gen_hash_thread_data_t data;
+
+  data.bwt = bwt;
+  data.len = len;
+  data.prefix_len = prefix_len;
+  data.next_prefix = 0;
+  data.mutex = &mutex;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  threads = tmap_calloc(num_threads, sizeof(pthread_t), "threads");
+  for(i=0;i<num_threads;i++) {
+      if(0 != pthread_create(&threads[i], &attr, tmap_bwt_gen_hash_thread_worker, &data)) {
+          tmap_error("error creating threads", Exit, ThreadError);
+      }
+  }
+  for(i=0;i<num_threads;i++) {
+      if(0 != pthread_join(threads[i], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
+      }
+  }
+  free(threads);
+  pthread_attr_destroy(&attr);
+}
+#endif
+
+void
+tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash, int32_t num_threads)
+{
+  int32_t i, prefix_len;
+  double start_time = tmap_time_realtime();
 
   tmap_progress_print("constructing the occurrence hash for the BWT string");
   if(bwt->seq_len < (tmap_bwt_int_t) hash_width) {
@@ -594,7 +665,18 @@ tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
       bwt->hash_k[i-1] = tmap_malloc(sizeof(tmap_bwt_int_t)*hash_length, "bwt->hash_k[i-1]");
       bwt->hash_l[i-1] = tmap_malloc(sizeof(tmap_bwt_int_t)*hash_length, "bwt->hash_l[i-1]");
 
-      tmap_bwt_gen_hash_helper(bwt, i);
+      // the prefixes have to be hashed already, so that pruning is the same as a serial fill
+      prefix_len = (i - 1 < TMAP_BWT_HASH_PREFIX_LEN) ? i - 1 : TMAP_BWT_HASH_PREFIX_LEN;
+#ifdef HAVE_LIBPTHREAD
+      if(1 < num_threads && 0 < prefix_len) {
+          tmap_bwt_gen_hash_threads(bwt, i, prefix_len, num_threads);
+      }
+      else {
+          tmap_bwt_gen_hash_helper(bwt, i, 0, 0);
+      }
+#else
+      tmap_bwt_gen_hash_helper(bwt, i, 0, 0);
+#endif
       bwt->hash_width = i; // updated the hash width
   }
 
@@ -604,7 +686,7 @@ tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash)
       tmap_bwt_check_core2(bwt, bwt->hash_width, 1, 0, 1);
   }
 
-  tmap_progress_print2("constructed the occurrence hash for the BWT string");
+  tmap_progress_print2("constructed the occurrence hash for the BWT string in %.2f sec", tmap_time_realtime() - start_time);
 }
 
 /**
@@ -964,11 +1046,12 @@ int
 tmap_bwt_pac2bwt_main(int argc, char *argv[])
 {
   int c, is_large = 0, occ_interval = TMAP_BWT_OCC_INTERVAL, help = 0;
-  int32_t hash_width = INT32_MAX, check_hash = 1;
+  int32_t hash_width = INT32_MAX, check_hash = 1, num_threads = 1;
 
-  while((c = getopt(argc, argv, "o:lw:vhH")) >= 0) {
+  while((c = getopt(argc, argv, "o:lw:n:vhH")) >= 0) {
       switch(c) {
         case 'l': is_large = 1; break;
+        case 'n': num_threads = atoi(optarg); break;
         case 'o': occ_interval = atoi(optarg); break;
         case 'w': hash_width = atoi(optarg); break;
         case 'v': tmap_progress_set_verbosity(1); break;
@@ -978,14 +1061,17 @@ tmap_bwt_pac2bwt_main(int argc, char *argv[])
       }
   }
   if(1 != argc - optind || 1 == help) {
-      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-l -o INT -w INT -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-l -o INT -w INT -n INT -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
       return 1;
   }
+  if(num_threads <= 0) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
   if(occ_interval < TMAP_BWT_OCC_MOD || 0 != (occ_interval % 2) ||  0 != (occ_interval % TMAP_BWT_OCC_MOD)) {
       tmap_error("option -o out of range", Exit, CommandLineArgument);
   }
 
-  tmap_bwt_pac2bwt(argv[optind], is_large, occ_interval, hash_width, check_hash);
+  tmap_bwt_pac2bwt(argv[optind], is_large, occ_interval, hash_width, check_hash, num_threads);
 
   return 0;
 }
@@ -994,11 +1080,12 @@ int
 tmap_bwt_bwtupdate_main(int argc, char *argv[])
 {
   int c, help = 0;
-  int32_t hash_width = INT32_MAX, check_hash = 1;
+  int32_t hash_width = INT32_MAX, check_hash = 1, num_threads = 1;
 
-  while((c = getopt(argc, argv, "w:vh")) >= 0) {
+  while((c = getopt(argc, argv, "w:n:vh")) >= 0) {
       switch(c) {
         case 'w': hash_width = atoi(optarg); break;
+        case 'n': num_threads = atoi(optarg); break;
         case 'v': tmap_progress_set_verbosity(1); break;
         case 'h': help = 1; break;
         case 'H': check_hash = 0; break;
@@ -1006,10 +1093,13 @@ tmap_bwt_bwtupdate_main(int argc, char *argv[])
       }
   }
   if(1 != argc - optind || 1 == help) {
-      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-w INT -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-w INT -n INT -H -v -h] <in.fasta>\n", PACKAGE, argv[0]);
       return 1;
   }
-  tmap_bwt_update_hash(argv[optind], hash_width, check_hash);
+  if(num_threads <= 0) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
+  tmap_bwt_update_hash(argv[optind], hash_width, check_hash, num_threads);
 
   return 0;
 }
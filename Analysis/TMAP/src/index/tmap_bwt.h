@@ -55,6 +55,7 @@ typedef uint8_t ubyte_t;
 #define TMAP_BWT_OCC_INTERVAL 0x80
 #define TMAP_BWT_HASH_WIDTH_AUTO_MIN 8
 #define TMAP_BWT_HASH_WIDTH_AUTO_MAX 12
+#define TMAP_BWT_HASH_PREFIX_LEN 4  // the k-mer prefix length used to split the hash construction between threads
 
 // NB: we do not need a multi-level hash, just the highest-level hash.  We can
 // simulate the others from this one...
@@ -157,9 +158,10 @@ tmap_bwt_gen_cnt_table(tmap_bwt_t *bwt);
   @param  bwt         pointer to the bwt structure to update 
   @param  hash_width  the k-mer length to hash
   @param  check_hash  1 if we are to validate the hash, zero otherwise
+  @param  num_threads  the number of threads filling each level of the hash
   */
 void
-tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash);
+tmap_bwt_gen_hash(tmap_bwt_t *bwt, int32_t hash_width, uint32_t check_hash, int32_t num_threads);
 
 /*! 
   calculates the next occurrence given the previous occurrence and the next base
@@ -240,6 +242,13 @@ tmap_bwt_2occ4(const tmap_bwt_t *bwt, tmap_bwt_int_t k, tmap_bwt_int_t l, tmap_b
   */
 #define tmap_bwt_occ_intv(b, k) ((b)->bwt + tmap_bwt_get_occ_array_i16(b, k))
 
+/*!
+  @param  b   pointer to the bwt structure
+  @param  k   the zero-based index of the bwt character
+  @details    prefetches the occurrence array values and the bwt characters that tmap_bwt_occ reads for k
+  */
+#define tmap_bwt_prefetch_occ(b, k) (__builtin_prefetch(tmap_bwt_occ_intv(b, k)), __builtin_prefetch(&tmap_bwt_get_bwt16(b, k)))
+
 /*!  
   inverse Psi function
   @param  bwt  pointer to the bwt structure
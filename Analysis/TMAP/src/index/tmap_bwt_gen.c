@@ -29,10 +29,15 @@
 #include <stdint.h>
 #include <time.h>
 #include <unistd.h>
+#include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_progress.h"
 #include "../util/tmap_definitions.h"
+#include "../util/tmap_time.h"
 #include "../io/tmap_file.h"
 #include "tmap_refseq.h"
 #include "tmap_bwt.h"
@@ -101,6 +106,7 @@ typedef struct {
     uint32_t *packedText;
     uint8_t *textBuffer;
     uint32_t *packedShift;
+    int32_t numThreads;
 } tmap_bwt_gen_inc_t;
 
 static tmap_bwt_int_t
@@ -907,6 +913,91 @@ BWTIncSortKey(tmap_bwt_int_t* __restrict key, tmap_bwt_int_t* __restrict seq, co
   }
 }
 
+// one group of ranks to sort; the groups do not overlap
+typedef struct {
+    tmap_bwt_int_t *key;
+    tmap_bwt_int_t *seq;
+    tmap_bwt_int_t numItem;
+} tmap_bwt_gen_sort_key_task_t;
+
+static void
+BWTIncAddSortKeyTask(tmap_bwt_gen_sort_key_task_t *task, uint32_t *numTask, 
+                     tmap_bwt_int_t *key, tmap_bwt_int_t *seq, const tmap_bwt_int_t start, const tmap_bwt_int_t numItem)
+{
+  task[*numTask].key = key + start;
+  task[*numTask].seq = seq + start;
+  task[*numTask].numItem = numItem;
+  (*numTask)++;
+}
+
+#ifdef HAVE_LIBPTHREAD
+typedef struct {
+    tmap_bwt_gen_sort_key_task_t *task;
+    uint32_t numTask;
+    uint32_t nextTask;
+    pthread_mutex_t *mutex;
+} tmap_bwt_gen_sort_key_thread_data_t;
+
+static void *
+BWTIncSortKeyThreadWorker(void *arg)
+{
+  tmap_bwt_gen_sort_key_thread_data_t *data = (tmap_bwt_gen_sort_key_thread_data_t*)arg;
+  uint32_t i;
+
+  while(1) {
+      pthread_mutex_lock(data->mutex);
+      i = data->nextTask++;
+      pthread_mutex_unlock(data->mutex);
+      if(data->numTask <= i) break;
+      BWTIncSortKey(data->task[i].key, data->task[i].seq, data->task[i].numItem);
+  }
+
+  return arg;
+}
+#endif
+
+// each group is sorted on its own, so the result does not depend on the number of threads
+static void
+BWTIncSortKeyTasks(tmap_bwt_gen_sort_key_task_t *task, const uint32_t numTask, int32_t numThreads)
+{
+  uint32_t i;
+#ifdef HAVE_LIBPTHREAD
+  pthread_attr_t attr;
+  pthread_t *threads = NULL;
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  tmap_bwt_gen_sort_key_thread_data_t data;
+  int32_t j;
+
+  if(numTask < (uint32_t)numThreads) numThreads = numTask;
+  if(1 < numThreads) {
+      data.task = task;
+      data.numTask = numTask;
+      data.nextTask = 0;
+      data.mutex = &mutex;
+
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+      threads = tmap_calloc(numThreads, sizeof(pthread_t), "threads");
+      for(j=0;j<numThreads;j++) {
+          if(0 != pthread_create(&threads[j], &attr, BWTIncSortKeyThreadWorker, &data)) {
+              tmap_error("error creating threads", Exit, ThreadError);
+          }
+      }
+      for(j=0;j<numThreads;j++) {
+          if(0 != pthread_join(threads[j], NULL)) {
+              tmap_error("error joining threads", Exit, ThreadError);
+          }
+      }
+      free(threads);
+      pthread_attr_destroy(&attr);
+      return;
+  }
+#endif
+  for (i=0; i<numTask; i++) {
+      BWTIncSortKey(task[i].key, task[i].seq, task[i].numItem);
+  }
+}
+
 static void 
 BWTIncBuildRelativeRank(tmap_bwt_int_t* __restrict sortedRank, tmap_bwt_int_t* __restrict seq,
                         tmap_bwt_int_t* __restrict relativeRank, const tmap_bwt_int_t numItem,
@@ -1345,6 +1436,8 @@ BWTIncConstruct(tmap_bwt_gen_inc_t *bwtInc, const tmap_bwt_int_t numChar)
   tmap_bwt_int_t *relativeRank, *seq, *sortedRank;
   uint32_t *insertBwt, *mergedBwt;
   tmap_bwt_int_t newInverseSa0RelativeRank, oldInverseSa0RelativeRank, newInverseSa0;
+  tmap_bwt_gen_sort_key_task_t sortKeyTask[ALPHABET_SIZE + 1];
+  uint32_t numSortKeyTask;
 
 #ifdef DEBUG
   if (numChar > bwtInc->buildSize) {
@@ -1413,19 +1506,21 @@ BWTIncConstruct(tmap_bwt_gen_inc_t *bwtInc, const tmap_bwt_int_t numChar)
                                                         numChar, bwtInc->cumulativeCountInCurrentBuild, bwtInc->firstCharInLastIteration);
 
       // Sort rank by ALPHABET_SIZE + 2 groups (or ALPHABET_SIZE + 1 groups when inverseSa0 sit on the border of a group)
+      numSortKeyTask = 0;
       for (i=0; i<ALPHABET_SIZE; i++) {
           if (bwtInc->cumulativeCountInCurrentBuild[i] > oldInverseSa0RelativeRank ||
               bwtInc->cumulativeCountInCurrentBuild[i+1] <= oldInverseSa0RelativeRank) {
-              BWTIncSortKey(sortedRank + bwtInc->cumulativeCountInCurrentBuild[i], seq + bwtInc->cumulativeCountInCurrentBuild[i], bwtInc->cumulativeCountInCurrentBuild[i+1] - bwtInc->cumulativeCountInCurrentBuild[i]);
+              BWTIncAddSortKeyTask(sortKeyTask, &numSortKeyTask, sortedRank, seq, bwtInc->cumulativeCountInCurrentBuild[i], bwtInc->cumulativeCountInCurrentBuild[i+1] - bwtInc->cumulativeCountInCurrentBuild[i]);
           } else {
               if (bwtInc->cumulativeCountInCurrentBuild[i] < oldInverseSa0RelativeRank) {
-                  BWTIncSortKey(sortedRank + bwtInc->cumulativeCountInCurrentBuild[i], seq + bwtInc->cumulativeCountInCurrentBuild[i], oldInverseSa0RelativeRank - bwtInc->cumulativeCountInCurrentBuild[i]);
+                  BWTIncAddSortKeyTask(sortKeyTask, &numSortKeyTask, sortedRank, seq, bwtInc->cumulativeCountInCurrentBuild[i], oldInverseSa0RelativeRank - bwtInc->cumulativeCountInCurrentBuild[i]);
               }
               if (bwtInc->cumulativeCountInCurrentBuild[i+1] > oldInverseSa0RelativeRank + 1) {
-                  BWTIncSortKey(sortedRank + oldInverseSa0RelativeRank + 1, seq + oldInverseSa0RelativeRank + 1, bwtInc->cumulativeCountInCurrentBuild[i+1] - oldInverseSa0RelativeRank - 1);
+                  BWTIncAddSortKeyTask(sortKeyTask, &numSortKeyTask, sortedRank, seq, oldInverseSa0RelativeRank + 1, bwtInc->cumulativeCountInCurrentBuild[i+1] - oldInverseSa0RelativeRank - 1);
               }
           }
       }
+      BWTIncSortKeyTasks(sortKeyTask, numSortKeyTask, bwtInc->numThreads);
 
       // build relative rank; sortedRank is updated for merging to cater for the fact that $ is not encoded in bwt
       // the cumulative freq information is used to make sure that inverseSa0 and suffix beginning with different characters are kept in different unsorted groups)
@@ -1490,7 +1585,8 @@ BWTIncConstruct(tmap_bwt_gen_inc_t *bwtInc, const tmap_bwt_int_t numChar)
 
 tmap_bwt_gen_inc_t *
 BWTIncConstructFromPacked(const char *inputFileName, 
-                          const tmap_bwt_int_t initialMaxBuildSize, const tmap_bwt_int_t incMaxBuildSize)
+                          const tmap_bwt_int_t initialMaxBuildSize, const tmap_bwt_int_t incMaxBuildSize,
+                          int32_t numThreads)
 {
 
   FILE *packedFile;
@@ -1520,6 +1616,7 @@ BWTIncConstructFromPacked(const char *inputFileName,
   totalTextLength = TextLengthFromBytePacked(packedFileLen, BIT_PER_CHAR, lastByteLength);
 
   bwtInc = BWTIncCreate(totalTextLength, initialMaxBuildSize, incMaxBuildSize);
+  bwtInc->numThreads = numThreads;
 
   BWTIncSetBuildSizeAndTextAddr(bwtInc);
 
@@ -1658,7 +1755,7 @@ tmap_bwt_tune_hash_width(uint64_t ref_len)
 }
 
 void 
-tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash)
+tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash, int32_t num_threads)
 {
   tmap_bwt_gen_inc_t *bwtInc=NULL;
   tmap_bwt_t *bwt=NULL;
@@ -1667,6 +1764,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
   char *fn_pac=NULL;
   tmap_refseq_t *refseq=NULL;
   uint64_t ref_len;
+  double start_time = tmap_time_realtime();
 
   tmap_progress_print("constructing the BWT string from the packed FASTA");
 
@@ -1688,7 +1786,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
       if(TMAP_PAC_COMPRESSION != TMAP_FILE_NO_COMPRESSION) { // the below uses fseek
           tmap_error("PAC compression not supported", Exit, OutOfRange);
       }
-      bwtInc = BWTIncConstructFromPacked(fn_pac, 10000000, 10000000);
+      bwtInc = BWTIncConstructFromPacked(fn_pac, 10000000, 10000000, num_threads);
       BWTSaveBwtCodeAndOcc(bwt, bwtInc->bwt, fn_fasta, occ_interval);
       BWTIncFree(bwtInc);
       free(fn_pac);
@@ -1729,7 +1827,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
   }
   tmap_bwt_destroy(bwt);
 
-  tmap_progress_print2("constructed the BWT string from the packed FASTA");
+  tmap_progress_print2("constructed the BWT string from the packed FASTA in %.2f sec", tmap_time_realtime() - start_time);
 
   if(INT32_MAX == hash_width) {
       hash_width = tmap_bwt_tune_hash_width(ref_len);
@@ -1738,7 +1836,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
 
   if(0 < hash_width) {
       bwt = tmap_bwt_read(fn_fasta); 
-      tmap_bwt_gen_hash(bwt, hash_width, check_hash);
+      tmap_bwt_gen_hash(bwt, hash_width, check_hash, num_threads);
       tmap_bwt_write(fn_fasta, bwt);
       tmap_bwt_destroy(bwt);
   }
@@ -1748,7 +1846,7 @@ tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval,
 }
 
 void 
-tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_hash)
+tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_hash, int32_t num_threads)
 {
   int32_t i;
   tmap_bwt_t *bwt;
@@ -1774,7 +1872,7 @@ tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_has
       bwt->hash_k = bwt->hash_l = NULL;
 
       // new hash
-      tmap_bwt_gen_hash(bwt, hash_width, check_hash);
+      tmap_bwt_gen_hash(bwt, hash_width, check_hash, num_threads);
 
       // write
       tmap_bwt_write(fn_fasta, bwt);
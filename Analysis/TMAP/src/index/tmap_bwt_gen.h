@@ -47,18 +47,20 @@ tmap_bwt_tune_hash_width(uint64_t ref_len);
   @param  occ_interval  the desired occurrence interval
   @param  hash_width    the desired k-mer hash width
   @param  check_hash    1 to validate the hash, 0 otherwise
+  @param  num_threads   the number of threads used to sort the bwtsw keys and build the hash
   */
 void 
-tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash);
+tmap_bwt_pac2bwt(const char *fn_fasta, uint32_t is_large, int32_t occ_interval, int32_t hash_width, int32_t check_hash, int32_t num_threads);
 
 /*! 
   updates a bwt FASTA file for a new hash width
   @param  fn_fasta      file name of the FASTA file
   @param  hash_width    the desired k-mer hash width
   @param  check_hash    1 to validate the hash, 0 otherwise
+  @param  num_threads   the number of threads used to build the hash
   */
 void 
-tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_hash);
+tmap_bwt_update_hash(const char *fn_fasta, int32_t hash_width, int32_t check_hash, int32_t num_threads);
 
 /*! 
   @param  T  the input string
@@ -41,6 +41,12 @@ tmap_bwt_match_cal_width_reverse(const tmap_bwt_t *bwt, int len, const char *str
   tmap_bwt_match_hash_cal_width_reverse(bwt, len, str, width, NULL);
 }
 
+void
+tmap_bwt_match_cal_width_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const char **str, tmap_bwt_match_width_t **width)
+{
+  tmap_bwt_match_hash_cal_width_reverse_batch(bwt, n, len, str, width, NULL);
+}
+
 inline tmap_bwt_int_t
 tmap_bwt_match_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa)
 {
@@ -53,6 +59,13 @@ tmap_bwt_match_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str,
   return tmap_bwt_match_hash_exact_reverse(bwt, len, str, match_sa, NULL);
 }
 
+void
+tmap_bwt_match_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const uint8_t **str, 
+                                   tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *num)
+{
+  tmap_bwt_match_hash_exact_reverse_batch(bwt, n, len, str, match_sa, num, NULL);
+}
+
 inline tmap_bwt_int_t
 tmap_bwt_match_exact_alt(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa)
 {
@@ -86,6 +86,17 @@ tmap_bwt_match_cal_width_forward(const tmap_bwt_t *bwt, int len, const char *str
 void
 tmap_bwt_match_cal_width_reverse(const tmap_bwt_t *bwt, int len, const char *str, tmap_bwt_match_width_t *width);
 
+/*! 
+  tmap_bwt_match_cal_width_reverse for several strings at once, see tmap_bwt_match_hash_cal_width_reverse_batch
+  @param  bwt    the reverse BWT being used to search
+  @param  n      the number of strings
+  @param  len    the length of each string
+  @param  str    the strings with bases in integer format
+  @param  width  the width array of each string
+*/
+void
+tmap_bwt_match_cal_width_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const char **str, tmap_bwt_match_width_t **width);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -108,6 +119,19 @@ tmap_bwt_match_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bw
 tmap_bwt_int_t
 tmap_bwt_match_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa);
 
+/*! 
+  tmap_bwt_match_exact_reverse for several sequences at once, see tmap_bwt_match_hash_exact_reverse_batch
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  len       the length of each sequence
+  @param  str       the DNA sequences in 2-bit format
+  @param  match_sa  the match structure of each sequence to be returned
+  @param  num       the size of the SA interval of each sequence to be returned, 0 if none found
+  */
+void
+tmap_bwt_match_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const uint8_t **str, 
+                                   tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *num);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -372,6 +372,74 @@ tmap_bwt_match_hash_cal_width_reverse(const tmap_bwt_t *bwt, int len, const char
   width[len].bid = ++bid;
 }
 
+// the most searches advanced together by the batch functions
+#define TMAP_BWT_MATCH_HASH_BATCH_MAX 32
+
+// prefetches what tmap_bwt_match_hash_2occ reads to extend prev by c
+static inline void
+tmap_bwt_match_hash_prefetch_2occ(const tmap_bwt_t *bwt, const tmap_bwt_match_occ_t *prev, uint8_t c)
+{
+  if(bwt->hash_width <= prev->offset) {
+      if(0 < prev->k) tmap_bwt_prefetch_occ(bwt, prev->k - 1);
+      tmap_bwt_prefetch_occ(bwt, prev->l);
+  }
+  else {
+      __builtin_prefetch(&bwt->hash_k[prev->offset][(prev->hi << 2) + c]);
+      __builtin_prefetch(&bwt->hash_l[prev->offset][(prev->hi << 2) + c]);
+  }
+}
+
+void
+tmap_bwt_match_hash_cal_width_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const char **str, 
+                                            tmap_bwt_match_width_t **width, tmap_bwt_match_hash_t *hash)
+{
+  tmap_bwt_match_occ_t prev[TMAP_BWT_MATCH_HASH_BATCH_MAX], next;
+  int32_t bid[TMAP_BWT_MATCH_HASH_BATCH_MAX];
+  int32_t b, i, j, m, max_len;
+  uint8_t c;
+
+  for(b=0;b<n;b+=TMAP_BWT_MATCH_HASH_BATCH_MAX) {
+      m = (n - b < TMAP_BWT_MATCH_HASH_BATCH_MAX) ? n - b : TMAP_BWT_MATCH_HASH_BATCH_MAX;
+      max_len = 0;
+      for(j=0;j<m;j++) {
+          prev[j].k = 0; prev[j].l = bwt->seq_len;
+          prev[j].offset = 0;
+          prev[j].hi = 0;
+          bid[j] = 0;
+          if(max_len < len[b+j]) max_len = len[b+j];
+      }
+      for(i=0;i<max_len;i++) {
+          for(j=0;j<m;j++) {
+              if(i < len[b+j] && (c = (uint8_t)str[b+j][i]) < 4) {
+                  tmap_bwt_match_hash_prefetch_2occ(bwt, &prev[j], c);
+              }
+          }
+          for(j=0;j<m;j++) {
+              if(len[b+j] <= i) continue;
+              // same as tmap_bwt_match_hash_cal_width_reverse
+              c = (uint8_t)str[b+j][i];
+              if(c < 4) {
+                  tmap_bwt_match_hash_2occ(bwt, &prev[j], c, &next, hash);
+              }
+              if(3 < c || next.l < next.k || TMAP_BWT_INT_MAX == next.k) { // new width
+                  next.k = 0;
+                  next.l = bwt->seq_len;
+                  next.offset = 0;
+                  next.hi = 0;
+                  bid[j]++;
+              }
+              width[b+j][i].w = next.l - next.k + 1;
+              width[b+j][i].bid = bid[j];
+              prev[j] = next;
+          }
+      }
+      for(j=0;j<m;j++) {
+          width[b+j][len[b+j]].w = 0;
+          width[b+j][len[b+j]].bid = ++bid[j];
+      }
+  }
+}
+
 static inline tmap_bwt_int_t
 tmap_bwt_match_hash_forward_init(const tmap_bwt_t *bwt, int len, const uint8_t *str,
                                     tmap_bwt_match_occ_t *match_sa)
@@ -526,6 +594,69 @@ tmap_bwt_match_hash_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t
   return prev.l - prev.k + 1;
 }
 
+void
+tmap_bwt_match_hash_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const uint8_t **str, 
+                                        tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *num, tmap_bwt_match_hash_t *hash)
+{
+  int32_t lane[TMAP_BWT_MATCH_HASH_BATCH_MAX], pos[TMAP_BWT_MATCH_HASH_BATCH_MAX];
+  int32_t b, i, j, m, num_active, num_next;
+  tmap_bwt_match_occ_t *prev, next;
+  uint8_t c;
+
+  for(b=0;b<n;b+=TMAP_BWT_MATCH_HASH_BATCH_MAX) {
+      m = (n - b < TMAP_BWT_MATCH_HASH_BATCH_MAX) ? n - b : TMAP_BWT_MATCH_HASH_BATCH_MAX;
+      num_active = 0;
+      for(j=b;j<b+m;j++) {
+          // same start as tmap_bwt_match_hash_exact_reverse
+          num[j] = 0;
+          prev = &match_sa[j];
+          if(0 < bwt->hash_width && 0 < len[j]) { 
+              if(0 == tmap_bwt_match_hash_reverse_init(bwt, len[j], str[j], prev)) {
+                  continue;
+              }
+          }
+          else {
+              prev->k = 0; prev->l = bwt->seq_len;
+              prev->offset = 0;
+              prev->hi = 0;
+          }
+          lane[num_active] = j;
+          pos[num_active] = len[j] - prev->offset - 1;
+          num_active++;
+      }
+      while(0 < num_active) {
+          for(i=0;i<num_active;i++) {
+              if(0 <= pos[i] && (c = str[lane[i]][pos[i]]) < 4) {
+                  tmap_bwt_match_hash_prefetch_2occ(bwt, &match_sa[lane[i]], c);
+              }
+          }
+          for(i=num_next=0;i<num_active;i++) {
+              j = lane[i];
+              prev = &match_sa[j];
+              if(pos[i] < 0) { // all bases matched
+                  if(prev->k <= prev->l && TMAP_BWT_INT_MAX != prev->k) {
+                      num[j] = prev->l - prev->k + 1;
+                  }
+                  continue;
+              }
+              c = str[j][pos[i]];
+              if(TMAP_UNLIKELY(3 < c)) {
+                  prev->offset++; 
+                  prev->k = prev->l + 1;
+                  continue;
+              }
+              tmap_bwt_match_hash_2occ(bwt, prev, c, &next, hash);
+              (*prev) = next;
+              if(next.k > next.l || TMAP_BWT_INT_MAX == next.k) continue; // no match
+              lane[num_next] = j;
+              pos[num_next] = pos[i] - 1;
+              num_next++;
+          }
+          num_active = num_next;
+      }
+  }
+}
+
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact_alt(const tmap_bwt_t *bwt, int len, const uint8_t *str, 
                          tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash)
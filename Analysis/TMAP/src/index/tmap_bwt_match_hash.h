@@ -97,6 +97,24 @@ tmap_bwt_match_hash_occ4(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev, tmap
 void
 tmap_bwt_match_hash_2occ4(const tmap_bwt_t *bwt, tmap_bwt_match_occ_t *prev, tmap_bwt_match_occ_t next[4], tmap_bwt_match_hash_t *hash);
 
+/*! 
+  prefetches the bwt hash entries or occurrence blocks that tmap_bwt_match_hash_2occ4 reads for prev
+  @param  bwt      pointer to the bwt structure 
+  @param  prev     pointer to the match structure that will be extended
+  */
+static inline void
+tmap_bwt_match_hash_prefetch_2occ4(const tmap_bwt_t *bwt, const tmap_bwt_match_occ_t *prev)
+{
+  if(bwt->hash_width <= prev->offset) {
+      if(0 < prev->k) tmap_bwt_prefetch_occ(bwt, prev->k - 1);
+      tmap_bwt_prefetch_occ(bwt, prev->l);
+  }
+  else {
+      __builtin_prefetch(&bwt->hash_k[prev->offset][prev->hi << 2]);
+      __builtin_prefetch(&bwt->hash_l[prev->offset][prev->hi << 2]);
+  }
+}
+
 /*! 
   calculates a lower bound on the number of mismatches in the string for each interval [i,len-1]
   @param  bwt    the reverse BWT being used to search
@@ -119,6 +137,20 @@ tmap_bwt_match_hash_cal_width_forward(const tmap_bwt_t *bwt, int len, const char
 void
 tmap_bwt_match_hash_cal_width_reverse(const tmap_bwt_t *bwt, int len, const char *str, tmap_bwt_match_width_t *width, tmap_bwt_match_hash_t *hash);
 
+/*! 
+  tmap_bwt_match_hash_cal_width_reverse for several strings at once
+  @param  bwt    the reverse BWT being used to search
+  @param  n      the number of strings
+  @param  len    the length of each string
+  @param  str    the strings with bases in integer format
+  @param  width  the width array of each string
+  @param  hash   a occurence array hash
+  @details       the searches advance one base at a time in lockstep, and the occurrence blocks of every
+  search are prefetched before any of them is extended, so their cache misses overlap
+*/
+void
+tmap_bwt_match_hash_cal_width_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const char **str, tmap_bwt_match_width_t **width, tmap_bwt_match_hash_t *hash);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -143,6 +175,22 @@ tmap_bwt_match_hash_exact(const tmap_bwt_t *bwt, int len, const uint8_t *str, tm
 tmap_bwt_int_t
 tmap_bwt_match_hash_exact_reverse(const tmap_bwt_t *bwt, int len, const uint8_t *str, tmap_bwt_match_occ_t *match_sa, tmap_bwt_match_hash_t *hash);
 
+/*! 
+  tmap_bwt_match_hash_exact_reverse for several sequences at once
+  @param  bwt       pointer to the bwt structure 
+  @param  n         the number of sequences
+  @param  len       the length of each sequence
+  @param  str       the DNA sequences in 2-bit format
+  @param  match_sa  the match structure of each sequence to be returned
+  @param  num       the size of the SA interval of each sequence to be returned, 0 if none found
+  @param  hash      a occurence array hash
+  @details          the searches advance one base at a time in lockstep, and the occurrence blocks of every
+  search are prefetched before any of them is extended, so their cache misses overlap
+  */
+void
+tmap_bwt_match_hash_exact_reverse_batch(const tmap_bwt_t *bwt, int32_t n, const int32_t *len, const uint8_t **str, 
+                                        tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *num, tmap_bwt_match_hash_t *hash);
+
 /*! 
   computes the SA interval for the given sequence (if any), using forward search
   @param  bwt       pointer to the bwt structure 
@@ -131,6 +131,12 @@ tmap_bwt_smem1(const tmap_bwt_t *bwt, int32_t len, const uint8_t *q, int32_t x,
   for (i = x - 1; i >= -1; --i) { // backward search for MEMs
       c = (i < 0) ? 0 : q[i];
       if (c > 3) break;
+      // the intervals are independent, so fetch all of their occurrence blocks before extending any
+      for (j = 0; j < prev->n; ++j) {
+          tmap_bwt_smem_intv_t *p = &prev->a[j];
+          if (0 < p->x[0]) tmap_bwt_prefetch_occ(bwt, p->x[0] - 1);
+          tmap_bwt_prefetch_occ(bwt, p->x[0] - 1 + p->size);
+      }
       for (j = 0, curr->n = 0; j < prev->n; ++j) {
           tmap_bwt_smem_intv_t *p = &prev->a[j];
           tmap_bwt_smem_extend(bwt, p, ok, 1);
@@ -12,6 +12,7 @@
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_progress.h"
 #include "../util/tmap_definitions.h"
+#include "../util/tmap_time.h"
 #include "../server/tmap_shm.h"
 #include "tmap_refseq.h"
 #include "tmap_bwt_gen.h"
@@ -77,9 +78,11 @@ static void
 tmap_index_core(tmap_index_opt_t *opt)
 {
   uint64_t ref_len = 0;
+  double start_time = tmap_time_realtime();
 
   // pack the reference sequence
   ref_len = tmap_refseq_fasta2pac(opt->fn_fasta, TMAP_FILE_NO_COMPRESSION, 0, opt->old_v);
+  tmap_progress_print2("packed the reference in %.2f sec", tmap_time_realtime() - start_time);
       
   if(TMAP_INDEX_TOO_BIG_GENOME <= ref_len) { // too big (2^32 - 1)!
       tmap_error("Reference sequence too large", Exit, OutOfRange);
@@ -98,10 +101,10 @@ tmap_index_core(tmap_index_opt_t *opt)
   }
 
   // create the bwt 
-  tmap_bwt_pac2bwt(opt->fn_fasta, opt->is_large, opt->occ_interval, opt->hash_width, opt->check_hash);
+  tmap_bwt_pac2bwt(opt->fn_fasta, opt->is_large, opt->occ_interval, opt->hash_width, opt->check_hash, opt->num_threads);
 
   // create the suffix array
-  tmap_sa_bwt2sa(opt->fn_fasta, opt->sa_interval);
+  tmap_sa_bwt2sa(opt->fn_fasta, opt->sa_interval, opt->num_threads);
 
   // pack the reference sequence
   // ref_len = tmap_refseq_fasta2pac(opt->fn_fasta, TMAP_FILE_NO_COMPRESSION, 1, opt->old_v);
@@ -125,6 +128,7 @@ usage(tmap_index_opt_t *opt)
   tmap_file_fprintf(tmap_file_stderr, "                     \t\"bwtsw\" (large genomes)\n");
   tmap_file_fprintf(tmap_file_stderr, "                     \t\"is\" (short genomes)\n");
   tmap_file_fprintf(tmap_file_stderr, "         -H          do not validate the BWT hash [%d]\n", opt->check_hash);
+  tmap_file_fprintf(tmap_file_stderr, "         -n INT      the number of threads for the bwtsw key sort, the occurrence hash and the suffix array [%d]\n", opt->num_threads);
   tmap_file_fprintf(tmap_file_stderr, "         --version   print the index format that will be created and exit\n");
   tmap_file_fprintf(tmap_file_stderr, "         -v          print verbose progress information\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
@@ -146,6 +150,7 @@ tmap_index(int argc, char *argv[])
   opt.is_large = -1;
   opt.check_hash = 1;
   opt.old_v = 0;
+  opt.num_threads = 1;
       
   if(2 == argc && 0 == strcmp("--version", argv[1])) {
       tmap_file_stdout = tmap_file_fdopen(fileno(stdout), "wb", TMAP_FILE_NO_COMPRESSION);
@@ -154,7 +159,7 @@ tmap_index(int argc, char *argv[])
       return 0;
   }
 
-  while((c = getopt(argc, argv, "f:o:i:w:a:hvHp")) >= 0) {
+  while((c = getopt(argc, argv, "f:o:i:w:a:n:hvHp")) >= 0) {
       switch(c) {
         case 'f':
           opt.fn_fasta = tmap_strdup(optarg); break;
@@ -164,6 +169,8 @@ tmap_index(int argc, char *argv[])
           opt.sa_interval = atoi(optarg); break;
         case 'w':
           opt.hash_width = atoi(optarg); break;
+        case 'n':
+          opt.num_threads = atoi(optarg); break;
         case 'a':
           if(0 == strcmp("is", optarg)) opt.is_large = 0;
           else if(0 == strcmp("bwtsw", optarg)) opt.is_large = 1;
@@ -197,6 +204,9 @@ tmap_index(int argc, char *argv[])
   if(opt.sa_interval <= 0 || (1 < opt.sa_interval && 0 != (opt.sa_interval % 2))) {
       tmap_error("option -i out of range", Exit, CommandLineArgument);
   }
+  if(opt.num_threads <= 0) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
 
   tmap_index_core(&opt);
 
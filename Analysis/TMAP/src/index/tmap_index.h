@@ -56,6 +56,7 @@ typedef struct {
     int32_t is_large;  /*!< 0 to use the short BWT construction algorith, 1 otherwise (large BWT construction algorithm) */
     int32_t check_hash;  /*< 1 to validate the BWT hash, 0 otherwise */
     int32_t old_v;
+    int32_t num_threads;  /*!< the number of threads (-n) */
 } tmap_index_opt_t;
 
 /*! 
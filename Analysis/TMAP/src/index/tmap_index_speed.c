@@ -19,27 +19,71 @@
 #include "tmap_bwt_match.h"
 #include "tmap_index_speed.h"
 
+// looks up n kmers, together if there is more than one, and retrieves their positions
+// the positions are xor-ed into pacpos_sum so that their retrieval is not optimized away
+static int32_t
+tmap_index_speed_lookup(tmap_index_t *index, tmap_index_speed_opt_t *opt, int32_t n, const int32_t *lens, const uint8_t **strs,
+                        tmap_bwt_match_occ_t *match_sa, tmap_bwt_int_t *num, tmap_bwt_int_t *pacpos_sum)
+{
+  int32_t i, num_found = 0;
+  tmap_bwt_int_t k, pacpos;
+
+  if(1 == n) {
+      num[0] = tmap_bwt_match_exact_reverse(index->bwt, lens[0], strs[0], &match_sa[0]);
+  }
+  else {
+      tmap_bwt_match_exact_reverse_batch(index->bwt, n, lens, strs, match_sa, num);
+  }
+  for(i=0;i<n;i++) {
+      if(0 < num[i]) {
+          if(0 <= opt->enum_max_hits && (match_sa[i].l - match_sa[i].k + 1) <= opt->enum_max_hits) {
+              for(k=match_sa[i].k;k<=match_sa[i].l;k++) {
+                  // retrieve the packed position
+                  pacpos = index->bwt->seq_len - tmap_sa_pac_pos(index->sa, index->bwt, k) - opt->kmer_length + 1;
+                  (*pacpos_sum) ^= pacpos;
+              }
+          }
+          num_found++;
+      }
+  }
+  return num_found;
+}
+
 static int32_t  
-tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_index_speed_opt_t *opt)
+tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_bwt_int_t *pacpos_sum, tmap_index_speed_opt_t *opt)
 {
   tmap_rand_t *rand;
-  int32_t i, j, num_found, found;
+  int32_t i, j, num_found, n;
   tmap_bwt_int_t k, l;
   tmap_bwt_int_t pacpos;
-  uint8_t *seq = NULL;
-  tmap_bwt_match_occ_t cur;
+  uint8_t *seq = NULL, *seqs = NULL;
+  const uint8_t **strs = NULL;
+  int32_t *lens = NULL;
+  tmap_bwt_match_occ_t *match_sa = NULL;
+  tmap_bwt_int_t *num = NULL;
   clock_t start_clock = 0;
   tmap_bwt_int_t cntk[4], cntl[4], ok, ol;
 
   rand = tmap_rand_init(13);
-  if(0 == opt->func) seq = tmap_malloc(opt->kmer_length * sizeof(uint8_t), "seq");
+  if(0 == opt->func) {
+      seqs = tmap_malloc(opt->batch_size * opt->kmer_length * sizeof(uint8_t), "seqs");
+      strs = tmap_malloc(opt->batch_size * sizeof(uint8_t*), "strs");
+      lens = tmap_malloc(opt->batch_size * sizeof(int32_t), "lens");
+      match_sa = tmap_malloc(opt->batch_size * sizeof(tmap_bwt_match_occ_t), "match_sa");
+      num = tmap_malloc(opt->batch_size * sizeof(tmap_bwt_int_t), "num");
+      for(j=0;j<opt->batch_size;j++) {
+          strs[j] = seqs + (j * opt->kmer_length);
+          lens[j] = opt->kmer_length;
+      }
+  }
 
-  num_found = 0;
+  num_found = n = 0;
   for(i=0;i<opt->kmer_num;i++) {
       if(0 < i && 0 == (i % 1000000)) {
           tmap_progress_print2("processed %d kmers", i);
       }
       if(0 == opt->func) {
+          seq = seqs + (n * opt->kmer_length);
           if(tmap_rand_get(rand) < opt->rand_frac) {
               for(j=0;j<opt->kmer_length;j++) {
                   seq[j] = (uint8_t)(tmap_rand_get(rand) * 4);
@@ -53,20 +97,12 @@ tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_index_spee
                   continue;
               }
           }
-          found = 0;
-          start_clock = clock();
-          if(0 < tmap_bwt_match_exact_reverse(index->bwt, opt->kmer_length, seq, &cur)) {
-              if(0 <= opt->enum_max_hits && (cur.l - cur.k + 1) <= opt->enum_max_hits) {
-                  for(k=cur.k;k<=cur.l;k++) {
-                      // retrieve the packed position
-                      pacpos = index->bwt->seq_len - tmap_sa_pac_pos(index->sa, index->bwt, k) - opt->kmer_length + 1;
-                  }
-              }
-              found = 1;
-          }
-          (*total_clock) += clock() - start_clock;
-          if(0 < found) {
-              num_found++;
+          n++;
+          if(n == opt->batch_size || i == opt->kmer_num - 1) {
+              start_clock = clock();
+              num_found += tmap_index_speed_lookup(index, opt, n, lens, strs, match_sa, num, pacpos_sum);
+              (*total_clock) += clock() - start_clock;
+              n = 0;
           }
       }
       else {
@@ -99,7 +135,13 @@ tmap_index_speed_test(tmap_index_t *index, clock_t *total_clock, tmap_index_spee
   tmap_progress_print2("processed %d kmers", i);
 
   tmap_rand_destroy(rand);
-  if(0 == opt->func) free(seq);
+  if(0 == opt->func) {
+      free(seqs);
+      free(strs);
+      free(lens);
+      free(match_sa);
+      free(num);
+  }
 
   return num_found;
 }
@@ -111,6 +153,7 @@ tmap_index_speed_core(tmap_index_speed_opt_t *opt)
   clock_t total_clock= 0;
   time_t start_time, end_time;
   int32_t num_found;
+  tmap_bwt_int_t pacpos_sum = 0;
 
   // read in the index
   index = tmap_index_init(opt->fn_fasta, opt->shm_key);
@@ -127,7 +170,7 @@ tmap_index_speed_core(tmap_index_speed_opt_t *opt)
   start_time = time(NULL);
 
   // run the speed test
-  num_found = tmap_index_speed_test(index, &total_clock, opt);
+  num_found = tmap_index_speed_test(index, &total_clock, &pacpos_sum, opt);
 
   // clock off
   end_time = time(NULL);
@@ -139,6 +182,9 @@ tmap_index_speed_core(tmap_index_speed_opt_t *opt)
   tmap_progress_print2("[tmap index] found %d out of %d (%.2f%%)", num_found, opt->kmer_num, (100.0 * num_found) / opt->kmer_num);
   tmap_progress_print2("[tmap index] wallclock time: %d seconds", (int)difftime(end_time,start_time));
   tmap_progress_print2("[tmap index] index lookup cpu cycle time: %.2f seconds", (float)(total_clock) / CLOCKS_PER_SEC);
+  if(0 == opt->func) {
+      tmap_progress_print2("[tmap index] retrieved position checksum: %llu", (unsigned long long)pacpos_sum);
+  }
 }
 
 static int 
@@ -164,6 +210,7 @@ usage(tmap_index_speed_opt_t *opt)
   tmap_file_fprintf(tmap_file_stderr, "         -e INT      the maximum number of hits to enumerate with -F 0 (-1 for unlimited, 0 to disable) [%d]\n", opt->enum_max_hits);
   tmap_file_fprintf(tmap_file_stderr, "         -K INT      the kmer length to simulate with -F 0 [%d]\n", opt->kmer_length);
   tmap_file_fprintf(tmap_file_stderr, "         -R FLOAT    the fraction of random kmers with -F 0 [%.2lf]\n", opt->rand_frac);
+  tmap_file_fprintf(tmap_file_stderr, "         -B INT      the number of kmers to look up together with -F 0 [%d]\n", opt->batch_size);
   tmap_file_fprintf(tmap_file_stderr, "         -v          print verbose progress information\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
   tmap_file_fprintf(tmap_file_stderr, "\n");
@@ -184,8 +231,9 @@ tmap_index_speed(int argc, char *argv[])
   opt.rand_frac = 0.0;
   opt.shm_key = 0;
   opt.func = 0;
+  opt.batch_size = 1;
       
-  while((c = getopt(argc, argv, "f:k:w:e:K:N:R:F:hv")) >= 0) {
+  while((c = getopt(argc, argv, "f:k:w:e:K:N:R:F:B:hv")) >= 0) {
       switch(c) {
         case 'f':
           opt.fn_fasta = tmap_strdup(optarg); break;
@@ -205,6 +253,8 @@ tmap_index_speed(int argc, char *argv[])
           tmap_progress_set_verbosity(1); break;
         case 'F':
           opt.func = atoi(optarg); break;
+        case 'B':
+          opt.batch_size = atoi(optarg); break;
         case 'h':
         default:
           return usage(&opt);
@@ -232,6 +282,9 @@ tmap_index_speed(int argc, char *argv[])
   if(opt.func < 0 || 5 < opt.func) {
       tmap_error("the option -F must be between 0 and 5", Exit, CommandLineArgument);
   }
+  if(opt.batch_size <= 0) {
+      tmap_error("the option -B must be greater than zero", Exit, CommandLineArgument);
+  }
 
   tmap_index_speed_core(&opt);
 
@@ -19,6 +19,7 @@ typedef struct {
     int32_t kmer_num;  /*!< the number of kmers to simulate (-N) */
     double rand_frac;  /*!< the fraction of random kmers (-R) */
     int32_t func;  /*!< the function to test (-F) */
+    int32_t batch_size;  /*!< the number of kmers to look up together with -F 0 (-B) */
 } tmap_index_speed_opt_t;
 
 /*! 
@@ -4,11 +4,17 @@
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <sys/mman.h>
+#include <config.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_progress.h"
 #include "../util/tmap_definitions.h"
+#include "../util/tmap_time.h"
 #include "../io/tmap_file.h"
 #include "tmap_bwt.h"
 #include "tmap_bwt_match.h"
@@ -39,6 +45,33 @@ tmap_sa_read(const char *fn_fasta)
 
   sa = tmap_calloc(1, sizeof(tmap_sa_t), "sa");
 
+#ifdef TMAP_MMAP
+  size_t fp_length = 0;
+  tmap_bwt_int_t *sa_ptr = NULL, sa_intv = 0;
+
+  sa_ptr = tmap_file_mmap(fp_sa, &fp_length);
+  if(NULL == sa_ptr || fp_length < 3 * sizeof(tmap_bwt_int_t)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+  sa->mmap_fp = (void *)fp_sa;
+  sa->primary = sa_ptr[0];
+  sa_intv = sa_ptr[1];
+  sa->sa_intv = sa_intv;
+  sa->seq_len = sa_ptr[2];
+
+  sa->n_sa = (sa->seq_len + sa->sa_intv) / sa->sa_intv;
+  if(fp_length < (2 + sa->n_sa) * sizeof(tmap_bwt_int_t)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+  // the entries start right after the header, so sa[0] overlays seq_len and only the first
+  // page becomes private to this process when it is set
+  sa->sa = sa_ptr + 2;
+  if(0 != mprotect(sa_ptr, fp_sa->PageSize, PROT_READ | PROT_WRITE)) {
+      tmap_error(fn_sa, Exit, ReadFileError);
+  }
+  sa->sa[0] = -1;
+  mprotect(sa_ptr, fp_sa->PageSize, PROT_READ);
+#else
   if(1 != tmap_file_fread(&sa->primary, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->seq_len, sizeof(tmap_bwt_int_t), 1, fp_sa)) {
@@ -53,9 +86,11 @@ tmap_sa_read(const char *fn_fasta)
       tmap_error(NULL, Exit, ReadFileError);
   }
 
+  tmap_file_fclose(fp_sa);
+#endif
+
   sa->sa_intv_log2 = tmap_log2(sa->sa_intv);
 
-  tmap_file_fclose(fp_sa);
   free(fn_sa);
 
   sa->is_shm = 0;
@@ -195,7 +230,8 @@ tmap_sa_destroy(tmap_sa_t *sa)
   free(sa);
   }
   else {
-  free(sa->sa);
+  if(NULL != sa->mmap_fp) tmap_file_fclose((tmap_file_t *)sa->mmap_fp);
+  else free(sa->sa);
   free(sa);
   }
 }
@@ -247,13 +283,159 @@ tmap_sa_pac_pos(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k)
 
 extern int32_t debug_on;
 
+#if defined(HAVE_LIBPTHREAD) && !defined(TMAP_BWT_32_BIT)
+/*
+   Concurrent SA sampling.  The SA is sampled by walking the inverse Psi (LF) cycle, which
+   visits every BWT row once, from the row of the empty suffix down to text position zero.
+   Walkers start at evenly spaced rows whose text positions are not known yet.  Each walker
+   claims the sampled rows it visits by writing its id and its step count into the SA slot,
+   and stops at the first slot already claimed by another walker.  Since the cycle is
+   covered exactly once, the step counts at the meeting points give every walker's start
+   position relative to walker zero, which starts at the empty suffix, and the slots are
+   then rewritten with text positions.  The result does not depend on thread timing.
+ */
+#define TMAP_SA_WALKERS_PER_THREAD 16
+#define TMAP_SA_WALKER_SHIFT 40  // the slot holds (walker id << shift) | steps until resolved
+#define TMAP_SA_WALKER_STEPS(x) ((x) & ((((tmap_bwt_int_t)1) << TMAP_SA_WALKER_SHIFT) - 1))
+#define TMAP_SA_SLOT_EMPTY TMAP_BWT_INT_MAX
+
+typedef struct {
+    tmap_bwt_int_t start;  /*!< the BWT row the walker starts at */
+    tmap_bwt_int_t steps;  /*!< the number of steps until it met a claimed slot */
+    tmap_bwt_int_t met;  /*!< the value of that slot */
+    tmap_bwt_int_t pos;  /*!< the text position of the start row, once resolved */
+    int32_t resolved;  /*!< 1 if pos is known */
+} tmap_sa_walker_t;
+
+typedef struct {
+    const tmap_bwt_t *bwt;
+    tmap_sa_t *sa;
+    tmap_sa_walker_t *walkers;
+    int32_t num_walkers;
+    int32_t next_walker;
+    pthread_mutex_t *mutex;
+} tmap_sa_bwt2sa_thread_data_t;
+
+static void
+tmap_sa_bwt2sa_walk(const tmap_bwt_t *bwt, tmap_sa_t *sa, tmap_sa_walker_t *walker, int32_t id)
+{
+  tmap_bwt_int_t isa = walker->start, steps = 0, claim;
+
+  if(0 == id) { // walker zero has claimed row zero up front
+      isa = tmap_bwt_invPsi(bwt, isa);
+      steps++;
+  }
+  while(1) {
+      if(0 == isa % sa->sa_intv) {
+          claim = (((tmap_bwt_int_t)id) << TMAP_SA_WALKER_SHIFT) | steps;
+          if(!__sync_bool_compare_and_swap(&sa->sa[isa / sa->sa_intv], TMAP_SA_SLOT_EMPTY, claim)) {
+              walker->steps = steps;
+              walker->met = sa->sa[isa / sa->sa_intv];
+              break;
+          }
+      }
+      isa = tmap_bwt_invPsi(bwt, isa);
+      steps++;
+  }
+}
+
+static void *
+tmap_sa_bwt2sa_thread_worker(void *arg)
+{
+  tmap_sa_bwt2sa_thread_data_t *data = (tmap_sa_bwt2sa_thread_data_t*)arg;
+  int32_t id;
+
+  while(1) {
+      pthread_mutex_lock(data->mutex);
+      id = data->next_walker++;
+      pthread_mutex_unlock(data->mutex);
+      if(data->num_walkers <= id) break;
+      tmap_sa_bwt2sa_walk(data->bwt, data->sa, &data->walkers[id], id);
+  }
+
+  return arg;
+}
+
+static void
+tmap_sa_bwt2sa_threads(const tmap_bwt_t *bwt, tmap_sa_t *sa, int32_t num_threads)
+{
+  int32_t i, num_walkers, num_resolved;
+  tmap_bwt_int_t j, n = bwt->seq_len + 1; // the number of BWT rows, including the empty suffix
+  tmap_sa_walker_t *walkers = NULL, *met;
+  pthread_attr_t attr;
+  pthread_t *threads = NULL;
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  tmap_sa_bwt2sa_thread_data_t data;
+
+  num_walkers = num_threads * TMAP_SA_WALKERS_PER_THREAD;
+  if(n < (tmap_bwt_int_t)num_walkers) num_walkers = n;
+  walkers = tmap_calloc(num_walkers, sizeof(tmap_sa_walker_t), "walkers");
+  for(i=0;i<num_walkers;i++) {
+      walkers[i].start = (n * i) / num_walkers;
+  }
+  walkers[0].pos = bwt->seq_len;
+  walkers[0].resolved = 1;
+
+  for(j=0;j<sa->n_sa;j++) {
+      sa->sa[j] = TMAP_SA_SLOT_EMPTY;
+  }
+  sa->sa[0] = 0; // walker zero, step zero
+
+  data.bwt = bwt;
+  data.sa = sa;
+  data.walkers = walkers;
+  data.num_walkers = num_walkers;
+  data.next_walker = 0;
+  data.mutex = &mutex;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  threads = tmap_calloc(num_threads, sizeof(pthread_t), "threads");
+  for(i=0;i<num_threads;i++) {
+      if(0 != pthread_create(&threads[i], &attr, tmap_sa_bwt2sa_thread_worker, &data)) {
+          tmap_error("error creating threads", Exit, ThreadError);
+      }
+  }
+  for(i=0;i<num_threads;i++) {
+      if(0 != pthread_join(threads[i], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
+      }
+  }
+  free(threads);
+  pthread_attr_destroy(&attr);
+
+  // every walker but zero stopped on a slot claimed by a walker further along the cycle,
+  // so following the meeting points always ends at walker zero
+  num_resolved = 1;
+  while(num_resolved < num_walkers) {
+      for(i=1;i<num_walkers;i++) {
+          if(1 == walkers[i].resolved) continue;
+          met = &walkers[walkers[i].met >> TMAP_SA_WALKER_SHIFT];
+          if(0 == met->resolved) continue;
+          // the step from text position zero wraps around to the empty suffix
+          walkers[i].pos = (met->pos + n - TMAP_SA_WALKER_STEPS(walkers[i].met) + walkers[i].steps) % n;
+          walkers[i].resolved = 1;
+          num_resolved++;
+      }
+  }
+
+  for(j=0;j<sa->n_sa;j++) {
+      if(TMAP_SA_SLOT_EMPTY == sa->sa[j]) tmap_bug();
+      sa->sa[j] = walkers[sa->sa[j] >> TMAP_SA_WALKER_SHIFT].pos - TMAP_SA_WALKER_STEPS(sa->sa[j]);
+  }
+
+  free(walkers);
+}
+#endif
+
 void
-tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
+tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv, int32_t num_threads)
 {
   int64_t isa, s; // S(isa) = sa
   uint64_t i;
   tmap_bwt_t *bwt = NULL;
   tmap_sa_t *sa = NULL;
+  double start_time = tmap_time_realtime();
 
   tmap_progress_print("constructing the SA from the BWT string");
 
@@ -268,6 +450,12 @@ tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
 
   // calculate SA value
   sa->sa = tmap_calloc(sa->n_sa, sizeof(tmap_bwt_int_t), "sa->sa");
+#if defined(HAVE_LIBPTHREAD) && !defined(TMAP_BWT_32_BIT)
+  if(1 < num_threads) {
+      tmap_sa_bwt2sa_threads(bwt, sa, num_threads);
+  }
+  else {
+#endif
   isa = 0; s = bwt->seq_len;
   for(i = 0; i < bwt->seq_len; ++i) {
       if(isa % intv == 0) sa->sa[isa/intv] = s;
@@ -275,6 +463,9 @@ tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
       isa = tmap_bwt_invPsi(bwt, isa);
   }
   if(isa % intv == 0) sa->sa[isa/intv] = s;
+#if defined(HAVE_LIBPTHREAD) && !defined(TMAP_BWT_32_BIT)
+  }
+#endif
   sa->sa[0] = (tmap_bwt_int_t)-1; // before this line, bwt->sa[0] = bwt->seq_len
 
   tmap_sa_write(fn_fasta, sa);
@@ -284,7 +475,7 @@ tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv)
   sa=NULL;
   bwt=NULL;
 
-  tmap_progress_print2("constructed the SA from the BWT string");
+  tmap_progress_print2("constructed the SA from the BWT string in %.2f sec", tmap_time_realtime() - start_time);
 }
 
 /* 
@@ -939,25 +1130,29 @@ tmap_sa_gen_short(const uint8_t *T, int32_t *SA, uint32_t n)
 int
 tmap_sa_bwt2sa_main(int argc, char *argv[])
 {
-  int c, intv = TMAP_SA_INTERVAL, help=0;
+  int c, intv = TMAP_SA_INTERVAL, help=0, num_threads = 1;
 
-  while((c = getopt(argc, argv, "i:vh")) >= 0) {
+  while((c = getopt(argc, argv, "i:n:vh")) >= 0) {
       switch(c) {
         case 'i': intv = atoi(optarg); break;
+        case 'n': num_threads = atoi(optarg); break;
         case 'v': tmap_progress_set_verbosity(1); break;
         case 'h': help = 1; break;
         default: return 1;
       }
   }
   if(1 != argc - optind || 1 == help) {
-      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-i INT -vh] <in.fasta>\n", PACKAGE, argv[0]);
+      tmap_file_fprintf(tmap_file_stderr, "Usage: %s %s [-i INT -n INT -vh] <in.fasta>\n", PACKAGE, argv[0]);
       return 1;
   }
   if(intv <= 0 || (1 < intv && 0 != (intv % 2))) {
       tmap_error("option -i out of range", Exit, CommandLineArgument);
   }
+  if(num_threads <= 0) {
+      tmap_error("option -n out of range", Exit, CommandLineArgument);
+  }
 
-  tmap_sa_bwt2sa(argv[optind], intv);
+  tmap_sa_bwt2sa(argv[optind], intv, num_threads);
 
   return 0;
 }
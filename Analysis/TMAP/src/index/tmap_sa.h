@@ -24,6 +24,7 @@ typedef struct {
     uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
     // Not stored in the file
     uint32_t sa_intv_log2;  /*!< the log2 suffix array interval (sampled) */
+    void *mmap_fp;  /*!< the mapped SA file, if the entries point into it */
 } tmap_sa_t;
 
 /*! 
@@ -107,9 +108,10 @@ tmap_sa_pac_pos(const tmap_sa_t *sa, const tmap_bwt_t *bwt, tmap_bwt_int_t k);
 /*! 
   @param  fn_fasta  the FASTA file name
   @param  intv      the suffix array interval
+  @param  num_threads  the number of threads sampling the suffix array
   */
 void
-tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv);
+tmap_sa_bwt2sa(const char *fn_fasta, uint32_t intv, int32_t num_threads);
 
 /*! 
   constructs the suffix array of a given string.
@@ -332,21 +332,67 @@ tmap_file_fread(void *ptr, size_t size, size_t count, tmap_file_t *fp)
   return num_read;
 }
 
+// huge page size used to align mappings when tmap_file_mmap_hugepages is set
+#define TMAP_FILE_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+static int32_t tmap_file_mmap_hugepages = 0;
+
+void
+tmap_file_mmap_set_hugepages(int32_t hugepages)
+{
+  tmap_file_mmap_hugepages = hugepages;
+}
+
 void *
 tmap_file_mmap(tmap_file_t *fp, size_t *fp_length)
 {
-	  // size_t len;
+  struct stat statbuf;
+  char *ptr = MAP_FAILED;
+
+  if(0 != fstat(fileno(fp->fp), &statbuf)) {
+      return NULL;
+  }
+  fp->fileLen = statbuf.st_size;
 
-	  struct stat statbuf;
-	  fstat ( fileno(fp->fp),&statbuf );
-	  fp->fileLen = statbuf.st_size;
+  if(fp_length)
+	  *fp_length = fp->fileLen;
+  if(0 == fp->fileLen) {
+      return NULL;
+  }
 
-	  if(fp_length)
-		  *fp_length = fp->fileLen;
+  if(1 == tmap_file_mmap_hugepages && TMAP_FILE_HUGEPAGE_SIZE <= fp->fileLen) {
+      // reserve enough address space to start the file on a huge page boundary, so the
+      // kernel can collapse it into huge pages, then give back what is not used
+      size_t reserve = fp->fileLen + TMAP_FILE_HUGEPAGE_SIZE;
+      char *base = mmap(0, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if(MAP_FAILED != base) {
+          char *aligned = (char *)(((size_t)base + TMAP_FILE_HUGEPAGE_SIZE - 1) & ~((size_t)TMAP_FILE_HUGEPAGE_SIZE - 1));
+          size_t tail = (aligned + fp->fileLen) - base;
+          tail = (tail + fp->PageSize - 1) & ~(fp->PageSize - 1);
+          ptr = mmap(aligned, fp->fileLen, PROT_READ, MAP_PRIVATE | MAP_FIXED, fileno(fp->fp), 0);
+          if(MAP_FAILED == ptr) {
+              munmap(base, reserve);
+          }
+          else {
+              if(base < aligned) munmap(base, aligned - base);
+              if(tail < reserve) munmap(base + tail, reserve - tail);
+#ifdef MADV_HUGEPAGE
+              madvise(ptr, fp->fileLen, MADV_HUGEPAGE);
+#endif
+          }
+      }
+  }
+  if(MAP_FAILED == ptr) {
+      ptr = mmap(0, fp->fileLen, PROT_READ, MAP_PRIVATE, fileno(fp->fp), 0);
+      if(MAP_FAILED == ptr) {
+          return NULL;
+      }
+  }
 
-	  fp->CurrentAllocPtr = ( char * ) mmap ( 0,fp->fileLen,PROT_READ,MAP_PRIVATE,fileno(fp->fp),0);
+  fp->CurrentAllocPtr = ptr;
+  fp->CurrentAllocLen = fp->fileLen;
 
-	  return fp->CurrentAllocPtr;
+  return fp->CurrentAllocPtr;
 }
 
 int 
@@ -46,12 +46,11 @@ typedef struct {
     int32_t n_unused;  /*!< for bz2 function 'BZ2_bzReadGetUnused' */
     int32_t bzerror;  /*!< stores the last BZ2 error */
     int32_t open_type;  /*!< the type of bzip2 stream */
-    char *CurrentAllocPtr;
-    int CurrentAllocLen;
+#endif
+    char *CurrentAllocPtr;  /*!< the read-only mapping made by tmap_file_mmap, if any */
+    size_t CurrentAllocLen;  /*!< the length of the mapping */
     size_t PageSize;
     size_t fileLen;
-
-#endif
 } tmap_file_t;
 
 extern tmap_file_t *tmap_file_stdout; // to use, initialize this in your main
@@ -120,11 +119,23 @@ tmap_file_fread2(tmap_file_t *fp, void *ptr, unsigned int len);
   emulates mmap
   @param  fp   pointer to the file structure from which to mmap
   @param  fp_length  return pointer to size of the file in bytes
-  @return      mmap'd pointer to the file data
+  @return      mmap'd pointer to the file data, NULL on failure
+  @details     the whole file is mapped read-only and copy-on-write, so that every process
+  mapping the same index shares its pages through the page cache; the mapping is released
+  when the file is closed
   */
 void *
 tmap_file_mmap(tmap_file_t *fp, size_t *fp_length);
 
+/*!
+  ask for transparent huge pages on later tmap_file_mmap calls
+  @param  hugepages  1 to place mappings on huge page boundaries and advise huge pages, 0 otherwise
+  @details  the kernel only backs file mappings with huge pages if it supports read-only huge
+  pages for file systems; an index stored on hugetlbfs is always backed by huge pages
+  */
+void
+tmap_file_mmap_set_hugepages(int32_t hugepages);
+
 
 /*! 
   emulates fgetc from stdio.h
@@ -208,6 +208,9 @@ tmap_map1_thread_map_core(void **data, tmap_seq_t *seqs[4], int32_t seq_len,
   tmap_map_opt_t opt_local = (*opt); // copy over values
   tmap_map_sams_t *sams = NULL;
   tmap_string_t *bases = NULL;
+  int32_t num_widths, width_len[2];
+  const char *width_str[2];
+  tmap_bwt_match_width_t *widths[2];
 
   if((0 < opt->min_seq_len && seq_len < opt->min_seq_len)
      || (0 < opt->max_seq_len && opt->max_seq_len < seq_len)) {
@@ -244,14 +247,23 @@ tmap_map1_thread_map_core(void **data, tmap_seq_t *seqs[4], int32_t seq_len,
       memset(d->width, 0, (1+d->width_length) * sizeof(tmap_bwt_match_width_t));
   }
   // NB: use the reversed sequence
-  tmap_bwt_match_cal_width_reverse(index->bwt, seed2_len, bases->s + (seq_len - seed2_len), d->width);
+  width_len[0] = seed2_len;
+  width_str[0] = bases->s + (seq_len - seed2_len);
+  widths[0] = d->width;
+  num_widths = 1;
 
   // seed width
   if(0 < opt->seed_length) {
       // NB: use the reversed sequence
-      tmap_bwt_match_cal_width_reverse(index->bwt, opt->seed_length, bases->s + (seq_len - opt->seed_length), d->seed_width);
+      width_len[1] = opt->seed_length;
+      width_str[1] = bases->s + (seq_len - opt->seed_length);
+      widths[1] = d->seed_width;
+      num_widths = 2;
   }
 
+  // the two searches are independent, so run them together
+  tmap_bwt_match_cal_width_reverse_batch(index->bwt, num_widths, width_len, width_str, widths);
+
   // NB: use the reverse complimented sequence
   sams = tmap_map1_aux_core(seqs[1], index, hash, d->width, (0 < opt_local.seed_length) ? d->seed_width : NULL, &opt_local, d->stack, seed2_len);
 
@@ -183,6 +183,7 @@ tmap_map1_aux_stack_reset(tmap_map1_aux_stack_t *stack,
 
 static inline void
 tmap_map1_aux_stack_push(tmap_map1_aux_stack_t *stack, 
+                         const tmap_bwt_t *bwt,
                          int32_t offset,
                          tmap_bwt_match_occ_t *match_sa_prev,
                          int32_t n_mm, int32_t n_gapo, int32_t n_gape,
@@ -215,6 +216,8 @@ tmap_map1_aux_stack_push(tmap_map1_aux_stack_t *stack,
   entry->n_gape = n_gape;
   entry->state = state;
   entry->match_sa = (*match_sa_prev); 
+  // siblings are pushed together, so their next occurrence lookups overlap
+  tmap_bwt_match_hash_prefetch_2occ4(bwt, &entry->match_sa);
   entry->i = stack->entry_pool_i;
   entry->offset = offset;
   if(NULL == prev_entry) {
@@ -533,7 +536,7 @@ tmap_map1_aux_core(tmap_seq_t *seq, tmap_index_t *index,
   match_sa_start.l = bwt->seq_len;
 
   stack = tmap_map1_aux_stack_reset(stack, max_mm, max_gapo, max_gape, opt); // reset stack
-  tmap_map1_aux_stack_push(stack, bases->l, &match_sa_start, 0, 0, 0, STATE_M, 0, NULL, opt);
+  tmap_map1_aux_stack_push(stack, bwt, bases->l, &match_sa_start, 0, 0, 0, STATE_M, 0, NULL, opt);
 
   while(0 < tmap_map1_aux_stack_size(stack) && tmap_map1_aux_stack_size(stack) < opt->max_entries) {
       tmap_map1_aux_stack_entry_t *e = NULL;
@@ -778,21 +781,21 @@ tmap_map1_aux_core(tmap_seq_t *seq, tmap_index_t *index,
               if(STATE_M == e->state) { // gap open
                   if(e->n_gapo < max_gapo) { // gap open is allowed
                       // insertion
-                      tmap_map1_aux_stack_push(stack, offset, &match_sa_cur, e->n_mm, e->n_gapo + 1, e->n_gape, STATE_I, 1, e, opt);
+                      tmap_map1_aux_stack_push(stack, bwt, offset, &match_sa_cur, e->n_mm, e->n_gapo + 1, e->n_gape, STATE_I, 1, e, opt);
 
                       // deletion
                       for(j = 0; j != 4; ++j) {
                           if(match_sa_next[j].k <= match_sa_next[j].l) {
                               //   remember that a gap deletion does not consume a
                               //   read base, so use 'offset+1'
-                              tmap_map1_aux_stack_push(stack, offset+1, &match_sa_next[j], e->n_mm, e->n_gapo + 1, e->n_gape, STATE_D, 1, e, opt);
+                              tmap_map1_aux_stack_push(stack, bwt, offset+1, &match_sa_next[j], e->n_mm, e->n_gapo + 1, e->n_gape, STATE_D, 1, e, opt);
                           }
                       }
                   }
               }
               else if(STATE_I == e->state) { // extension of an insertion
                   if(e->n_gape < max_gape) { // gap extension is allowed
-                      tmap_map1_aux_stack_push(stack, offset, &match_sa_cur, e->n_mm, e->n_gapo, e->n_gape + 1, STATE_I, 1, e, opt);
+                      tmap_map1_aux_stack_push(stack, bwt, offset, &match_sa_cur, e->n_mm, e->n_gapo, e->n_gape + 1, STATE_I, 1, e, opt);
                   }
               }
               else if(STATE_D == e->state) { // extension of a deletion
@@ -802,7 +805,7 @@ tmap_map1_aux_core(tmap_seq_t *seq, tmap_index_t *index,
                               if(match_sa_next[j].k <= match_sa_next[j].l) {
                                   //   remember that a gap deletion does not consume a
                                   //   read base, so use 'offset+1'
-                                  tmap_map1_aux_stack_push(stack, offset+1, &match_sa_next[j], e->n_mm, e->n_gapo, e->n_gape + 1, STATE_D, 1, e, opt);
+                                  tmap_map1_aux_stack_push(stack, bwt, offset+1, &match_sa_next[j], e->n_mm, e->n_gapo, e->n_gape + 1, STATE_D, 1, e, opt);
                               }
                           }
                       }
@@ -816,14 +819,14 @@ tmap_map1_aux_core(tmap_seq_t *seq, tmap_index_t *index,
                   int32_t c = (str[offset] + j) & 3;
                   int32_t is_mm = (0 < j || 3 < str[offset]);
                   if(match_sa_next[c].k <= match_sa_next[c].l) {
-                      tmap_map1_aux_stack_push(stack, offset, &match_sa_next[c], e->n_mm + is_mm, e->n_gapo, e->n_gape, STATE_M, is_mm, e, opt);
+                      tmap_map1_aux_stack_push(stack, bwt, offset, &match_sa_next[c], e->n_mm + is_mm, e->n_gapo, e->n_gape, STATE_M, is_mm, e, opt);
                   }
               }
           } 
           else if(str[offset] < 4) { // try exact match only
               int32_t c = str[offset] & 3;
               if(match_sa_next[c].k <= match_sa_next[c].l) {
-                  tmap_map1_aux_stack_push(stack, offset, &match_sa_next[c], e->n_mm, e->n_gapo, e->n_gape, STATE_M, 0, e, opt);
+                  tmap_map1_aux_stack_push(stack, bwt, offset, &match_sa_next[c], e->n_mm, e->n_gapo, e->n_gape, STATE_M, 0, e, opt);
               }
           }
       }
@@ -1,5 +1,6 @@
 /* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 #include <config.h>
@@ -13,6 +14,7 @@
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_definitions.h"
 #include "../util/tmap_progress.h"
+#include "../util/tmap_time.h"
 #include "../util/tmap_sam_convert.h"
 #include "../util/tmap_sort.h"
 #include "../util/tmap_rand.h"
@@ -25,6 +27,7 @@
 #include "../index/tmap_bwt_match_hash.h"
 #include "../index/tmap_sa.h"
 #include "../index/tmap_index.h"
+#include "../io/tmap_file.h"
 #include "../io/tmap_seqs_io.h"
 #include "../server/tmap_shm.h"
 #include "../sw/tmap_fsw.h"
@@ -51,6 +54,16 @@ TMAP_SORT_INIT(tmap_map_sam_sort_score, tmap_map_sam_t, __tmap_map_sam_sort_scor
 // sorts integers
 TMAP_SORT_INIT(tmap_map_driver_sort_isize, int32_t, tmap_sort_lt_generic);
 
+// a read and its estimated mapping cost
+typedef struct {
+    int32_t cost;
+    int32_t idx;
+} tmap_map_driver_cost_t;
+
+// sorts by decreasing cost, ties in input order
+#define __tmap_map_driver_sort_cost_lt(a, b) ((a).cost > (b).cost || ((a).cost == (b).cost && (a).idx < (b).idx))
+TMAP_SORT_INIT(tmap_map_driver_sort_cost, tmap_map_driver_cost_t, __tmap_map_driver_sort_cost_lt)
+
 static void
 tmap_map_driver_do_init(tmap_map_driver_t *driver, tmap_refseq_t *refseq)
 {
@@ -969,16 +982,278 @@ void tail_repeat_clip_reads (tmap_seqs_t *seqs_buffer, tmap_refseq_t* refseq, tm
     }
 }
 
+static void
+tmap_map_driver_batch_init(tmap_map_driver_batch_t *batch, int32_t seq_type, int32_t reads_queue_size, int32_t num_threads)
+{
+  int32_t i;
+  batch->seqs_buffer = tmap_malloc(sizeof(tmap_seqs_t*)*reads_queue_size, "batch->seqs_buffer");
+  for(i=0;i<reads_queue_size;i++) { // initialize the buffer
+      batch->seqs_buffer[i] = tmap_seqs_init(seq_type);
+  }
+  batch->records = tmap_calloc(reads_queue_size, sizeof(tmap_map_record_t*), "batch->records");
+  batch->bams = tmap_calloc(reads_queue_size, sizeof(tmap_map_bams_t*), "batch->bams");
+  batch->done = tmap_calloc(reads_queue_size, sizeof(uint8_t), "batch->done");
+  batch->order = tmap_malloc(sizeof(int32_t)*reads_queue_size, "batch->order");
+  batch->stats = tmap_malloc(sizeof(tmap_map_stats_t*)*num_threads, "batch->stats");
+  for(i=0;i<num_threads;i++) {
+      batch->stats[i] = tmap_map_stats_init();
+  }
+  batch->seqs_buffer_length = 0;
+  batch->next_idx = 0;
+  batch->num_workers = 0;
+  batch->read_offset = 0;
+}
+
+static void
+tmap_map_driver_batch_destroy(tmap_map_driver_batch_t *batch, int32_t reads_queue_size, int32_t num_threads)
+{
+  int32_t i;
+  for(i=0;i<reads_queue_size;i++) {
+      tmap_seqs_destroy(batch->seqs_buffer[i]);
+  }
+  for(i=0;i<num_threads;i++) {
+      tmap_map_stats_destroy(batch->stats[i]);
+  }
+  free(batch->seqs_buffer);
+  free(batch->records);
+  free(batch->bams);
+  free(batch->done);
+  free(batch->order);
+  free(batch->stats);
+}
+
+// sets the order in which the reads of a batch are handed out: input order, or the costliest reads first so
+// that the last chunks of a batch are short ones and the threads finish together
+static void
+tmap_map_driver_batch_order(tmap_map_driver_batch_t *batch, int32_t seqs_buffer_length, int32_t long_reads_first)
+{
+  int32_t i, j;
+  tmap_map_driver_cost_t *costs = NULL;
+
+  if(0 == long_reads_first) {
+      for(i=0;i<seqs_buffer_length;i++) {
+          batch->order[i] = i;
+      }
+      return;
+  }
+
+  // NB: the seeding and Smith-Waterman work grows with the number of bases, over all the ends of a read
+  costs = tmap_malloc(sizeof(tmap_map_driver_cost_t)*seqs_buffer_length, "costs");
+  for(i=0;i<seqs_buffer_length;i++) {
+      costs[i].cost = 0;
+      costs[i].idx = i;
+      for(j=0;j<batch->seqs_buffer[i]->n;j++) {
+          costs[i].cost += tmap_seq_get_bases_length(batch->seqs_buffer[i]->seqs[j]);
+      }
+  }
+  tmap_sort_introsort(tmap_map_driver_sort_cost, seqs_buffer_length, costs);
+  for(i=0;i<seqs_buffer_length;i++) {
+      batch->order[i] = costs[i].idx;
+  }
+  free(costs);
+}
+
+static void
+tmap_map_driver_pipeline_init(tmap_map_driver_pipeline_t *pipeline, int32_t num_batches, 
+                              int32_t seq_type, int32_t reads_queue_size, int32_t num_threads,
+                              int32_t chunk_size, int32_t long_reads_first)
+{
+  int32_t i;
+  pipeline->num_batches = num_batches;
+  pipeline->batches = tmap_calloc(num_batches, sizeof(tmap_map_driver_batch_t), "pipeline->batches");
+  for(i=0;i<num_batches;i++) {
+      tmap_map_driver_batch_init(&pipeline->batches[i], seq_type, reads_queue_size, num_threads);
+  }
+  pipeline->read_batch = pipeline->map_batch = pipeline->write_batch = 0;
+  pipeline->num_reads_loaded = 0;
+  pipeline->eof = 0;
+  pipeline->chunk_size = chunk_size;
+  pipeline->long_reads_first = long_reads_first;
+  pipeline->thread_stats = tmap_malloc(sizeof(tmap_map_stats_t*)*num_threads, "pipeline->thread_stats");
+  for(i=0;i<num_threads;i++) {
+      pipeline->thread_stats[i] = tmap_map_stats_init();
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->loaded, NULL);
+  pthread_cond_init(&pipeline->mapped, NULL);
+  pthread_cond_init(&pipeline->written, NULL);
+#endif
+}
+
+static void
+tmap_map_driver_pipeline_destroy(tmap_map_driver_pipeline_t *pipeline, int32_t reads_queue_size, int32_t num_threads)
+{
+  int32_t i;
+  for(i=0;i<pipeline->num_batches;i++) {
+      tmap_map_driver_batch_destroy(&pipeline->batches[i], reads_queue_size, num_threads);
+  }
+  free(pipeline->batches);
+  pipeline->batches = NULL;
+  for(i=0;i<num_threads;i++) {
+      tmap_map_stats_destroy(pipeline->thread_stats[i]);
+  }
+  free(pipeline->thread_stats);
+  pipeline->thread_stats = NULL;
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_destroy(&pipeline->lock);
+  pthread_cond_destroy(&pipeline->loaded);
+  pthread_cond_destroy(&pipeline->mapped);
+  pthread_cond_destroy(&pipeline->written);
+#endif
+}
+
+// returns the batch the reader should fill next, waiting until the writer has released it
+static tmap_map_driver_batch_t*
+tmap_map_driver_pipeline_next_empty(tmap_map_driver_pipeline_t *pipeline)
+{
+  tmap_map_driver_batch_t *batch = NULL;
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&pipeline->lock);
+  while(pipeline->num_batches <= pipeline->read_batch - pipeline->write_batch) {
+      pthread_cond_wait(&pipeline->written, &pipeline->lock);
+  }
+#endif
+  batch = &pipeline->batches[pipeline->read_batch % pipeline->num_batches];
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&pipeline->lock);
+#endif
+  return batch;
+}
+
+// hands a freshly loaded batch to the workers and the writer; zero reads marks the end of the input
+static void
+tmap_map_driver_pipeline_publish(tmap_map_driver_pipeline_t *pipeline, tmap_map_driver_batch_t *batch, int32_t seqs_buffer_length)
+{
+  // NB: the batch is not visible to the workers yet, so order it outside the lock
+  if(0 < seqs_buffer_length) {
+      tmap_map_driver_batch_order(batch, seqs_buffer_length, pipeline->long_reads_first);
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&pipeline->lock);
+#endif
+  if(0 == seqs_buffer_length) {
+      pipeline->eof = 1;
+  }
+  else {
+      memset(batch->done, 0, sizeof(uint8_t) * seqs_buffer_length);
+      batch->seqs_buffer_length = seqs_buffer_length;
+      batch->next_idx = 0;
+      batch->read_offset = pipeline->num_reads_loaded;
+      pipeline->num_reads_loaded += seqs_buffer_length;
+      pipeline->read_batch++;
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_cond_broadcast(&pipeline->loaded);
+  pthread_mutex_unlock(&pipeline->lock);
+#endif
+}
+
+// claims the next chunk of the batch for the calling thread, returns 0 if every read of the batch was handed out
+static int32_t
+tmap_map_driver_batch_claim(tmap_map_driver_batch_t *batch, int32_t chunk_size, tmap_map_driver_chunk_t *chunk)
+{
+  // NB: lock free, the batch cannot be recycled while this thread is counted in num_workers
+  int32_t begin = __sync_fetch_and_add(&batch->next_idx, chunk_size);
+  if(batch->seqs_buffer_length <= begin) return 0;
+  chunk->batch = batch;
+  chunk->begin = chunk->pos = begin;
+  chunk->end = (batch->seqs_buffer_length < begin + chunk_size) ? batch->seqs_buffer_length : begin + chunk_size;
+  return 1;
+}
+
+// hands the reads of the finished chunk over to the writer; the caller holds the lock
+static void
+tmap_map_driver_chunk_done(tmap_map_driver_pipeline_t *pipeline, tmap_map_driver_chunk_t *chunk)
+{
+  int32_t i;
+  for(i=chunk->begin;i<chunk->end;i++) {
+      chunk->batch->done[chunk->batch->order[i]] = 1;
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_cond_signal(&pipeline->mapped);
+#endif
+}
+
+// returns the batch holding the next read to map, and its index in (*idx), or NULL when the input is exhausted.
+// Reads are claimed chunk_size at a time from the batch's atomic cursor, so the lock is taken once per chunk
+// (to hand the finished chunk to the writer) rather than twice per read.
+static tmap_map_driver_batch_t*
+tmap_map_driver_pipeline_next_read(tmap_map_driver_pipeline_t *pipeline, tmap_map_driver_chunk_t *chunk, int32_t *idx)
+{
+  tmap_map_driver_batch_t *batch = chunk->batch;
+  tmap_map_driver_chunk_t prev = (*chunk);
+
+  if(NULL != batch) {
+      if(chunk->pos < chunk->end) {
+          (*idx) = batch->order[chunk->pos++];
+          return batch;
+      }
+      if(1 == tmap_map_driver_batch_claim(batch, pipeline->chunk_size, chunk)) {
+#ifdef HAVE_LIBPTHREAD
+          pthread_mutex_lock(&pipeline->lock);
+#endif
+          tmap_map_driver_chunk_done(pipeline, &prev);
+#ifdef HAVE_LIBPTHREAD
+          pthread_mutex_unlock(&pipeline->lock);
+#endif
+          (*idx) = batch->order[chunk->pos++];
+          return batch;
+      }
+  }
+
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&pipeline->lock);
+#endif
+  if(NULL != batch) {
+      // the batch ran dry, leave it so the writer can release it once it is written
+      tmap_map_driver_chunk_done(pipeline, &prev);
+      batch->num_workers--;
+      chunk->batch = batch = NULL;
+  }
+  while(1) {
+      if(pipeline->map_batch < pipeline->read_batch) {
+          batch = &pipeline->batches[pipeline->map_batch % pipeline->num_batches];
+          if(1 == tmap_map_driver_batch_claim(batch, pipeline->chunk_size, chunk)) {
+              batch->num_workers++;
+              (*idx) = batch->order[chunk->pos++];
+              break;
+          }
+          // every read in this batch was handed out, move on to the next one
+          pipeline->map_batch++;
+          batch = NULL;
+      }
+#ifdef HAVE_LIBPTHREAD
+      else if(0 == pipeline->eof) {
+          pthread_cond_wait(&pipeline->loaded, &pipeline->lock);
+      }
+#endif
+      else {
+          break;
+      }
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&pipeline->lock);
+#endif
+  return batch;
+}
+
+// resets the first batch after the pairing parameters were inferred from it, so it is mapped again
+static void
+tmap_map_driver_pipeline_rewind(tmap_map_driver_pipeline_t *pipeline)
+{
+  tmap_map_driver_batch_t *batch = &pipeline->batches[0];
+  memset(batch->done, 0, sizeof(uint8_t) * batch->seqs_buffer_length);
+  batch->next_idx = 0;
+  pipeline->map_batch = 0;
+  pipeline->eof = 0;
+}
+
 void
 tmap_map_driver_core_worker(sam_header_t *sam_header,
-                            tmap_seqs_t **seqs_buffer, 
-                            tmap_map_record_t **records, 
-                            tmap_map_bams_t **bams,
-                            int32_t seqs_buffer_length,
-                            int32_t *buffer_idx,
+                            tmap_map_driver_pipeline_t *pipeline,
                             tmap_index_t *index,
                             tmap_map_driver_t *driver,
-                            tmap_map_stats_t *stat,
                             tmap_rand_t *rand,
                             // DVK - realigner
                             struct RealignProxy* realigner,
@@ -991,6 +1266,9 @@ tmap_map_driver_core_worker(sam_header_t *sam_header,
     tmap_seq_t*** seqs = NULL;
     tmap_bwt_match_hash_t* hash=NULL;
     int32_t max_num_ends = 0;
+    tmap_map_driver_batch_t *batch = NULL;
+    tmap_map_driver_chunk_t chunk;
+    double mapped_time, claimed_time;
 
     // common memory resource for all target fragments
     // common memory resource for WS traceback paths
@@ -1015,10 +1293,18 @@ tmap_map_driver_core_worker(sam_header_t *sam_header,
     // initialize thread data
     tmap_map_driver_do_threads_init (driver, tid);
 
-    // Go through the buffer
-    while (low < seqs_buffer_length) 
+    // Go through the reads as the pipeline hands them out
+    chunk.batch = NULL;
+    chunk.begin = chunk.pos = chunk.end = 0;
+    mapped_time = tmap_time_realtime ();
+    while (NULL != (batch = tmap_map_driver_pipeline_next_read (pipeline, &chunk, &low))) 
     {
-        if (tid == (low % driver->opt->num_threads)) 
+        tmap_seqs_t **seqs_buffer = batch->seqs_buffer;
+        tmap_map_record_t **records = batch->records;
+        tmap_map_bams_t **bams = batch->bams;
+        tmap_map_stats_t *stat = (0 == do_pairing) ? batch->stats [tid] : NULL;
+        claimed_time = tmap_time_realtime ();
+        if (0 == do_pairing) pipeline->thread_stats [tid]->idle_time += claimed_time - mapped_time;
         {
             tmap_map_stats_t *stage_stat = NULL;
             tmap_map_record_t *record_prev = NULL;
@@ -1045,6 +1331,8 @@ tmap_map_driver_core_worker(sam_header_t *sam_header,
             // re-initialize the random seed
             if(driver->opt->rand_read_name)
                 tmap_rand_reinit(rand, tmap_hash_str_hash_func_exc(tmap_seq_get_name(seqs_buffer[low]->seqs[0])->s, driver->opt->prefix_exclude, driver->opt->suffix_exclude));
+            else // NB: seed by input position, so the output does not depend on which thread picks up the read
+                tmap_rand_reinit(rand, batch->read_offset + low);
 
             // init
             for(i = 0; i < num_ends; i++) 
@@ -1412,11 +1700,11 @@ tmap_map_driver_core_worker(sam_header_t *sam_header,
             }
             tmap_map_record_destroy (record_prev);
         }
-        // next
-        (*buffer_idx) = low;
-        low++;
+        // the read is handed over to the writer with the rest of its chunk
+        mapped_time = tmap_time_realtime ();
+        if (0 == do_pairing) pipeline->thread_stats [tid]->busy_time += mapped_time - claimed_time;
     }
-    (*buffer_idx) = seqs_buffer_length;
+    if (0 == do_pairing) pipeline->thread_stats [tid]->idle_time += tmap_time_realtime () - mapped_time;
 
     // free thread variables
     for (i = 0; i < max_num_ends; i++) 
@@ -1438,183 +1726,190 @@ tmap_map_driver_core_thread_worker(void *arg)
 {
   tmap_map_driver_thread_data_t *thread_data = (tmap_map_driver_thread_data_t*)arg;
 
-  tmap_map_driver_core_worker(thread_data->sam_header, thread_data->seqs_buffer, thread_data->records, thread_data->bams, 
-                              thread_data->seqs_buffer_length, thread_data->buffer_idx, thread_data->index, thread_data->driver, 
-                              thread_data->stat, thread_data->rand, /* DVK - realigner */ thread_data->realigner, thread_data->context, thread_data->do_pairing, thread_data->tid);
+  tmap_map_driver_core_worker(thread_data->sam_header, thread_data->pipeline, thread_data->index, thread_data->driver, 
+                              thread_data->rand, /* DVK - realigner */ thread_data->realigner, thread_data->context, thread_data->do_pairing, thread_data->tid);
 
   return arg;
 }
 
-//static inline void
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
 static int32_t
+tmap_map_driver_sample_reads(tmap_map_driver_t *driver, tmap_rand_t *rand_core,
+                             tmap_seqs_t **seqs_buffer, int32_t seqs_buffer_length)
+{
+  int32_t i, j;
+  if(driver->opt->sample_reads < 1) {
+      for(i=j=0;i<seqs_buffer_length;i++) {
+          if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
+          if(j < i) {
+              tmap_seqs_t *seqs;
+              seqs = seqs_buffer[j];
+              seqs_buffer[j] = seqs_buffer[i]; 
+              seqs_buffer[i] = seqs;
+          }
+          j++;
+      }
+      tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, seqs_buffer_length, 100.0*j/(double)seqs_buffer_length);
+      seqs_buffer_length = j;
+  }
+  return seqs_buffer_length;
+}
+#endif
+
+// reads the next batch of reads from the input into the pipeline
+static int32_t
+tmap_map_driver_load_batch(tmap_seqs_io_t *io_in,
+                           sam_header_t *header,
+                           tmap_map_driver_pipeline_t *pipeline,
+                           int32_t reads_queue_size,
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+                           tmap_map_driver_t *driver,
+                           tmap_rand_t *rand_core,
+#endif
+                           int32_t do_publish)
+{
+  int32_t seqs_buffer_length;
+  tmap_map_driver_batch_t *batch = NULL;
+
+  batch = tmap_map_driver_pipeline_next_empty(pipeline);
+  tmap_progress_print("loading reads");
+  seqs_buffer_length = tmap_seqs_io_read_buffer(io_in, batch->seqs_buffer, reads_queue_size, header);
+  tmap_progress_print2("loaded %d reads", seqs_buffer_length);
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+  // NB: an empty sample would look like the end of the input, so keep loading
+  while(0 < seqs_buffer_length && 0 == (seqs_buffer_length = tmap_map_driver_sample_reads(driver, rand_core, batch->seqs_buffer, seqs_buffer_length))) {
+      seqs_buffer_length = tmap_seqs_io_read_buffer(io_in, batch->seqs_buffer, reads_queue_size, header);
+  }
+#endif
+  if(1 == do_publish) {
+      tmap_map_driver_pipeline_publish(pipeline, batch, seqs_buffer_length);
+  }
+  return seqs_buffer_length;
+}
+
+// starts the mapping workers; without threads the reads already loaded are mapped in place
+static void
 tmap_map_driver_create_threads(sam_header_t *header,
-                               tmap_seqs_t **seqs_buffer, 
-                               tmap_map_record_t **records, 
-                               tmap_map_bams_t **bams,
-                               int32_t seqs_buffer_length,
+                               tmap_map_driver_pipeline_t *pipeline,
                                tmap_index_t *index,
                                tmap_map_driver_t *driver,
-                               tmap_map_stats_t *stat,
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-                               tmap_rand_t *rand_core,
-#endif
-#ifdef HAVE_LIBPTHREAD
-                               pthread_attr_t **attr,
-                               pthread_t **threads,
-                               tmap_map_driver_thread_data_t **thread_data,
                                tmap_rand_t **rand,
-                               tmap_map_stats_t **stats,
                                struct RealignProxy** realigner,
                                struct RealignProxy** context,
+#ifdef HAVE_LIBPTHREAD
+                               pthread_t **threads,
+                               tmap_map_driver_thread_data_t **thread_data,
 #endif
                                int32_t do_pairing)
 {
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-  int32_t j;
-#endif
-  int32_t buffer_idx; // buffer index for processing data with a single thread
+#ifdef HAVE_LIBPTHREAD
+  int32_t i;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-  // sample reads
-  {
-      int32_t i;
-      if(driver->opt->sample_reads < 1) {
-          for(i=j=0;i<seqs_buffer_length;i++) {
-              if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
-              if(j < i) {
-                  tmap_seqs_t *seqs;
-                  seqs = seqs_buffer[j];
-                  seqs_buffer[j] = seqs_buffer[i]; 
-                  seqs_buffer[i] = seqs;
-              }
-              j++;
-          }
-          tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, seqs_buffer_length, 100.0*j/(double)seqs_buffer_length);
-          seqs_buffer_length = j;
-          if(0 == seqs_buffer_length) return 0;
+  (*threads) = tmap_calloc(driver->opt->num_threads, sizeof(pthread_t), "(*threads)");
+  (*thread_data) = tmap_calloc(driver->opt->num_threads, sizeof(tmap_map_driver_thread_data_t), "(*thread_data)");
+
+  // create threads
+  for(i=0;i<driver->opt->num_threads;i++) {
+      (*thread_data)[i].sam_header = header;
+      (*thread_data)[i].pipeline = pipeline;
+      (*thread_data)[i].index = index;
+      (*thread_data)[i].driver = driver;
+      (*thread_data)[i].rand = rand[i];
+      // DVK - realigner
+      (*thread_data)[i].realigner = realigner [i];
+      (*thread_data)[i].context = context [i];
+      (*thread_data)[i].do_pairing = do_pairing;
+      (*thread_data)[i].tid = i;
+      if(0 != pthread_create(&(*threads)[i], &attr, tmap_map_driver_core_thread_worker, &(*thread_data)[i])) {
+          tmap_error("error creating threads", Exit, ThreadError);
       }
   }
+  pthread_attr_destroy(&attr);
+#else 
+  tmap_map_driver_core_worker(header, pipeline, index, driver, rand[0], realigner[0], context[0], do_pairing, 0);
 #endif
+}
 
-  // do alignment
 #ifdef HAVE_LIBPTHREAD
-  if(1 == driver->opt->num_threads) {
-      buffer_idx = 0;
-      tmap_map_driver_core_worker(header, seqs_buffer, records, bams, 
-                                  seqs_buffer_length, &buffer_idx, index, driver, stat, rand[0], realigner [0], context [0], do_pairing, 0);
-  }
-  else {
-      int32_t i;
-      (*attr) = tmap_calloc(1, sizeof(pthread_attr_t), "(*attr)");
-      pthread_attr_init((*attr));
-      pthread_attr_setdetachstate((*attr), PTHREAD_CREATE_JOINABLE);
-
-      (*threads) = tmap_calloc(driver->opt->num_threads, sizeof(pthread_t), "(*threads)");
-      (*thread_data) = tmap_calloc(driver->opt->num_threads, sizeof(tmap_map_driver_thread_data_t), "(*thread_data)");
-
-      // create threads
-      for(i=0;i<driver->opt->num_threads;i++) {
-          (*thread_data)[i].sam_header = header;
-          (*thread_data)[i].seqs_buffer = seqs_buffer;
-          (*thread_data)[i].seqs_buffer_length = seqs_buffer_length;
-          (*thread_data)[i].buffer_idx = tmap_calloc(1, sizeof(int32_t), "(*thread_data)[i].buffer_id");
-          (*thread_data)[i].records = records;
-          (*thread_data)[i].bams = bams;
-          (*thread_data)[i].index = index;
-          (*thread_data)[i].driver = driver;
-          if(NULL != stats) (*thread_data)[i].stat = stats[i];
-          else (*thread_data)[i].stat = NULL;
-          (*thread_data)[i].rand = rand[i];
-          // DVK - realigner
-          (*thread_data)[i].realigner = realigner [i];
-          (*thread_data)[i].context = context [i];
-          (*thread_data)[i].do_pairing = do_pairing;
-          (*thread_data)[i].tid = i;
-          if(0 != pthread_create(&(*threads)[i], (*attr), tmap_map_driver_core_thread_worker, &(*thread_data)[i])) {
-              tmap_error("error creating threads", Exit, ThreadError);
-          }
+static void
+tmap_map_driver_join_threads(tmap_map_driver_t *driver,
+                             pthread_t **threads,
+                             tmap_map_driver_thread_data_t **thread_data)
+{
+  int32_t i;
+  for(i=0;i<driver->opt->num_threads;i++) {
+      if(0 != pthread_join((*threads)[i], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
       }
   }
-#else 
-  buffer_idx = 0;
-  tmap_map_driver_core_worker(header, seqs_buffer, records, bams, 
-                              seqs_buffer_length, &buffer_idx, index, driver, stat, rand, do_pairing, 0);
-#endif
-  return 1;
+  free((*threads)); (*threads) = NULL;
+  free((*thread_data)); (*thread_data) = NULL;
 }
+#endif
 
 static int32_t
 tmap_map_driver_infer_pairing(tmap_seqs_io_t *io_in,
                               sam_header_t *header,
-                              tmap_seqs_t **seqs_buffer, 
-                              tmap_map_record_t **records, 
-                              tmap_map_bams_t **bams,
-                              int32_t seqs_buffer_length,
+                              tmap_map_driver_pipeline_t *pipeline,
                               int32_t reads_queue_size,
                               tmap_index_t *index,
                               tmap_map_driver_t *driver,
-                              tmap_map_stats_t *stat,
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
                               tmap_rand_t *rand_core,
 #endif
-#ifdef HAVE_LIBPTHREAD
-                              pthread_attr_t **attr,
-                              pthread_t **threads,
-                              tmap_map_driver_thread_data_t **thread_data,
                               tmap_rand_t **rand,
-                              tmap_map_stats_t **stats,
                               // DVK - realigner
                               struct RealignProxy** realigner,
                               struct RealignProxy** context
-#endif
                               ) // NB: just so that the function definition is clean
 {
   int32_t i, isize_num = 0, tmp;
   int32_t *isize = NULL;
   int32_t p25, p50, p75;
   int32_t max_len = 0;
+  int32_t seqs_buffer_length;
+  tmap_seqs_t **seqs_buffer = NULL;
+  tmap_map_record_t **records = NULL;
+#ifdef HAVE_LIBPTHREAD
+  pthread_t *threads = NULL;
+  tmap_map_driver_thread_data_t *thread_data = NULL;
+#endif
 
   // check if we should do pairing
   if(driver->opt->strandedness < 0 || driver->opt->positioning < 0 || !(driver->opt->ins_size_std < 0)) return 0;
 
   // NB: infers from the first chunk of reads
   tmap_progress_print("inferring pairing parameters");
-  tmap_progress_print("loading reads");
-  seqs_buffer_length = tmap_seqs_io_read_buffer(io_in, seqs_buffer, reads_queue_size, header);
-  tmap_progress_print2("loaded %d reads", seqs_buffer_length);
+  seqs_buffer_length = tmap_map_driver_load_batch(io_in, header, pipeline, reads_queue_size, 
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+                                                  driver, rand_core,
+#endif
+                                                  1);
   if(0 == seqs_buffer_length) return 0;
+  seqs_buffer = pipeline->batches[0].seqs_buffer;
+  records = pipeline->batches[0].records;
 
   // holds the insert sizes
   isize = tmap_malloc(sizeof(int32_t) * seqs_buffer_length, "isize");
 
   // TODO: check that he data is paired...
   // TODO: check that we choose only the best scoring alignment
-  // create the threads
-  if(0 == tmap_map_driver_create_threads(header, seqs_buffer, records, 
-                                         bams, seqs_buffer_length, index, driver, NULL,
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-                                         rand_core,
+  // map the first chunk, with no more reads to follow
+  pipeline->eof = 1;
+  tmap_map_driver_create_threads(header, pipeline, index, driver, rand, realigner, context,
+#ifdef HAVE_LIBPTHREAD
+                                 &threads, &thread_data,
 #endif
+                                 1);
 #ifdef HAVE_LIBPTHREAD
-                                         attr, threads, thread_data, rand, NULL, realigner, context,
+  tmap_map_driver_join_threads(driver, &threads, &thread_data);
 #endif
-                                         1)) {
-      return 0;
-  }
 
   // estimate pairing parameters
   for(i=0;i<seqs_buffer_length;i++) {
-#ifdef HAVE_LIBPTHREAD
-      if(1 < driver->opt->num_threads) {
-          // NB: we will write data as threads process the data.  This is to
-          // facilitate SAM/BAM writing, which may be slow, especially for
-          // BAM.
-          int32_t tid = (i % driver->opt->num_threads);
-          while((*(*thread_data)[tid].buffer_idx) <= i) {
-              usleep(1000*1000); // sleep
-          }
-      }
-#endif
       // only for paired ends
       if(NULL != records[i]
          && 2 == records[i]->n 
@@ -1652,23 +1947,8 @@ tmap_map_driver_infer_pairing(tmap_seqs_io_t *io_in,
       records[i] = NULL;
   }
 
-#ifdef HAVE_LIBPTHREAD
-  // join threads
-  if(1 < driver->opt->num_threads) {
-      // join threads
-      for(i=0;i<driver->opt->num_threads;i++) {
-          if(0 != pthread_join((*threads)[i], NULL)) {
-              tmap_error("error joining threads", Exit, ThreadError);
-          }
-          // free the buffer index
-          free((*thread_data)[i].buffer_idx);
-          (*thread_data)[i].buffer_idx = NULL;
-      }
-      free((*threads)); (*threads) = NULL;
-      free(*(thread_data)); (*thread_data) = NULL;
-      free((*attr)); (*attr) = NULL;
-  }
-#endif
+  // the chunk will be mapped again by the main loop
+  tmap_map_driver_pipeline_rewind(pipeline);
 
   if(isize_num < 8) {
       tmap_error("failed to infer the insert size distribution (too few reads): turning pairing off", Warn, OutOfRange);
@@ -1745,49 +2025,132 @@ tmap_map_driver_infer_pairing(tmap_seqs_io_t *io_in,
 typedef struct {
     tmap_seqs_io_t *io_in;
     tmap_sam_io_t *io_out;
-    tmap_seqs_t **seqs_buffer;
-    int32_t seqs_buffer_length;
+    tmap_map_driver_pipeline_t *pipeline;
     int32_t reads_queue_size;
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+    tmap_map_driver_t *driver;
+    tmap_rand_t *rand_core;
+#endif
 } tmap_map_driver_thread_io_data_t;
 
+// the reader stage: keeps the pipeline's free batches filled until the input is exhausted
 static void *
 tmap_map_driver_thread_io_worker (void *arg)
 {
   tmap_map_driver_thread_io_data_t *d = (tmap_map_driver_thread_io_data_t*) arg;
-  d->seqs_buffer_length = tmap_seqs_io_read_buffer (d->io_in, d->seqs_buffer, d->reads_queue_size, d->io_out->fp->header->header);
+  while(0 < tmap_map_driver_load_batch(d->io_in, d->io_out->fp->header->header, d->pipeline, d->reads_queue_size,
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+                                       d->driver, d->rand_core,
+#endif
+                                       1)) {
+      // keep going
+  }
   return d;
 }
 #endif
 
+// the writer stage: writes the next batch in input order as its reads get mapped, returns the number of reads written
+static int32_t
+tmap_map_driver_write_batch(tmap_map_driver_pipeline_t *pipeline,
+                            tmap_sam_io_t *io_out,
+                            tmap_map_stats_t *stat,
+                            int32_t num_threads)
+{
+  int32_t i, j, k, n, seqs_buffer_length;
+  int64_t write_batch = pipeline->write_batch;
+  tmap_map_driver_batch_t *batch = NULL;
+
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&pipeline->lock);
+  while(pipeline->read_batch <= write_batch && 0 == pipeline->eof) {
+      pthread_cond_wait(&pipeline->loaded, &pipeline->lock);
+  }
+#endif
+  if(pipeline->read_batch <= write_batch) { // no more reads
+#ifdef HAVE_LIBPTHREAD
+      pthread_mutex_unlock(&pipeline->lock);
+#endif
+      return 0;
+  }
+  batch = &pipeline->batches[write_batch % pipeline->num_batches];
+  // the reader refills the batch as soon as it is released below
+  seqs_buffer_length = batch->seqs_buffer_length;
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&pipeline->lock);
+#endif
+
+  for(i=0;i<seqs_buffer_length;) {
+      // NB: we will write data as threads process the data.  This is to
+      // facilitate SAM/BAM writing, which may be slow, especially for
+      // BAM.
+#ifdef HAVE_LIBPTHREAD
+      pthread_mutex_lock(&pipeline->lock);
+      while(0 == batch->done[i]) {
+          pthread_cond_wait(&pipeline->mapped, &pipeline->lock);
+      }
+#endif
+      for(n=i+1;n<seqs_buffer_length && 1 == batch->done[n];n++); // all mapped reads in order
+#ifdef HAVE_LIBPTHREAD
+      pthread_mutex_unlock(&pipeline->lock);
+#endif
+      // write
+      for(;i<n;i++) {
+          for(j=0;j<batch->bams[i]->n;j++) { // for each end
+              for(k=0;k<batch->bams[i]->bams[j]->n;k++) { // for each hit
+                  bam1_t *b = NULL;
+                  b = batch->bams[i]->bams[j]->bams[k]; // that's a lot of BAMs
+                  if(NULL == b) tmap_bug();
+                  if(samwrite(io_out->fp, b) <= 0) {
+                      tmap_error("Error writing the SAM file", Exit, WriteFileError);
+                  }
+              }
+          }
+          tmap_map_bams_destroy(batch->bams[i]);
+          batch->bams[i] = NULL;
+      }
+  }
+
+  // add the stats
+  for(i=0;i<num_threads;i++) {
+      tmap_map_stats_add(stat, batch->stats[i]);
+      tmap_map_stats_zero(batch->stats[i]);
+  }
+
+  // release the batch to the reader, once no thread can claim from it any more
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&pipeline->lock);
+  while(0 < batch->num_workers) {
+      pthread_cond_wait(&pipeline->mapped, &pipeline->lock);
+  }
+#endif
+  if(pipeline->map_batch <= write_batch) pipeline->map_batch = write_batch + 1;
+  pipeline->write_batch++;
+#ifdef HAVE_LIBPTHREAD
+  pthread_cond_signal(&pipeline->written);
+  pthread_mutex_unlock(&pipeline->lock);
+#endif
+
+  return seqs_buffer_length;
+}
 
 
 void 
 tmap_map_driver_core (tmap_map_driver_t *driver)
 {
-  uint32_t i, j, k, n_reads_processed = 0; // # of reads processed
+  uint32_t i, j, n_reads_processed = 0; // # of reads processed
   int32_t seqs_buffer_length = 0; // # of reads read in
-  int32_t seqs_loaded = 0; // 1 if the seq_buffer is loaded, 0 otherwse
   tmap_seqs_io_t *io_in = NULL; // input file(s)
   tmap_sam_io_t *io_out = NULL; // output file
-  tmap_seqs_t **seqs_buffer = NULL; // buffer for the reads
-#ifdef HAVE_LIBPTHREAD
-  tmap_seqs_t **seqs_buffer_next = NULL; // buffer for the reads
-#endif
-  tmap_map_record_t **records=NULL; // buffer for the mapped data
-  tmap_map_bams_t **bams=NULL;// buffer for the mapped BAM data
+  tmap_map_driver_pipeline_t pipeline; // buffers for the reads and mapped data, cycling between reader, workers and writer
   tmap_index_t *index = NULL; // reference indes
   tmap_map_stats_t *stat = NULL; // alignment statistics
+  tmap_rand_t **rand = NULL; // random # generator for each thread
 #ifdef HAVE_LIBPTHREAD
-  pthread_attr_t *attr = NULL;
   pthread_attr_t attr_io;
   pthread_t *threads = NULL;
-  pthread_t *thread_io = NULL;
+  pthread_t thread_io;
   tmap_map_driver_thread_data_t *thread_data=NULL;
   tmap_map_driver_thread_io_data_t thread_io_data;
-  tmap_rand_t **rand = NULL; // random # generator for each thread
-  tmap_map_stats_t **stats = NULL; // alignment statistics for each thread
-#else
-  tmap_rand_t *rand = NULL; // random # generator
 #endif
 
   time_t start_time = time (NULL);
@@ -1796,13 +2159,8 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
       tmap_file_stdout = tmap_file_fdopen(fileno(stdout), "wb", TMAP_FILE_NO_COMPRESSION);
 
 // DVK - realignment
-#ifdef HAVE_LIBPTHREAD
   struct RealignProxy** realigner = NULL;
   struct RealignProxy** context = NULL;
-#else
-  struct RealignProxy* realigner = NULL;
-  struct RealignProxy* context = NULL;
-#endif
 
 
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
@@ -1837,6 +2195,7 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
                             driver->opt->bam_start_vfo, driver->opt->bam_end_vfo);
 
   // get the index
+  tmap_file_mmap_set_hugepages(driver->opt->index_hugepages);
   index = tmap_index_init(driver->opt->fn_fasta, driver->opt->shm_key);
 
   // initialize the driver->options and print any relevant information
@@ -1851,30 +2210,14 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
   else {
       reads_queue_size = driver->opt->reads_queue_size;
   }
-  seqs_buffer = tmap_malloc(sizeof(tmap_seqs_t*)*reads_queue_size, "seqs_buffer");
-#ifdef HAVE_LIBPTHREAD
-  seqs_buffer_next = tmap_malloc(sizeof(tmap_seqs_t*)*reads_queue_size, "seqs_buffer_next");
-#endif
-  for(i=0;i<reads_queue_size;i++) { // initialize the buffer
-      seqs_buffer[i] = tmap_seqs_init(seq_type);
-#ifdef HAVE_LIBPTHREAD
-      seqs_buffer_next[i] = tmap_seqs_init(seq_type);
-#endif
-  }
-  records = tmap_malloc(sizeof(tmap_map_record_t*)*reads_queue_size, "records");
-  bams = tmap_malloc(sizeof(tmap_map_bams_t*)*reads_queue_size, "bams");
+  tmap_map_driver_pipeline_init(&pipeline, TMAP_MAP_DRIVER_NUM_BATCHES, seq_type, reads_queue_size, driver->opt->num_threads,
+                                driver->opt->reads_chunk_size, driver->opt->long_reads_first);
 
   stat = tmap_map_stats_init();
-#ifdef HAVE_LIBPTHREAD
-  stats = tmap_malloc(driver->opt->num_threads * sizeof(tmap_map_stats_t*), "stats");
   rand = tmap_malloc(driver->opt->num_threads * sizeof(tmap_rand_t*), "rand");
   for(i=0;i<driver->opt->num_threads;i++) {
-      stats[i] = tmap_map_stats_init();
       rand[i] = tmap_rand_init(i);
   }
-#else
-  rand = tmap_rand_init(13);
-#endif
 
     // DVK - thread-safe logging
     FILE* logfile = NULL;
@@ -1894,7 +2237,6 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
     // Note: this needs to be initialized only if --do-realign is specified, 
     // !!! or if --do-repeat-clip is specified, as repeat clipping uses some of the structures in realigner for data holding
     {
-#ifdef HAVE_LIBPTHREAD
         realigner = tmap_malloc (driver->opt->num_threads * sizeof (struct RealignProxy*), "realigner");
         context = tmap_malloc (driver->opt->num_threads * sizeof (struct RealignProxy*), "context");
         for (i = 0; i != driver->opt->num_threads;  ++i)
@@ -1913,20 +2255,6 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
             if (driver->opt->context_debug_log && logfile)
                 realigner_set_log (context [i], fileno (logfile));
         }
-    #else
-        realigner = realigner_create ();
-        realigner_set_scores (realigner, driver->opt->realign_mat_score, driver->opt->realign_mis_score, driver->opt->realign_gip_score, driver->opt->realign_gep_score);
-        realigner_set_bandwidth (realigner, driver->opt->realign_bandwidth);
-        realigner_set_clipping (realigner, (enum CLIPTYPE) driver->opt->realign_cliptype);
-
-        context = context_aligner_create ();
-        realigner_set_scores (context, driver->opt->context_mat_score, driver->opt->context_mis_score, driver->opt->context_gip_score, driver->opt->context_gep_score);
-        realigner_set_bandwidth (context, driver->opt->context_extra_bandwidth);
-        realigner_set_gap_scale_mode (context, driver->opt->gap_scale_mode);
-        realigner_set_debug (context, driver->opt->context_debug_log);
-        if (driver->opt->context_debug_log && logfile)
-            realigner_set_log (context, fileno (logfile));
-#endif
     }
 
 
@@ -1955,132 +2283,55 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
   header = NULL;
 
   // pairing
-  seqs_buffer_length = tmap_map_driver_infer_pairing(io_in, io_out->fp->header->header, seqs_buffer, records, 
-                                                     bams, seqs_buffer_length, reads_queue_size,
-                                                     index, driver, stat,
+  seqs_buffer_length = tmap_map_driver_infer_pairing(io_in, io_out->fp->header->header, &pipeline, 
+                                                     reads_queue_size, index, driver,
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
                                                      rand_core,
 #endif
-#ifdef HAVE_LIBPTHREAD
-                                                     &attr, &threads, &thread_data, rand, stats, realigner, context
-#endif
+                                                     rand, realigner, context
                                                      );
-  if(0 == seqs_buffer_length) {
-      tmap_progress_print("loading reads");
-      seqs_buffer_length = tmap_seqs_io_read_buffer(io_in, seqs_buffer, reads_queue_size, io_out->fp->header->header);
-      tmap_progress_print2("loaded %d reads", seqs_buffer_length);
-  }
-  seqs_loaded = 1;
 
   // main processing loop
   tmap_progress_print("processing reads");
-  while(1) {
-      // get the reads
-      if(0 == seqs_loaded) { 
-          tmap_progress_print("loading reads");
 #ifdef HAVE_LIBPTHREAD
-          // join the thread that loads in the reads
-          if(0 != pthread_join((*thread_io), NULL)) {
-              tmap_error("error joining IO thread", Exit, ThreadError);
-          }
-          free(thread_io);
-          thread_io = NULL;
-          // swap buffers
-          seqs_buffer_length = thread_io_data.seqs_buffer_length;
-          seqs_buffer_next = seqs_buffer; // temporarily store this here
-          seqs_buffer = thread_io_data.seqs_buffer; 
-          thread_io_data.seqs_buffer = seqs_buffer_next;
-#else
-          seqs_buffer_length = tmap_seqs_io_read_buffer (io_in, seqs_buffer, reads_queue_size, io_out->fp->header->header);
+  // launch the reader, which keeps loading reads while the workers map and the alignments get written
+  pthread_attr_init(&attr_io);
+  pthread_attr_setdetachstate(&attr_io, PTHREAD_CREATE_JOINABLE);
+  thread_io_data.io_in = io_in;
+  thread_io_data.io_out = io_out;
+  thread_io_data.pipeline = &pipeline;
+  thread_io_data.reads_queue_size = reads_queue_size;
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+  thread_io_data.driver = driver;
+  thread_io_data.rand_core = rand_core;
 #endif
-          seqs_loaded = 1;
-          tmap_progress_print2("loaded %d reads", seqs_buffer_length);
-      }
-      if(0 == seqs_buffer_length) { // are there any more?
-          break;
-      }
+  if(0 != pthread_create(&thread_io, &attr_io, tmap_map_driver_thread_io_worker, &thread_io_data)) {
+      tmap_error("error creating threads", Exit, ThreadError);
+  }
+  pthread_attr_destroy(&attr_io);
 
-#ifdef HAVE_LIBPTHREAD
-      // launch a new thread that loads in the reads 
-      pthread_attr_init(&attr_io);
-      pthread_attr_setdetachstate(&attr_io, PTHREAD_CREATE_JOINABLE);
-      thread_io = tmap_malloc(sizeof(pthread_t), "thread_io");
-      thread_io_data.io_in = io_in;
-      thread_io_data.io_out = io_out;
-      thread_io_data.seqs_buffer_length = 0;
-      thread_io_data.reads_queue_size = reads_queue_size;
-      thread_io_data.seqs_buffer = seqs_buffer_next;
-      if(0 != pthread_create(thread_io, &attr_io, tmap_map_driver_thread_io_worker, &thread_io_data)) {
-          tmap_error("error creating threads", Exit, ThreadError);
-      }
+  // the workers pull reads from the loaded batches until the input is exhausted
+  tmap_map_driver_create_threads(io_out->fp->header->header, &pipeline, index, driver, rand, realigner, context,
+                                 &threads, &thread_data, 0);
 #endif
 
-      // create the threads
-      if(0 == tmap_map_driver_create_threads(io_out->fp->header->header, seqs_buffer, records, 
-                                             bams, seqs_buffer_length, index, driver, stat,
+  while(1) {
+#ifndef HAVE_LIBPTHREAD
+      // load and map the next batch in place
+      if(pipeline.read_batch <= pipeline.write_batch) {
+          tmap_map_driver_load_batch(io_in, io_out->fp->header->header, &pipeline, reads_queue_size,
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-                                             rand_core,
-#endif
-#ifdef HAVE_LIBPTHREAD
-                                             &attr, &threads, &thread_data, rand, stats, realigner, context,
+                                     driver, rand_core,
 #endif
-                                             0)) {
-          break;
+                                     1);
       }
-
-      /*
-      if(-1 != driver->opt->reads_queue_size) {
-          tmap_progress_print("writing alignments");
-      }
-      */
-
-      // write data
-      for(i=0;i<seqs_buffer_length;i++) {
-#ifdef HAVE_LIBPTHREAD
-          if(1 < driver->opt->num_threads) {
-              // NB: we will write data as threads process the data.  This is to
-              // facilitate SAM/BAM writing, which may be slow, especially for
-              // BAM.
-              int32_t tid = (i % driver->opt->num_threads);
-              while((*thread_data[tid].buffer_idx) <= i) {
-                  usleep(1000*1000); // sleep
-              }
-          }
+      tmap_map_driver_create_threads(io_out->fp->header->header, &pipeline, index, driver, rand, realigner, context, 0);
 #endif
-          // write
-          for(j=0;j<bams[i]->n;j++) { // for each end
-              for(k=0;k<bams[i]->bams[j]->n;k++) { // for each hit
-                  bam1_t *b = NULL;
-                  b = bams[i]->bams[j]->bams[k]; // that's a lot of BAMs
-                  if(NULL == b) tmap_bug();
-                  if(samwrite(io_out->fp, b) <= 0) {
-                      tmap_error("Error writing the SAM file", Exit, WriteFileError);
-                  }
-              }
-          }
-          tmap_map_bams_destroy(bams[i]);
-          bams[i] = NULL;
-      }
-
-#ifdef HAVE_LIBPTHREAD
-      // join threads
-      if(1 < driver->opt->num_threads) {
-          // join threads
-          for(i=0;i<driver->opt->num_threads;i++) {
-              if(0 != pthread_join(threads[i], NULL)) {
-                  tmap_error("error joining threads", Exit, ThreadError);
-              }
-              // add the stats
-              tmap_map_stats_add (stat, stats[i]);
-              tmap_map_stats_zero (stats[i]);
-              // free the buffer index
-              free(thread_data[i].buffer_idx);
-          }
-          free(threads); threads = NULL;
-          free(thread_data); thread_data = NULL;
-          free(attr); attr = NULL;
+      // write data
+      seqs_buffer_length = tmap_map_driver_write_batch(&pipeline, io_out, stat, driver->opt->num_threads);
+      if(0 == seqs_buffer_length) { // are there any more?
+          break;
       }
-#endif
       // TODO: should we flush when writing SAM and processing one read at a time?
 
         // print statistics
@@ -2105,7 +2356,21 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
                                     ((double) stat->bases_tailclipped) * 100 / stat->bases_seen_tailclipped);
             }
         }
-        seqs_loaded = 0;
+    }
+
+#ifdef HAVE_LIBPTHREAD
+    // join the workers and the reader
+    tmap_map_driver_join_threads(driver, &threads, &thread_data);
+    if(0 != pthread_join(thread_io, NULL)) {
+        tmap_error("error joining IO thread", Exit, ThreadError);
+    }
+#endif
+
+    // thread load balance
+    for(i=0;i<driver->opt->num_threads;i++) {
+        tmap_map_stats_add(stat, pipeline.thread_stats[i]);
+        tmap_progress_print2("thread %d busy for %.2lf seconds, idle for %.2lf seconds", i,
+                             pipeline.thread_stats[i]->busy_time, pipeline.thread_stats[i]->idle_time);
     }
 
     if(-1 == driver->opt->reads_queue_size) 
@@ -2132,6 +2397,9 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
         tmap_file_printf ("                  After scoring:  %llu\n", stat->num_after_scoring);
         tmap_file_printf ("             After dups removal:  %llu\n", stat->num_after_rmdup);
         tmap_file_printf ("                After filtering:  %llu\n", stat->num_after_filter);
+        tmap_file_printf ("Thread load balance (busy / idle seconds): %.2f / %.2f\n", stat->busy_time, stat->idle_time);
+        for (i = 0; i != driver->opt->num_threads; ++i)
+            tmap_file_printf ("                     Thread %3d:  %.2f / %.2f\n", i, pipeline.thread_stats [i]->busy_time, pipeline.thread_stats [i]->idle_time);
 
         if (!driver->opt->do_realign)
             tmap_file_printf (  "No realignment perormed\n");
@@ -2309,19 +2577,9 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
   // free memory
   tmap_index_destroy(index);
   tmap_seqs_io_destroy(io_in);
-  for(i=0;i<reads_queue_size;i++) {
-      tmap_seqs_destroy(seqs_buffer[i]);
-#ifdef HAVE_LIBPTHREAD
-      tmap_seqs_destroy(seqs_buffer_next[i]);
-#endif
-  }
-  free(seqs_buffer);
-#ifdef HAVE_LIBPTHREAD
-  free(seqs_buffer_next);
-#endif
+  tmap_map_driver_pipeline_destroy(&pipeline, reads_queue_size, driver->opt->num_threads);
 
 // DVK - realigner
-#ifdef HAVE_LIBPTHREAD
   for (i = 0; i != driver->opt->num_threads; ++i)
   {
       realigner_destroy (realigner [i]);
@@ -2330,29 +2588,15 @@ tmap_map_driver_core (tmap_map_driver_t *driver)
   free (realigner);
   free (context);
 
-#else
-  realigner_destroy (realigner);
-  realigner_destroy (context);
-#endif
-
   tmap_log_disable ();
   if (logfile)
     fclose (logfile);
 
-  free(records);
-  free(bams);
   tmap_map_stats_destroy(stat);
-#ifdef HAVE_LIBPTHREAD
   for(i=0;i<driver->opt->num_threads;i++) {
-      tmap_map_stats_destroy(stats[i]);
       tmap_rand_destroy(rand[i]);
   }
-  free(stats);
   free(rand);
-  free(thread_io);
-#else
-  tmap_rand_destroy(rand);
-#endif
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   tmap_rand_destroy(rand_core);
 #endif
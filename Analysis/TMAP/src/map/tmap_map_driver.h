@@ -3,6 +3,9 @@
 #define TMAP_MAP_DRIVER_H
 
 #include <sys/types.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 #include "../index/tmap_index.h"
 #include "../seq/tmap_seqs.h"
 
@@ -13,6 +16,11 @@
 #define TMAP_MAP_DRIVER_THREAD_BLOCK_SIZE 512
 #endif
 
+/*!
+  The number of read buffers cycling between the reader, the mapping threads and the writer.
+ */
+#define TMAP_MAP_DRIVER_NUM_BATCHES 3
+
 /*!
   This function will be invoked after reading in all the reference data
   to initialize any program options and print messages.
@@ -143,19 +151,64 @@ tmap_map_driver_run(tmap_map_driver_t *driver);
 void
 tmap_map_driver_destroy(tmap_map_driver_t *driver);
 
+/*!
+  A buffer of reads and their alignments, handed from the reader to the mapping threads to the writer.
+  */
+typedef struct {
+    tmap_seqs_t **seqs_buffer;  /*!< the buffer of sequences */
+    tmap_map_record_t **records;  /*!< the alignments for each sequence */
+    tmap_map_bams_t **bams;  /*!< the BAM alignments for each sequence */
+    uint8_t *done;  /*!< 1 if the sequence was mapped and its BAM alignments can be written, 0 otherwise */
+    int32_t *order;  /*!< the order in which the sequences are handed out, as indexes into the buffer */
+    tmap_map_stats_t **stats;  /*!< the driver statistics for this buffer, one per thread */
+    int32_t seqs_buffer_length;  /*!< the number of sequences in the buffer */
+    int32_t next_idx;  /*!< the zero-based position in order of the next chunk to hand out, advanced atomically */
+    int32_t num_workers;  /*!< the number of threads that may still claim chunks from this buffer */
+    uint64_t read_offset;  /*!< the number of sequences read from the input before this buffer */
+} tmap_map_driver_batch_t;
+
+/*!
+  The read/map/write pipeline: a ring of batches, filled in order by the reader, mapped in small chunks
+  of reads by any free thread, and written in input order.  The zero-based batch counters only increase;
+  the batch number n lives in batches[n % num_batches].
+  */
+typedef struct {
+    tmap_map_driver_batch_t *batches;  /*!< the ring of batches */
+    int32_t num_batches;  /*!< the number of batches in the ring */
+    int64_t read_batch;  /*!< the number of batches loaded by the reader */
+    int64_t map_batch;  /*!< the batch the threads currently take reads from */
+    int64_t write_batch;  /*!< the number of batches written */
+    uint64_t num_reads_loaded;  /*!< the number of sequences loaded so far */
+    int32_t eof;  /*!< 1 if the reader found no more sequences, 0 otherwise */
+    int32_t chunk_size;  /*!< the number of sequences a thread claims at a time */
+    int32_t long_reads_first;  /*!< 1 to hand out the longest sequences of a batch first, 0 for input order */
+    tmap_map_stats_t **thread_stats;  /*!< the busy and idle time of each thread */
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_t lock;  /*!< guards the counters above and the batches' done flags */
+    pthread_cond_t loaded;  /*!< signalled when a batch was loaded or the input ended */
+    pthread_cond_t mapped;  /*!< signalled when a chunk was mapped or a thread left a batch */
+    pthread_cond_t written;  /*!< signalled when a batch was written and can be re-used */
+#endif
+} tmap_map_driver_pipeline_t;
+
+/*!
+  The chunk of a batch a thread is mapping: positions [begin, end) of the batch order.
+  */
+typedef struct {
+    tmap_map_driver_batch_t *batch;  /*!< the batch, NULL if the thread holds no chunk */
+    int32_t begin;  /*!< the first position of the chunk */
+    int32_t pos;  /*!< the position of the next sequence to map */
+    int32_t end;  /*!< one past the last position of the chunk */
+} tmap_map_driver_chunk_t;
+
 /*! 
   Driver data to be passed to a thread                         
   */
 typedef struct {                                            
     sam_header_t *sam_header;  /*!< the SAM Header */
-    tmap_seqs_t **seqs_buffer;  /*!< the buffers of sequences */    
-    int32_t seqs_buffer_length;  /*!< the buffers length */
-    int32_t *buffer_idx; /*!< the current zero-based index into the buffer */
-    tmap_map_record_t **records;  /*!< the alignments for each sequence */
-    tmap_map_bams_t **bams;  /*!< the BAM alignments for each sequence */
+    tmap_map_driver_pipeline_t *pipeline;  /*!< the pipeline handing out the sequences */
     tmap_index_t *index;  /*!< pointer to the reference index */
     tmap_map_driver_t *driver;  /*!< the main driver object */
-    tmap_map_stats_t *stat; /*!< the driver statistics */
     tmap_rand_t *rand;  /*!< the random number generator */
     // DVK - realigner
     struct RealignProxy *realigner; /*!< post-processing realigner engine */
@@ -165,30 +218,20 @@ typedef struct {
 } tmap_map_driver_thread_data_t;
 
 /*!
-  The core worker routine of mapall
+  The core worker routine of mapall; maps sequences taken from the pipeline until it runs dry
   @param  sam_header           the SAM Header
-  @param  seqs_buffer           the buffer of sequences
-  @param  records              the records to return
-  @param  bams                 the bams to return
-  @param  seqs_buffer_length    the number of sequences in the buffer
-  @param  buffer_idx            the current zero-based index into the buffer
+  @param  pipeline             the pipeline handing out the sequences
   @param  index                the reference index
   @param  driver               the driver
-  @param  stat                 the driver statistics
   @param  rand                 the random number generator
   @param  do_pairing           1 if we are performing pairing paramter calculation, 0 otherwise 
   @param  tid                  the thread ids
  */
 void
 tmap_map_driver_core_worker(sam_header_t *sam_header,
-                            tmap_seqs_t **seqs_buffer, 
-                            tmap_map_record_t **records,
-                            tmap_map_bams_t **bams,
-                            int32_t seqs_buffer_length,
-                            int32_t *buffer_idx,
+                            tmap_map_driver_pipeline_t *pipeline,
                             tmap_index_t *index,
                             tmap_map_driver_t *driver,
-                            tmap_map_stats_t* stat,
                             tmap_rand_t *rand,
                             // DVK - realign
                             struct RealignProxy *realigner, 
@@ -170,6 +170,8 @@ __tmap_map_opt_option_print_func_double_init(long_hit_mult)
 __tmap_map_opt_option_print_func_int_init(score_thr)
 __tmap_map_opt_option_print_func_int_init(reads_queue_size)
 __tmap_map_opt_option_print_func_int_autodetected_init(num_threads, num_threads_autodetected)
+__tmap_map_opt_option_print_func_int_init(reads_chunk_size)
+__tmap_map_opt_option_print_func_tf_init(long_reads_first)
 __tmap_map_opt_option_print_func_int_init(aln_output_mode)
 __tmap_map_opt_option_print_func_char_array_init(sam_rg, sam_rg_num, "not using")
 __tmap_map_opt_option_print_func_tf_init(bidirectional)
@@ -190,6 +192,7 @@ __tmap_map_opt_option_print_func_int_init(max_adapter_bases_for_soft_clipping)
 __tmap_map_opt_option_print_func_tf_init(end_repair_5_prime_softclip)
 
 __tmap_map_opt_option_print_func_int_init(shm_key)
+__tmap_map_opt_option_print_func_tf_init(index_hugepages)
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
 __tmap_map_opt_option_print_func_double_init(sample_reads)
 #endif
@@ -470,7 +473,7 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
       "3 - all alignments",
       NULL};
   static char *vsw_type[] = {
-      "NB: currently only #1, #4, and #6 have been tested",
+      "NB: currently only #1, #4, #6 and #11 have been tested",
       "1 - lh3/ksw.c/nh13",
       "2 - simple VSW",
       "3 - SHRiMP2 VSW [not working]",
@@ -481,6 +484,7 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
       "8 - venco (Top Coder #5) [not working]",
       "9 - Bladze (Top Coder #6)",
       "10 - ngthuydiem (Top Coder #7) [Farrar cut-and-paste]",
+      "11 - striped SSE2/AVX2/AVX-512 with 8-bit lanes where possible",
       NULL};
   static char *realignment_clip_type[] = {
       "0 - global realignment",
@@ -646,6 +650,18 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
                            NULL,
                            tmap_map_opt_option_print_func_num_threads,
                            TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "reads-chunk-size", required_argument, 0, 0, 
+                           TMAP_MAP_OPT_TYPE_INT,
+                           "the number of reads a thread takes from the queue at a time",
+                           NULL,
+                           tmap_map_opt_option_print_func_reads_chunk_size,
+                           TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "long-reads-first", no_argument, 0, 0, 
+                           TMAP_MAP_OPT_TYPE_NONE,
+                           "specifies to map the longest reads in the queue first, so that no thread is left with a long read at the end",
+                           NULL,
+                           tmap_map_opt_option_print_func_long_reads_first,
+                           TMAP_MAP_ALGO_GLOBAL);
   tmap_map_opt_options_add(opt->options, "aln-output-mode", required_argument, 0, 'a', 
                            TMAP_MAP_OPT_TYPE_INT,
                            "output filter",
@@ -763,6 +779,12 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
                            NULL,
                            tmap_map_opt_option_print_func_shm_key,
                            TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "index-hugepages", no_argument, 0, 0, 
+                           TMAP_MAP_OPT_TYPE_NONE,
+                           "map the reference index on huge page boundaries and advise transparent huge pages",
+                           NULL,
+                           tmap_map_opt_option_print_func_index_hugepages,
+                           TMAP_MAP_ALGO_GLOBAL);
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   tmap_map_opt_options_add(opt->options, "sample-reads", required_argument, 0, 'x',
                            TMAP_MAP_OPT_TYPE_FLOAT,
@@ -1397,6 +1419,8 @@ tmap_map_opt_init(int32_t algo_id)
   opt->reads_queue_size = 262144;
   opt->num_threads = tmap_detect_cpus();
   opt->num_threads_autodetected = 1;
+  opt->reads_chunk_size = 16;
+  opt->long_reads_first = 0;
   opt->aln_output_mode = TMAP_MAP_OPT_ALN_MODE_RAND_BEST;
   opt->sam_rg = NULL;
   opt->sam_rg_num = 0;
@@ -1413,6 +1437,7 @@ tmap_map_opt_init(int32_t algo_id)
   opt->max_adapter_bases_for_soft_clipping = INT32_MAX;
   opt->end_repair_5_prime_softclip = 0;
   opt->shm_key = 0;
+  opt->index_hugepages = 0;
   opt->min_seq_len = -1;
   opt->max_seq_len = -1;
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
@@ -1881,6 +1906,9 @@ tmap_map_opt_parse(int argc, char *argv[], tmap_map_opt_t *opt)
       else if(c == 'k' || (0 == c && 0 == strcmp("shared-memory-key", options[option_index].name))) {       
           opt->shm_key = atoi(optarg);
       }
+      else if(0 == c && 0 == strcmp("index-hugepages", options[option_index].name)) {
+          opt->index_hugepages = 1;
+      }
       else if(c == 'o' || (0 == c && 0 == strcmp("output-type", options[option_index].name))) {
           opt->output_type = atoi(optarg);
       }
@@ -1891,6 +1919,12 @@ tmap_map_opt_parse(int argc, char *argv[], tmap_map_opt_t *opt)
       else if(c == 'q' || (0 == c && 0 == strcmp("reads-queue-size", options[option_index].name))) {       
           opt->reads_queue_size = atoi(optarg);
       }
+      else if(0 == c && 0 == strcmp("reads-chunk-size", options[option_index].name)) {
+          opt->reads_chunk_size = atoi(optarg);
+      }
+      else if(0 == c && 0 == strcmp("long-reads-first", options[option_index].name)) {
+          opt->long_reads_first = 1;
+      }
       else if(c == 'r' || (0 == c && 0 == strcmp("fn-reads", options[option_index].name))) {       
           opt->fn_reads_num++;
           opt->fn_reads = tmap_realloc(opt->fn_reads, sizeof(char*) * opt->fn_reads_num, "opt->fn_reads");
@@ -2348,6 +2382,12 @@ tmap_map_opt_check_global(tmap_map_opt_t *opt_a, tmap_map_opt_t *opt_b)
     if(opt_a->num_threads != opt_b->num_threads) {
         tmap_error("option -n was specified outside of the common options", Exit, CommandLineArgument);
     }
+    if(opt_a->reads_chunk_size != opt_b->reads_chunk_size) {
+        tmap_error("option --reads-chunk-size was specified outside of the common options", Exit, CommandLineArgument);
+    }
+    if(opt_a->long_reads_first != opt_b->long_reads_first) {
+        tmap_error("option --long-reads-first was specified outside of the common options", Exit, CommandLineArgument);
+    }
     /* NB: "aln_output_mode" or "-a" may be modified by mapall */
     if(opt_a->sam_rg_num != opt_b->sam_rg_num) {
         tmap_error("option -R was specified outside of the common options", Exit, CommandLineArgument);
@@ -2372,6 +2412,9 @@ tmap_map_opt_check_global(tmap_map_opt_t *opt_a, tmap_map_opt_t *opt_b)
     if(opt_a->shm_key != opt_b->shm_key) {
         tmap_error("option -k was specified outside of the common options", Exit, CommandLineArgument);
     }
+    if(opt_a->index_hugepages != opt_b->index_hugepages) {
+        tmap_error("option --index-hugepages was specified outside of the common options", Exit, CommandLineArgument);
+    }
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     if(opt_a->sample_reads != opt_b->sample_reads) {
         tmap_error("option -x was specified outside of the common options", Exit, CommandLineArgument);
@@ -2533,6 +2576,8 @@ tmap_map_opt_check(tmap_map_opt_t *opt)
   tmap_error_cmd_check_int(opt->score_thr, INT32_MIN, INT32_MAX, "-T");
   if(-1 != opt->reads_queue_size) tmap_error_cmd_check_int(opt->reads_queue_size, 1, INT32_MAX, "-q");
   tmap_error_cmd_check_int(opt->num_threads, 1, INT32_MAX, "-n");
+  tmap_error_cmd_check_int(opt->reads_chunk_size, 1, INT32_MAX, "--reads-chunk-size");
+  tmap_error_cmd_check_int(opt->long_reads_first, 0, 1, "--long-reads-first");
   tmap_error_cmd_check_int(opt->aln_output_mode, 0, 3, "-a");
   // SAM RG
   if(0 < opt->sam_rg_num) {
@@ -2555,12 +2600,13 @@ tmap_map_opt_check(tmap_map_opt_t *opt)
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   tmap_error_cmd_check_int(opt->sample_reads, 0, 1, "-x");
 #endif
-  tmap_error_cmd_check_int(opt->vsw_type, 1, 10, "-H");
+  tmap_error_cmd_check_int(opt->vsw_type, 1, 11, "-H");
   // Warn users
   switch(opt->vsw_type) {
     case 1:
     case 4:
     case 6:
+    case 11:
       break;
     default:
       tmap_error("the option -H value has not been extensively tested; proceed with caution", Warn, CommandLineArgument);
@@ -2751,6 +2797,8 @@ tmap_map_opt_copy_global(tmap_map_opt_t *opt_dest, tmap_map_opt_t *opt_src)
     opt_dest->score_thr = opt_src->score_thr;
     opt_dest->reads_queue_size = opt_src->reads_queue_size;
     opt_dest->num_threads = opt_src->num_threads;
+    opt_dest->reads_chunk_size = opt_src->reads_chunk_size;
+    opt_dest->long_reads_first = opt_src->long_reads_first;
     if(TMAP_MAP_ALGO_STAGE == opt_dest->algo_id) {
         opt_dest->aln_output_mode = opt_src->aln_output_mode;
     }
@@ -2775,6 +2823,7 @@ tmap_map_opt_copy_global(tmap_map_opt_t *opt_dest, tmap_map_opt_t *opt_src)
     opt_dest->max_adapter_bases_for_soft_clipping = opt_src->max_adapter_bases_for_soft_clipping;
     opt_dest->end_repair_5_prime_softclip = opt_src->end_repair_5_prime_softclip;
     opt_dest->shm_key = opt_src->shm_key;
+    opt_dest->index_hugepages = opt_src->index_hugepages;
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     opt_dest->sample_reads = opt_src->sample_reads;
 #endif
@@ -2848,6 +2897,8 @@ tmap_map_opt_print(tmap_map_opt_t *opt)
   fprintf(stderr, "score_thr=%d\n", opt->score_thr);
   fprintf(stderr, "reads_queue_size=%d\n", opt->reads_queue_size);
   fprintf(stderr, "num_threads=%d\n", opt->num_threads);
+  fprintf(stderr, "reads_chunk_size=%d\n", opt->reads_chunk_size);
+  fprintf(stderr, "long_reads_first=%d\n", opt->long_reads_first);
   fprintf(stderr, "aln_output_mode=%d\n", opt->aln_output_mode);
   for(i=0;i<opt->sam_rg_num;i++) {
       if(0 < i) fprintf(stderr, ",");
@@ -2869,6 +2920,7 @@ tmap_map_opt_print(tmap_map_opt_t *opt)
   fprintf(stderr, "max_adapter_bases_for_soft_clipping=%d\n", opt->max_adapter_bases_for_soft_clipping);
   fprintf(stderr, "end_repair_5_prime_softclip=%d\n", opt->end_repair_5_prime_softclip);
   fprintf(stderr, "shm_key=%d\n", (int)opt->shm_key);
+  fprintf(stderr, "index_hugepages=%d\n", opt->index_hugepages);
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   fprintf(stderr, "sample_reads=%lf\n", opt->sample_reads);
 #endif
@@ -218,6 +218,8 @@ typedef struct __tmap_map_opt_t {
     int32_t reads_queue_size;  /*!< the reads queue size (-q,--reads-queue-size) */
     int32_t num_threads;  /*!< the number of threads (-n,--num-threads) */
     int32_t num_threads_autodetected;  /*!< 1 if the number of threads has been auto detected, 0 otherwise (-n,--num-threads) */
+    int32_t reads_chunk_size;  /*!< the number of reads a thread takes from the queue at a time (--reads-chunk-size) */
+    int32_t long_reads_first;  /*!< specifies to map the longest reads in the queue first (--long-reads-first) */
     int32_t aln_output_mode;  /*!< specifies how to choose alignments (-a,--aln-output-mode) */
     char **sam_rg;  /*!< specifies the RG line in the SAM header (-R,--sam-read-group) */
     int32_t sam_rg_num;  /*!< the number of rg tags */
@@ -238,6 +240,7 @@ typedef struct __tmap_map_opt_t {
     int32_t end_repair_5_prime_softclip; /*!< end-repair is allowed to introduce 5' softclip */
 
     key_t shm_key;  /*!< the shared memory key (-k,--shared-memory-key) */
+    int32_t index_hugepages;  /*!< map the reference index on huge page boundaries and advise huge pages (--index-hugepages) */
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     double sample_reads;  /*!< sample the reads at this fraction (-x,--sample-reads) */
 #endif
@@ -63,6 +63,9 @@ typedef struct
     uint64_t bases_fully_tailclipped;
     // number of filtered alignments 
     uint64_t num_filtered_als;
+    // thread load balance
+    double busy_time; /*!< the wall time, in seconds, spent mapping reads */
+    double idle_time; /*!< the wall time, in seconds, spent waiting for reads to map */
 } tmap_map_stats_t;
 
 /*!
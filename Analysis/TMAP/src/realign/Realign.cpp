@@ -12,14 +12,15 @@
 
 
 void AlignmentCell::initialize(int init_score) {
-  int FROM_NOWHERE = 4;
   int kNotApplicable = -1000000;
   is_match = false;
   best_score = init_score;
   best_path_direction = FROM_NOWHERE;
-  scores.assign(FROM_NOWHERE+1, kNotApplicable);
+  for (int i=0; i<FROM_NOWHERE; i++) {
+    scores[i] = kNotApplicable;
+    in_directions[i] = FROM_NOWHERE;
+  }
   scores[FROM_NOWHERE] = init_score;
-  in_directions.assign(FROM_NOWHERE, FROM_NOWHERE);
 }
 
 // -------------------------------------------------------------------
@@ -174,45 +175,28 @@ void Realigner::ReverseClipping() {
 
 // -------------------------------------------------------------------
 
-bool Realigner::isMatch(char nuc1, char nuc2)
-{
-  bool isM = false;
-  vector<bool> nuc_ensemble1(4, false);
-  vector<bool> nuc_ensemble2(4, false);
-  nuc_ensemble1 = getNucMatches(nuc1);
-  nuc_ensemble2 = getNucMatches(nuc2);
-  for (int i=0; i<4; i++)
-    isM = isM || (nuc_ensemble1[i] && nuc_ensemble2[i]);
-  return isM;
-}
-
-// -------------------------------------------------------------------
-
-vector<bool> Realigner::getNucMatches(char nuc)
+unsigned char Realigner::NucMask(char nuc)
 {
-  vector<bool> nuc_ensemble(4, false);
-  nuc = toupper(nuc);
-
-  switch(nuc) {
-      case 'A': nuc_ensemble[0] = true; break;
-      case 'C': nuc_ensemble[1] = true; break;
-      case 'G': nuc_ensemble[2] = true; break;
-      case 'T': nuc_ensemble[3] = true; break;
-      case 'U': nuc_ensemble[3] = true; break;
-      case 'W': nuc_ensemble[0] = true; nuc_ensemble[3] = true; break;
-      case 'S': nuc_ensemble[1] = true; nuc_ensemble[2] = true; break;
-      case 'M': nuc_ensemble[0] = true; nuc_ensemble[1] = true; break;
-      case 'K': nuc_ensemble[2] = true; nuc_ensemble[3] = true; break;
-      case 'R': nuc_ensemble[0] = true; nuc_ensemble[2] = true; break;
-      case 'Y': nuc_ensemble[1] = true; nuc_ensemble[3] = true; break;
-      case 'B': nuc_ensemble[1] = true; nuc_ensemble[2] = true; nuc_ensemble[3] = true; break;
-      case 'D': nuc_ensemble[0] = true; nuc_ensemble[2] = true; nuc_ensemble[3] = true; break;
-      case 'H': nuc_ensemble[0] = true; nuc_ensemble[1] = true; nuc_ensemble[3] = true; break;
-      case 'I': nuc_ensemble[0] = true; nuc_ensemble[1] = true; nuc_ensemble[3] = true; break;
-      case 'V': nuc_ensemble[0] = true; nuc_ensemble[1] = true; nuc_ensemble[2] = true; break;
-      case 'N': nuc_ensemble.assign(4, true); break;
+  switch(toupper(nuc)) {
+      case 'A': return 1;
+      case 'C': return 2;
+      case 'G': return 4;
+      case 'T': return 8;
+      case 'U': return 8;
+      case 'W': return 1|8;
+      case 'S': return 2|4;
+      case 'M': return 1|2;
+      case 'K': return 4|8;
+      case 'R': return 1|4;
+      case 'Y': return 2|8;
+      case 'B': return 2|4|8;
+      case 'D': return 1|4|8;
+      case 'H': return 1|2|8;
+      case 'I': return 1|2|8;
+      case 'V': return 1|2|4;
+      case 'N': return 1|2|4|8;
   }
-  return nuc_ensemble;
+  return 0;
 }
 
 // -------------------------------------------------------------------
@@ -328,16 +312,6 @@ bool Realigner::computeSWalignment(vector<CigarOp>& CigarData, vector<MDelement>
   if (!ComputeTubedAlignmentBoundaries())
     return false;
 
-  // Path ordering creates left aligned InDels
-  vector<int> insertion_path_ordering(3);
-  vector<int> deletion_path_ordering(3);
-  insertion_path_ordering[0] = FROM_I;
-  insertion_path_ordering[1] = FROM_MATCH;
-  insertion_path_ordering[2] = FROM_MISM;
-  deletion_path_ordering[0] = FROM_D;
-  deletion_path_ordering[1] = FROM_MATCH;
-  deletion_path_ordering[2] = FROM_MISM;
-
   // --- Compute first row  and column of the matrix
   // First row: moving horizontally for insertions
   if (!soft_clip_left_) {
@@ -371,83 +345,104 @@ bool Realigner::computeSWalignment(vector<CigarOp>& CigarData, vector<MDelement>
     }
   }
 
+  // Nucleotide ensembles are looked up once per base instead of once per cell
+  q_nuc_mask_.resize(q_seq_.size());
+  for (unsigned int q_idx=0; q_idx<q_seq_.size(); q_idx++)
+    q_nuc_mask_[q_idx] = NucMask(q_seq_[q_idx]);
+  t_nuc_mask_.resize(t_seq_.size());
+  for (unsigned int t_idx=0; t_idx<t_seq_.size(); t_idx++)
+    t_nuc_mask_[t_idx] = NucMask(t_seq_[t_idx]);
+
   // ------ Main alignment loop ------
-  vector<int>   temp_scores(FROM_NOWHERE);
-  vector<int>   highest_score_cell(2, 0);
+  unsigned int highest_t_idx = 0, highest_q_idx = 0;
+  int highest_score = DP_matrix[0][0].best_score;
+  const int start_score = soft_clip_left_ ? 0 : kNotApplicable;
 
   for (unsigned int t_idx=1; t_idx<t_seq_.size()+1; t_idx++) {
 
+    AlignmentCell* row = &DP_matrix[t_idx][0];
+    const AlignmentCell* prev_row = &DP_matrix[t_idx-1][0];
+    const unsigned char t_mask = t_nuc_mask_[t_idx-1];
+    // Clipping settings determine where we search for the best scoring cell to stop aligning
+    const bool valid_t_idx = stop_anywhere_in_ref_ or (t_idx == t_seq_.size());
+
     for (unsigned int q_idx=q_limit_minus_[t_idx]; q_idx<q_limit_plus_[t_idx]; q_idx++) {
 
       if (q_idx == 0)
         continue;
 
+      AlignmentCell& cell = row[q_idx];
+      const AlignmentCell& diag = prev_row[q_idx-1];
+      const AlignmentCell& left = row[q_idx-1];
+      const AlignmentCell& up = prev_row[q_idx];
+
       // Scoring for Match; Mismatch / Insertion / Deletion;
-      // work around a c++11 issue
-      int kNotApplicable_tmp = kNotApplicable;
-      int FROM_NOWHERE_tmp = FROM_NOWHERE;
-      DP_matrix[t_idx][q_idx].scores.assign(FROM_NOWHERE_tmp+1, kNotApplicable_tmp); //C++11 issue
-      DP_matrix[t_idx][q_idx].in_directions.assign(FROM_NOWHERE_tmp, FROM_NOWHERE_tmp); //C++11 issue
-      if (soft_clip_left_)
-        DP_matrix[t_idx][q_idx].scores[FROM_NOWHERE] = 0;
+      for (int iMove=0; iMove<FROM_NOWHERE; iMove++) {
+        cell.scores[iMove] = kNotApplicable;
+        cell.in_directions[iMove] = FROM_NOWHERE;
+      }
+      cell.scores[FROM_NOWHERE] = start_score;
 
       // 1) - Match / Mismatch Score
-      DP_matrix[t_idx][q_idx].is_match = isMatch(q_seq_[q_idx-1], t_seq_[t_idx-1]);
-      if (DP_matrix[t_idx][q_idx].is_match) {
-        DP_matrix[t_idx][q_idx].in_directions[FROM_MATCH] = DP_matrix[t_idx-1][q_idx-1].best_path_direction;
-        DP_matrix[t_idx][q_idx].scores[FROM_MATCH] = DP_matrix[t_idx-1][q_idx-1].best_score + kMatchScore;
+      cell.is_match = (q_nuc_mask_[q_idx-1] & t_mask) != 0;
+      if (cell.is_match) {
+        cell.in_directions[FROM_MATCH] = diag.best_path_direction;
+        cell.scores[FROM_MATCH] = diag.best_score + kMatchScore;
       } else {
-        DP_matrix[t_idx][q_idx].in_directions[FROM_MISM] = DP_matrix[t_idx-1][q_idx-1].best_path_direction;
-        DP_matrix[t_idx][q_idx].scores[FROM_MISM] = DP_matrix[t_idx-1][q_idx-1].best_score + kMismatchScore;
+        cell.in_directions[FROM_MISM] = diag.best_path_direction;
+        cell.scores[FROM_MISM] = diag.best_score + kMismatchScore;
       }
 
       // 2) - Insertion Score
-      temp_scores.assign(FROM_NOWHERE, kNotApplicable_tmp);
-      temp_scores[FROM_MATCH] = DP_matrix[t_idx][q_idx-1].scores[FROM_MATCH] + kGapOpen;
-      temp_scores[FROM_I] = DP_matrix[t_idx][q_idx-1].scores[FROM_I] + kGapExtend;
-      temp_scores[FROM_MISM] = DP_matrix[t_idx][q_idx-1].scores[FROM_MISM] + kGapOpen;
-      DP_matrix[t_idx][q_idx].scores[FROM_I] = kNotApplicable;
-      DP_matrix[t_idx][q_idx].in_directions[FROM_I] = FROM_NOWHERE;
-      for (int i=0; i<(int)insertion_path_ordering.size(); i++) {
-        if (temp_scores[insertion_path_ordering[i]] > DP_matrix[t_idx][q_idx].scores[FROM_I]) {
-          DP_matrix[t_idx][q_idx].scores[FROM_I] = temp_scores[insertion_path_ordering[i]];
-          DP_matrix[t_idx][q_idx].in_directions[FROM_I] = insertion_path_ordering[i];
-        }
+      // Path ordering I, MATCH, MISM with strict comparisons creates left aligned InDels
+      int score = left.scores[FROM_I] + kGapExtend;
+      if (score > kNotApplicable) {
+        cell.scores[FROM_I] = score;
+        cell.in_directions[FROM_I] = FROM_I;
+      }
+      score = left.scores[FROM_MATCH] + kGapOpen;
+      if (score > cell.scores[FROM_I]) {
+        cell.scores[FROM_I] = score;
+        cell.in_directions[FROM_I] = FROM_MATCH;
+      }
+      score = left.scores[FROM_MISM] + kGapOpen;
+      if (score > cell.scores[FROM_I]) {
+        cell.scores[FROM_I] = score;
+        cell.in_directions[FROM_I] = FROM_MISM;
       }
 
-      // 3) - Deletion Score
-      temp_scores.assign(FROM_NOWHERE, kNotApplicable_tmp);
-      temp_scores[FROM_MATCH] = DP_matrix[t_idx-1][q_idx].scores[FROM_MATCH] + kGapOpen;
-      temp_scores[FROM_D] = DP_matrix[t_idx-1][q_idx].scores[FROM_D] + kGapExtend;
-      temp_scores[FROM_MISM] = DP_matrix[t_idx-1][q_idx].scores[FROM_MISM] + kGapOpen;
-      DP_matrix[t_idx][q_idx].scores[FROM_D] = kNotApplicable;
-      DP_matrix[t_idx][q_idx].in_directions[FROM_D] = FROM_NOWHERE;
-      for (int i=0; i<(int)deletion_path_ordering.size(); i++) {
-        if (temp_scores[deletion_path_ordering[i]] > DP_matrix[t_idx][q_idx].scores[FROM_D]) {
-          DP_matrix[t_idx][q_idx].scores[FROM_D] = temp_scores[deletion_path_ordering[i]];
-          DP_matrix[t_idx][q_idx].in_directions[FROM_D] = deletion_path_ordering[i];
-        }
+      // 3) - Deletion Score, path ordering D, MATCH, MISM
+      score = up.scores[FROM_D] + kGapExtend;
+      if (score > kNotApplicable) {
+        cell.scores[FROM_D] = score;
+        cell.in_directions[FROM_D] = FROM_D;
+      }
+      score = up.scores[FROM_MATCH] + kGapOpen;
+      if (score > cell.scores[FROM_D]) {
+        cell.scores[FROM_D] = score;
+        cell.in_directions[FROM_D] = FROM_MATCH;
+      }
+      score = up.scores[FROM_MISM] + kGapOpen;
+      if (score > cell.scores[FROM_D]) {
+        cell.scores[FROM_D] = score;
+        cell.in_directions[FROM_D] = FROM_MISM;
       }
 
       // Choose best move for this cell
-      DP_matrix[t_idx][q_idx].best_score = kNotApplicable-1;
-      DP_matrix[t_idx][q_idx].best_path_direction = FROM_NOWHERE;
-      for (unsigned int iMove=0; iMove<DP_matrix[t_idx][q_idx].scores.size(); iMove++) {
-        if (DP_matrix[t_idx][q_idx].scores[iMove] > DP_matrix[t_idx][q_idx].best_score) {
-          DP_matrix[t_idx][q_idx].best_score = DP_matrix[t_idx][q_idx].scores[iMove];
-          DP_matrix[t_idx][q_idx].best_path_direction = iMove;
+      cell.best_score = kNotApplicable-1;
+      cell.best_path_direction = FROM_NOWHERE;
+      for (int iMove=0; iMove<=FROM_NOWHERE; iMove++) {
+        if (cell.scores[iMove] > cell.best_score) {
+          cell.best_score = cell.scores[iMove];
+          cell.best_path_direction = iMove;
         }
       }
 
-      // Clipping settings determine where we search for the best scoring cell to stop aligning
-      bool valid_t_idx = stop_anywhere_in_ref_ or (t_idx == t_seq_.size());
       bool valid_q_idx = soft_clip_right_ or (q_idx == q_seq_.size());
-      bool investigate_highscore = valid_t_idx && valid_q_idx;
-
-      if (investigate_highscore and DP_matrix[t_idx][q_idx].best_score
-               > DP_matrix[highest_score_cell[0]][highest_score_cell[1]].best_score) {
-        highest_score_cell[0] = t_idx;
-        highest_score_cell[1] = q_idx;
+      if (valid_t_idx and valid_q_idx and cell.best_score > highest_score) {
+        highest_t_idx = t_idx;
+        highest_q_idx = q_idx;
+        highest_score = cell.best_score;
       }
 
     }
@@ -456,12 +451,12 @@ bool Realigner::computeSWalignment(vector<CigarOp>& CigarData, vector<MDelement>
 
   // Force full string alignment if desired, no matter what the score is.
   if (!stop_anywhere_in_ref_ and !soft_clip_right_) {
-    highest_score_cell[0] = t_seq_.size();
-    highest_score_cell[1] = q_seq_.size();
+    highest_t_idx = t_seq_.size();
+    highest_q_idx = q_seq_.size();
   }
 
   // Backtrack alignment in dynamic programming matrix, generate cigar string / MD tag
-  backtrackAlignment(highest_score_cell[0], highest_score_cell[1], CigarData, MD_data, start_pos_update);
+  backtrackAlignment(highest_t_idx, highest_q_idx, CigarData, MD_data, start_pos_update);
   return true;
 }
 
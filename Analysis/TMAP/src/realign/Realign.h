@@ -23,15 +23,27 @@ using namespace std;
 
 // ==================================================================
 
+//! Incoming alignment moves of a DP matrix cell.
+enum AlignmentMove {
+  FROM_MATCH   = 0,   //!< The alignment was extended from a match.
+  FROM_MISM    = 1,   //!< The alignment was extended from a mismatch.
+  FROM_I       = 2,   //!< The alignment was extended from an insertion.
+  FROM_D       = 3,   //!< The alignment was extended from an deletion.
+  FROM_NOWHERE = 4    //!< No valid incoming alignment move.
+};
+
+// Scores and incoming moves are indexed by FROM_MATCH .. FROM_NOWHERE. The cell is kept
+// flat so that filling the matrix does not touch the heap.
 struct AlignmentCell {
 
+  AlignmentCell() { initialize(-1000000); }
   void initialize(int init_score);
 
   bool            is_match;
   int             best_score;
   int             best_path_direction;
-  vector<int>     scores;
-  vector<int>     in_directions;
+  int             scores[FROM_NOWHERE+1];
+  int             in_directions[FROM_NOWHERE];
 };
 
 struct MDelement {
@@ -192,10 +204,10 @@ protected:
           MDelement& current_MD_element, vector<MDelement>& MD_data);
 
   //! @brief  Do query and target (complex symbol) nucleotide produce a match?
-  bool isMatch(char nuc1, char nuc2);
+  bool isMatch(char nuc1, char nuc2) const { return (NucMask(nuc1) & NucMask(nuc2)) != 0; }
 
-  //! @brief  Which nucleotides match this complex symbol?
-  vector<bool> getNucMatches(char nuc);
+  //! @brief  Which nucleotides match this complex symbol? Bits 0-3 stand for A,C,G,T
+  static unsigned char NucMask(char nuc);
 
   //! @ brief  Spells out the constants representing alignment types
   string PrintAlignType(int align_type);
@@ -219,6 +231,8 @@ protected:
   unsigned int     alignment_bandwidth_;    //!< Diagonal bandwidth of tubed alignment around previously found one
   vector<unsigned int>   q_limit_minus_;    //!< Lower (inclusive) limit on the query index for each target index
   vector<unsigned int>   q_limit_plus_;     //!< Upper (exclusive) limit on the query index for each target index
+  vector<unsigned char>  q_nuc_mask_;       //!< NucMask() of every query base, filled by computeSWalignment
+  vector<unsigned char>  t_nuc_mask_;       //!< NucMask() of every target base, filled by computeSWalignment
   ClippedAnchors         clipped_anchors_;  //!< Stores information of bases the are not realigned
 
   int              kMatchScore;
@@ -227,12 +241,6 @@ protected:
   int              kGapExtend;
   const static int kNotApplicable = -1000000;
 
-  const static int      FROM_MATCH   = 0;   //!< The alignment was extended from a match.
-  const static int      FROM_MISM    = 1;   //!< The alignment was extended from a mismatch.
-  const static int      FROM_I       = 2;   //!< The alignment was extended from an insertion.
-  const static int      FROM_D       = 3;   //!< The alignment was extended from an deletion.
-  const static int      FROM_NOWHERE = 4;   //!< No valid incoming alignment move.
-
   const static char     ALN_DEL      = '-'; //!< A base deletion in the alignment string.
   const static char     ALN_INS      = '+'; //!< A base insertion in the alignment string.
   const static char     ALN_MATCH    = '|'; //!< A matching base in the alignment string.
@@ -25,6 +25,8 @@ struct ALIGN_FVECT
     double h; // horizontal == weight for the best path coming from right (horizontally)
     int r;    // residue (==base :)
     int div;  // length of homooligotract for current residue
+    double vgip; // gap initiation penalty for a vertical skip at this residue, scaled by div as the aligner requires
+    double vgep; // gap extension penalty for a vertical skip at this residue, scaled by div as the aligner requires
 } __attribute__ ((packed));
 
 // in-place array element order reversal
@@ -69,6 +69,10 @@ double ContAlign::align_y_loop (register ALIGN_FVECT* ap, unsigned char base, ch
     double v = low_score, nv, nh; // works for both to_first and normal mode: just guarantees that cost of coming from the bottom is higher then by diagonal
     double w, pw = prev_w;
 
+    // horizontal skip penalties only depend on the column, the vertical ones are kept in ap
+    const double hgip = (scale_type_ == SCALE_GIP_GEP) ? gip / xdivisor : gip;
+    const double hgep = (scale_type_ == SCALE_NONE) ? gep : gep / xdivisor;
+
     if (logp_)
     {
         (*logp_) << "\n";
@@ -127,20 +131,20 @@ double ContAlign::align_y_loop (register ALIGN_FVECT* ap, unsigned char base, ch
         ap->w = pw = w;
 
         // h = max (w - gip, h) - gep;
-        nh = w - ((scale_type_ == SCALE_GIP_GEP) ? gip / xdivisor : gip);
+        nh = w - hgip;
         float_error_bound += epsilon (nh);
 
         if (nh > ap->h)
             ap->h = nh, dir |= ALIGN_HSKIP;
-        ap->h -= ((scale_type_ == SCALE_NONE) ? gep : gep / xdivisor);
+        ap->h -= hgep;
         float_error_bound += epsilon (ap->h);
 
         //v = max (w - gip, v) - gep;
-        nv = w - ((scale_type_ == SCALE_GIP_GEP) ? gip / ap->div : gip);
+        nv = w - ap->vgip;
         float_error_bound += epsilon (nv);
         if (nv > v)
             v = nv, dir |= ALIGN_VSKIP;
-        v -= ((scale_type_ == SCALE_NONE) ? gep : gep / ap->div); 
+        v -= ap->vgep;
         float_error_bound += epsilon (v);
 
         if (logp_)
@@ -308,6 +312,8 @@ double ContAlign::align (const char* xseq, int xlen, const char* yseq, int ylen)
         ap[y].h = low_score;
         ap[y].r = yseq [y];
         ap[y].div = yhomo [y+1];
+        ap[y].vgip = (scale_type_ == SCALE_GIP_GEP) ? gip / ap[y].div : gip;
+        ap[y].vgep = (scale_type_ == SCALE_NONE) ? gep : gep / ap[y].div;
     }
 
     //find best local alignment
@@ -408,6 +414,8 @@ double ContAlign::align_band (const char* xseq, int xlen, const char* yseq, int
         ap[i].h = low_score; // guaranteed to always prevent 'coming from the right'. Works for both tobeg and not.
         ap[i].r = yseq [i];
         ap[i].div = yhomo [i - yref + 1];
+        ap[i].vgip = (scale_type_ == SCALE_GIP_GEP) ? gip / ap[i].div : gip;
+        ap[i].vgep = (scale_type_ == SCALE_NONE) ? gep : gep / ap[i].div;
     }
 
     // find best local alignment, save backtrace pointers
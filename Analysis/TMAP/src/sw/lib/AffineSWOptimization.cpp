@@ -12,6 +12,7 @@
 //#include "Solution8.h"
 #include "Solution9.h"
 #include "Solution10.h"
+#include "Solution11.h"
 #include "AffineSWOptimization.h"
 
 using namespace std;
@@ -51,6 +52,9 @@ AffineSWOptimization::AffineSWOptimization(int type) {
       case 10:
         s = new Solution10();
         break;
+      case 11:
+        s = new Solution11();
+        break;
       default:
         fprintf(stderr, "Error: unknown type: %d\n", type);
         exit(1);
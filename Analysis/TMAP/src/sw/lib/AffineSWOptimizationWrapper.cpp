@@ -5,6 +5,7 @@
 #include <limits>
 #include <iostream>
 #include "AffineSWOptimization.h"
+#include "Solution11.h"
 #include "AffineSWOptimizationWrapper.h"
 
 using namespace std;
@@ -34,20 +35,25 @@ tmap_vsw_wrapper_process(tmap_vsw_wrapper_t *v,
   }
   */
 
-  // Top coder style
-  /*
-  int i;
-  for(i=0;i<tlen;i++) fputc("ACGTN"[target[i]], stderr);
-  fputc('\t', stderr);
-  for(i=0;i<qlen;i++) fputc("ACGTN"[query[i]], stderr);
-  fputc('\t', stderr);
-  fprintf(stderr, "%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n",
+#ifdef TMAP_VSW_CAPTURE
+  // Top coder style, with the results, to be replayed by "tmap vswbm -f"
+  int i, score;
+  string line;
+  char buf[128];
+  score = v->process(target, tlen, query, qlen, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
+  for(i=0;i<tlen;i++) line += "ACGTN"[target[i]];
+  line += '\t';
+  for(i=0;i<qlen;i++) line += "ACGTN"[query[i]];
+  sprintf(buf, "\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n",
           qsc, qec,
           mm, mi, o, e, dir,
-          -1, -1, -1, -1);
-  */
-
+          *opt, *te, *qe, *n_best);
+  line += buf;
+  fputs(line.c_str(), stderr); // NB: one call, so lines of different threads do not mix
+  return score;
+#else
   return v->process(target, tlen, query, qlen, qsc, qec, mm, mi, o, e, dir, opt, te, qe, n_best);
+#endif
 }
 
 void
@@ -68,3 +74,10 @@ tmap_vsw_wrapper_get_max_tlen(tmap_vsw_wrapper_t *v)
 {
   return v->getMaxTlen();
 }
+
+int
+tmap_vsw_wrapper_set_vec_bytes(int bytes)
+{
+  if(!Solution11::SetVecBytes(bytes)) return 0;
+  return Solution11::VecBytes();
+}
@@ -31,6 +31,13 @@ extern "C" {
     
     int
       tmap_vsw_wrapper_get_max_tlen(tmap_vsw_wrapper_t *v);
+
+    /*!
+      @param  bytes  the vector width in bytes for type 11 (16, 32 or 64), 0 for the widest supported
+      @return        the vector width in use, or 0 if the CPU does not support the given width
+     */
+    int
+      tmap_vsw_wrapper_set_vec_bytes(int bytes);
 #ifdef __cplusplus 
 }
 #endif
@@ -0,0 +1,169 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <cstring>
+#include <sstream>
+#include <stdint.h>
+#include <limits.h>
+#include "../../util/tmap_alloc.h"
+#include "../../util/tmap_definitions.h"
+#include "Solution11.h"
+#include "Solution11Kernel.h"
+
+// Striped vectorized Smith Waterman with runtime CPU dispatch
+
+using namespace std;
+
+// The 128-bit kernels only need SSE2 and are what every other CPU runs
+const solution11_kernels_t solution11_kernels16 = {
+  16, NULL, Solution11Align<int16_t,8>
+};
+
+static int SupportedVecBytes()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports ("avx512bw"))
+    return 64;
+  if (__builtin_cpu_supports ("avx2"))
+    return 32;
+#endif
+  return 16;
+}
+
+static const solution11_kernels_t *KernelsForBytes (int bytes)
+{
+#if defined(__x86_64__)
+  if (bytes >= 64)
+    return &solution11_kernels64;
+  if (bytes >= 32)
+    return &solution11_kernels32;
+#endif
+  return &solution11_kernels16;
+}
+
+// Picked on first use rather than by a static initializer, which could run after another
+// translation unit's static initialization has already aligned something
+static const solution11_kernels_t *&ActiveKernels()
+{
+  static const solution11_kernels_t *active_kernels = KernelsForBytes (SupportedVecBytes());
+  return active_kernels;
+}
+
+bool Solution11::SetVecBytes(int bytes)
+{
+  if (bytes <= 0)
+    bytes = SupportedVecBytes();
+  if (bytes > SupportedVecBytes() || (bytes != 16 && bytes != 32 && bytes != 64))
+    return false;
+  ActiveKernels() = KernelsForBytes (bytes);
+  return true;
+}
+
+int Solution11::VecBytes()
+{
+  return ActiveKernels()->bytes;
+}
+
+// Input: ASCII character
+// Output: 2-bit DNA value
+static uint8_t nt_char_to_int[256] = {
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,
+    4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4
+};
+
+Solution11::Solution11() {
+    fallback = NULL;
+    query = target = NULL;
+    q_max = t_max = 0;
+    mem = NULL;
+    mem_size = 0;
+    max_qlen = INT_MAX;
+    max_tlen = INT_MAX;
+}
+
+Solution11::~Solution11() {
+    delete fallback;
+    free(query);
+    free(target);
+    free(mem);
+}
+
+int Solution11::process(const string& b, const string& a, int qsc, int qec,
+                        int mm, int mi, int o, int e, int dir,
+                        int *_opt, int *_te, int *_qe, int *_n_best) {
+    int i;
+    int n = b.size(), m = a.size();
+    solution11_problem_t p;
+    solution11_result_t r;
+    size_t size;
+    void *aligned;
+
+    // The lanes are laid out differently than in Solution1, which decides which
+    // insertions may be directly followed by a deletion. That never matters as long as a
+    // mismatch is no worse than two gap extensions, and the lazy F loop needs a gap open
+    // penalty to see where F stops changing H.
+    if(-mi > -2 * e || 0 <= o || 0 == m || 0 == n) {
+        if(NULL == fallback) fallback = new Solution1();
+        return fallback->process(b, a, qsc, qec, mm, mi, o, e, dir, _opt, _te, _qe, _n_best);
+    }
+
+    // set query and target
+    if(q_max < m) {
+        q_max = m;
+        tmap_roundup32(q_max);
+        query = (uint8_t*)tmap_realloc(query, sizeof(uint8_t) * q_max, "query");
+    }
+    for(i=0;i<m;i++) query[i] = nt_char_to_int[(int)a[i]];
+    if(t_max < n) {
+        t_max = n;
+        tmap_roundup32(t_max);
+        target = (uint8_t*)tmap_realloc(target, sizeof(uint8_t) * t_max, "target");
+    }
+    for(i=0;i<n;i++) target[i] = nt_char_to_int[(int)b[i]];
+
+    // 16-bit lanes need the most stripes
+    const solution11_kernels_t *kernels = ActiveKernels();
+    int32_t lanes16 = kernels->bytes / 2;
+    size = (size_t)SOLUTION11_MEM_VECTORS * kernels->bytes * ((solution11_qlen_pad(m) + lanes16 - 1) / lanes16);
+    if(mem_size < size) {
+        mem = tmap_realloc(mem, size + 63, "mem"); // NB: aligned below
+        mem_size = size;
+    }
+
+    p.query = query;
+    p.qlen = m;
+    p.target = target;
+    p.tlen = n;
+    p.query_start_clip = qsc;
+    p.query_end_clip = qec;
+    p.score_match = mm;
+    p.pen_mm = -mi;
+    p.pen_gapo = -o;
+    p.pen_gape = -e;
+    p.dir = dir;
+
+    // try 8-bit lanes first
+    aligned = (void*)(((size_t)mem + 63) >> 6 << 6);
+    if(NULL == kernels->align8 || 0 != kernels->align8(&p, &r, aligned)) {
+        kernels->align16(&p, &r, aligned);
+    }
+
+    (*_opt) = r.opt;
+    (*_te) = r.te;
+    (*_qe) = r.qe;
+    (*_n_best) = r.n_best;
+    return r.opt;
+}
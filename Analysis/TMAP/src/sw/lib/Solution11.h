@@ -0,0 +1,40 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef SOLUTION11_H
+#define SOLUTION11_H
+
+#ifndef __cplusplus
+#error a C++ compiler is required
+#endif
+
+#include <cstring>
+#include <sstream>
+#include "Solution.h"
+#include "Solution1.h"
+
+using namespace std;
+
+// Striped vectorized Smith Waterman on 128, 256 or 512-bit vectors, picked at run time.
+// Scores are first computed in 8-bit lanes where possible, and again in 16-bit lanes if
+// they do not fit. Results are the same as those of Solution1, which it falls back to
+// when the penalties could make them depend on the vector width.
+class Solution11 : public Solution {
+public:
+  Solution11();
+  ~Solution11();
+
+  virtual int process(const string& b, const string& a, int qsc, int qec,
+                 int mm, int mi, int o, int e, int dir,
+                 int *opt, int *te, int *qe, int *n_best);
+
+  // Use vectors of 16, 32 or 64 bytes (0 for the widest the CPU supports), false if the
+  // CPU does not support them
+  static bool SetVecBytes(int bytes);
+  static int VecBytes();
+private:
+  Solution1 *fallback;
+  uint8_t *query, *target;
+  int32_t q_max, t_max;
+  void *mem;
+  size_t mem_size;
+};
+#endif // SOLUTION11_H
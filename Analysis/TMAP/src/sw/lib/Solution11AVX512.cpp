@@ -0,0 +1,9 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+
+// 512-bit Solution11 kernels. Compiled with -mavx512bw and only called on CPUs that support it.
+
+#include "Solution11Kernel.h"
+
+const solution11_kernels_t solution11_kernels64 = {
+  64, Solution11Align<int8_t,64>, Solution11Align<int16_t,32>
+};
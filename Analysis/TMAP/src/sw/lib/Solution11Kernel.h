@@ -0,0 +1,387 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef SOLUTION11KERNEL_H
+#define SOLUTION11KERNEL_H
+
+#ifndef __cplusplus
+#error a C++ compiler is required
+#endif
+
+// Width-generic striped kernels behind Solution11.
+// Only to be included by the translation units that instantiate them, each of them
+// compiled for the instruction set its width needs.
+
+#include <stdint.h>
+#include <string.h>
+#include <emmintrin.h>
+
+// One alignment as the kernels see it. The query and target are in 2-bit format
+// (4 is N) and the penalties are positive, as in vsw_opt_t.
+typedef struct {
+    const uint8_t *query;
+    int32_t qlen;
+    const uint8_t *target;
+    int32_t tlen;
+    int32_t query_start_clip;
+    int32_t query_end_clip;
+    int32_t score_match;
+    int32_t pen_mm;
+    int32_t pen_gapo;
+    int32_t pen_gape;
+    int32_t dir;
+} solution11_problem_t;
+
+typedef struct {
+    int32_t opt;
+    int32_t te;
+    int32_t qe;
+    int32_t n_best;
+} solution11_result_t;
+
+// Returns 0 on success and -1 if the scores do not fit the lanes, in which case the
+// alignment has to be repeated with wider lanes. mem has to hold
+// SOLUTION11_MEM_VECTORS stripes of the lane width.
+typedef int32_t (*solution11_align_t)(const solution11_problem_t *p, solution11_result_t *r, void *mem);
+
+// One set of kernels working on vectors of 'bytes' bytes. align8 uses 8-bit lanes and
+// may be NULL, align16 uses 16-bit lanes and always succeeds.
+typedef struct {
+    int32_t bytes;
+    solution11_align_t align8;
+    solution11_align_t align16;
+} solution11_kernels_t;
+
+extern const solution11_kernels_t solution11_kernels16;  // Solution11.cpp
+extern const solution11_kernels_t solution11_kernels32;  // Solution11AVX2.cpp
+extern const solution11_kernels_t solution11_kernels64;  // Solution11AVX512.cpp
+
+// query profile for the five bases, H(i-1,.), H(i,.), E, the leading insertions and F
+#define SOLUTION11_MEM_VECTORS 10
+
+// vsw16 pads the query to a multiple of this many positions, and the padding takes part
+// in the maximum of each row, so the kernels keep the same padding
+#define SOLUTION11_VSW16_PAD 8
+#define solution11_qlen_pad(_qlen) ((((_qlen) + SOLUTION11_VSW16_PAD - 1) / SOLUTION11_VSW16_PAD) * SOLUTION11_VSW16_PAD)
+
+// Anonymous, so that instantiations built for different instruction sets never get merged
+namespace {
+
+template<typename T, int W> struct Solution11Vec {
+  typedef T V __attribute__ ((vector_size (sizeof(T)*W)));
+};
+
+template<typename V, typename T>
+inline __attribute__ ((always_inline)) V Solution11Splat(T val)
+{
+  V v = {};
+  return v + val;
+}
+
+template<typename V>
+inline __attribute__ ((always_inline)) V Solution11Max(V a, V b)
+{
+  return a > b ? a : b;
+}
+
+// true if any lane of the comparison result is set
+template<typename V>
+inline __attribute__ ((always_inline)) bool Solution11Any(V m)
+{
+  uint64_t w[sizeof(V) / 8], x = 0;
+  memcpy(w, &m, sizeof(V));
+  for(unsigned l = 0; l < sizeof(V) / 8; l++) x |= w[l];
+  return 0 != x;
+}
+
+// shifts all lanes up by S, the lowest S lanes are taken from fill
+template<typename T, int W, int S, bool k128 = (16 == sizeof(T) * W)>
+struct Solution11Shift {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Up(V v, V fill) {
+      V m;
+      for(int k = 0; k < W; k++) m[k] = (k < S) ? W + k : k - S;
+      return __builtin_shuffle(v, fill, m);
+  }
+};
+
+// SSE2 has no general shuffle for these lanes, but a byte shift does
+template<typename T, int W, int S>
+struct Solution11Shift<T,W,S,true> {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Up(V v, V fill) {
+      V m;
+      for(int k = 0; k < W; k++) m[k] = (k < S) ? -1 : 0;
+      return (V)_mm_slli_si128((__m128i)v, S * sizeof(T)) | (fill & m);
+  }
+};
+
+// largest lane, by halving the vector down to 16 bytes and then shifting within it
+template<typename T, int W, bool kHalve = (16 < sizeof(T) * W)>
+struct Solution11Reduce {
+  typedef typename Solution11Vec<T,W>::V V;
+  typedef typename Solution11Vec<T,W/2>::V H;
+  static inline __attribute__ ((always_inline)) int32_t Max(V v) {
+      H lo, hi;
+      memcpy(&lo, &v, sizeof(H));
+      memcpy(&hi, (const char*)&v + sizeof(H), sizeof(H));
+      return Solution11Reduce<T,W/2>::Max(Solution11Max(lo, hi));
+  }
+};
+
+template<typename T, int W, int S>
+struct Solution11ReduceStep {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Max(V v) {
+      return Solution11ReduceStep<T,W,S/2>::Max(Solution11Max(v, Solution11Shift<T,W,S>::Up(v, v)));
+  }
+};
+
+template<typename T, int W>
+struct Solution11ReduceStep<T,W,0> {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Max(V v) {
+      return v;
+  }
+};
+
+template<typename T, int W>
+struct Solution11Reduce<T,W,false> {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) int32_t Max(V v) {
+      return Solution11ReduceStep<T,W,W/2>::Max(v)[W-1];
+  }
+};
+
+// Prefix maximum over the lanes where each lane further away costs another decay:
+// lane k becomes the largest of v[l] - (k-l)*decay for l <= k, never less than neg_inf.
+// All lanes have to be at least neg_inf, the subtractions are kept from wrapping around.
+template<typename T, int W, int S>
+struct Solution11Scan {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Max(V v, int32_t decay, int32_t neg_inf, V neg_inf_v) {
+      int32_t d = decay * S;
+      if(neg_inf + d <= (int32_t)((1 == sizeof(T)) ? INT8_MAX : INT16_MAX)) { // else lane k-S can no longer win
+          V s = Solution11Max(Solution11Shift<T,W,S>::Up(v, neg_inf_v), Solution11Splat<V>((T)(neg_inf + d)));
+          v = Solution11Max(v, s - Solution11Splat<V>((T)d));
+      }
+      return Solution11Scan<T,W,(2*S < W) ? 2*S : 0>::Max(v, decay, neg_inf, neg_inf_v);
+  }
+};
+
+template<typename T, int W>
+struct Solution11Scan<T,W,0> {
+  typedef typename Solution11Vec<T,W>::V V;
+  static inline __attribute__ ((always_inline)) V Max(V v, int32_t decay, int32_t neg_inf, V neg_inf_v) {
+      return v;
+  }
+};
+
+// same as vsw16_sse2_dir_cmp
+inline int32_t Solution11DirCmp(int32_t cur_score, int32_t cur_qe, int32_t cur_te,
+                                int32_t next_score, int32_t next_qe, int32_t next_te,
+                                int32_t dir)
+{
+  if(next_score < cur_score) return 0;
+  if(cur_score < next_score) return 1;
+  if(0 == dir) { // min qe, break ties by max te
+      if(next_qe < cur_qe) return 1;
+      if(next_qe == cur_qe && cur_te < next_te) return 1;
+  }
+  else { // max qe, break ties by max te
+      if(cur_qe < next_qe) return 1;
+      if(cur_qe == next_qe && cur_te < next_te) return 1;
+  }
+  return 0;
+}
+
+/* Striped affine gap alignment with the recurrences, clipping and result
+   selection of vsw16_sse2_forward, on W lanes of T.
+
+   Instead of Farrar's lazy F loop, which goes around the lanes up to W times whenever a
+   deletion is better than H for a long stretch of the query (always the case without
+   clipping at the start), the deletions are found in three steps: within each lane, across
+   the lanes on the last value of each lane, then added to every stripe in a second pass.
+
+   With 16-bit lanes the scores are normalized exactly as vsw16 does, so the bounds and the
+   overflow check are the same. 8-bit lanes hold the plain scores and are only used when the
+   start of the query is clipped, where no cell of interest can drop below the match/gap
+   penalties. They are not tried when a query of all matches could get close to the top of
+   the lane, and give up (-1) as soon as a row does.
+
+   Positions from qlen to the vsw16 padded length score like the vsw16 padding, positions
+   beyond that are extra lanes of the wider stripes. They only ever hold values derived from
+   the other positions of the same row through a penalty, so they never reach the maximum
+   of a row and are left out of the result. */
+template<typename T, int W, bool kStartClip>
+int32_t Solution11AlignStriped(const solution11_problem_t *p, solution11_result_t *r, void *mem)
+{
+  typedef typename Solution11Vec<T,W>::V V;
+  const bool k8Bit = (1 == sizeof(T));
+  const int32_t qlen = p->qlen, qlen_pad = solution11_qlen_pad(p->qlen);
+  const int32_t slen = (qlen_pad + W - 1) / W;
+  const int32_t gapoe = p->pen_gapo + p->pen_gape;
+  int32_t min_edit, zero, neg_inf, overflow_max, i, j, k;
+  int32_t best, n_best = 0;
+  int16_t query_end = -1, target_end = -1;
+
+  // same as vsw16_query_init
+  min_edit = ((gapoe < p->pen_mm) ? -p->pen_mm : -gapoe) - 1;
+  if(k8Bit) {
+      zero = 0;
+      neg_inf = -128 + gapoe;
+      overflow_max = 127 - 2 * p->score_match; // the next row could overflow
+      // do not start what would only be found to overflow after most of the rows
+      if(128 <= 2 * gapoe + 1 - min_edit || overflow_max < qlen * p->score_match) return -1;
+  }
+  else {
+      int32_t min_mm_score = qlen * -p->pen_mm;
+      int32_t min_gap_score = -p->pen_gapo + (-p->pen_gape * qlen);
+      int32_t zero_aln_score = (min_mm_score < min_gap_score) ? min_mm_score : min_gap_score;
+      int32_t min_aln_score = (zero_aln_score << 1) + min_edit;
+      zero = INT16_MIN - min_aln_score - zero_aln_score;
+      neg_inf = INT16_MIN - min_aln_score;
+      overflow_max = INT16_MAX - p->score_match - p->score_match;
+  }
+  best = k8Bit ? INT32_MIN : INT16_MIN;
+
+  V *profile = (V*)mem;
+  V *H0 = profile + 5 * slen;
+  V *H1 = H0 + slen;
+  V *E = H1 + slen;
+  V *G = E + slen;
+  V *F = G + slen;
+
+  const V zero_v = Solution11Splat<V>((T)zero);
+  const V neg_inf_v = Solution11Splat<V>((T)neg_inf);
+  const V gapoe_v = Solution11Splat<V>((T)gapoe);
+  const V gape_v = Solution11Splat<V>((T)p->pen_gape);
+  const V overflow_max_v = Solution11Splat<V>((T)overflow_max);
+
+  // the query profile, H(-1,.), E(0,.) and the leading insertions
+  for(j = 0; j < slen; j++) {
+      T *h = (T*)(H0 + j), *e = (T*)(E + j), *g = (T*)(G + j);
+      for(k = 0; k < W; k++) {
+          int32_t pos = k * slen + j;
+          int32_t a, v;
+          for(a = 0; a < 5; a++) {
+              ((T*)(profile + a * slen + j))[k] = (qlen <= pos) ? min_edit : ((a == p->query[pos]) ? p->score_match : -p->pen_mm);
+          }
+          h[k] = kStartClip ? zero : neg_inf;
+          e[k] = (kStartClip && pos < qlen_pad) ? zero : neg_inf;
+          if(!kStartClip) {
+              v = -p->pen_gapo - p->pen_gape * pos + zero; // diagonal into pos from a leading insertion
+              g[k] = (v < INT16_MIN) ? INT16_MIN : v;
+          }
+      }
+  }
+
+  for(i = 0; i < p->tlen; i++) { // for each base in the target
+      const V *S = profile + ((p->target[i] < 4) ? p->target[i] : 4) * slen;
+      V e, h, f, vmax;
+
+      // H without the deletions, and the deletions that start in the same lane
+      h = Solution11Shift<T,W,1>::Up(H0[slen-1], zero_v); // H(i-1,-1) is zero
+      f = neg_inf_v;
+      for(j = 0; j < slen; j++) {
+          h = kStartClip ? Solution11Max(h, zero_v) : Solution11Max(h, G[j]);
+          h = h + S[j]; // H(i-1,j-1)+S(i,j)
+          h = Solution11Max(h, E[j]);
+          h = Solution11Max(h, neg_inf_v);
+          F[j] = f;
+          f = Solution11Max(f - gape_v, h - gapoe_v); // F(i,j+1)
+          f = Solution11Max(f, neg_inf_v);
+          e = H0[j];
+          H1[j] = h;
+          h = e;
+      }
+
+      // deletions carried over from the lanes below, F only depends on H without F
+      f = Solution11Shift<T,W,1>::Up(f, neg_inf_v);
+      f = Solution11Scan<T,W,1>::Max(f, p->pen_gape * slen, neg_inf, neg_inf_v);
+
+      // H and E with all the deletions
+      vmax = neg_inf_v;
+      for(j = 0; j < slen; j++) {
+          h = Solution11Max(H1[j], Solution11Max(F[j], f));
+          vmax = Solution11Max(vmax, h);
+          H1[j] = h;
+          h = h - gapoe_v;
+          e = Solution11Max(E[j] - gape_v, h); // E(i+1,j)
+          E[j] = Solution11Max(e, neg_inf_v);
+          f = Solution11Max(f - gape_v, neg_inf_v);
+      }
+
+      if(Solution11Any(vmax > overflow_max_v)) {
+          if(k8Bit) return -1;
+          // vsw16 gives up with what it found so far
+          r->opt = INT16_MIN;
+          r->te = target_end;
+          r->qe = query_end;
+          r->n_best = n_best;
+          return 0;
+      }
+      if(Solution11Any(vmax >= Solution11Splat<V>((T)((best < zero) ? zero : best)))) { // potential best score
+          const T *t = (const T*)H1;
+          if(0 == p->query_end_clip) { // check the last
+              int32_t v = t[((qlen-1) % slen) * W + (qlen-1) / slen];
+              if(best == v) n_best++;
+              else if(best < v) n_best = 1;
+              if(1 == Solution11DirCmp(best, query_end, target_end, v, qlen-1, i, p->dir)) {
+                  query_end = qlen-1;
+                  target_end = i;
+                  best = v;
+              }
+          }
+          else { // check all: the cells with the maximum of the row decide, as in vsw16's scan
+              int32_t imax = Solution11Reduce<T,W>::Max(vmax), n = 0, qe_min = INT32_MAX, qe_max = -1;
+              const V imax_v = Solution11Splat<V>((T)imax);
+              for(j = 0; j < slen; j++) {
+                  if(!Solution11Any(H1[j] == imax_v)) continue;
+                  for(k = 0; k < W; k++) {
+                      int32_t pos = k * slen + j;
+                      if(qlen_pad <= pos) break;
+                      if(imax != t[j * W + k]) continue;
+                      n++;
+                      if(pos < qe_min) qe_min = pos;
+                      if(qe_max < pos) qe_max = pos;
+                  }
+              }
+              if(0 < n) {
+                  int32_t pos = (0 == p->dir) ? qe_min : qe_max;
+                  if(best < imax) n_best = n;
+                  else n_best += n;
+                  if(1 == Solution11DirCmp(best, query_end, target_end, imax, pos, i, p->dir)) {
+                      best = imax;
+                      query_end = pos;
+                      target_end = i;
+                  }
+              }
+          }
+      }
+      V *tmp = H1; H1 = H0; H0 = tmp; // swap H0 and H1
+  }
+
+  if((k8Bit ? INT32_MIN : INT16_MIN) == best) {
+      r->opt = INT16_MIN;
+      r->te = r->qe = -1;
+      r->n_best = n_best;
+  }
+  else {
+      r->opt = best - zero;
+      r->te = target_end;
+      r->qe = query_end;
+      r->n_best = n_best;
+  }
+  return 0;
+}
+
+template<typename T, int W>
+int32_t Solution11Align(const solution11_problem_t *p, solution11_result_t *r, void *mem)
+{
+  if(1 == p->query_start_clip) return Solution11AlignStriped<T,W,true>(p, r, mem);
+  if(1 == sizeof(T)) return -1; // the leading insertions are not bounded
+  return Solution11AlignStriped<T,W,false>(p, r, mem);
+}
+
+} // namespace
+
+#endif // SOLUTION11KERNEL_H
@@ -1,7 +1,10 @@
 /* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <math.h>
+#include <time.h>
 #include <config.h>
 #include "../util/tmap_alloc.h"
 #include "../util/tmap_error.h"
@@ -100,6 +103,102 @@ tmap_vsw_bm_core(int32_t seq_len, int32_t tlen, int32_t n_iter,
   tmap_rand_destroy(rand);
 }
 
+// one alignment window, as printed by a build with -DTMAP_VSW_CAPTURE
+typedef struct {
+    uint8_t *target, *query;
+    int32_t tlen, qlen;
+    int32_t qsc, qec, mm, mi, o, e, dir;
+    int32_t opt, te, qe, n_best;
+} tmap_vsw_bm_window_t;
+
+static int32_t
+tmap_vsw_bm_parse(char *line, tmap_vsw_bm_window_t *w)
+{
+  char *field[13], *save = NULL;
+  int32_t i, j, n = 0;
+
+  while(n < 13 && NULL != (field[n] = strtok_r((0 == n) ? line : NULL, "\t\n", &save))) {
+      n++;
+  }
+  if(n < 13) return 0; // not a window, e.g. other output on stderr
+  for(i=0;i<2;i++) {
+      int32_t len = strlen(field[i]);
+      uint8_t *s = tmap_malloc(sizeof(uint8_t) * (len+1), "s");
+      for(j=0;j<len;j++) {
+          s[j] = tmap_nt_char_to_int[(int)field[i][j]];
+      }
+      if(0 == i) { w->target = s; w->tlen = len; }
+      else { w->query = s; w->qlen = len; }
+  }
+  w->qsc = atoi(field[2]); w->qec = atoi(field[3]);
+  w->mm = atoi(field[4]); w->mi = atoi(field[5]);
+  w->o = atoi(field[6]); w->e = atoi(field[7]);
+  w->dir = atoi(field[8]);
+  w->opt = atoi(field[9]); w->te = atoi(field[10]);
+  w->qe = atoi(field[11]); w->n_best = atoi(field[12]);
+  return 1;
+}
+
+void
+tmap_vsw_bm_replay(const char *fn, int32_t n_sub_iter, int32_t vsw_type, int32_t cmp_type)
+{
+  FILE *fp;
+  char *line = NULL;
+  size_t line_mem = 0;
+  tmap_vsw_bm_window_t *w = NULL;
+  int32_t i, j, n = 0, m = 0, n_diff = 0;
+  int32_t opt, te, qe, n_best;
+  tmap_vsw_wrapper_t *vsw, *vsw_cmp = NULL;
+  clock_t start_clock, total_clock = 0;
+
+  fp = fopen(fn, "r");
+  if(NULL == fp) tmap_error(fn, Exit, OpenFileError);
+  while(0 <= getline(&line, &line_mem, fp)) {
+      if(m <= n) {
+          m = (0 == m) ? 1024 : (m << 1);
+          w = tmap_realloc(w, sizeof(tmap_vsw_bm_window_t) * m, "w");
+      }
+      n += tmap_vsw_bm_parse(line, &w[n]);
+  }
+  fclose(fp);
+  free(line);
+  tmap_progress_print2("read %d windows", n);
+
+  vsw = tmap_vsw_wrapper_init(vsw_type);
+  if(0 < cmp_type) vsw_cmp = tmap_vsw_wrapper_init(cmp_type);
+  for(i=0;i<n;i++) {
+      start_clock = clock();
+      for(j=0;j<n_sub_iter;j++) {
+          tmap_vsw_wrapper_process(vsw, w[i].target, w[i].tlen, w[i].query, w[i].qlen,
+                                   w[i].mm, w[i].mi, w[i].o, w[i].e, w[i].dir, w[i].qsc, w[i].qec,
+                                   &opt, &te, &qe, &n_best);
+      }
+      total_clock += clock() - start_clock;
+      if(NULL != vsw_cmp) { // compare with another algorithm instead of the captured results
+          tmap_vsw_wrapper_process(vsw_cmp, w[i].target, w[i].tlen, w[i].query, w[i].qlen,
+                                   w[i].mm, w[i].mi, w[i].o, w[i].e, w[i].dir, w[i].qsc, w[i].qec,
+                                   &w[i].opt, &w[i].te, &w[i].qe, &w[i].n_best);
+      }
+      if(opt != w[i].opt || te != w[i].te || qe != w[i].qe || n_best != w[i].n_best) {
+          if(0 == n_diff) {
+              tmap_progress_print2("window %d differs: opt=[%d,%d] te=[%d,%d] qe=[%d,%d] n_best=[%d,%d]", 
+                                   i + 1, w[i].opt, opt, w[i].te, te, w[i].qe, qe, w[i].n_best, n_best);
+          }
+          n_diff++;
+      }
+      free(w[i].target);
+      free(w[i].query);
+  }
+  tmap_progress_print2("%d windows differ", n_diff);
+  tmap_progress_print2("alignment cpu time: %.2f seconds (%.0f alignments per second)", 
+                       (double)total_clock / CLOCKS_PER_SEC,
+                       (0 < total_clock) ? (double)n * n_sub_iter * CLOCKS_PER_SEC / total_clock : 0.0);
+
+  tmap_vsw_wrapper_destroy(vsw);
+  if(NULL != vsw_cmp) tmap_vsw_wrapper_destroy(vsw_cmp);
+  free(w);
+}
+
 static int
 usage(int32_t seq_len, int32_t tlen, int32_t n_iter, 
       int32_t n_sub_iter, int32_t vsw_type)
@@ -114,6 +213,9 @@ usage(int32_t seq_len, int32_t tlen, int32_t n_iter,
   tmap_file_fprintf(tmap_file_stderr, "         -N INT      the number of re-evaluations of the same query/target combination [%d]\n", n_sub_iter);
   tmap_file_fprintf(tmap_file_stderr, "         -H INT      smith waterman algorithm [%d]\n", vsw_type);
   tmap_file_fprintf(tmap_file_stderr, "Options (optional):\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -f FILE     replay the windows captured in this file (a build with -DTMAP_VSW_CAPTURE prints them to stderr)\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -C INT      with -f, compare with this smith waterman algorithm instead of the captured results\n");
+  tmap_file_fprintf(tmap_file_stderr, "         -W INT      the vector width in bytes for -H 11 (16, 32 or 64), 0 for the widest supported\n");
   tmap_file_fprintf(tmap_file_stderr, "         -h          print this message\n");
   tmap_file_fprintf(tmap_file_stderr, "\n");
   return 1;
@@ -128,9 +230,12 @@ tmap_vswbm_main(int argc, char *argv[])
   int32_t n_iter = 1000;
   int32_t n_sub_iter = 1;
   int32_t vsw_type = 0;
+  int32_t cmp_type = 0;
+  int32_t vec_bytes = 0;
+  char *fn = NULL;
   int c;
 
-  while((c = getopt(argc, argv, "q:t:n:N:H:h")) >= 0) {
+  while((c = getopt(argc, argv, "q:t:n:N:H:f:C:W:h")) >= 0) {
       switch(c) {
         case 'q':
           seq_len = atoi(optarg); break;
@@ -142,6 +247,12 @@ tmap_vswbm_main(int argc, char *argv[])
           n_sub_iter = atoi(optarg); break;
         case 'H':
           vsw_type = atoi(optarg); break;
+        case 'f':
+          free(fn); fn = tmap_strdup(optarg); break;
+        case 'C':
+          cmp_type = atoi(optarg); break;
+        case 'W':
+          vec_bytes = atoi(optarg); break;
         case 'h':
         default:
           return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
@@ -151,10 +262,20 @@ tmap_vswbm_main(int argc, char *argv[])
       return usage(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
   }
 
+  if(0 == tmap_vsw_wrapper_set_vec_bytes(vec_bytes)) {
+      tmap_error("the vector width is not supported (-W)", Exit, CommandLineArgument);
+  }
+
   tmap_progress_set_verbosity(1);
   tmap_progress_print2("starting benchmark");
 
-  tmap_vsw_bm_core(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+  if(NULL != fn) {
+      tmap_vsw_bm_replay(fn, n_sub_iter, vsw_type, cmp_type);
+      free(fn);
+  }
+  else {
+      tmap_vsw_bm_core(seq_len, tlen, n_iter, n_sub_iter, vsw_type);
+  }
   
   tmap_progress_print2("ending benchmark");
 
@@ -188,6 +188,8 @@ int main(int argc, const char *argv[])
     mapOptType["ignore-checksum-errors"] = OT_BOOL;
     mapOptType["ignore-checksum-errors-1frame"] = OT_BOOL;
     mapOptType["img-gain-correct"] = OT_BOOL;
+    mapOptType["img-load-threads"] = OT_INT;
+    mapOptType["img-prefetch-depth"] = OT_INT;
     mapOptType["incorporation-type"] = OT_INT;
     mapOptType["kmult-hi-limit"] = OT_DOUBLE;
     mapOptType["kmult-low-limit"] = OT_DOUBLE;
@@ -250,6 +252,7 @@ int main(int argc, const char *argv[])
     mapOptType["vectorize"] = OT_BOOL;
     mapOptType["well-stat-file"] = OT_STRING;
     mapOptType["wells-compression"] = OT_INT;
+    mapOptType["wells-compression-threads"] = OT_INT;
     mapOptType["wells-convert-high"] = OT_DOUBLE;
     mapOptType["wells-convert-low"] = OT_DOUBLE;
     mapOptType["wells-convert-with-copies"] = OT_BOOL;
@@ -281,6 +281,10 @@ int main(int argc, const char *argv[])
     jsonBase["SignalProcessingBlockControl"]["wells-compression"]["value"] = 0;
     jsonBase["SignalProcessingBlockControl"]["wells-compression"]["min"] = 0;
     jsonBase["SignalProcessingBlockControl"]["wells-compression"]["max"] = 10;
+    jsonBase["SignalProcessingBlockControl"]["wells-compression-threads"]["type"] = OT_INT;
+    jsonBase["SignalProcessingBlockControl"]["wells-compression-threads"]["value"] = 0;
+    jsonBase["SignalProcessingBlockControl"]["wells-compression-threads"]["min"] = 0;
+    jsonBase["SignalProcessingBlockControl"]["wells-compression-threads"]["max"] = "";
     jsonBase["SignalProcessingBlockControl"]["wells-save-freq"]["type"] = OT_INT;
     jsonBase["SignalProcessingBlockControl"]["wells-save-freq"]["value"] = -1;
     jsonBase["SignalProcessingBlockControl"]["wells-save-freq"]["min"] = "";
@@ -583,6 +587,14 @@ int main(int argc, const char *argv[])
     jsonBase["ImageControlOpts"]["no-threaded-file-access"]["value"] = false;
     jsonBase["ImageControlOpts"]["no-threaded-file-access"]["min"] = "";
     jsonBase["ImageControlOpts"]["no-threaded-file-access"]["max"] = "";
+    jsonBase["ImageControlOpts"]["img-prefetch-depth"]["type"] = OT_INT;
+    jsonBase["ImageControlOpts"]["img-prefetch-depth"]["value"] = 4;
+    jsonBase["ImageControlOpts"]["img-prefetch-depth"]["min"] = 0;
+    jsonBase["ImageControlOpts"]["img-prefetch-depth"]["max"] = "";
+    jsonBase["ImageControlOpts"]["img-load-threads"]["type"] = OT_INT;
+    jsonBase["ImageControlOpts"]["img-load-threads"]["value"] = 0;
+    jsonBase["ImageControlOpts"]["img-load-threads"]["min"] = 0;
+    jsonBase["ImageControlOpts"]["img-load-threads"]["max"] = "";
     jsonBase["ImageControlOpts"]["frames"]["type"] = OT_INT;
     jsonBase["ImageControlOpts"]["frames"]["value"] = -1;
     jsonBase["ImageControlOpts"]["frames"]["min"] = "";
@@ -125,6 +125,9 @@ public:
   
   /** Access to underlying memory for I/O */
   T * GetMemPtr() { return &mData[0]; }
+
+  /** Exchange the memory of the current range with buf, e.g. to hand a filled range to a writer. */
+  void SwapBuffer(std::vector<T> &buf) { mData.swap(buf); }
   
 private:
   std::vector<T> mData; ///< Actual values stored in z,x,y order increasing
@@ -0,0 +1,260 @@
+/* Copyright (C) 2016 Ion Torrent Systems, Inc. All Rights Reserved */
+
+#include "IntervalIndex.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+struct IntervalIndexHeader {
+  char        magic[8];
+  uint32_t    version;
+  uint32_t    node_size;
+  uint64_t    num_nodes;
+};
+
+static bool NodeOrder(const IntervalIndexNode& a, const IntervalIndexNode& b)
+{
+  if (a.contig != b.contig)
+    return a.contig < b.contig;
+  if (a.begin != b.begin)
+    return a.begin < b.begin;
+  return a.id < b.id;
+}
+
+// Fill in max_end of the implicit tree over n sorted nodes.
+// Nodes past the end of the array do not exist, their subtrees take the max_end of the
+// last node that does.
+static void IndexTree(IntervalIndexNode *node, int64_t n)
+{
+  int64_t last_i = 0;
+  int32_t last = 0;
+  for (int64_t i = 0; i < n; i += 2) {
+    last_i = i;
+    last = node[i].max_end = node[i].end;
+  }
+  for (int level = 1; ((int64_t)1 << level) <= n; ++level) {
+    int64_t x = 1LL << (level-1);
+    for (int64_t i = (x << 1) - 1; i < n; i += x << 2) {
+      int32_t left_end = node[i-x].max_end;
+      int32_t right_end = i + x < n ? node[i+x].max_end : last;
+      node[i].max_end = max(node[i].end, max(left_end, right_end));
+    }
+    last_i = (last_i >> level) & 1 ? last_i - x : last_i + x;
+    if (last_i < n and node[last_i].max_end > last)
+      last = node[last_i].max_end;
+  }
+}
+
+
+IntervalIndex::IntervalIndex()
+{
+  nodes_ = NULL;
+  num_nodes_ = 0;
+}
+
+void IntervalIndex::Clear()
+{
+  owned_nodes_.clear();
+  contigs_.clear();
+  nodes_ = NULL;
+  num_nodes_ = 0;
+}
+
+void IntervalIndex::Add(int contig, int begin, int end, int id)
+{
+  IntervalIndexNode node;
+  node.contig = contig;
+  node.begin = begin;
+  node.end = end;
+  node.max_end = end;
+  node.id = id;
+  owned_nodes_.push_back(node);
+}
+
+void IntervalIndex::Build()
+{
+  sort(owned_nodes_.begin(), owned_nodes_.end(), NodeOrder);
+  nodes_ = owned_nodes_.empty() ? NULL : &owned_nodes_[0];
+  num_nodes_ = owned_nodes_.size();
+  IndexContigs();
+  for (size_t contig = 0; contig < contigs_.size(); ++contig)
+    if (contigs_[contig].count)
+      IndexTree(&owned_nodes_[contigs_[contig].offset], contigs_[contig].count);
+}
+
+void IntervalIndex::Attach(const IntervalIndexNode *nodes, size_t num_nodes)
+{
+  owned_nodes_.clear();
+  nodes_ = num_nodes ? nodes : NULL;
+  num_nodes_ = num_nodes;
+  IndexContigs();
+}
+
+void IntervalIndex::IndexContigs()
+{
+  contigs_.clear();
+  if (num_nodes_)
+    contigs_.resize(max(nodes_[num_nodes_-1].contig + 1, 0));
+  for (size_t i = 0; i < contigs_.size(); ++i) {
+    contigs_[i].offset = 0;
+    contigs_[i].count = 0;
+    contigs_[i].root_level = 0;
+  }
+  for (size_t i = 0; i < num_nodes_; ) {
+    size_t j = i + 1;
+    while (j < num_nodes_ and nodes_[j].contig == nodes_[i].contig)
+      ++j;
+    if (nodes_[i].contig >= 0) {
+      ContigRange& range = contigs_[nodes_[i].contig];
+      range.offset = i;
+      range.count = j - i;
+      while ((2ULL << range.root_level) <= range.count)
+        ++range.root_level;
+    }
+    i = j;
+  }
+}
+
+// -------------------------------------------------------------------------------------
+
+bool IntervalIndex::Save(const string& index_filename) const
+{
+  FILE *fp = fopen(index_filename.c_str(), "wb");
+  if (!fp)
+    return false;
+  IntervalIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INTERVAL_INDEX_MAGIC, sizeof(header.magic));
+  header.version = INTERVAL_INDEX_VERSION;
+  header.node_size = sizeof(IntervalIndexNode);
+  header.num_nodes = num_nodes_;
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  if (ok and num_nodes_)
+    ok = fwrite(nodes_, sizeof(IntervalIndexNode), num_nodes_, fp) == num_nodes_;
+  if (fclose(fp) != 0)
+    ok = false;
+  return ok;
+}
+
+bool IntervalIndex::Load(const string& index_filename)
+{
+  Clear();
+  FILE *fp = fopen(index_filename.c_str(), "rb");
+  if (!fp)
+    return false;
+  IntervalIndexHeader header;
+  bool ok = fread(&header, sizeof(header), 1, fp) == 1
+      and memcmp(header.magic, INTERVAL_INDEX_MAGIC, sizeof(header.magic)) == 0
+      and header.version == INTERVAL_INDEX_VERSION
+      and header.node_size == sizeof(IntervalIndexNode);
+  if (ok) {
+    owned_nodes_.resize(header.num_nodes);
+    if (header.num_nodes)
+      ok = fread(&owned_nodes_[0], sizeof(IntervalIndexNode), header.num_nodes, fp) == header.num_nodes;
+  }
+  fclose(fp);
+  if (!ok) {
+    Clear();
+    return false;
+  }
+  nodes_ = owned_nodes_.empty() ? NULL : &owned_nodes_[0];
+  num_nodes_ = owned_nodes_.size();
+  IndexContigs();
+  return true;
+}
+
+// -------------------------------------------------------------------------------------
+
+const IntervalIndexNode *IntervalIndex::ContigNodes(int contig, size_t& count) const
+{
+  count = 0;
+  if (contig < 0 or contig >= (int)contigs_.size() or contigs_[contig].count == 0)
+    return NULL;
+  count = contigs_[contig].count;
+  return nodes_ + contigs_[contig].offset;
+}
+
+// Top down walk of the implicit tree that visits overlapping nodes left to right.
+// Small subtrees are scanned linearly, that is cheaper than descending into them.
+template<bool kFirstOnly>
+int IntervalIndex::Search(int contig, int begin, int end, vector<int> *ids) const
+{
+  size_t num = 0;
+  const IntervalIndexNode *node = ContigNodes(contig, num);
+  if (!node)
+    return kFirstOnly ? -1 : 0;
+  int64_t n = num;
+  int found = 0;
+
+  struct { int64_t x; int level; bool left_done; } stack[64];
+  int top = 0;
+  int root_level = contigs_[contig].root_level;
+  stack[top].x = ((int64_t)1 << root_level) - 1;
+  stack[top].level = root_level;
+  stack[top++].left_done = false;
+
+  while (top) {
+    int64_t x = stack[--top].x;
+    int level = stack[top].level;
+    bool left_done = stack[top].left_done;
+
+    if (level <= 3) {
+      int64_t i0 = x >> level << level;
+      int64_t i1 = min(i0 + ((int64_t)1 << (level+1)) - 1, n);
+      for (int64_t i = i0; i < i1 and node[i].begin < end; ++i) {
+        if (begin < node[i].end) {
+          if (kFirstOnly)
+            return node[i].id;
+          ids->push_back(node[i].id);
+          ++found;
+        }
+      }
+    } else if (not left_done) {
+      // come back to x once its left subtree is done
+      int64_t y = x - ((int64_t)1 << (level-1));
+      stack[top].x = x;
+      stack[top].level = level;
+      stack[top++].left_done = true;
+      if (y >= n or node[y].max_end > begin) {
+        stack[top].x = y;
+        stack[top].level = level - 1;
+        stack[top++].left_done = false;
+      }
+    } else if (x < n and node[x].begin < end) {
+      if (begin < node[x].end) {
+        if (kFirstOnly)
+          return node[x].id;
+        ids->push_back(node[x].id);
+        ++found;
+      }
+      stack[top].x = x + ((int64_t)1 << (level-1));
+      stack[top].level = level - 1;
+      stack[top++].left_done = false;
+    }
+  }
+  return kFirstOnly ? -1 : found;
+}
+
+int IntervalIndex::FirstOverlap(int contig, int begin, int end) const
+{
+  return Search<true>(contig, begin, end, NULL);
+}
+
+int IntervalIndex::Overlaps(int contig, int begin, int end, vector<int>& ids) const
+{
+  return Search<false>(contig, begin, end, &ids);
+}
+
+void IntervalIndex::Overlaps(const vector<IntervalIndexQuery>& queries, vector<int>& ids, vector<size_t>& offsets) const
+{
+  ids.clear();
+  offsets.resize(queries.size() + 1);
+  for (size_t q = 0; q < queries.size(); ++q) {
+    offsets[q] = ids.size();
+    Search<false>(queries[q].contig, queries[q].begin, queries[q].end, &ids);
+  }
+  offsets[queries.size()] = ids.size();
+}
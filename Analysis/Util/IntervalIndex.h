@@ -0,0 +1,89 @@
+/* Copyright (C) 2016 Ion Torrent Systems, Inc. All Rights Reserved */
+
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// An immutable index of 0-based, half open intervals on numbered contigs, shared by
+// tvc's TargetsManager, bbctools and seqCoverage.
+//
+// All intervals live in one flat array sorted by (contig, begin, id). Within a contig
+// the array is an implicit balanced binary tree: the node at index i sits at the level
+// given by the number of trailing 1 bits of i, its children are i -/+ 2^(level-1), and
+// every node carries the largest end of its subtree. There are no pointers, so the
+// array can be written to disk as it is and used straight out of a mapped file.
+// Overlapping intervals always come back in array order.
+
+#define INTERVAL_INDEX_MAGIC    "IVLINDEX"
+#define INTERVAL_INDEX_VERSION  1
+
+struct IntervalIndexNode {
+  int32_t     contig;
+  int32_t     begin;
+  int32_t     end;
+  int32_t     max_end;        // largest end in the subtree of this node
+  int32_t     id;             // caller's handle, returned by the queries
+};
+
+struct IntervalIndexQuery {
+  int32_t     contig;
+  int32_t     begin;
+  int32_t     end;
+};
+
+class IntervalIndex {
+public:
+  IntervalIndex();
+
+  void Clear();
+
+  // Collect the intervals, then Build() once before querying
+  void Add(int contig, int begin, int end, int id);
+  void Build();
+
+  // Index nodes written by an earlier Build(), e.g. a section of a mapped file.
+  // Nothing is copied, the nodes have to outlive this index.
+  void Attach(const IntervalIndexNode *nodes, size_t num_nodes);
+
+  // Binary copy of the built index, false if the file cannot be written or is not an index
+  bool Save(const std::string& index_filename) const;
+  bool Load(const std::string& index_filename);
+
+  // Id of the first interval in array order overlapping [begin,end), or -1 if there is none
+  int  FirstOverlap(int contig, int begin, int end) const;
+
+  // Append the ids of all intervals overlapping [begin,end) in array order, returns their number
+  int  Overlaps(int contig, int begin, int end, std::vector<int>& ids) const;
+
+  // Batched version for many queries: the ids of queries[q] are ids[offsets[q]] to ids[offsets[q+1]-1]
+  void Overlaps(const std::vector<IntervalIndexQuery>& queries, std::vector<int>& ids, std::vector<size_t>& offsets) const;
+
+  // Sorted nodes of one contig, NULL if it has none
+  const IntervalIndexNode *ContigNodes(int contig, size_t& count) const;
+
+  const IntervalIndexNode *nodes() const { return nodes_; }
+  size_t num_nodes() const { return num_nodes_; }
+  int    num_contigs() const { return (int)contigs_.size(); }
+
+private:
+  struct ContigRange {
+    size_t    offset;
+    size_t    count;
+    int       root_level;
+  };
+
+  void IndexContigs();
+  template<bool kFirstOnly>
+  int  Search(int contig, int begin, int end, std::vector<int> *ids) const;
+
+  std::vector<IntervalIndexNode>  owned_nodes_;
+  const IntervalIndexNode *       nodes_;
+  size_t                          num_nodes_;
+  std::vector<ContigRange>        contigs_;
+};
+
+#endif // INTERVALINDEX_H
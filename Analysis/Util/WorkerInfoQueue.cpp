@@ -2,70 +2,209 @@
 
 #include "WorkerInfoQueue.h"
 
+#include <sched.h>
+#include <map>
+#include <set>
+#include "json/json.h"
+
+namespace {
+
+// number of retries before a thread that cannot make progress goes to sleep
+const int kSpinTries = 64;
+
+// registry of live queues and of the folded metrics of deleted ones
+pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+std::set<WorkerInfoQueue*>& LiveQueues()
+{
+  static std::set<WorkerInfoQueue*> live_queues;
+  return live_queues;
+}
+
+std::map<std::string, WorkerInfoQueueMetrics>& RetiredMetrics()
+{
+  static std::map<std::string, WorkerInfoQueueMetrics> retired_metrics;
+  return retired_metrics;
+}
+
+long NanoSecondsSince(const struct timespec &start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec);
+}
+
+}
+
+void WorkerInfoQueueMetrics::Add(const WorkerInfoQueueMetrics &other)
+{
+  instances        += other.instances;
+  depth             = std::max(depth, other.depth);
+  items            += other.items;
+  enqueue_waits    += other.enqueue_waits;
+  enqueue_wait_sec += other.enqueue_wait_sec;
+  dequeue_waits    += other.dequeue_waits;
+  dequeue_wait_sec += other.dequeue_wait_sec;
+  in_flight        += other.in_flight;
+  max_in_flight     = std::max(max_in_flight, other.max_in_flight);
+}
+
+
 // create a queue w/ that can hold the specified number of items
-WorkerInfoQueue::WorkerInfoQueue(int _depth)
+WorkerInfoQueue::WorkerInfoQueue(int _depth, const char *_name)
+  : name(_name)
 {
-  depth = _depth;
-  rdndx = 0;
-  wrndx = 0;
-  num = 0;
-  not_done_cnt = 0;
-  qlist = new WorkerInfoQueueItem[depth];
-  
+  depth = std::max(_depth, 1);
+  qlist = new Cell[depth];
+  for (int i = 0; i < depth; i++)
+    qlist[i].sequence.store(i, std::memory_order_relaxed);
+  wrndx.store(0);
+  rdndx.store(0);
+  not_done_cnt.store(0);
+  max_in_flight.store(0);
+  writers_waiting.store(0);
+  readers_waiting.store(0);
+  done_waiting.store(0);
+  enqueue_waits.store(0);
+  dequeue_waits.store(0);
+  enqueue_wait_nsec.store(0);
+  dequeue_wait_nsec.store(0);
+
   pthread_mutex_init(&lock, NULL);
   pthread_cond_init(&rdcond,NULL);
   pthread_cond_init(&wrcond,NULL);
   pthread_cond_init(&donecond,NULL);
 
+  pthread_mutex_lock(&metrics_lock);
+  LiveQueues().insert(this);
+  pthread_mutex_unlock(&metrics_lock);
+
   std::cout << "Analysis pipeline: Worker Info Queue with depth: " << _depth << " created." << std::endl;
 }
 
+// Claim the cell at the write index if its previous item has been consumed.
+// A cell holding sequence == index is free, sequence == index+1 holds an item.
+bool WorkerInfoQueue::TryPut(const WorkerInfoQueueItem &new_item)
+{
+  unsigned long pos = wrndx.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &qlist[pos % depth];
+    long dif = (long)cell->sequence.load(std::memory_order_acquire) - (long)pos;
+    if (dif == 0) {
+      if (wrndx.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return false;   // full
+    else
+      pos = wrndx.load(std::memory_order_relaxed);
+  }
+  cell->item = new_item;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool WorkerInfoQueue::TryGet(WorkerInfoQueueItem &item)
+{
+  unsigned long pos = rdndx.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &qlist[pos % depth];
+    long dif = (long)cell->sequence.load(std::memory_order_acquire) - (long)(pos + 1);
+    if (dif == 0) {
+      if (rdndx.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return false;   // empty
+    else
+      pos = rdndx.load(std::memory_order_relaxed);
+  }
+  item = cell->item;
+  cell->sequence.store(pos + depth, std::memory_order_release);
+  return true;
+}
+
+// A sleeper registers itself under the lock and then retries, the other side publishes its
+// change and then checks for sleepers. The fences make sure one of the two sees the other.
+void WorkerInfoQueue::WakeWaiters(std::atomic<int> &waiters, pthread_cond_t *cond)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed) > 0) {
+    pthread_mutex_lock(&lock);
+    pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
 // put a new item on the queue.  this will block if the queue is full
 void WorkerInfoQueue::PutItem(WorkerInfoQueueItem &new_item)
 {
-  // obtain the lock
-  pthread_mutex_lock(&lock);
-  
-  // wait for someone to signal new free space
-  // fprintf(stdout, "WorkerInfoQueue::PutItem: %d\n", num);
-  while (num >= depth)
-    pthread_cond_wait(&wrcond,&lock);
-  
-  qlist[wrndx] = new_item;
-  if (++wrndx >= depth) wrndx = 0;
-  num++;
-  not_done_cnt++;
-  
+  // count the item before anyone can pick it up and mark it done
+  int in_flight = not_done_cnt.fetch_add(1) + 1;
+  int high = max_in_flight.load(std::memory_order_relaxed);
+  while (in_flight > high and not max_in_flight.compare_exchange_weak(high, in_flight, std::memory_order_relaxed))
+    ;
+
+  if (not TryPut(new_item)) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    enqueue_waits.fetch_add(1, std::memory_order_relaxed);
+
+    bool done = false;
+    for (int spin = 0; spin < kSpinTries and not done; spin++) {
+      sched_yield();
+      done = TryPut(new_item);
+    }
+    if (not done) {
+      // wait for someone to signal new free space
+      pthread_mutex_lock(&lock);
+      writers_waiting.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (not TryPut(new_item))
+        pthread_cond_wait(&wrcond,&lock);
+      writers_waiting.fetch_sub(1);
+      pthread_mutex_unlock(&lock);
+    }
+    enqueue_wait_nsec.fetch_add(NanoSecondsSince(start), std::memory_order_relaxed);
+  }
+
   // signal readers to check for the new item
-  pthread_cond_signal(&rdcond);
-  
-  // give up the lock
-  pthread_mutex_unlock(&lock);
+  WakeWaiters(readers_waiting, &rdcond);
 }
 
 // remove an item from the queue.  this will block if the queue is empty
 WorkerInfoQueueItem WorkerInfoQueue::GetItem(void)
 {
   WorkerInfoQueueItem item;
-  
-  // obtain the lock
-  pthread_mutex_lock(&lock);
-  
-  // wait for someone to signal a new item
-  // fprintf(stdout, "WorkerInfoQueue::GetItem: %d\n", num);
-  while (num == 0)
-    pthread_cond_wait(&rdcond,&lock);
-  
-  item = qlist[rdndx];
-  if (++rdndx >= depth) rdndx = 0;
-  num--;
-  
+
+  if (not TryGet(item)) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    dequeue_waits.fetch_add(1, std::memory_order_relaxed);
+
+    bool done = false;
+    for (int spin = 0; spin < kSpinTries and not done; spin++) {
+      sched_yield();
+      done = TryGet(item);
+    }
+    if (not done) {
+      // wait for someone to signal a new item
+      pthread_mutex_lock(&lock);
+      readers_waiting.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (not TryGet(item))
+        pthread_cond_wait(&rdcond,&lock);
+      readers_waiting.fetch_sub(1);
+      pthread_mutex_unlock(&lock);
+    }
+    dequeue_wait_nsec.fetch_add(NanoSecondsSince(start), std::memory_order_relaxed);
+  }
+
   // signal writers that more free space is available
-  pthread_cond_signal(&wrcond);
-  
-  // give up the lock
-  pthread_mutex_unlock(&lock);
-  
+  WakeWaiters(writers_waiting, &wrcond);
+
   return(item);
 }
 
@@ -74,25 +213,13 @@ WorkerInfoQueueItem WorkerInfoQueue::TryGetItem(void)
 {
   WorkerInfoQueueItem item;
 
-  // obtain the lock
-  pthread_mutex_lock(&lock);
-
-  // wait for someone to signal a new item
-  if (num == 0) {
-	  pthread_mutex_unlock(&lock);
-	  item.private_data = NULL;
-	  return item;
+  if (not TryGet(item)) {
+    item.private_data = NULL;
+    return item;
   }
 
-  item = qlist[rdndx];
-  if (++rdndx >= depth) rdndx = 0;
-  num--;
-
   // signal writers that more free space is available
-  pthread_cond_signal(&wrcond);
-
-  // give up the lock
-  pthread_mutex_unlock(&lock);
+  WakeWaiters(writers_waiting, &wrcond);
 
   return(item);
 }
@@ -103,36 +230,84 @@ WorkerInfoQueueItem WorkerInfoQueue::TryGetItem(void)
 // finish a work item.  This waits till all the work items have been completed
 void WorkerInfoQueue::WaitTillDone(void)
 {
+  if (not_done_cnt.load() <= 0)
+    return;
+
   // obtain the lock
   pthread_mutex_lock(&lock);
-  
-  // wait for someone to signal new free space
-  while (not_done_cnt > 0)
+  done_waiting.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // wait for the last worker to signal
+  while (not_done_cnt.load() > 0)
     pthread_cond_wait(&donecond,&lock);
-  
+
   // give up the lock
+  done_waiting.fetch_sub(1);
   pthread_mutex_unlock(&lock);
 }
 
 // Allows workers to indicate that they have completed a task
 void WorkerInfoQueue::DecrementDone(void)
 {
-  // obtain the lock
-  pthread_mutex_lock(&lock);
-  
-  // decrement done count
-  not_done_cnt--;
-  
   // if everything is done, signal the condition change
-  if (not_done_cnt == 0)
-    pthread_cond_signal(&donecond);
-  
-  // give up the lock
-  pthread_mutex_unlock(&lock);
+  if (not_done_cnt.fetch_sub(1) == 1)
+    WakeWaiters(done_waiting, &donecond);
+}
+
+WorkerInfoQueueMetrics WorkerInfoQueue::GetMetrics() const
+{
+  WorkerInfoQueueMetrics metrics;
+  metrics.instances        = 1;
+  metrics.depth            = depth;
+  metrics.items            = wrndx.load(std::memory_order_relaxed);
+  metrics.enqueue_waits    = enqueue_waits.load(std::memory_order_relaxed);
+  metrics.enqueue_wait_sec = 1e-9 * enqueue_wait_nsec.load(std::memory_order_relaxed);
+  metrics.dequeue_waits    = dequeue_waits.load(std::memory_order_relaxed);
+  metrics.dequeue_wait_sec = 1e-9 * dequeue_wait_nsec.load(std::memory_order_relaxed);
+  metrics.in_flight        = not_done_cnt.load(std::memory_order_relaxed);
+  metrics.max_in_flight    = max_in_flight.load(std::memory_order_relaxed);
+  return metrics;
+}
+
+void WorkerInfoQueue::WriteMetricsJson(const std::string &filename)
+{
+  pthread_mutex_lock(&metrics_lock);
+  std::map<std::string, WorkerInfoQueueMetrics> metrics = RetiredMetrics();
+  for (std::set<WorkerInfoQueue*>::iterator q = LiveQueues().begin(); q != LiveQueues().end(); ++q)
+    metrics[(*q)->name].Add((*q)->GetMetrics());
+  pthread_mutex_unlock(&metrics_lock);
+
+  Json::Value json(Json::objectValue);
+  for (std::map<std::string, WorkerInfoQueueMetrics>::iterator m = metrics.begin(); m != metrics.end(); ++m) {
+    Json::Value& q = json[m->first];
+    q["instances"]        = m->second.instances;
+    q["depth"]            = m->second.depth;
+    q["items"]            = (Json::Int64)m->second.items;
+    q["enqueue_waits"]    = (Json::Int64)m->second.enqueue_waits;
+    q["enqueue_wait_sec"] = m->second.enqueue_wait_sec;
+    q["dequeue_waits"]    = (Json::Int64)m->second.dequeue_waits;
+    q["dequeue_wait_sec"] = m->second.dequeue_wait_sec;
+    q["in_flight"]        = m->second.in_flight;
+    q["max_in_flight"]    = m->second.max_in_flight;
+  }
+
+  std::ofstream out(filename.c_str(), std::ios::out);
+  if (not out.good()) {
+    std::cerr << "WorkerInfoQueue: unable to write queue metrics to " << filename << std::endl;
+    return;
+  }
+  Json::StyledWriter writer;
+  out << writer.write(json);
 }
 
 WorkerInfoQueue::~WorkerInfoQueue()
 {
+  pthread_mutex_lock(&metrics_lock);
+  LiveQueues().erase(this);
+  RetiredMetrics()[name].Add(GetMetrics());
+  pthread_mutex_unlock(&metrics_lock);
+
   pthread_cond_destroy(&donecond);
   pthread_cond_destroy(&wrcond);
   pthread_cond_destroy(&rdcond);
@@ -22,6 +22,9 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <string>
+#include <atomic>
+#include <pthread.h>
 
 
 struct WorkerInfoQueueItem
@@ -35,13 +38,38 @@ struct WorkerInfoQueueItem
     }
 };
 
+/// counters of a WorkerInfoQueue, folded together for all queues of the same name
+struct WorkerInfoQueueMetrics
+{
+    int    instances;         // number of queues that contributed
+    int    depth;             // largest queue depth
+    long   items;             // items put on the queue
+    long   enqueue_waits;     // PutItem calls that found the queue full
+    double enqueue_wait_sec;  // time spent waiting for free space
+    long   dequeue_waits;     // GetItem calls that found the queue empty
+    double dequeue_wait_sec;  // time spent waiting for an item
+    int    in_flight;         // items put but not yet marked done
+    int    max_in_flight;     // high water mark of in_flight
+    WorkerInfoQueueMetrics()
+    {
+      instances = depth = in_flight = max_in_flight = 0;
+      items = enqueue_waits = dequeue_waits = 0;
+      enqueue_wait_sec = dequeue_wait_sec = 0.0;
+    }
+    void Add(const WorkerInfoQueueMetrics &other);
+};
+
 /// helper class to distribute work items to a set of threads for processing
 /// add class access is thread safe
+/// Items are exchanged through a bounded ring of sequence-numbered cells, so producers and
+/// consumers only contend on an atomic index. The mutex and condition variables are used
+/// to park threads that find the queue full or empty, and are not touched otherwise.
 class WorkerInfoQueue
 {
  public:
-  /** Create a queue w/ that can hold the specified number of items */
-  WorkerInfoQueue(int _depth);
+  /** Create a queue w/ that can hold the specified number of items.
+      Metrics are reported under the given name */
+  WorkerInfoQueue(int _depth, const char *name = "WorkerInfoQueue");
 
   /** Put a new item on the queue.  Blocks if the queue is full */
   void PutItem(WorkerInfoQueueItem &new_item);
@@ -61,17 +89,48 @@ class WorkerInfoQueue
   /* Call when a worker has completed a task */
   void DecrementDone(void);
 
-  inline bool empty(){return (not_done_cnt == 0);}
+  inline bool empty(){return (not_done_cnt.load() == 0);}
+
+  /** Snapshot of the counters of this queue */
+  WorkerInfoQueueMetrics GetMetrics() const;
+
+  /** Write the metrics of all queues created so far to a json file, grouped by queue name */
+  static void WriteMetricsJson(const std::string &filename);
 
   ~WorkerInfoQueue();
 
 private:
-    int rdndx;
-    int wrndx;
-    int num;
-    int not_done_cnt;
+    struct Cell {
+      std::atomic<unsigned long> sequence;
+      WorkerInfoQueueItem item;
+    };
+
+    bool TryPut(const WorkerInfoQueueItem &new_item);
+    bool TryGet(WorkerInfoQueueItem &item);
+    void WakeWaiters(std::atomic<int> &waiters, pthread_cond_t *cond);
+
     int depth;
-    WorkerInfoQueueItem *qlist;
+    std::string name;
+    Cell *qlist;
+
+    // producers and consumers advance their own index, keep them on separate cache lines
+    char pad0[64];
+    std::atomic<unsigned long> wrndx;
+    char pad1[64];
+    std::atomic<unsigned long> rdndx;
+    char pad2[64];
+    std::atomic<int> not_done_cnt;
+    std::atomic<int> max_in_flight;
+    char pad3[64];
+
+    // parking of threads that cannot make progress
+    std::atomic<int> writers_waiting;
+    std::atomic<int> readers_waiting;
+    std::atomic<int> done_waiting;
+    std::atomic<long> enqueue_waits;
+    std::atomic<long> dequeue_waits;
+    std::atomic<long> enqueue_wait_nsec;
+    std::atomic<long> dequeue_wait_nsec;
 
     // synchronization objects
     pthread_mutex_t lock;
@@ -765,16 +765,6 @@ void BAMWalkerEngine::FinishPositionProcessingTask(list<PositionInProgress>::ite
 }
 
 
-int BAMWalkerEngine::GetRecentUnmergedTarget()
-{
-  MergedTarget *my_next_target = next_target_;
-  if (my_next_target)
-    return my_next_target->first_unmerged;
-  else
-    return 0;
-}
-
-
 bool BAMWalkerEngine::MemoryContention(int max_num_reads)
 {
   if (positions_in_progress_.empty())
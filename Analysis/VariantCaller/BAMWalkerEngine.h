@@ -201,7 +201,6 @@ public:
   void FinishReadRemovalTask(Alignment* removal_list, int recycle_limit = 55000);
 
   void PrintStatus();
-  int GetRecentUnmergedTarget();
 
   bool HasMoreAlignments() { return has_more_alignments_; }
   bool ReadProcessingTasksInProgress() { return processing_first_; }
@@ -32,6 +32,7 @@ void VariantCallerHelp() {
 
   printf("Inputs:\n");
   printf("  -r,--reference                        FILE        reference fasta file [required]\n");
+  printf("     --reference-bundle                 FILE        reference, targets and hotspots precompiled by tvcutils build_bundle [optional]\n");
   printf("  -b,--input-bam                        FILE        bam file with mapped reads [required]\n");
   printf("  -g,--sample-name                      STRING      sample for which variants are called (In case of input BAM files with multiple samples) [optional if there is only one sample]\n");
   printf("     --force-sample-name                STRING      force all read groups to have this sample name [off]\n");
@@ -746,6 +747,10 @@ void ExtendParameters::SetupFileIO(OptArgs &opts, Json::Value& tvc_params) {
   }
   ValidateAndCanonicalizePath(fasta);
 
+  reference_bundle                      = opts.GetFirstString('-', "reference-bundle", "");
+  if (not reference_bundle.empty())
+    ValidateAndCanonicalizePath(reference_bundle);
+
   // freeBayes slot
   blacklistFile                     = opts.GetFirstString('l', "sse-vcf", "");
   if (blacklistFile.empty()) {
@@ -252,6 +252,7 @@ public:
   vector<string>    bams;
   string            fasta;                // -f --fasta-reference
   string            targets;              // -t --targets
+  string            reference_bundle;     // --reference-bundle
 
   string            small_variants_vcf;   // small indel output vcf file name
   string            indel_assembly_vcf;   // indel assembly vcf file name
@@ -410,7 +410,7 @@ void * FlowSpaceConsensusWorker(void *input) {
 
 				// 3) Filter by target
 				// These two variables should be parameters of consensus.
-				vc.targets_manager->FilterReadByRegion(new_read[i], vc.bam_walker->GetRecentUnmergedTarget());
+				vc.targets_manager->FilterReadByRegion(new_read[i]);
 				if (new_read[i]->filtered)
 				{ continue; }
 				// 4) Unpacking read meta data for flow-space consensus
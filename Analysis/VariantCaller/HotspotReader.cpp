@@ -7,6 +7,7 @@
 #include "HotspotReader.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 
@@ -19,6 +20,10 @@ HotspotReader::HotspotReader()
   next_pos_ = 0;
   hint_header_ = 0;
   hint_cur_ = 0;
+  bundle_hotspots_ = NULL;
+  bundle_num_hotspots_ = 0;
+  bundle_next_ = 0;
+  bundle_ = NULL;
 }
 
 
@@ -62,6 +67,151 @@ void HotspotReader::Initialize(const ReferenceReader &ref_reader)
   has_more_variants_ = false;
 }
 
+// Alleles and strand hints precompiled into a reference bundle by tvcutils build_bundle
+void HotspotReader::Initialize(const ReferenceReader &ref_reader, const ReferenceBundle& bundle)
+{
+  ref_reader_ = &ref_reader;
+  line_number_ = 0;
+  bundle_ = &bundle;
+  bundle_hotspots_ = bundle.Section<BundleHotspot>(BUNDLE_SECTION_HOTSPOTS, bundle_num_hotspots_);
+  bundle_next_ = 0;
+
+  has_more_variants_ = true;
+  FetchNextVariant();
+
+  LoadHints(bundle, BUNDLE_SECTION_HOTSPOT_HINTS);
+  cout << "HotspotReader: Loaded " << bundle_num_hotspots_ << " hotspot allele(s) of " << bundle.source_path(BUNDLE_SOURCE_HOTSPOTS)
+       << " from " << bundle.filename() << endl;
+}
+
+void HotspotReader::LoadHints(const ReferenceBundle& bundle, BundleSection section)
+{
+  size_t num_hints = 0;
+  const BundleHint *hints = bundle.Section<BundleHint>(section, num_hints);
+  hint_vec.reserve(hint_vec.size() + num_hints);
+  for (size_t idx = 0; idx < num_hints; ++idx) {
+    hint_item hint_entry;
+    hint_entry.chr_ind = hints[idx].chr;
+    hint_entry.pos = hints[idx].pos;
+    hint_entry.value = hints[idx].value;
+    hint_entry.rlen = hints[idx].rlen;
+    hint_entry.alt = bundle.String(hints[idx].alt);
+    hint_vec.push_back(hint_entry);
+  }
+}
+
+// The per-allele parameter overrides, in BundleHotspot::values order
+static void PackParam(BundleHotspot& record, int idx, bool override, float value)
+{
+  if (override)
+    record.overrides |= 1u << idx;
+  record.values[idx] = value;
+}
+
+static void UnpackParam(const BundleHotspot& record, int idx, bool& override, float& value)
+{
+  override = record.overrides & (1u << idx);
+  value = record.values[idx];
+}
+
+static void UnpackParam(const BundleHotspot& record, int idx, bool& override, int& value)
+{
+  override = record.overrides & (1u << idx);
+  value = (int)record.values[idx];
+}
+
+void HotspotReader::WriteToBundle(ReferenceBundleWriter& bundle)
+{
+  vector<BundleHotspot> records;
+  int record_idx = 0;
+  for (; has_more_variants_; FetchNextVariant(), ++record_idx) {
+    for (vector<HotspotAllele>::const_iterator allele = next_.begin(); allele != next_.end(); ++allele) {
+      records.push_back(BundleHotspot());
+      BundleHotspot& record = records.back();
+      memset(&record, 0, sizeof(record));
+      record.record = record_idx;
+      record.chr = allele->chr;
+      record.pos = allele->pos;
+      record.ref_length = allele->ref_length;
+      record.type = allele->type;
+      record.length = allele->length;
+      record.alt = bundle.AddString(allele->alt);
+      record.black_strand = allele->params.black_strand;
+
+      const VariantSpecificParams& p = allele->params;
+      PackParam(record, 0,  p.min_allele_freq_override,              p.min_allele_freq);
+      PackParam(record, 1,  p.strand_bias_override,                  p.strand_bias);
+      PackParam(record, 2,  p.min_coverage_override,                 p.min_coverage);
+      PackParam(record, 3,  p.min_coverage_each_strand_override,     p.min_coverage_each_strand);
+      PackParam(record, 4,  p.min_var_coverage_override,             p.min_var_coverage);
+      PackParam(record, 5,  p.min_variant_score_override,            p.min_variant_score);
+      PackParam(record, 6,  p.data_quality_stringency_override,      p.data_quality_stringency);
+      PackParam(record, 7,  p.hp_max_length_override,                p.hp_max_length);
+      PackParam(record, 8,  p.filter_unusual_predictions_override,   p.filter_unusual_predictions);
+      PackParam(record, 9,  p.filter_insertion_predictions_override, p.filter_insertion_predictions);
+      PackParam(record, 10, p.filter_deletion_predictions_override,  p.filter_deletion_predictions);
+      PackParam(record, 11, p.min_tag_fam_size_override,             p.min_tag_fam_size);
+      PackParam(record, 12, p.sse_prob_threshold_override,           p.sse_prob_threshold);
+    }
+  }
+  bundle.SetSection(BUNDLE_SECTION_HOTSPOTS, records);
+  WriteHintsToBundle(bundle, BUNDLE_SECTION_HOTSPOT_HINTS);
+}
+
+void HotspotReader::WriteHintsToBundle(ReferenceBundleWriter& bundle, BundleSection section) const
+{
+  vector<BundleHint> hints(hint_vec.size());
+  for (size_t idx = 0; idx < hint_vec.size(); ++idx) {
+    hints[idx].chr = hint_vec[idx].chr_ind;
+    hints[idx].pos = hint_vec[idx].pos;
+    hints[idx].value = hint_vec[idx].value;
+    hints[idx].rlen = hint_vec[idx].rlen;
+    hints[idx].alt = bundle.AddString(hint_vec[idx].alt);
+  }
+  bundle.SetSection(section, hints);
+}
+
+void HotspotReader::FetchNextBundleVariant()
+{
+  next_.clear();
+  if (bundle_next_ >= bundle_num_hotspots_) {
+    has_more_variants_ = false;
+    return;
+  }
+
+  int record_idx = bundle_hotspots_[bundle_next_].record;
+  next_chr_ = bundle_hotspots_[bundle_next_].chr;
+  next_pos_ = bundle_hotspots_[bundle_next_].pos;
+
+  for (; bundle_next_ < bundle_num_hotspots_ and bundle_hotspots_[bundle_next_].record == record_idx; ++bundle_next_) {
+    const BundleHotspot& record = bundle_hotspots_[bundle_next_];
+    next_.push_back(HotspotAllele());
+    HotspotAllele& hotspot = next_.back();
+    hotspot.chr = record.chr;
+    hotspot.pos = record.pos;
+    hotspot.ref_length = record.ref_length;
+    hotspot.alt = bundle_->String(record.alt);
+    hotspot.type = (AlleleType)record.type;
+    hotspot.length = record.length;
+    hotspot.params.black_strand = record.black_strand;
+
+    VariantSpecificParams& p = hotspot.params;
+    UnpackParam(record, 0,  p.min_allele_freq_override,              p.min_allele_freq);
+    UnpackParam(record, 1,  p.strand_bias_override,                  p.strand_bias);
+    UnpackParam(record, 2,  p.min_coverage_override,                 p.min_coverage);
+    UnpackParam(record, 3,  p.min_coverage_each_strand_override,     p.min_coverage_each_strand);
+    UnpackParam(record, 4,  p.min_var_coverage_override,             p.min_var_coverage);
+    UnpackParam(record, 5,  p.min_variant_score_override,            p.min_variant_score);
+    UnpackParam(record, 6,  p.data_quality_stringency_override,      p.data_quality_stringency);
+    UnpackParam(record, 7,  p.hp_max_length_override,                p.hp_max_length);
+    UnpackParam(record, 8,  p.filter_unusual_predictions_override,   p.filter_unusual_predictions);
+    UnpackParam(record, 9,  p.filter_insertion_predictions_override, p.filter_insertion_predictions);
+    UnpackParam(record, 10, p.filter_deletion_predictions_override,  p.filter_deletion_predictions);
+    UnpackParam(record, 11, p.min_tag_fam_size_override,             p.min_tag_fam_size);
+    UnpackParam(record, 12, p.sse_prob_threshold_override,           p.sse_prob_threshold);
+  }
+}
+
 void HotspotReader::MakeHintQueue(const string& hotspot_vcf_filename)
 {
   // go through the entire vcf to generate the blacklist
@@ -161,6 +311,11 @@ void HotspotReader::FetchNextVariant()
   if (not has_more_variants_)
     return;
 
+  if (bundle_hotspots_) {
+    FetchNextBundleVariant();
+    return;
+  }
+
   next_.clear();
 
   vcf::Variant current_hotspot(hotspot_vcf_);
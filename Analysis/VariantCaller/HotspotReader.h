@@ -55,9 +55,11 @@ public:
 
   void Initialize(const ReferenceReader &ref_reader, const string& hotspot_vcf_filename);
   void Initialize(const ReferenceReader &ref_reader);
+  void Initialize(const ReferenceReader &ref_reader, const ReferenceBundle& bundle);
 
   bool HasMoreVariants() const { return has_more_variants_; }
   void FetchNextVariant();
+  void FetchNextBundleVariant();
 
   const vector<HotspotAllele>& next() const { return next_; }
   int next_chr() const { return next_chr_; }
@@ -76,6 +78,11 @@ public:
   bool hint_more() { return hint_cur_ < hint_vec.size();}
 
   void MakeHintQueue(const string& hotspot_vcf_filename);
+  void LoadHints(const ReferenceBundle& bundle, BundleSection section);
+
+  // Store all remaining alleles and their hints, consumes the reader
+  void WriteToBundle(ReferenceBundleWriter& bundle);
+  void WriteHintsToBundle(ReferenceBundleWriter& bundle, BundleSection section) const;
 
 private:
   const ReferenceReader * ref_reader_;
@@ -88,6 +95,12 @@ private:
 
 
   vcf::VariantCallFile    hotspot_vcf_;
+
+  // alleles from a mapped reference bundle instead of hotspot_vcf_
+  const BundleHotspot *   bundle_hotspots_;
+  size_t                  bundle_num_hotspots_;
+  size_t                  bundle_next_;
+  const ReferenceBundle * bundle_;
   //ifstream                hotspot_vcf_;
 
   int                     line_number_;
@@ -1429,7 +1429,7 @@ void GenerateConsensusPositionTicket(vector< vector< vector<MolecularFamily> > >
 							if ((not success) or (not vc.candidate_generator->BasicFilters(*alignment))) {
 								delete alignment;
 							} else {
-								vc.targets_manager->TrimAmpliseqPrimers(alignment, vc.bam_walker->GetRecentUnmergedTarget());
+								vc.targets_manager->TrimAmpliseqPrimers(alignment);
 								if (alignment->filtered) {delete alignment;}
 								else {
 									if (consensus_position_ticket->begin == NULL) {consensus_position_ticket->begin = alignment;}
@@ -1472,7 +1472,7 @@ void GenerateConsensusPositionTicket(vector< vector< vector<MolecularFamily> > >
 						delete alignment;
 					}
 					else {
-						vc.targets_manager->TrimAmpliseqPrimers(alignment, vc.bam_walker->GetRecentUnmergedTarget());
+						vc.targets_manager->TrimAmpliseqPrimers(alignment);
 						if (alignment->filtered) {delete alignment;}
 						else {
 							if (consensus_position_ticket->begin == NULL) {consensus_position_ticket->begin = alignment;}
@@ -0,0 +1,406 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+
+//! @file     ReferenceBundle.cpp
+//! @ingroup  VariantCaller
+//! @brief    Precompiled reference, targets and hotspots for memory-mapped loading
+
+#include "ReferenceBundle.h"
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ReferenceReader.h"
+#include "IntervalIndex.h"
+
+
+static bool CanonicalSource(const string& filename, string& path, struct stat& file_stat)
+{
+  char *real_path = realpath(filename.c_str(), NULL);
+  if (real_path == NULL)
+    return false;
+  path = real_path;
+  free(real_path);
+  return stat(path.c_str(), &file_stat) == 0;
+}
+
+static uint64_t AlignedSize(uint64_t size)
+{
+  return (size + 7) & ~(uint64_t)7;
+}
+
+static const uint64_t kBundleRecordSize[BUNDLE_NUM_SECTIONS] = {
+  sizeof(char),                   // BUNDLE_SECTION_STRINGS
+  sizeof(BundleChromosome),       // BUNDLE_SECTION_CHROMOSOMES
+  sizeof(char),                   // BUNDLE_SECTION_SEQUENCE
+  sizeof(BundleTarget),           // BUNDLE_SECTION_TARGETS
+  sizeof(BundleMergedTarget),     // BUNDLE_SECTION_MERGED_TARGETS
+  sizeof(IntervalIndexNode),      // BUNDLE_SECTION_TARGET_INDEX
+  sizeof(BundleHotspot),          // BUNDLE_SECTION_HOTSPOTS
+  sizeof(BundleHint),             // BUNDLE_SECTION_HOTSPOT_HINTS
+  sizeof(BundleHint)              // BUNDLE_SECTION_SSE_HINTS
+};
+
+// -------------------------------------------------------------------------------------
+
+ReferenceBundle::ReferenceBundle()
+  : handle_(-1), size_(0), mmap_(NULL), header_(NULL), strings_(NULL)
+{
+}
+
+ReferenceBundle::~ReferenceBundle()
+{
+  Cleanup();
+}
+
+void ReferenceBundle::Cleanup()
+{
+  if (mmap_)
+    munmap((void *)mmap_, size_);
+  if (handle_ >= 0)
+    close(handle_);
+  handle_ = -1;
+  size_ = 0;
+  mmap_ = NULL;
+  header_ = NULL;
+  strings_ = NULL;
+}
+
+void ReferenceBundle::Open(const string& bundle_filename, const string& fasta_filename)
+{
+  Cleanup();
+  bundle_filename_ = bundle_filename;
+
+  handle_ = open(bundle_filename.c_str(), O_RDONLY);
+  if (handle_ < 0) {
+    cerr << "ERROR: Cannot open reference bundle " << bundle_filename << " : " << strerror(errno) << endl;
+    exit(1);
+  }
+  struct stat bundle_stat;
+  if (fstat(handle_, &bundle_stat) != 0 or bundle_stat.st_size < (off_t)sizeof(BundleHeader)) {
+    cerr << "ERROR: Reference bundle " << bundle_filename << " is truncated" << endl;
+    exit(1);
+  }
+  size_ = bundle_stat.st_size;
+  mmap_ = (const char *)mmap(0, size_, PROT_READ, MAP_SHARED, handle_, 0);
+  if (mmap_ == MAP_FAILED) {
+    mmap_ = NULL;
+    cerr << "ERROR: Cannot mmap reference bundle " << bundle_filename << " : " << strerror(errno) << endl;
+    exit(1);
+  }
+
+  const BundleHeader *header = (const BundleHeader *)mmap_;
+  if (memcmp(header->magic, REFERENCE_BUNDLE_MAGIC, sizeof(REFERENCE_BUNDLE_MAGIC)) != 0
+      or header->version != REFERENCE_BUNDLE_VERSION or header->num_sections != BUNDLE_NUM_SECTIONS) {
+    cerr << "ERROR: " << bundle_filename << " is not a version " << REFERENCE_BUNDLE_VERSION << " reference bundle" << endl;
+    exit(1);
+  }
+  for (int section = 0; section < BUNDLE_NUM_SECTIONS; ++section) {
+    uint64_t offset = header->section[section].offset;
+    if (offset > size_ or header->section[section].count > (size_ - offset) / kBundleRecordSize[section]) {
+      cerr << "ERROR: Reference bundle " << bundle_filename << " is truncated" << endl;
+      exit(1);
+    }
+  }
+  header_ = header;
+  strings_ = mmap_ + header_->section[BUNDLE_SECTION_STRINGS].offset;
+  if (not RecordsAreConsistent()) {
+    cerr << "ERROR: Reference bundle " << bundle_filename << " is corrupt" << endl;
+    exit(1);
+  }
+
+  if (not HasSource(BUNDLE_SOURCE_FASTA, fasta_filename)) {
+    cerr << "ERROR: Reference bundle " << bundle_filename << " was built from " << source_path(BUNDLE_SOURCE_FASTA)
+         << ", not from the current " << fasta_filename << endl;
+    exit(1);
+  }
+
+  // the sequence is read all over the place by every thread, ask for it up front
+  size_t sequence_size = 0;
+  const char *sequence = Section<char>(BUNDLE_SECTION_SEQUENCE, sequence_size);
+  madvise((void *)((uintptr_t)sequence & ~(uintptr_t)(getpagesize()-1)), sequence_size, MADV_WILLNEED);
+
+  cout << "ReferenceBundle: Mapped " << bundle_filename << " (" << (size_ >> 20) << " MB)" << endl;
+}
+
+// Sections are known to lie inside the file, check that the records only point inside their sections
+bool ReferenceBundle::RecordsAreConsistent() const
+{
+  // every string ends before the end of the section, so any offset below its size is a valid string
+  size_t num_strings_bytes = 0;
+  Section<char>(BUNDLE_SECTION_STRINGS, num_strings_bytes);
+  if (num_strings_bytes == 0 or strings_[num_strings_bytes-1] != '\0')
+    return false;
+  for (int source = 0; source < BUNDLE_NUM_SOURCES; ++source)
+    if (header_->source[source].path >= num_strings_bytes)
+      return false;
+
+  size_t num_chr = 0, sequence_size = 0;
+  const BundleChromosome *chromosomes = Section<BundleChromosome>(BUNDLE_SECTION_CHROMOSOMES, num_chr);
+  Section<char>(BUNDLE_SECTION_SEQUENCE, sequence_size);
+  for (size_t idx = 0; idx < num_chr; ++idx) {
+    if (chromosomes[idx].name >= num_strings_bytes or chromosomes[idx].size < 0
+        or chromosomes[idx].seq_offset > sequence_size
+        or (uint64_t)chromosomes[idx].size > sequence_size - chromosomes[idx].seq_offset)
+      return false;
+  }
+
+  size_t num_targets = 0, num_merged = 0;
+  const BundleTarget *targets = Section<BundleTarget>(BUNDLE_SECTION_TARGETS, num_targets);
+  const BundleMergedTarget *merged = Section<BundleMergedTarget>(BUNDLE_SECTION_MERGED_TARGETS, num_merged);
+  for (size_t idx = 0; idx < num_targets; ++idx)
+    if (targets[idx].name >= num_strings_bytes)
+      return false;
+  for (size_t idx = 0; idx < num_merged; ++idx)
+    if (merged[idx].first_unmerged < 0 or (size_t)merged[idx].first_unmerged >= num_targets)
+      return false;
+
+  // IntervalIndex::Attach uses the nodes as they are: contigs have to be sorted and no larger
+  // than the chromosome count, ids have to be targets
+  size_t num_nodes = 0;
+  const IntervalIndexNode *nodes = Section<IntervalIndexNode>(BUNDLE_SECTION_TARGET_INDEX, num_nodes);
+  for (size_t idx = 0; idx < num_nodes; ++idx) {
+    if (nodes[idx].contig >= (int64_t)num_chr
+        or (idx > 0 and nodes[idx].contig < nodes[idx-1].contig)
+        or nodes[idx].id < 0 or (size_t)nodes[idx].id >= num_targets)
+      return false;
+  }
+
+  size_t num_hotspots = 0;
+  const BundleHotspot *hotspots = Section<BundleHotspot>(BUNDLE_SECTION_HOTSPOTS, num_hotspots);
+  for (size_t idx = 0; idx < num_hotspots; ++idx)
+    if (hotspots[idx].alt >= num_strings_bytes)
+      return false;
+
+  const BundleSection hint_sections[2] = { BUNDLE_SECTION_HOTSPOT_HINTS, BUNDLE_SECTION_SSE_HINTS };
+  for (int hint_section = 0; hint_section < 2; ++hint_section) {
+    size_t num_hints = 0;
+    const BundleHint *hints = Section<BundleHint>(hint_sections[hint_section], num_hints);
+    for (size_t idx = 0; idx < num_hints; ++idx)
+      if (hints[idx].alt >= num_strings_bytes)
+        return false;
+  }
+  return true;
+}
+
+bool ReferenceBundle::HasSource(BundleSource source, const string& filename) const
+{
+  if (not is_open() or filename.empty() or header_->source[source].path == 0)
+    return false;
+
+  string path;
+  struct stat file_stat;
+  if (not CanonicalSource(filename, path, file_stat) or path != source_path(source))
+    return false;
+
+  if (file_stat.st_size != header_->source[source].size or file_stat.st_mtime != header_->source[source].mtime) {
+    cerr << "WARNING: " << path << " changed since reference bundle " << bundle_filename_ << " was built, not using the bundle copy" << endl;
+    return false;
+  }
+  return true;
+}
+
+// -------------------------------------------------------------------------------------
+
+ReferenceBundleWriter::ReferenceBundleWriter()
+{
+  ref_reader_ = NULL;
+  memset(counts_, 0, sizeof(counts_));
+  memset(sources_, 0, sizeof(sources_));
+  sections_[BUNDLE_SECTION_STRINGS].push_back('\0');
+  counts_[BUNDLE_SECTION_STRINGS] = 1;
+}
+
+uint64_t ReferenceBundleWriter::AddString(const string& value)
+{
+  vector<char>& strings = sections_[BUNDLE_SECTION_STRINGS];
+  if (value.empty())
+    return 0;
+  uint64_t offset = strings.size();
+  strings.insert(strings.end(), value.begin(), value.end());
+  strings.push_back('\0');
+  counts_[BUNDLE_SECTION_STRINGS] = strings.size();
+  return offset;
+}
+
+void ReferenceBundleWriter::SetSource(BundleSource source, const string& filename)
+{
+  string path;
+  struct stat file_stat;
+  if (not CanonicalSource(filename, path, file_stat)) {
+    cerr << "ERROR: Cannot access " << filename << " : " << strerror(errno) << endl;
+    exit(1);
+  }
+  sources_[source].path = AddString(path);
+  sources_[source].size = file_stat.st_size;
+  sources_[source].mtime = file_stat.st_mtime;
+}
+
+void ReferenceBundleWriter::SetReference(const ReferenceReader& ref_reader)
+{
+  ref_reader_ = &ref_reader;
+  SetSource(BUNDLE_SOURCE_FASTA, ref_reader.get_filename());
+
+  vector<BundleChromosome> chromosomes(ref_reader.chr_count());
+  uint64_t seq_offset = 0;
+  for (int chr = 0; chr < ref_reader.chr_count(); ++chr) {
+    chromosomes[chr].name = AddString(ref_reader.chr_str(chr));
+    chromosomes[chr].size = ref_reader.chr_size(chr);
+    chromosomes[chr].seq_offset = seq_offset;
+    seq_offset += chromosomes[chr].size;
+  }
+  SetSection(BUNDLE_SECTION_CHROMOSOMES, chromosomes);
+  counts_[BUNDLE_SECTION_SEQUENCE] = seq_offset;
+}
+
+bool ReferenceBundleWriter::Write(const string& bundle_filename)
+{
+  if (ref_reader_ == NULL) {
+    cerr << "ERROR: No reference given for bundle " << bundle_filename << endl;
+    return false;
+  }
+
+  BundleHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, REFERENCE_BUNDLE_MAGIC, sizeof(REFERENCE_BUNDLE_MAGIC));
+  header.version = REFERENCE_BUNDLE_VERSION;
+  header.num_sections = BUNDLE_NUM_SECTIONS;
+  memcpy(header.source, sources_, sizeof(sources_));
+
+  uint64_t offset = AlignedSize(sizeof(header));
+  for (int section = 0; section < BUNDLE_NUM_SECTIONS; ++section) {
+    header.section[section].offset = offset;
+    header.section[section].count = counts_[section];
+    uint64_t bytes = section == BUNDLE_SECTION_SEQUENCE ? counts_[section] : sections_[section].size();
+    offset += AlignedSize(bytes);
+  }
+
+  FILE *bundle = fopen(bundle_filename.c_str(), "wb");
+  if (not bundle) {
+    cerr << "ERROR: Cannot open " << bundle_filename << " : " << strerror(errno) << endl;
+    return false;
+  }
+
+  const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  bool ok = fwrite(&header, sizeof(header), 1, bundle) == 1;
+  if (ok and AlignedSize(sizeof(header)) > sizeof(header))
+    ok = fwrite(padding, AlignedSize(sizeof(header)) - sizeof(header), 1, bundle) == 1;
+
+  for (int section = 0; ok and section < BUNDLE_NUM_SECTIONS; ++section) {
+    uint64_t bytes = 0;
+    if (section == BUNDLE_SECTION_SEQUENCE) {
+      // stream the bases one chromosome at a time, the reference may be larger than memory
+      string bases;
+      for (int chr = 0; ok and chr < ref_reader_->chr_count(); ++chr) {
+        bases.clear();
+        bases.reserve(ref_reader_->chr_size(chr));
+        for (ReferenceReader::iterator I = ref_reader_->begin(chr); I < ref_reader_->end(chr); ++I)
+          bases.push_back(*I);
+        ok = bases.empty() or fwrite(bases.data(), bases.size(), 1, bundle) == 1;
+        bytes += bases.size();
+      }
+    } else {
+      bytes = sections_[section].size();
+      ok = bytes == 0 or fwrite(&sections_[section][0], bytes, 1, bundle) == 1;
+    }
+    if (ok and AlignedSize(bytes) > bytes)
+      ok = fwrite(padding, AlignedSize(bytes) - bytes, 1, bundle) == 1;
+  }
+
+  if (fclose(bundle) != 0)
+    ok = false;
+  if (not ok)
+    cerr << "ERROR: Failed writing reference bundle " << bundle_filename << " : " << strerror(errno) << endl;
+  return ok;
+}
+
+// -------------------------------------------------------------------------------------
+
+bool WritePackedReference(const ReferenceReader& ref_reader, const string& pack_filename)
+{
+  struct stat fasta_stat;
+  if (stat(ref_reader.get_filename().c_str(), &fasta_stat) != 0) {
+    cerr << "ERROR: Cannot access " << ref_reader.get_filename() << " : " << strerror(errno) << endl;
+    return false;
+  }
+
+  int base_code[256];
+  for (int c = 0; c < 256; ++c)
+    base_code[c] = -1;
+  for (int code = 1; code < 16; ++code)
+    base_code[(uint8_t)kPackedBases[code]] = code;
+
+  PackedReferenceHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, PACKED_REFERENCE_MAGIC, sizeof(PACKED_REFERENCE_MAGIC));
+  header.version = PACKED_REFERENCE_VERSION;
+  header.num_chr = ref_reader.chr_count();
+  header.fasta_size = fasta_stat.st_size;
+  header.fasta_mtime = fasta_stat.st_mtime;
+
+  vector<char> strings;
+  vector<PackedChromosome> chromosomes(ref_reader.chr_count());
+  for (int chr = 0; chr < ref_reader.chr_count(); ++chr) {
+    chromosomes[chr].name = strings.size();
+    strings.insert(strings.end(), ref_reader.chr_str(chr).begin(), ref_reader.chr_str(chr).end());
+    strings.push_back('\0');
+    chromosomes[chr].size = ref_reader.chr_size(chr);
+    chromosomes[chr].seq_offset = header.seq_size;
+    header.seq_size += (chromosomes[chr].size + 1) / 2;
+  }
+  const int32_t *hash = ref_reader.chr_hash(header.hash_size);
+
+  header.strings_offset = AlignedSize(sizeof(header));
+  header.chr_offset = header.strings_offset + AlignedSize(strings.size());
+  header.hash_offset = header.chr_offset + AlignedSize(chromosomes.size() * sizeof(PackedChromosome));
+  header.seq_offset = header.hash_offset + AlignedSize(header.hash_size * sizeof(int32_t));
+
+  // The reader may have the old sidecar mapped, replace it only once the new one is complete
+  string temp_filename = pack_filename + ".tmp";
+  FILE *pack = fopen(temp_filename.c_str(), "wb");
+  if (not pack) {
+    cerr << "ERROR: Cannot open " << temp_filename << " : " << strerror(errno) << endl;
+    return false;
+  }
+
+  const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  bool ok = fwrite(&header, sizeof(header), 1, pack) == 1;
+  ok = ok and (header.strings_offset == sizeof(header) or fwrite(padding, header.strings_offset - sizeof(header), 1, pack) == 1);
+  ok = ok and (strings.empty() or fwrite(&strings[0], strings.size(), 1, pack) == 1);
+  ok = ok and (AlignedSize(strings.size()) == strings.size() or fwrite(padding, AlignedSize(strings.size()) - strings.size(), 1, pack) == 1);
+  ok = ok and (chromosomes.empty() or fwrite(&chromosomes[0], sizeof(PackedChromosome), chromosomes.size(), pack) == chromosomes.size());
+  ok = ok and fwrite(hash, sizeof(int32_t), header.hash_size, pack) == header.hash_size;
+  uint64_t hash_padding = header.seq_offset - header.hash_offset - header.hash_size * sizeof(int32_t);
+  ok = ok and (hash_padding == 0 or fwrite(padding, hash_padding, 1, pack) == 1);
+
+  // one chromosome at a time, the reference may be larger than memory
+  vector<uint8_t> packed;
+  for (int chr = 0; ok and chr < ref_reader.chr_count(); ++chr) {
+    packed.assign((chromosomes[chr].size + 1) / 2, 0);
+    long pos = 0;
+    for (ReferenceReader::iterator I = ref_reader.begin(chr); ok and I < ref_reader.end(chr); ++I, ++pos) {
+      int code = base_code[(uint8_t)*I];
+      if (code < 0) {
+        cerr << "ERROR: Cannot pack '" << *I << "' at " << ref_reader.chr_str(chr) << ":" << pos+1
+             << ", only IUPAC bases can be packed" << endl;
+        ok = false;
+      } else
+        packed[pos >> 1] |= code << ((pos & 1) << 2);
+    }
+    ok = ok and (packed.empty() or fwrite(&packed[0], packed.size(), 1, pack) == 1);
+  }
+
+  if (fclose(pack) != 0)
+    ok = false;
+  if (ok and rename(temp_filename.c_str(), pack_filename.c_str()) != 0)
+    ok = false;
+  if (not ok) {
+    cerr << "ERROR: Failed writing packed reference " << pack_filename << " : " << strerror(errno) << endl;
+    unlink(temp_filename.c_str());
+  }
+  return ok;
+}
@@ -0,0 +1,233 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+
+//! @file     ReferenceBundle.h
+//! @ingroup  VariantCaller
+//! @brief    Precompiled reference, targets and hotspots for memory-mapped loading
+
+#ifndef REFERENCEBUNDLE_H
+#define REFERENCEBUNDLE_H
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+using namespace std;
+
+class ReferenceReader;
+
+// A bundle is one read-only file holding everything tvc parses from text at startup:
+// the reference sequence without line breaks, the sorted and merged target regions
+// with their interval index, and the parsed hotspot alleles and strand hints. All records are fixed width and
+// every section is 8 byte aligned, so the file is used in place through mmap and
+// the page cache copy is shared by every tvc process running against the same panel.
+// Build one with "tvcutils build_bundle".
+
+#define REFERENCE_BUNDLE_MAGIC      "TVCBNDL"
+#define REFERENCE_BUNDLE_VERSION    2
+#define BUNDLE_NUM_HOTSPOT_PARAMS   16
+
+enum BundleSource {
+  BUNDLE_SOURCE_FASTA = 0,
+  BUNDLE_SOURCE_TARGETS,
+  BUNDLE_SOURCE_HOTSPOTS,
+  BUNDLE_SOURCE_SSE,
+  BUNDLE_NUM_SOURCES
+};
+
+enum BundleSection {
+  BUNDLE_SECTION_STRINGS = 0,         // char, NUL terminated strings, offset 0 is ""
+  BUNDLE_SECTION_CHROMOSOMES,         // BundleChromosome
+  BUNDLE_SECTION_SEQUENCE,            // char, upper case bases of all chromosomes
+  BUNDLE_SECTION_TARGETS,             // BundleTarget, sorted
+  BUNDLE_SECTION_MERGED_TARGETS,      // BundleMergedTarget
+  BUNDLE_SECTION_TARGET_INDEX,        // IntervalIndexNode, ids are BUNDLE_SECTION_TARGETS records
+  BUNDLE_SECTION_HOTSPOTS,            // BundleHotspot, in input vcf order
+  BUNDLE_SECTION_HOTSPOT_HINTS,       // BundleHint, from the hotspot vcf
+  BUNDLE_SECTION_SSE_HINTS,           // BundleHint, from the sse vcf
+  BUNDLE_NUM_SECTIONS
+};
+
+struct BundleSourceFile {
+  uint64_t    path;           // string offset, canonical path or "" if not in the bundle
+  int64_t     size;
+  int64_t     mtime;
+};
+
+struct BundleSectionEntry {
+  uint64_t    offset;         // bytes from start of file
+  uint64_t    count;          // number of records
+};
+
+struct BundleHeader {
+  char                magic[8];
+  uint32_t            version;
+  uint32_t            num_sections;
+  BundleSourceFile    source[BUNDLE_NUM_SOURCES];
+  BundleSectionEntry  section[BUNDLE_NUM_SECTIONS];
+};
+
+struct BundleChromosome {
+  uint64_t    name;           // string offset
+  int64_t     size;
+  uint64_t    seq_offset;     // into BUNDLE_SECTION_SEQUENCE
+};
+
+struct BundleTarget {
+  int32_t     chr;
+  int32_t     begin;
+  int32_t     end;
+  int32_t     merged;
+  int32_t     trim_left;
+  int32_t     trim_right;
+  int32_t     hotspots_only;
+  int32_t     read_mismatch_limit;
+  uint64_t    name;           // string offset
+};
+
+struct BundleMergedTarget {
+  int32_t     chr;
+  int32_t     begin;
+  int32_t     end;
+  int32_t     first_unmerged;
+};
+
+struct BundleHotspot {
+  int32_t     record;         // alleles of one vcf record share this number
+  int32_t     chr;
+  int32_t     pos;
+  int32_t     ref_length;
+  int32_t     type;
+  int32_t     length;
+  uint64_t    alt;            // string offset
+  uint32_t    overrides;      // bit i set if values[i] overrides the default
+  int32_t     black_strand;
+  float       values[BUNDLE_NUM_HOTSPOT_PARAMS];
+};
+
+struct BundleHint {
+  int64_t     chr;
+  int64_t     pos;
+  int64_t     value;
+  int64_t     rlen;
+  uint64_t    alt;            // string offset
+};
+
+
+// A packed reference is an optional sidecar next to the fasta (<fasta>.tvcpack) that
+// ReferenceReader maps instead of walking the text file. Bases are stored 4 bits each,
+// low nibble first, in the BAM encoding below, so any IUPAC code survives. Every
+// chromosome starts on a byte boundary. The contig names come with an open addressing
+// hash table of chromosome indices. Build one with "tvcutils pack_reference".
+
+#define PACKED_REFERENCE_MAGIC      "TVCPACK"
+#define PACKED_REFERENCE_VERSION    1
+#define PACKED_REFERENCE_SUFFIX     ".tvcpack"
+
+static const char kPackedBases[17] = "=ACMGRSVTWYHKDBN";
+
+struct PackedReferenceHeader {
+  char        magic[8];
+  uint32_t    version;
+  uint32_t    num_chr;
+  int64_t     fasta_size;     // the fasta the sidecar was packed from
+  int64_t     fasta_mtime;
+  uint64_t    hash_size;      // number of int32_t slots, a power of two
+  uint64_t    strings_offset; // sections, bytes from start of file
+  uint64_t    chr_offset;
+  uint64_t    hash_offset;
+  uint64_t    seq_offset;
+  uint64_t    seq_size;
+};
+
+struct PackedChromosome {
+  uint64_t    name;           // offset into the strings section
+  int64_t     size;
+  uint64_t    seq_offset;     // bytes into the sequence section
+};
+
+// Base at pos of a packed chromosome, no bounds check
+inline char PackedBase(const uint8_t *seq, long pos)
+{
+  return kPackedBases[(seq[pos >> 1] >> ((pos & 1) << 2)) & 0xF];
+}
+
+// FNV-1a of prefix followed by name, lets the contig lookup try "chr"+name without building the string
+inline uint64_t ContigNameHash(const char *prefix, const char *name)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char *c = prefix; *c; ++c)
+    hash = (hash ^ (uint8_t)*c) * 1099511628211ULL;
+  for (const char *c = name; *c; ++c)
+    hash = (hash ^ (uint8_t)*c) * 1099511628211ULL;
+  return hash;
+}
+
+// Write the sidecar for the fasta ref_reader was initialized with
+bool WritePackedReference(const ReferenceReader& ref_reader, const string& pack_filename);
+
+
+class ReferenceBundle {
+public:
+  ReferenceBundle();
+  ~ReferenceBundle();
+
+  // Map the bundle read-only. Exits if it is not a bundle, is damaged or was not built from fasta_filename.
+  void Open(const string& bundle_filename, const string& fasta_filename);
+  bool is_open() const { return header_ != NULL; }
+  const string& filename() const { return bundle_filename_; }
+
+  // True if the bundle holds the parsed contents of this file, as it is on disk now
+  bool HasSource(BundleSource source, const string& filename) const;
+  const char *source_path(BundleSource source) const { return String(header_->source[source].path); }
+
+  template<class T>
+  const T *Section(BundleSection section, size_t& count) const {
+    count = header_->section[section].count;
+    return (const T *)(mmap_ + header_->section[section].offset);
+  }
+  const char *String(uint64_t offset) const { return strings_ + offset; }
+
+private:
+  void Cleanup();
+  bool RecordsAreConsistent() const;
+
+  string              bundle_filename_;
+  int                 handle_;
+  size_t              size_;
+  const char *        mmap_;
+  const BundleHeader *header_;
+  const char *        strings_;
+};
+
+
+class ReferenceBundleWriter {
+public:
+  ReferenceBundleWriter();
+
+  // Record the file a section was parsed from, so tvc can tell whether it may use the bundle
+  void SetSource(BundleSource source, const string& filename);
+
+  // Chromosome table and sequence, the bases are copied from ref_reader while writing
+  void SetReference(const ReferenceReader& ref_reader);
+
+  uint64_t AddString(const string& value);
+
+  template<class T>
+  void SetSection(BundleSection section, const vector<T>& records) {
+    const char *data = records.empty() ? NULL : (const char *)&records[0];
+    sections_[section].assign(data, data + records.size() * sizeof(T));
+    counts_[section] = records.size();
+  }
+
+  bool Write(const string& bundle_filename);
+
+private:
+  const ReferenceReader * ref_reader_;
+  vector<char>            sections_[BUNDLE_NUM_SECTIONS];
+  uint64_t                counts_[BUNDLE_NUM_SECTIONS];
+  BundleSourceFile        sources_[BUNDLE_NUM_SOURCES];
+};
+
+
+#endif // REFERENCEBUNDLE_H
@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include "ReferenceBundle.h"
 
 using namespace std;
 
@@ -27,10 +28,12 @@ using namespace std;
 
 class ReferenceReader {
 public:
-  ReferenceReader () : initialized_(false), ref_handle_(0), ref_mmap_(0) {}
+  ReferenceReader () : initialized_(false), ref_handle_(0), ref_mmap_(0), pack_mmap_(0), pack_size_(0),
+    chr_hash_(0), chr_hash_mask_(0) {}
   ~ReferenceReader () { Cleanup(); }
   
   string& get_filename() {return ref_filename_;}
+  const string& get_filename() const {return ref_filename_;}
 
   void Initialize(const string& fasta_filename) {
     Cleanup();
@@ -72,16 +75,45 @@ public:
         continue;
       ref_entry.chr = chrom_name;
       ref_entry.start = ref_mmap_ + chr_start;
+      ref_entry.packed = 0;
       ref_entry.begin_ = ref_entry.iter(0);
       ref_entry.end_ = ref_entry.iter(ref_entry.size);
       ref_index_.push_back(ref_entry);
-      ref_map_[ref_entry.chr] = (int) ref_index_.size() - 1;
     }
     fclose(fai);
+
+    if (not LoadPacked(fasta_filename + PACKED_REFERENCE_SUFFIX))
+      BuildChrHash();
+    initialized_ = true;
+  }
+
+  // Use the sequence of a mapped reference bundle, each chromosome is stored as one line
+  void Initialize(const ReferenceBundle& bundle) {
+    Cleanup();
+
+    ref_filename_ = bundle.source_path(BUNDLE_SOURCE_FASTA);
+
+    size_t num_chr = 0, sequence_size = 0;
+    const BundleChromosome *chromosomes = bundle.Section<BundleChromosome>(BUNDLE_SECTION_CHROMOSOMES, num_chr);
+    const char *sequence = bundle.Section<char>(BUNDLE_SECTION_SEQUENCE, sequence_size);
+    for (size_t idx = 0; idx < num_chr; ++idx) {
+      Reference ref_entry;
+      ref_entry.chr = bundle.String(chromosomes[idx].name);
+      ref_entry.size = chromosomes[idx].size;
+      ref_entry.start = sequence + chromosomes[idx].seq_offset;
+      ref_entry.bases_per_line = ref_entry.size > 0 ? ref_entry.size : 1;
+      ref_entry.bytes_per_line = ref_entry.bases_per_line;
+      ref_entry.packed = 0;
+      ref_entry.begin_ = ref_entry.iter(0);
+      ref_entry.end_ = ref_entry.iter(ref_entry.size);
+      ref_index_.push_back(ref_entry);
+    }
+    BuildChrHash();
     initialized_ = true;
   }
 
   bool initialized() const { return initialized_; }
+  bool packed() const { return pack_mmap_ != 0; }
   int chr_count() const { return (int)ref_index_.size(); }
   const char *chr(int idx) const { return ref_index_[idx].chr.c_str(); }
   const string& chr_str(int idx) const { return ref_index_[idx].chr; }
@@ -89,31 +121,34 @@ public:
   long chr_size(int idx) const { return ref_index_[idx].size; }
 
   int chr_idx(const char *chr_name) const {
-    string string_chr(chr_name);
-    map<string,int>::const_iterator I = ref_map_.find(string_chr);
-    if (I != ref_map_.end())
-      return I->second;
-    I = ref_map_.find("chr"+string_chr);
-    if (I != ref_map_.end())
-      return I->second;
-    if (string_chr == "MT") {
-      I = ref_map_.find("chrM");
-      if (I != ref_map_.end())
-        return I->second;
-    }
-    return -1;
+    int idx = FindChr("", chr_name);
+    if (idx < 0)
+      idx = FindChr("chr", chr_name);
+    if (idx < 0 and strcmp(chr_name, "MT") == 0)
+      idx = FindChr("", "chrM");
+    return idx;
   }
 
+  // Contig hash table, chromosome index or -1 for every one of hash_size slots
+  const int32_t *chr_hash(uint64_t& hash_size) const { hash_size = chr_hash_mask_ + 1; return chr_hash_; }
+
 
+  // Walks the text of one chromosome skipping the line ends, or the bases of a packed one
   class iterator {
   public:
-    iterator() : pos_(0), start_of_line_(0), end_of_line_(0), bytes_per_line_(0), gap_size_(0) {}
+    iterator() : pos_(0), start_of_line_(0), end_of_line_(0), bytes_per_line_(0), gap_size_(0), packed_(0), idx_(0) {}
 
-    iterator(const char *pos, const char *end_of_line, int bases_per_line, int bytes_per_line)
+    iterator(const char *pos, const char *end_of_line, int bases_per_line, int bytes_per_line, long idx)
       : pos_(pos), start_of_line_(end_of_line-bases_per_line), end_of_line_(end_of_line),
-        bytes_per_line_(bytes_per_line), gap_size_(bytes_per_line-bases_per_line) {}
+        bytes_per_line_(bytes_per_line), gap_size_(bytes_per_line-bases_per_line), packed_(0), idx_(idx) {}
+
+    iterator(const uint8_t *packed, long idx)
+      : pos_(0), start_of_line_(0), end_of_line_(0), bytes_per_line_(0), gap_size_(0), packed_(packed), idx_(idx) {}
 
     void operator++() {
+      ++idx_;
+      if (packed_)
+        return;
       ++pos_;
       if (pos_ == end_of_line_) {
         pos_ += gap_size_;
@@ -122,6 +157,9 @@ public:
       }
     }
     void operator--() {
+      --idx_;
+      if (packed_)
+        return;
       --pos_;
       if (pos_ < start_of_line_) {
         pos_ -= gap_size_;
@@ -130,6 +168,9 @@ public:
       }
     }
     void operator+=(unsigned int delta) {
+      idx_ += delta;
+      if (packed_)
+        return;
       pos_ += delta;
       while (pos_ >= end_of_line_) {
         pos_ += gap_size_;
@@ -138,6 +179,9 @@ public:
       }
     }
     void operator-=(unsigned int delta) {
+      idx_ -= delta;
+      if (packed_)
+        return;
       pos_ -= delta;
       while(pos_ < start_of_line_) {
         pos_ -= gap_size_;
@@ -146,20 +190,23 @@ public:
       }
     }
     char operator*() const {
-      return FAST_TO_UPPER(*pos_);
+      return packed_ ? PackedBase(packed_, idx_) : FAST_TO_UPPER(*pos_);
     }
-    bool operator==(const iterator& other) const { return pos_ == other.pos_; }
-    bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
-    bool operator< (const iterator& other) const { return pos_ < other.pos_; }
-    bool operator> (const iterator& other) const { return pos_ > other.pos_; }
-    bool operator>=(const iterator& other) const { return pos_ >= other.pos_; }
+    // Only iterators of the same chromosome compare
+    bool operator==(const iterator& other) const { return idx_ == other.idx_; }
+    bool operator!=(const iterator& other) const { return idx_ != other.idx_; }
+    bool operator< (const iterator& other) const { return idx_ < other.idx_; }
+    bool operator> (const iterator& other) const { return idx_ > other.idx_; }
+    bool operator>=(const iterator& other) const { return idx_ >= other.idx_; }
 
   private:
-    const char *  pos_;
-    const char *  start_of_line_;
-    const char *  end_of_line_;
-    int           bytes_per_line_;
-    int           gap_size_;
+    const char *    pos_;
+    const char *    start_of_line_;
+    const char *    end_of_line_;
+    int             bytes_per_line_;
+    int             gap_size_;
+    const uint8_t * packed_;
+    long            idx_;
   };
 
   iterator iter(int chr_idx, long pos) const {  return ref_index_[chr_idx].iter(pos); }
@@ -167,6 +214,18 @@ public:
   const iterator& end(int chr_idx) const {  return ref_index_[chr_idx].end(); }
 
   string substr(int chr_idx, long pos, long len) const {
+    const Reference& ref = ref_index_[chr_idx];
+    if (ref.packed) {
+      // whole window in one go, no per base iterator steps
+      if (pos < 0 or pos > ref.size)
+        return string();
+      if (len < 0 or len > ref.size - pos)
+        len = ref.size - pos;
+      string s(len, 'N');
+      for (long idx = 0; idx < len; ++idx)
+        s[idx] = PackedBase(ref.packed, pos + idx);
+      return s;
+    }
     string s;
     s.reserve(len+1);
     iterator I = iter(chr_idx,pos);
@@ -181,26 +240,141 @@ public:
 private:
   void Cleanup() {
     if (initialized_) {
-      munmap(ref_mmap_, ref_stat_.st_size);
-      close(ref_handle_);
+      if (ref_mmap_) {
+        munmap(ref_mmap_, ref_stat_.st_size);
+        close(ref_handle_);
+        ref_mmap_ = 0;
+      }
+      if (pack_mmap_) {
+        munmap(pack_mmap_, pack_size_);
+        pack_mmap_ = 0;
+        pack_size_ = 0;
+      }
       ref_index_.clear();
-      ref_map_.clear();
+      own_chr_hash_.clear();
+      chr_hash_ = 0;
+      chr_hash_mask_ = 0;
       initialized_ = false;
     }
   }
 
+  // Map the packed sidecar of the fasta if there is one that matches the fasta and its index.
+  // A stale or broken sidecar is reported and ignored.
+  bool LoadPacked(const string& pack_filename) {
+    int handle = open(pack_filename.c_str(), O_RDONLY);
+    if (handle < 0)
+      return false;
+    struct stat pack_stat;
+    if (fstat(handle, &pack_stat) != 0 or pack_stat.st_size < (off_t)sizeof(PackedReferenceHeader)) {
+      close(handle);
+      cerr << "WARNING: Ignoring truncated packed reference " << pack_filename << endl;
+      return false;
+    }
+    char *pack_mmap = (char *)mmap(0, pack_stat.st_size, PROT_READ, MAP_SHARED, handle, 0);
+    close(handle);
+    if (pack_mmap == MAP_FAILED) {
+      cerr << "WARNING: Cannot mmap packed reference " << pack_filename << " : " << strerror(errno) << endl;
+      return false;
+    }
+
+    const PackedReferenceHeader *header = (const PackedReferenceHeader *)pack_mmap;
+    uint64_t size = pack_stat.st_size;
+    bool ok = memcmp(header->magic, PACKED_REFERENCE_MAGIC, sizeof(PACKED_REFERENCE_MAGIC)) == 0
+        and header->version == PACKED_REFERENCE_VERSION
+        and header->num_chr == ref_index_.size()
+        and header->fasta_size == (int64_t)ref_stat_.st_size
+        and header->fasta_mtime == (int64_t)ref_stat_.st_mtime
+        and header->hash_size > 0 and (header->hash_size & (header->hash_size - 1)) == 0
+        // the strings end where the chromosome table starts
+        and header->strings_offset <= header->chr_offset and header->chr_offset <= size
+        and header->num_chr <= (size - header->chr_offset) / sizeof(PackedChromosome)
+        and header->hash_offset <= size and header->hash_size <= (size - header->hash_offset) / sizeof(int32_t)
+        and header->seq_offset <= size and header->seq_size <= size - header->seq_offset;
+
+    const char *strings = pack_mmap + header->strings_offset;
+    uint64_t strings_size = header->chr_offset - header->strings_offset;
+    const PackedChromosome *chromosomes = (const PackedChromosome *)(pack_mmap + header->chr_offset);
+    const uint8_t *sequence = (const uint8_t *)(pack_mmap + header->seq_offset);
+    for (size_t idx = 0; ok and idx < ref_index_.size(); ++idx) {
+      ok = chromosomes[idx].size == ref_index_[idx].size
+          and chromosomes[idx].seq_offset <= header->seq_size
+          and (uint64_t)(chromosomes[idx].size + 1) / 2 <= header->seq_size - chromosomes[idx].seq_offset
+          and chromosomes[idx].name < strings_size
+          and memchr(strings + chromosomes[idx].name, '\0', strings_size - chromosomes[idx].name) != NULL
+          and ref_index_[idx].chr == strings + chromosomes[idx].name;
+    }
+
+    // FindChr probes until it meets an empty slot and indexes ref_index_ with the others
+    const int32_t *chr_hash = (const int32_t *)(pack_mmap + header->hash_offset);
+    bool has_empty_slot = false;
+    for (uint64_t slot = 0; ok and slot < header->hash_size; ++slot) {
+      ok = chr_hash[slot] >= -1 and chr_hash[slot] < (int64_t)header->num_chr;
+      has_empty_slot = has_empty_slot or chr_hash[slot] == -1;
+    }
+    ok = ok and has_empty_slot;
+    if (not ok) {
+      munmap(pack_mmap, pack_stat.st_size);
+      cerr << "WARNING: Ignoring packed reference " << pack_filename << ", it is damaged or does not match "
+           << ref_filename_ << ". Rebuild it with tvcutils pack_reference." << endl;
+      return false;
+    }
+
+    pack_mmap_ = pack_mmap;
+    pack_size_ = pack_stat.st_size;
+    for (size_t idx = 0; idx < ref_index_.size(); ++idx) {
+      Reference& ref_entry = ref_index_[idx];
+      ref_entry.packed = sequence + chromosomes[idx].seq_offset;
+      ref_entry.begin_ = ref_entry.iter(0);
+      ref_entry.end_ = ref_entry.iter(ref_entry.size);
+    }
+    chr_hash_ = chr_hash;
+    chr_hash_mask_ = header->hash_size - 1;
+    return true;
+  }
+
+  // Open addressing with linear probing, at most half full. A repeated name keeps the last chromosome.
+  void BuildChrHash() {
+    uint64_t hash_size = 1;
+    while (hash_size < 2 * ref_index_.size())
+      hash_size <<= 1;
+    own_chr_hash_.assign(hash_size, -1);
+    chr_hash_ = &own_chr_hash_[0];
+    chr_hash_mask_ = hash_size - 1;
+    for (size_t idx = 0; idx < ref_index_.size(); ++idx) {
+      uint64_t slot = ContigNameHash("", ref_index_[idx].chr.c_str()) & chr_hash_mask_;
+      while (own_chr_hash_[slot] >= 0 and ref_index_[own_chr_hash_[slot]].chr != ref_index_[idx].chr)
+        slot = (slot + 1) & chr_hash_mask_;
+      own_chr_hash_[slot] = idx;
+    }
+  }
+
+  int FindChr(const char *prefix, const char *name) const {
+    if (not chr_hash_)    // not initialized or already cleaned up
+      return -1;
+    size_t prefix_len = strlen(prefix);
+    for (uint64_t slot = ContigNameHash(prefix, name) & chr_hash_mask_; chr_hash_[slot] >= 0; slot = (slot + 1) & chr_hash_mask_) {
+      const string& chr = ref_index_[chr_hash_[slot]].chr;
+      if (chr.compare(0, prefix_len, prefix) == 0 and strcmp(chr.c_str() + prefix_len, name) == 0)
+        return chr_hash_[slot];
+    }
+    return -1;
+  }
+
   struct Reference {
     string            chr;
     long              size;
     const char *      start;
     int               bases_per_line;
     int               bytes_per_line;
+    const uint8_t *   packed;         // 4 bit bases from the sidecar, or 0 to read the text
     iterator          begin_;
     iterator          end_;
 
     char base(long pos) const {
       if (pos < 0 or pos >= size)
         return 'N';
+      if (packed)
+        return PackedBase(packed, pos);
       long ref_line_idx = pos / bases_per_line;
       long ref_line_pos = pos % bases_per_line;
       return toupper(start[ref_line_idx*bytes_per_line + ref_line_pos]);
@@ -209,11 +383,13 @@ private:
     iterator iter(long pos) const {
       if (pos < 0 or pos > size)
         pos = size;
+      if (packed)
+        return iterator(packed, pos);
       long ref_line_idx = pos / bases_per_line;
       long ref_line_pos = pos % bases_per_line;
       return iterator(start + ref_line_idx*bytes_per_line + ref_line_pos,
           start + ref_line_idx*bytes_per_line + bases_per_line,
-          bases_per_line, bytes_per_line);
+          bases_per_line, bytes_per_line, pos);
     }
     const iterator& begin() const { return begin_; }
     const iterator& end() const { return end_; }
@@ -225,8 +401,12 @@ private:
   int                 ref_handle_;
   struct stat       ref_stat_;
   char *              ref_mmap_;
+  char *              pack_mmap_;
+  size_t              pack_size_;
   vector<Reference>   ref_index_;
-  map<string,int>     ref_map_;
+  vector<int32_t>     own_chr_hash_;
+  const int32_t *     chr_hash_;      // own_chr_hash_ or the table of the sidecar
+  uint64_t            chr_hash_mask_;
   string              ref_filename_;
 
 };
@@ -118,6 +118,12 @@ void TargetsManager::Initialize(const ReferenceReader& ref_reader, const string&
     unmerged[idx].merged = merged.size();
   }
 
+  //
+  // Step 4. Index unmerged targets for read to target lookups
+  //
+
+  IndexTargets();
+
   if (_targets.empty()) {
     cout << "TargetsManager: No targets file specified, processing entire reference" << endl;
 
@@ -140,6 +146,92 @@ void TargetsManager::Initialize(const ReferenceReader& ref_reader, const string&
 }
 
 
+// -------------------------------------------------------------------------------------
+// Sorted and merged targets precompiled into a reference bundle by tvcutils build_bundle
+
+void TargetsManager::Initialize(const ReferenceBundle& bundle, float min_cov_frac, bool _trim_ampliseq_primers)
+{
+  min_coverage_fraction = min_cov_frac;
+
+  size_t num_unmerged = 0, num_merged = 0;
+  const BundleTarget *bundle_unmerged = bundle.Section<BundleTarget>(BUNDLE_SECTION_TARGETS, num_unmerged);
+  const BundleMergedTarget *bundle_merged = bundle.Section<BundleMergedTarget>(BUNDLE_SECTION_MERGED_TARGETS, num_merged);
+
+  unmerged.resize(num_unmerged);
+  for (size_t idx = 0; idx < num_unmerged; ++idx) {
+    UnmergedTarget& target = unmerged[idx];
+    target.chr = bundle_unmerged[idx].chr;
+    target.begin = bundle_unmerged[idx].begin;
+    target.end = bundle_unmerged[idx].end;
+    target.name = bundle.String(bundle_unmerged[idx].name);
+    target.merged = bundle_unmerged[idx].merged;
+    target.trim_left = bundle_unmerged[idx].trim_left;
+    target.trim_right = bundle_unmerged[idx].trim_right;
+    target.hotspots_only = bundle_unmerged[idx].hotspots_only;
+    target.read_mismatch_limit = bundle_unmerged[idx].read_mismatch_limit;
+  }
+
+  merged.resize(num_merged);
+  for (size_t idx = 0; idx < num_merged; ++idx) {
+    merged[idx].chr = bundle_merged[idx].chr;
+    merged[idx].begin = bundle_merged[idx].begin;
+    merged[idx].end = bundle_merged[idx].end;
+    merged[idx].first_unmerged = bundle_merged[idx].first_unmerged;
+  }
+
+  // the index is used straight from the mapped bundle
+  size_t num_index_nodes = 0;
+  const IntervalIndexNode *index_nodes = bundle.Section<IntervalIndexNode>(BUNDLE_SECTION_TARGET_INDEX, num_index_nodes);
+  unmerged_index.Attach(index_nodes, num_index_nodes);
+
+  cout << "TargetsManager: Loaded targets file " << bundle.source_path(BUNDLE_SOURCE_TARGETS) << " from " << bundle.filename() << endl;
+  cout << "TargetsManager: " << num_unmerged << " target(s)";
+  if (num_merged != num_unmerged)
+    cout << " (" << num_merged << " after merging)";
+  cout << endl;
+
+  trim_ampliseq_primers = _trim_ampliseq_primers;
+  if (trim_ampliseq_primers)
+    cout << "TargetsManager: Trimming of AmpliSeq primers is enabled" << endl;
+}
+
+void TargetsManager::WriteToBundle(ReferenceBundleWriter& bundle) const
+{
+  vector<BundleTarget> bundle_unmerged(unmerged.size());
+  for (size_t idx = 0; idx < unmerged.size(); ++idx) {
+    bundle_unmerged[idx].chr = unmerged[idx].chr;
+    bundle_unmerged[idx].begin = unmerged[idx].begin;
+    bundle_unmerged[idx].end = unmerged[idx].end;
+    bundle_unmerged[idx].merged = unmerged[idx].merged;
+    bundle_unmerged[idx].trim_left = unmerged[idx].trim_left;
+    bundle_unmerged[idx].trim_right = unmerged[idx].trim_right;
+    bundle_unmerged[idx].hotspots_only = unmerged[idx].hotspots_only;
+    bundle_unmerged[idx].read_mismatch_limit = unmerged[idx].read_mismatch_limit;
+    bundle_unmerged[idx].name = bundle.AddString(unmerged[idx].name);
+  }
+  bundle.SetSection(BUNDLE_SECTION_TARGETS, bundle_unmerged);
+
+  vector<BundleMergedTarget> bundle_merged(merged.size());
+  for (size_t idx = 0; idx < merged.size(); ++idx) {
+    bundle_merged[idx].chr = merged[idx].chr;
+    bundle_merged[idx].begin = merged[idx].begin;
+    bundle_merged[idx].end = merged[idx].end;
+    bundle_merged[idx].first_unmerged = merged[idx].first_unmerged;
+  }
+  bundle.SetSection(BUNDLE_SECTION_MERGED_TARGETS, bundle_merged);
+
+  vector<IntervalIndexNode> index_nodes(unmerged_index.nodes(), unmerged_index.nodes() + unmerged_index.num_nodes());
+  bundle.SetSection(BUNDLE_SECTION_TARGET_INDEX, index_nodes);
+}
+
+void TargetsManager::IndexTargets()
+{
+  unmerged_index.Clear();
+  for (int idx = 0; idx < (int)unmerged.size(); ++idx)
+    unmerged_index.Add(unmerged[idx].chr, unmerged[idx].begin, unmerged[idx].end, idx);
+  unmerged_index.Build();
+}
+
 // -------------------------------------------------------------------------------------
 
 void TargetsManager::LoadRawTargets(const ReferenceReader& ref_reader, const string& bed_filename, list<UnmergedTarget>& raw_targets)
@@ -280,7 +372,7 @@ int TargetsManager::ReportHotspotsOnly(const MergedTarget &merged, int chr, long
 
 // -------------------------------------------------------------------------------------
 
-void TargetsManager::GetBestTargetIndex(Alignment *rai, int unmerged_target_hint, int& best_target_idx, int& best_fit_penalty, int& best_overlap) const
+void TargetsManager::GetBestTargetIndex(Alignment *rai, int& best_target_idx, int& best_fit_penalty, int& best_overlap) const
 {
 
   // set these before any trimming
@@ -288,16 +380,12 @@ void TargetsManager::GetBestTargetIndex(Alignment *rai, int unmerged_target_hint
   rai->align_end = rai->alignment.GetEndPosition(false, true);
   rai->old_cigar = rai->alignment.CigarData;
 
-  // Step 1: Find the first potential target region
+  // Step 1: Find all target regions the read overlaps, in target order.
+  // Targets the read only touches or misses cannot be picked below, so they are not looked at.
+  // The index also finds long targets enclosing shorter ones ahead of the read.
 
-  int target_idx = unmerged_target_hint;
-  while (target_idx and (rai->alignment.RefID < unmerged[target_idx].chr or
-          (rai->alignment.RefID == unmerged[target_idx].chr and rai->alignment.Position < unmerged[target_idx].end)))
-    --target_idx;
-
-  while (target_idx < (int)unmerged.size() and (rai->alignment.RefID > unmerged[target_idx].chr or
-          (rai->alignment.RefID == unmerged[target_idx].chr and rai->alignment.Position >= unmerged[target_idx].end)))
-    ++target_idx;
+  vector<int> candidates;
+  unmerged_index.Overlaps(rai->alignment.RefID, rai->alignment.Position, rai->end, candidates);
 
 
   // Step 2: Iterate over potential target regions, evaluate fit, pick the best fit
@@ -305,7 +393,8 @@ void TargetsManager::GetBestTargetIndex(Alignment *rai, int unmerged_target_hint
   best_fit_penalty = 100;
   best_overlap = 0;
 
-  while (target_idx < (int)unmerged.size() and rai->alignment.RefID == unmerged[target_idx].chr and rai->end >= unmerged[target_idx].begin) {
+  for (vector<int>::const_iterator candidate = candidates.begin(); candidate != candidates.end(); ++candidate) {
+    int target_idx = *candidate;
 
     int read_start = rai->alignment.Position;
     int read_end = rai->end;
@@ -339,8 +428,6 @@ void TargetsManager::GetBestTargetIndex(Alignment *rai, int unmerged_target_hint
       best_target_idx = target_idx;
       best_overlap = overlap;
     }
-
-    ++target_idx;
   }
   if (rai->target_coverage_indices.size() > 1){
     sort(rai->target_coverage_indices.begin(), rai->target_coverage_indices.end());
@@ -348,12 +435,12 @@ void TargetsManager::GetBestTargetIndex(Alignment *rai, int unmerged_target_hint
 }
 
 
-void TargetsManager::TrimAmpliseqPrimers(Alignment *rai, int unmerged_target_hint) const
+void TargetsManager::TrimAmpliseqPrimers(Alignment *rai) const
 {
   int best_target_idx = -1;
   int best_fit_penalty = 100;
   int best_overlap = 0;
-  GetBestTargetIndex(rai, unmerged_target_hint, best_target_idx, best_fit_penalty, best_overlap);
+  GetBestTargetIndex(rai, best_target_idx, best_fit_penalty, best_overlap);
 
   if (best_target_idx < 0 or rai->target_coverage_indices.empty()){
 	  rai->filtered = true;
@@ -518,13 +605,13 @@ void TargetsManager::TrimAmpliseqPrimers(Alignment *rai, int unmerged_target_hin
 // Filter out a read if any of the following conditions is satisfied
 // a) The read does not cover any region.
 // b) The coverage ratio at the best region < min_coverage_ratio.
-bool TargetsManager::FilterReadByRegion(Alignment* rai, int unmerged_target_hint) const
+bool TargetsManager::FilterReadByRegion(Alignment* rai) const
 {
 	bool is_filtered_out = false;
 	int best_target_idx = -1;
 	int best_fit_penalty = 100;
 	int best_overlap = 0;
-	GetBestTargetIndex(rai, unmerged_target_hint, best_target_idx, best_fit_penalty, best_overlap);
+	GetBestTargetIndex(rai, best_target_idx, best_fit_penalty, best_overlap);
 
 	// Filter out the read if it does not cover any region.
 	if (best_target_idx < 0 or rai->target_coverage_indices.empty()){
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <fstream>
 #include "ReferenceReader.h"
+#include "IntervalIndex.h"
 
 struct Alignment;
 
@@ -37,6 +38,8 @@ public:
   ~TargetsManager();
 
   void Initialize(const ReferenceReader& ref_reader, const string& _targets, float min_cov_frac = 0.0f, bool _trim_ampliseq_primers = false);
+  void Initialize(const ReferenceBundle& bundle, float min_cov_frac = 0.0f, bool _trim_ampliseq_primers = false);
+  void WriteToBundle(ReferenceBundleWriter& bundle) const;
 
   struct UnmergedTarget {
     int          chr    = 0;
@@ -54,20 +57,23 @@ public:
 
   void LoadRawTargets(const ReferenceReader& ref_reader, const string& bed_filename, list<UnmergedTarget>& raw_targets);
   void ParseBedInfoField(UnmergedTarget& target, const string info);
-  void TrimAmpliseqPrimers(Alignment *rai, int unmerged_target_hint) const;
-  void GetBestTargetIndex(Alignment *rai, int unmerged_target_hint, int& best_target_idx, int& best_fit_penalty, int& best_overlap) const;
-  bool FilterReadByRegion(Alignment* rai, int unmerged_target_hint) const;
+  void TrimAmpliseqPrimers(Alignment *rai) const;
+  void GetBestTargetIndex(Alignment *rai, int& best_target_idx, int& best_fit_penalty, int& best_overlap) const;
+  bool FilterReadByRegion(Alignment* rai) const;
   void AddCoverageToRegions(const map<int, TargetStat>& stat_of_targets);
   void WriteTargetsCoverage(const string& file_path, const ReferenceReader& ref_reader) const;
   int  ReportHotspotsOnly(const MergedTarget &merged, int chr, long pos);
 
   vector<UnmergedTarget>  unmerged;
   vector<MergedTarget>    merged;
+  IntervalIndex           unmerged_index;   // ids are indices into unmerged
   bool  trim_ampliseq_primers;
 
-  // The following variables are just for bool FilterReadByRegion(Alignment* rai, int recent_target) use only.
+  // The following variables are just for bool FilterReadByRegion(Alignment* rai) use only.
   float min_coverage_fraction;
 private:
+  void IndexTargets();
+
   pthread_mutex_t coverage_counter_mutex_;
 };
 
@@ -17,6 +17,7 @@
 #include "InputStructures.h"
 #include "HandleVariant.h"
 #include "ReferenceReader.h"
+#include "ReferenceBundle.h"
 #include "OrderedVCFWriter.h"
 #include "BAMWalkerEngine.h"
 #include "SampleManager.h"
@@ -67,11 +68,22 @@ static int main_tvc(int argc, char* argv[])
   // Read parameters and create output directories
   ExtendParameters parameters(argc, argv);
 
+  // Sequence, targets and hotspots parsed ahead of time and shared between tvc processes
+  ReferenceBundle ref_bundle;
+  if (not parameters.reference_bundle.empty())
+    ref_bundle.Open(parameters.reference_bundle, parameters.fasta);
+
   ReferenceReader ref_reader;
-  ref_reader.Initialize(parameters.fasta);
+  if (ref_bundle.is_open())
+    ref_reader.Initialize(ref_bundle);
+  else
+    ref_reader.Initialize(parameters.fasta);
 
   TargetsManager targets_manager;
-  targets_manager.Initialize(ref_reader, parameters.targets, parameters.min_cov_fraction, parameters.trim_ampliseq_primers);
+  if (ref_bundle.HasSource(BUNDLE_SOURCE_TARGETS, parameters.targets))
+    targets_manager.Initialize(ref_bundle, parameters.min_cov_fraction, parameters.trim_ampliseq_primers);
+  else
+    targets_manager.Initialize(ref_reader, parameters.targets, parameters.min_cov_fraction, parameters.trim_ampliseq_primers);
 
   BAMWalkerEngine bam_walker;
   bam_walker.Initialize(ref_reader, targets_manager, parameters.bams, parameters.postprocessed_bam, parameters.prefixExclusion);
@@ -100,10 +112,16 @@ static int main_tvc(int argc, char* argv[])
   OrderedBAMWriter bam_writer;
 
   HotspotReader hotspot_reader;
-  hotspot_reader.Initialize(ref_reader, parameters.variantPriorsFile);
+  if (ref_bundle.HasSource(BUNDLE_SOURCE_HOTSPOTS, parameters.variantPriorsFile))
+    hotspot_reader.Initialize(ref_reader, ref_bundle);
+  else
+    hotspot_reader.Initialize(ref_reader, parameters.variantPriorsFile);
   if (!parameters.blacklistFile.empty()) {
     if (parameters.variantPriorsFile.empty()) {hotspot_reader.Initialize(ref_reader);}
-    hotspot_reader.MakeHintQueue(parameters.blacklistFile);
+    if (ref_bundle.HasSource(BUNDLE_SOURCE_SSE, parameters.blacklistFile))
+      hotspot_reader.LoadHints(ref_bundle, BUNDLE_SECTION_SSE_HINTS);
+    else
+      hotspot_reader.MakeHintQueue(parameters.blacklistFile);
   }
   string parameters_file = parameters.opts.GetFirstString('-', "parameters-file", "");
 
@@ -389,7 +407,7 @@ void * VariantCallerWorker(void *input)
         }
 
         // 3) Filter by target and Trim ampliseq primer here
-        vc.targets_manager->TrimAmpliseqPrimers(new_read[i], vc.bam_walker->GetRecentUnmergedTarget());
+        vc.targets_manager->TrimAmpliseqPrimers(new_read[i]);
         if (new_read[i]->filtered)
           continue;
 
@@ -0,0 +1,140 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+
+#include "tvcutils.h"
+
+#include <string>
+#include <iostream>
+#include <stdio.h>
+#include <time.h>
+
+#include "OptArgs.h"
+#include "IonVersion.h"
+#include "ReferenceReader.h"
+#include "ReferenceBundle.h"
+#include "TargetsManager.h"
+#include "HotspotReader.h"
+
+using namespace std;
+
+
+void BuildBundleHelp()
+{
+  printf ("\n");
+  printf ("tvcutils %s-%s (%s) - Miscellaneous tools used by Torrent Variant Caller plugin and workflow.\n",
+      IonVersion::GetVersion().c_str(), IonVersion::GetRelease().c_str(), IonVersion::GetGitHash().c_str());
+  printf ("\n");
+  printf ("Usage:   tvcutils build_bundle [options]\n");
+  printf ("\n");
+  printf ("Precompile the inputs tvc parses at startup into one file that every tvc process maps read-only (tvc --reference-bundle).\n");
+  printf ("tvc uses the targets and hotspots from the bundle only if it is given the same, unchanged files.\n");
+  printf ("\n");
+  printf ("General options:\n");
+  printf ("  -r,--reference                 FILE       FASTA file containing reference genome (required)\n");
+  printf ("  -o,--output-bundle             FILE       reference bundle to write (required)\n");
+  printf ("  -t,--target-file               FILE       target regions BED file, as passed to tvc [optional]\n");
+  printf ("  -c,--input-vcf                 FILE       hotspots VCF file, as passed to tvc [optional]\n");
+  printf ("  -l,--sse-vcf                   FILE       sse VCF file, as passed to tvc [optional]\n");
+  printf ("\n");
+}
+
+
+int BuildBundle(int argc, const char *argv[])
+{
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  string reference      = opts.GetFirstString ('r', "reference", "");
+  string output_bundle  = opts.GetFirstString ('o', "output-bundle", "");
+  string targets        = opts.GetFirstString ('t', "target-file", "");
+  string hotspots_vcf   = opts.GetFirstString ('c', "input-vcf", "");
+  string sse_vcf        = opts.GetFirstString ('l', "sse-vcf", "");
+  opts.CheckNoLeftovers();
+
+  if (reference.empty() or output_bundle.empty()) {
+    BuildBundleHelp();
+    return 1;
+  }
+
+  time_t start_time = time(NULL);
+
+  ReferenceReader ref_reader;
+  ref_reader.Initialize(reference);
+
+  ReferenceBundleWriter bundle;
+  bundle.SetReference(ref_reader);
+
+  if (not targets.empty()) {
+    TargetsManager targets_manager;
+    targets_manager.Initialize(ref_reader, targets);
+    targets_manager.WriteToBundle(bundle);
+    bundle.SetSource(BUNDLE_SOURCE_TARGETS, targets);
+  }
+
+  if (not hotspots_vcf.empty()) {
+    HotspotReader hotspot_reader;
+    hotspot_reader.Initialize(ref_reader, hotspots_vcf);
+    hotspot_reader.WriteToBundle(bundle);
+    bundle.SetSource(BUNDLE_SOURCE_HOTSPOTS, hotspots_vcf);
+  }
+
+  if (not sse_vcf.empty()) {
+    HotspotReader sse_reader;
+    sse_reader.Initialize(ref_reader);
+    sse_reader.MakeHintQueue(sse_vcf);
+    sse_reader.WriteHintsToBundle(bundle, BUNDLE_SECTION_SSE_HINTS);
+    bundle.SetSource(BUNDLE_SOURCE_SSE, sse_vcf);
+  }
+
+  if (not bundle.Write(output_bundle))
+    return 1;
+
+  cout << "build_bundle: Wrote " << output_bundle << " for " << ref_reader.chr_count() << " chromosome(s) in "
+       << (time(NULL) - start_time) << " seconds" << endl;
+  return 0;
+}
+
+
+void PackReferenceHelp()
+{
+  printf ("\n");
+  printf ("tvcutils %s-%s (%s) - Miscellaneous tools used by Torrent Variant Caller plugin and workflow.\n",
+      IonVersion::GetVersion().c_str(), IonVersion::GetRelease().c_str(), IonVersion::GetGitHash().c_str());
+  printf ("\n");
+  printf ("Usage:   tvcutils pack_reference [options]\n");
+  printf ("\n");
+  printf ("Write a 4 bit packed copy of the reference next to it (<reference>%s).\n", PACKED_REFERENCE_SUFFIX);
+  printf ("tvc and tvcutils use it instead of the fasta text as long as the fasta is unchanged.\n");
+  printf ("\n");
+  printf ("General options:\n");
+  printf ("  -r,--reference                 FILE       FASTA file containing reference genome (required)\n");
+  printf ("  -o,--output-pack               FILE       packed reference to write [<reference>%s]\n", PACKED_REFERENCE_SUFFIX);
+  printf ("\n");
+}
+
+
+int PackReference(int argc, const char *argv[])
+{
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  string reference      = opts.GetFirstString ('r', "reference", "");
+  string output_pack    = opts.GetFirstString ('o', "output-pack", "");
+  opts.CheckNoLeftovers();
+
+  if (reference.empty()) {
+    PackReferenceHelp();
+    return 1;
+  }
+  if (output_pack.empty())
+    output_pack = reference + PACKED_REFERENCE_SUFFIX;
+
+  time_t start_time = time(NULL);
+
+  ReferenceReader ref_reader;
+  ref_reader.Initialize(reference);
+
+  if (not WritePackedReference(ref_reader, output_pack))
+    return 1;
+
+  cout << "pack_reference: Wrote " << output_pack << " for " << ref_reader.chr_count() << " chromosome(s) in "
+       << (time(NULL) - start_time) << " seconds" << endl;
+  return 0;
+}
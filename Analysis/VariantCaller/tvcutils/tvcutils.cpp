@@ -26,6 +26,8 @@ void TVCUtilsHelp()
   printf ("         validate_bed      Validate targets or hotspots file\n");
   printf ("         unify_vcf         Unify variants and annotations from all sources (tvc,IndelAssembly,hotpots)\n");
   printf ("         split_vcf         Split multisample vcf file into single sample vcf files\n");
+  printf ("         build_bundle      Precompile reference, targets and hotspots for tvc --reference-bundle\n");
+  printf ("         pack_reference    Write the 4 bit packed reference that tvc maps when it is present\n");
   printf ("\n");
 }
 
@@ -44,6 +46,8 @@ int main(int argc, const char *argv[])
   else if (tvcutils_command == "validate_bed") return ValidateBed(argc-1, argv+1);
   else if (tvcutils_command == "unify_vcf") return UnifyVcf(argc-1, argv+1);
   else if (tvcutils_command == "split_vcf") return SplitVcf(argc-1, argv+1);
+  else if (tvcutils_command == "build_bundle") return BuildBundle(argc-1, argv+1);
+  else if (tvcutils_command == "pack_reference") return PackReference(argc-1, argv+1);
   else {
       fprintf(stderr, "ERROR: unrecognized tvcutils command '%s'\n", tvcutils_command.c_str());
       return 1;
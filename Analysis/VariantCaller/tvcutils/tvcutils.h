@@ -7,5 +7,7 @@ int PrepareHotspots(int argc, const char *argv[]);
 int ValidateBed(int argc, const char *argv[]);
 int UnifyVcf(int argc, const char *argv[]);
 int SplitVcf(int argc, const char *argv[]);
+int BuildBundle(int argc, const char *argv[]);
+int PackReference(int argc, const char *argv[]);
 
 #endif // TVCUTILS_H
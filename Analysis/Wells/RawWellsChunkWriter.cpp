@@ -0,0 +1,260 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include "RawWellsChunkWriter.h"
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#if !H5_VERSION_GE(1,10,3)
+#include "hdf5_hl.h"
+#endif
+#include "IonErr.h"
+
+using namespace std;
+
+RawWellsChunkWriter::RawWellsChunkWriter(int numThreads)
+{
+  mNumThreads = numThreads > 0 ? numThreads : 1;
+  mQuit = false;
+  mBlock = NULL;
+  mNumCols = 0;
+  mSaveAsUShort = false;
+  mLower = -5.0f;
+  mUpper = 28.0f;
+  mNextJob = mNextWrite = 0;
+  mMaxAhead = 4 * mNumThreads;
+  mDeflateLevel = 0;
+  for (int i = 0; i < 3; i++) {
+    mDims[i] = mChunkDims[i] = 0;
+  }
+  mChunksWritten = 0;
+  mRawBytes = mStoredBytes = 0.0;
+  mCompressSeconds = mWriteSeconds = 0.0;
+
+  pthread_mutex_init(&mMutex, NULL);
+  pthread_cond_init(&mWorkReady, NULL);
+  pthread_cond_init(&mJobDone, NULL);
+  for (int i = 0; i < mNumThreads; i++) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, CompressThread, this) == 0) {
+      mThreads.push_back(t);
+    }
+    else {
+      fprintf(stderr, "RawWellsChunkWriter: error starting thread\n");
+    }
+  }
+}
+
+RawWellsChunkWriter::~RawWellsChunkWriter()
+{
+  pthread_mutex_lock(&mMutex);
+  mQuit = true;
+  pthread_cond_broadcast(&mWorkReady);
+  pthread_mutex_unlock(&mMutex);
+  for (size_t i = 0; i < mThreads.size(); i++) {
+    pthread_join(mThreads[i], NULL);
+  }
+  pthread_cond_destroy(&mJobDone);
+  pthread_cond_destroy(&mWorkReady);
+  pthread_mutex_destroy(&mMutex);
+}
+
+bool RawWellsChunkWriter::Init(RWH5DataSet &dataSet)
+{
+  if (mThreads.empty() || dataSet.mDataset < 0) {
+    return false;
+  }
+  hid_t plist = H5Dget_create_plist(dataSet.mDataset);
+  bool ok = H5Pget_layout(plist) == H5D_CHUNKED && H5Pget_chunk(plist, 3, mChunkDims) == 3;
+  int nfilters = ok ? H5Pget_nfilters(plist) : 0;
+  mDeflateLevel = 0;
+  if (ok && nfilters == 1) {
+    unsigned int flags = 0, config = 0;
+    unsigned int cd_values[4] = {0, 0, 0, 0};
+    size_t nelmts = 4;
+    char name[64];
+    H5Z_filter_t filter = H5Pget_filter2(plist, 0, &flags, &nelmts, cd_values, sizeof(name), name, &config);
+    if (filter == H5Z_FILTER_DEFLATE && nelmts > 0) {
+      mDeflateLevel = cd_values[0];
+    }
+    else {
+      ok = false;
+    }
+  }
+  else if (nfilters > 1) {
+    ok = false;
+  }
+  H5Pclose(plist);
+
+  if (ok) {
+    ok = H5Sget_simple_extent_ndims(dataSet.mDataspace) == 3 &&
+         H5Sget_simple_extent_dims(dataSet.mDataspace, mDims, NULL) == 3;
+  }
+  // chunk bytes are handed to hdf5 as is, so the file type has to be the native one we fill in
+  if (ok) {
+    ok = H5Tget_size(dataSet.mDatatype) == (dataSet.mSaveAsUShort ? sizeof(unsigned short) : sizeof(float));
+  }
+  mSaveAsUShort = dataSet.mSaveAsUShort;
+  mLower = dataSet.mLower;
+  mUpper = dataSet.mUpper;
+  return ok;
+}
+
+bool RawWellsChunkWriter::CanWrite(const WellChunk &wellChunk) const
+{
+  if (mChunkDims[2] == 0) {
+    return false;
+  }
+  bool wholeChip = wellChunk.rowStart + wellChunk.rowHeight == mDims[0] &&
+                   wellChunk.colStart + wellChunk.colWidth == mDims[1];
+  bool wholeChunks = wellChunk.flowStart % mChunkDims[2] == 0 &&
+                     (wellChunk.flowDepth == mChunkDims[2] ||
+                      (wellChunk.flowDepth < mChunkDims[2] && wellChunk.flowStart + wellChunk.flowDepth == mDims[2]));
+  return wholeChip && wholeChunks;
+}
+
+void *RawWellsChunkWriter::CompressThread(void *arg)
+{
+  RawWellsChunkWriter *me = (RawWellsChunkWriter *)arg;
+  pthread_mutex_lock(&me->mMutex);
+  while (true) {
+    while (!me->mQuit &&
+           (me->mBlock == NULL || me->mNextJob >= me->mJobs.size() ||
+            me->mNextJob >= me->mNextWrite + me->mMaxAhead)) {
+      pthread_cond_wait(&me->mWorkReady, &me->mMutex);
+    }
+    if (me->mQuit) {
+      break;
+    }
+    ChunkJob &job = me->mJobs[me->mNextJob++];
+    pthread_mutex_unlock(&me->mMutex);
+
+    me->PackAndCompress(job);
+
+    pthread_mutex_lock(&me->mMutex);
+    job.done = true;
+    pthread_cond_broadcast(&me->mJobDone);
+  }
+  pthread_mutex_unlock(&me->mMutex);
+  return NULL;
+}
+
+void RawWellsChunkWriter::PackAndCompress(ChunkJob &job)
+{
+  Timer tmr;
+  const WellChunk &block = mBlock->wellChunk;
+  size_t chunkRows = mChunkDims[0], chunkCols = mChunkDims[1], chunkFlows = mChunkDims[2];
+  size_t rowEnd = min((size_t)(job.offset[0] + chunkRows), (size_t)mDims[0]);
+  size_t colEnd = min((size_t)(job.offset[1] + chunkCols), (size_t)mDims[1]);
+  size_t flowDepth = block.flowDepth;
+  size_t numElements = chunkRows * chunkCols * chunkFlows;
+
+  // edge chunks are stored at full size, the part outside the dataset is never read
+  vector<unsigned char> raw(numElements * (mSaveAsUShort ? sizeof(unsigned short) : sizeof(float)), 0);
+  unsigned short *ushortOut = (unsigned short *)&raw[0];
+  float *floatOut = (float *)&raw[0];
+  WellsConverter converter(mLower, mUpper);
+  for (size_t row = job.offset[0]; row < rowEnd; row++) {
+    for (size_t col = job.offset[1]; col < colEnd; col++) {
+      int32_t wellIx = mBlock->indexes[row * mNumCols + col];
+      size_t out = ((row - job.offset[0]) * chunkCols + (col - job.offset[1])) * chunkFlows;
+      for (size_t fIx = 0; fIx < flowDepth; fIx++) {
+        // wells outside the subset are written as zeros, as in RawWells::At()
+        float val = wellIx >= 0 ? mBlock->flowData[(uint64_t)wellIx * flowDepth + fIx] : 0.0f;
+        if (mSaveAsUShort) {
+          ushortOut[out + fIx] = converter.FloatToUInt16(val);
+        }
+        else {
+          floatOut[out + fIx] = val;
+        }
+      }
+    }
+  }
+
+  if (mDeflateLevel > 0) {
+    uLongf len = compressBound(raw.size());
+    job.data.resize(len);
+    if (compress2(&job.data[0], &len, &raw[0], raw.size(), mDeflateLevel) != Z_OK) {
+      ION_ABORT("ERROR - Failed to compress wells chunk at: " + ToStr(job.offset[0]) + "," + ToStr(job.offset[1]) + "," + ToStr(job.offset[2]));
+    }
+    job.data.resize(len);
+  }
+  else {
+    job.data.swap(raw);
+  }
+  job.seconds = tmr.elapsed();
+}
+
+int RawWellsChunkWriter::Write(RWH5DataSet &dataSet, ChunkFlowData &chunkData, size_t numCols)
+{
+  const WellChunk &block = chunkData.wellChunk;
+  size_t elementSize = mSaveAsUShort ? sizeof(unsigned short) : sizeof(float);
+  size_t chunkBytes = mChunkDims[0] * mChunkDims[1] * mChunkDims[2] * elementSize;
+
+  pthread_mutex_lock(&mMutex);
+  mJobs.clear();
+  for (hsize_t row = 0; row < mDims[0]; row += mChunkDims[0]) {
+    for (hsize_t col = 0; col < mDims[1]; col += mChunkDims[1]) {
+      ChunkJob job;
+      job.offset[0] = row;
+      job.offset[1] = col;
+      job.offset[2] = block.flowStart;
+      job.done = false;
+      job.seconds = 0.0;
+      mJobs.push_back(job);
+    }
+  }
+  mBlock = &chunkData;
+  mNumCols = numCols;
+  mNextJob = 0;
+  mNextWrite = 0;
+  pthread_cond_broadcast(&mWorkReady);
+
+  // hdf5 gets the chunks in file order from this thread only
+  int error = 0;
+  for (size_t i = 0; i < mJobs.size(); i++) {
+    while (!mJobs[i].done) {
+      pthread_cond_wait(&mJobDone, &mMutex);
+    }
+    ChunkJob &job = mJobs[i];
+    pthread_mutex_unlock(&mMutex);
+
+    Timer tmr;
+    if (error == 0) {
+      uint32_t filterMask = 0;
+#if H5_VERSION_GE(1,10,3)
+      herr_t status = H5Dwrite_chunk(dataSet.mDataset, H5P_DEFAULT, filterMask, job.offset, job.data.size(), &job.data[0]);
+#else
+      herr_t status = H5DOwrite_chunk(dataSet.mDataset, H5P_DEFAULT, filterMask, job.offset, job.data.size(), &job.data[0]);
+#endif
+      if (status < 0) {
+        ION_WARN("ERROR - Unsuccessful chunk write to file: " + ToStr(job.offset[0]) + "," + ToStr(job.offset[1]) + " x " +
+                 ToStr(block.flowStart) + "," + ToStr(block.flowDepth) + "\t" + dataSet.mName);
+        error = 1;
+      }
+    }
+    double seconds = tmr.elapsed();
+
+    pthread_mutex_lock(&mMutex);
+    mChunksWritten++;
+    mRawBytes += chunkBytes;
+    mStoredBytes += job.data.size();
+    mCompressSeconds += job.seconds;
+    mWriteSeconds += seconds;
+    vector<unsigned char>().swap(job.data);
+    mNextWrite = i + 1;
+    pthread_cond_broadcast(&mWorkReady);
+  }
+  mBlock = NULL;
+  mJobs.clear();
+  pthread_mutex_unlock(&mMutex);
+  return error;
+}
+
+void RawWellsChunkWriter::PrintSummary(FILE *fp)
+{
+  pthread_mutex_lock(&mMutex);
+  fprintf(fp, "SaveWells: %zu chunks written directly, %.1f MB -> %.1f MB (deflate %d), compress %.2f sec on %d threads, write %.2f sec\n",
+          mChunksWritten, mRawBytes / (1024.0 * 1024.0), mStoredBytes / (1024.0 * 1024.0), mDeflateLevel,
+          mCompressSeconds, mNumThreads, mWriteSeconds);
+  fflush(fp);
+  pthread_mutex_unlock(&mMutex);
+}
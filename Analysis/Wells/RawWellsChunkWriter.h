@@ -0,0 +1,80 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef RAWWELLSCHUNKWRITER_H
+#define RAWWELLSCHUNKWRITER_H
+
+#include <vector>
+#include <pthread.h>
+#include "hdf5.h"
+#include "RawWells.h"
+
+/**
+ * Writes blocks of flows to the wells dataset as whole, already compressed
+ * HDF5 chunks. Packing and deflating the chunks runs on a pool of threads
+ * while the calling thread hands finished chunks to HDF5 in order with a
+ * direct chunk write, so the file is identical in format to one written
+ * through the deflate filter and reads back with RawWells::OpenForRead.
+ */
+class RawWellsChunkWriter {
+ public:
+  RawWellsChunkWriter(int numThreads);
+  ~RawWellsChunkWriter();
+
+  /**
+   * Look up chunk shape and filters of an open wells dataset. Returns false
+   * if its chunks can not be written directly (filters other than deflate).
+   */
+  bool Init(RWH5DataSet &dataSet);
+
+  /** True if the block covers whole chunks in the flow dimension and the whole chip. */
+  bool CanWrite(const WellChunk &wellChunk) const;
+
+  /**
+   * Write the block held by chunkData, laid out as in the ChunkyWells write
+   * queue. Returns 0 if no error and nonzero if error, like RawWellsWriter.
+   */
+  int Write(RWH5DataSet &dataSet, ChunkFlowData &chunkData, size_t numCols);
+
+  void PrintSummary(FILE *fp);
+
+ private:
+  struct ChunkJob {
+    hsize_t offset[3];
+    std::vector<unsigned char> data;  ///< compressed (or raw) chunk bytes
+    bool done;
+    double seconds;
+  };
+
+  static void *CompressThread(void *arg);
+  void PackAndCompress(ChunkJob &job);
+
+  int mNumThreads;
+  std::vector<pthread_t> mThreads;
+  pthread_mutex_t mMutex;
+  pthread_cond_t mWorkReady;
+  pthread_cond_t mJobDone;
+  bool mQuit;
+
+  // the block being written
+  ChunkFlowData *mBlock;
+  size_t mNumCols;
+  bool mSaveAsUShort;
+  float mLower;
+  float mUpper;
+  std::vector<ChunkJob> mJobs;
+  size_t mNextJob;     ///< next job to be claimed by a compress thread
+  size_t mNextWrite;   ///< next job to be written, jobs run at most mMaxAhead past it
+  size_t mMaxAhead;
+
+  hsize_t mDims[3];
+  hsize_t mChunkDims[3];
+  int mDeflateLevel;
+
+  // bookkeeping for the summary
+  size_t mChunksWritten;
+  double mRawBytes;
+  double mStoredBytes;
+  double mCompressSeconds;
+  double mWriteSeconds;
+};
+
+#endif // RAWWELLSCHUNKWRITER_H
@@ -19,6 +19,8 @@ AmpliconRegionStatistics::AmpliconRegionStatistics( const BamTools::RefVector& r
 	, m_maxE2eEndDist(2)
 	, m_sigFacCoverage(0)
 	, m_regionStackSize(32)
+	, m_clockSeed(0)
+	, m_lastRefID(0)
 {
 	m_regionStack = (TargetRegion **)malloc( m_regionStackSize * sizeof(TargetRegion *) );
 }
@@ -79,13 +81,10 @@ AmpliconRegionStatistics::StatsData *AmpliconRegionStatistics::GetStats( TargetR
 
 void AmpliconRegionStatistics::TrackReadsOnRegion( const BamTools::BamAlignment &aread, uint32_t endPos )
 {
-	// pseudo-random number generator 'seed' for resolving equivalent read assignments
-	static uint16_t clockSeed = 0;
-	static int32_t lastRefID = 0;
-	// always reset clockSeed for new contig to allow consistency with BAM split up by contig vs. whole
-	if( lastRefID != aread.RefID ) {
-		clockSeed = 0;
-		lastRefID = aread.RefID;
+	// always reset m_clockSeed for new contig to allow consistency with BAM split up by contig vs. whole
+	if( m_lastRefID != aread.RefID ) {
+		m_clockSeed = 0;
+		m_lastRefID = aread.RefID;
 	}
 	// check/set first region read overlaps
 	uint32_t readSrt = aread.Position + 1;
@@ -153,7 +152,7 @@ void AmpliconRegionStatistics::TrackReadsOnRegion( const BamTools::BamAlignment
 			}
 		}
 		// pseudo-randomly choose best region of equivalent best regions
-		TargetRegion *bestRegion = m_regionStack[ clockSeed % numBestRegions ];
+		TargetRegion *bestRegion = m_regionStack[ m_clockSeed % numBestRegions ];
 		m_lastRegionAssigned = bestRegion;
 		bool e2e_or_cov;
 		if( m_sigFacCoverage ) {
@@ -177,7 +176,7 @@ void AmpliconRegionStatistics::TrackReadsOnRegion( const BamTools::BamAlignment
 			if( e2e_or_cov ) ++stats->fwd_e2e;
 		}
 	}
-	++clockSeed;
+	++m_clockSeed;
 }
 
 // Create the statistics line per region
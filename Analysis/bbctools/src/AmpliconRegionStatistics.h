@@ -51,6 +51,9 @@ class AmpliconRegionStatistics: public RegionCoverage
         double   m_sigFacCoverage;
         uint32_t m_regionStackSize;
         TargetRegion **m_regionStack;
+        // pseudo-random number generator 'seed' for resolving equivalent read assignments
+        uint16_t m_clockSeed;
+        int32_t  m_lastRefID;
 
         StatsData *GetStats( TargetRegion *region );
 
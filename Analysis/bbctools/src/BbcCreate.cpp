@@ -14,6 +14,10 @@ const uint16_t s_versionNumber = 1000;
 const uint32_t s_wordSizeToggle = 2 * sizeof(uint16_t);
 const uint32_t s_recHeadSize = sizeof(uint16_t) + sizeof(uint32_t);
 const uint32_t s_flushAtIndexBlockSize = 100000;
+const uint32_t s_shardCopySize = 1 << 16;
+
+// 0 read length region, inserted where anchor points would fall on a 32bit boundary
+const uint16_t s_anchorNOP = 0x8000;
 
 BbcCreate::BbcCreate( const BamTools::RefVector& references, uint32_t bufferSize )
 	: m_references(references)
@@ -23,7 +27,8 @@ BbcCreate::BbcCreate( const BamTools::RefVector& references, uint32_t bufferSize
 	m_totalReads = m_contigReads = m_reads = m_wordsize = m_covtype = 0;
     m_srtPos = m_lstPos = m_curPos = m_curCov = m_curWsz = m_backWrdsz = m_backStep = 0;
     m_markAnchor = true;
-    m_printOutput = m_onTargetOnly = false;
+    m_printOutput = m_onTargetOnly = m_shard = false;
+    m_lastAnchorPos = 0;
     m_newContig = s_versionNumber;			// reset after first used
     m_contigIdx = references.size() + 1;	// forces initialization for first contig
 	m_buffer = (uint32_t *)malloc( 2 * m_bufsize * sizeof(uint32_t) );
@@ -35,16 +40,53 @@ BbcCreate::~BbcCreate()
 	free(m_buffer);
 }
 
-void BbcCreate::Close() {
-	if( m_reads ) {
-		FlushReads();
-		m_totalReads += m_contigReads;
-		m_reads = 0;
+bool BbcCreate::AppendShard( BbcCreate &shard )
+{
+	shard.FinishContig();
+	if( !m_bbcfile || !shard.m_bbcfile ) {
+		return false;
 	}
+	FILE *src = shard.m_bbcfile;
+	long srcEnd = ftell(src);
+	if( srcEnd > 0 ) {
+		rewind(src);
+		// the shard's leading contig marker is the version number if this is the first contig here
+		uint16_t marker;
+		if( fread( &marker, 1, sizeof(uint16_t), src ) != sizeof(uint16_t) ) {
+			return false;
+		}
+		fwrite( &m_newContig, 1, sizeof(uint16_t), m_bbcfile );
+		m_newContig = 0;
+		// copy up to each anchor in turn, to check if it lands on a 32bit boundary of this file
+		char buf[s_shardCopySize];
+		long srcPos = sizeof(uint16_t);
+		for( size_t i = 0; i <= shard.m_anchorOffsets.size(); ++i ) {
+			long copyEnd = i < shard.m_anchorOffsets.size() ? shard.m_anchorOffsets[i] : srcEnd;
+			while( srcPos < copyEnd ) {
+				size_t n = copyEnd - srcPos < s_shardCopySize ? copyEnd - srcPos : s_shardCopySize;
+				if( fread( buf, 1, n, src ) != n || fwrite( buf, 1, n, m_bbcfile ) != n ) {
+					return false;
+				}
+				srcPos += n;
+			}
+			if( i < shard.m_anchorOffsets.size() && !(ftell(m_bbcfile) & 0xFFFFFFFF) ) {
+				fwrite( &s_anchorNOP, 1, sizeof(uint16_t), m_bbcfile );
+			}
+		}
+	}
+	m_totalReads += shard.m_totalReads;
+	shard.Close();
+	return !ferror(m_bbcfile);
+}
+
+void BbcCreate::Close() {
+	FinishContig();
 	if( m_bbcfile ) {
 		fclose(m_bbcfile);
 		m_bbcfile = NULL;
 	}
+	m_anchorOffsets.clear();
+	m_shard = false;
 }
 
 void BbcCreate::CollectBaseCoverage(
@@ -172,6 +214,21 @@ bool BbcCreate::Open( const string &filename ) {
 	return true;
 }
 
+bool BbcCreate::OpenShard() {
+	Close();
+	if( !m_references.size() ) {
+		fprintf( stderr, "ERROR: Cannot create BBC file given empty list of reference contigs.\n");
+		return false;
+	}
+	m_bbcfile = tmpfile();
+	if( !m_bbcfile ) {
+		fprintf( stderr, "ERROR: Failed to open temporary file for BBC contig output.\n");
+		return false;
+	}
+	m_shard = true;
+	return true;
+}
+
 void BbcCreate::SetNoOffTargetPositions( bool hide )
 {
 	m_onTargetOnly = hide;
@@ -183,10 +240,17 @@ float BbcCreate::VersionNumber() {
 
 // ---- Private methods ----
 
+void BbcCreate::FinishContig()
+{
+	if( m_reads ) {
+		FlushReads();
+		m_totalReads += m_contigReads;
+		m_reads = 0;
+	}
+}
+
 void BbcCreate::FlushReads( bool markAnchor )
 {
-	static const uint16_t NOP = 0x8000;
-	static uint32_t s_lastAnchorPos = 0;
 	if( m_reads ) {
 		uint32_t ws = m_wordsize == 8 ? 3 : (m_wordsize >> 1);
 		if( m_bbcfile ) {
@@ -194,21 +258,24 @@ void BbcCreate::FlushReads( bool markAnchor )
 			// - only necessary where whole index block (100K) are covered (and typically no target regions)
 			if( (m_srtPos+m_reads-1)/s_flushAtIndexBlockSize > (m_srtPos-1)/s_flushAtIndexBlockSize ) {
 				// this saves need for unnecessary extra anchor insertions - e.g. 2-3K for AmpliSeq Exome
-				if( s_lastAnchorPos - m_srtPos > m_bufsize ) {
+				if( m_lastAnchorPos - m_srtPos > m_bufsize ) {
 					m_markAnchor = true;
 				}
 			}
 			// pack flag-pos.length.wordSizeCode.onTargetBit [+ anchor position]
 			uint16_t head = (m_reads << 3) | (ws << 1) | m_covtype;
 			if( m_markAnchor ) {
-				if( !(ftell(m_bbcfile) & 0xFFFFFFFF) ) {
+				if( m_shard ) {
+					// boundaries are those of the file the shard is appended to
+					m_anchorOffsets.push_back( ftell(m_bbcfile) );
+				} else if( !(ftell(m_bbcfile) & 0xFFFFFFFF) ) {
 					// anchor points must not be on 32bit boundary due to conflict with indexing
 					// (64bit wrap around vs. 0-coverage blocks). Insert NOP -> 0 read length region
-					fwrite( &NOP, 1, sizeof(uint16_t), m_bbcfile );
+					fwrite( &s_anchorNOP, 1, sizeof(uint16_t), m_bbcfile );
 				}
 				fwrite( &head, 1, sizeof(uint16_t), m_bbcfile );
 				fwrite( &m_srtPos, 1, sizeof(uint32_t), m_bbcfile );
-				s_lastAnchorPos = m_srtPos;
+				m_lastAnchorPos = m_srtPos;
 			} else {
 				head |= 0x8000;
 				fwrite( &head, 1, sizeof(uint16_t), m_bbcfile );
@@ -12,6 +12,7 @@
 #include "api/BamAux.h"
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include <cstdio>
 using namespace std;
@@ -29,6 +30,14 @@ class BbcCreate
 
 		bool Open( const string &filename );
 
+		// Open a temporary file to collect the coverage of a single contig, written by a thread of its own,
+		// for appending to the output BBC file with AppendShard(). No header is written to a shard.
+		bool OpenShard(void);
+
+		// Append the coverage collected by a shard to this file, exactly as if it was collected here.
+		// Shards must be appended in order of contig and the shard is left empty.
+		bool AppendShard( BbcCreate &shard );
+
 		void SetNoOffTargetPositions( bool hide = true );
 
 		float VersionNumber(void);
@@ -53,11 +62,14 @@ class BbcCreate
 		bool m_onTargetOnly;
 		bool m_markAnchor;
 		bool m_printOutput;
-
+		bool m_shard;
+		uint32_t m_lastAnchorPos;
+		vector<long> m_anchorOffsets;	// shard only: anchor placements still to be checked for NOPs
 
 		uint32_t *m_buffer;
 		FILE *m_bbcfile;
 
+		void FinishContig(void);
 		void FlushReads( bool markPosition = true );
 		void BackFlushReads(void);
 };
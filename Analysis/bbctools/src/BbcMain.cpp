@@ -22,6 +22,8 @@ using namespace BamTools;
 #include "BbcDepth.h"
 #include "TrackReads.h"
 
+#include <pthread.h>
+
 // Number alignments returned using SetRegion() appears incorrect when using closed regions!
 // It appears to work when using right-open regions but has MASSIVE performance issue.
 // Direct index Jump() works! (With care t avoid reviewing reads more than once.)
@@ -58,7 +60,7 @@ int main( int argc, char* argv[] ) {
 		subcmdFunc = &bbctools_create;
 		parseString =  "A=annotationFields:B=bbc:C=covStats:D=covDepths:E=e2eGap,L=minAlignLength,M=minPcCov;";
 		parseString += "O=readOrigin:P=primerLength,Q=minMAPQ,R=regions:S=sumStats:T=readType:a=autoCreateBamIndex ";
-		parseString += "b=onTargetBases c=coarse i=index d=noDups r=onTargetReads s=samdepth u=unique";
+		parseString += "b=onTargetBases c=coarse i=index d=noDups r=onTargetReads s=samdepth t=threads,u=unique";
 		maxArgs = 0;
 	} else if( subcmd == "report" ) {
 		subcmdFunc = &bbctools_report;
@@ -100,6 +102,321 @@ int main( int argc, char* argv[] ) {
     return status;
 }
 
+//
+// Functions used by bbctools create
+//
+
+// Type and loading options for region coverage collection
+struct RegionOptions {
+	string  readType;		// "" or "covdepth" for target loci and coverage at depths only
+	double  minPcCov;
+	int32_t primerLength;
+	int32_t maxE2eEndGap;
+	string  covDepths;
+	string  targetRegions;	// "" for whole contig targets
+	string  auxFieldIdx;
+};
+
+// Filtering options for streaming BAM alignments to coverage collectors
+struct StreamOptions {
+	uint32_t skipFlag;
+	uint16_t minMapQuality;
+	int32_t  minAlignLength;
+	bool     onlyOnTargetReads;
+	bool     bamReaderSetRegions;
+	bool     trackAllReads;
+	bool     useBaseCov;
+};
+
+// State shared by the threads collecting coverage one contig at a time for bbctools create --threads.
+// Contigs are handed out in order and the BBC shard of each is appended to the BBC file by the main
+// thread as soon as all contigs before it are, so a limited number of shards are ever pending.
+struct ContigShards {
+	const vector<string> *bamFiles;
+	const RefVector      *references;
+	RegionOptions         regionOpts;
+	StreamOptions         streamOpts;
+	RegionCoverage       *regions;		// receives the statistics collected for each contig
+	BbcCreate            *bbcCreate;	// NULL if no BBC file is created
+	bool                  invertOnTarget;
+	bool                  onlyOnTargetBases;
+
+	pthread_mutex_t          lock;
+	pthread_cond_t           changed;
+	int                      numContigs;
+	int                      nextContig;	// next contig to be claimed by a thread
+	int                      nextMerge;		// next contig to be appended to the BBC file
+	int                      maxAhead;
+	bool                     failed;
+	vector<char>             done;
+	vector<BbcCreate *>      shards;
+	vector<RegionCoverage *> threadRegions;
+};
+
+// Create the region coverage collector for a read type, ready for loading target regions
+static RegionCoverage *NewRegionCoverage( const RefVector &references, const RegionOptions &regionOpts )
+{
+	const string &readType = regionOpts.readType;
+	if( readType == "trgreads" || readType == "amplicon" || readType == "AmpliSeq" ) {
+		AmpliconRegionStatistics *ampRegionStats = new AmpliconRegionStatistics(references);
+		ampRegionStats->SetGenericReads( readType == "trgreads" );
+		ampRegionStats->SetSigFacCoverage( regionOpts.minPcCov/100 );
+		ampRegionStats->SetMaxUpstreamPrimerStart( regionOpts.primerLength );
+		ampRegionStats->SetMaxE2eEndDistance( regionOpts.maxE2eEndGap );
+		return ampRegionStats;
+	} else if( readType == "trgbases" ) {
+		return new RegionStatistics(references);
+	}
+	return new RegionCoverage(references);
+}
+
+// Load the input regions or default to whole reference contig targets.
+// Returns an error message on failure or "" for success.
+static string LoadRegionCoverage( RegionCoverage *regions, const RegionOptions &regionOpts )
+{
+	regions->SetCovAtDepths( regionOpts.covDepths );
+	if( regionOpts.targetRegions.empty() ) {
+		regions->SetWholeContigTargets();
+		return "";
+	}
+	return regions->Load( regionOpts.targetRegions, "BED", regionOpts.auxFieldIdx );
+}
+
+// Stream filtered BAM alignments to base coverage, region statistics and read tracking collectors.
+// If contigIdx is not negative only the alignments to that contig are read, using the BAM index.
+// Returns 0 for success or 1 if the BAM file was found not to be sorted.
+static int StreamAlignments( BamMultiReader &bamReader, StreamOptions opts,
+	RegionCoverage *regions, BaseCoverage &baseCov, TrackReads *readTracker, int contigIdx = -1 )
+{
+	int trgContig = 0, trgSrtPos = 0, trgEndPos = 0;
+	int minJumpLen = s_initialMinJumpLen;
+	int maxReadLen = s_initialMaxReadLen;
+	if( opts.onlyOnTargetReads ) {
+		if( contigIdx >= 0 ) {
+			// no reads are wanted from a contig without target regions
+			if( !regions->GetFirstRegion( trgContig, trgSrtPos, trgEndPos, contigIdx ) || trgContig != contigIdx ) {
+				return 0;
+			}
+		} else if( !regions->GetNextRegion( trgContig, trgSrtPos, trgEndPos ) ) {
+			// cancel region filtering if there are no regions to iterate (unexpected)
+			opts.onlyOnTargetReads = opts.bamReaderSetRegions = false;
+		}
+		if( opts.bamReaderSetRegions ) {
+			if( !bamReader.Jump( trgContig, trgSrtPos-maxReadLen ) && contigIdx >= 0 ) {
+				return 0;	// no reads on contig
+			}
+		}
+	} else if( contigIdx >= 0 && !bamReader.Jump( contigIdx ) ) {
+		return 0;
+	}
+	BamAlignment aln;
+	while( bamReader.GetNextAlignmentCore(aln) ) {
+		if( contigIdx >= 0 && aln.RefID != contigIdx ) {
+			// index jumps may start at reads on a previous contig, unmapped reads are last
+			if( aln.RefID >= 0 && aln.RefID < contigIdx ) continue;
+			break;
+		}
+		// appears to be an undocumented behavior here
+		if( aln.RefID < 0 ) continue;
+		// skip filtered reads by flag, length or mapping quality
+		if( aln.AlignmentFlag & opts.skipFlag ) continue;
+		if( aln.MapQuality < opts.minMapQuality ) continue;
+		int32_t endPos = aln.GetEndPosition();
+		if( opts.minAlignLength > 0 ) {
+			if( endPos - aln.Position < opts.minAlignLength ) continue;
+		}
+		// screen for on-target reads
+		if( opts.onlyOnTargetReads ) {
+			// find next region overlapping or beyond of current read
+			bool moreRegions = true;
+			bool setRegion = false;
+			while( aln.RefID > trgContig || (aln.RefID == trgContig && aln.Position > trgEndPos) ) {
+				if( !regions->GetNextRegion( trgContig, trgSrtPos, trgEndPos ) ) {
+					moreRegions = false;
+					break;
+				}
+				setRegion = opts.bamReaderSetRegions;
+			}
+			if( contigIdx >= 0 && trgContig != contigIdx ) {
+				// all remaining reads on the contig are beyond its last target region
+				break;
+			}
+			if( !moreRegions ) {
+				// prevent further on-target checks and exit early if not using sumStats
+				opts.onlyOnTargetReads = false;
+				if( opts.trackAllReads ) {
+					// force tracking of off-target reads
+					regions->TrackReadsOnRegion(aln,endPos);
+					if( readTracker ) readTracker->Write(aln,endPos);
+					continue;
+				}
+				break;
+			}
+			if( setRegion ) {
+				// track max read length for future index jumps - just in case long reads ever used
+				if( endPos - aln.Position > maxReadLen ) {
+					maxReadLen = endPos - aln.Position;
+					if( maxReadLen > minJumpLen ) minJumpLen = maxReadLen;
+				}
+				if( aln.RefID != trgContig || trgSrtPos - aln.Position > minJumpLen ) {
+					bamReader.Jump( trgContig, trgSrtPos-maxReadLen );
+				}
+			}
+			if( aln.RefID < trgContig || endPos < trgSrtPos ) {
+				// force tracking of off-target reads
+				if( opts.trackAllReads ) {
+					regions->TrackReadsOnRegion(aln,endPos);
+					if( readTracker ) readTracker->Write(aln,endPos);
+				}
+				continue;	// current is before next target region - fetch the next within bounds
+			}
+		}
+		// record base coverage and region coverage statistics
+		if( opts.useBaseCov ) {
+			endPos = baseCov.AddAlignment(aln,endPos);
+			if( endPos <= 0 ) {
+				if( endPos == 0 ) continue;	// read was silently ignored
+				cerr << "ERROR: BAM file is not correctly sorted vs. reference." << endl;
+				return 1;
+			}
+		}
+		// record read coverage and region coverage statistics
+		if( regions ) {
+			regions->TrackReadsOnRegion(aln,endPos);
+		}
+		if( readTracker ) {
+			readTracker->Write(aln,endPos);
+		}
+	}
+	return 0;
+}
+
+// Collect base coverage to a new BBC shard and region statistics for one contig.
+// Region statistics are handed over to the main region coverage collector.
+static bool CreateContigShard( ContigShards *cs, BamMultiReader &bamReader, RegionCoverage *regions,
+	int contigIdx, BbcCreate *&shard )
+{
+	BaseCoverage baseCov( *cs->references );
+	baseCov.SetRegionCoverage(regions);
+	baseCov.SetInvertOnTarget(cs->invertOnTarget);
+	if( cs->bbcCreate ) {
+		shard = new BbcCreate( *cs->references );
+		if( !shard->OpenShard() ) {
+			return false;
+		}
+		shard->SetNoOffTargetPositions(cs->onlyOnTargetBases);
+		baseCov.SetBbcCreate(shard);
+	}
+	if( StreamAlignments( bamReader, cs->streamOpts, regions, baseCov, NULL, contigIdx ) ) {
+		return false;
+	}
+	baseCov.Flush();
+	if( regions ) {
+		regions->SwapContigRegions( *cs->regions, contigIdx );
+	}
+	return true;
+}
+
+static void *ContigShardThread( void *arg )
+{
+	ContigShards *cs = (ContigShards *)arg;
+	// each thread has its own BAM readers and copy of the target regions
+	BamMultiReader bamReader;
+	bool ok = bamReader.Open( *cs->bamFiles ) && bamReader.LocateIndexes();
+	if( !ok ) {
+		cerr << "ERROR: Could not re-open indexed BAM file input for reading by contig." << endl;
+	}
+	RegionCoverage *regions = NULL;
+	if( ok && cs->regions ) {
+		regions = NewRegionCoverage( *cs->references, cs->regionOpts );
+		pthread_mutex_lock(&cs->lock);
+		cs->threadRegions.push_back(regions);
+		pthread_mutex_unlock(&cs->lock);
+		string errMsg = LoadRegionCoverage( regions, cs->regionOpts );
+		if( !errMsg.empty() ) {
+			cerr << "ERROR: " + errMsg + "\n";
+			ok = false;
+		}
+	}
+	while( true ) {
+		pthread_mutex_lock(&cs->lock);
+		while( cs->nextContig < cs->numContigs && cs->nextContig - cs->nextMerge >= cs->maxAhead ) {
+			pthread_cond_wait( &cs->changed, &cs->lock );
+		}
+		int contigIdx = cs->nextContig++;
+		bool failed = cs->failed;
+		pthread_mutex_unlock(&cs->lock);
+		if( contigIdx >= cs->numContigs ) break;
+
+		// contigs are still marked done after a failure so the main thread does not wait on them
+		BbcCreate *shard = NULL;
+		if( ok && !failed ) {
+			ok = CreateContigShard( cs, bamReader, regions, contigIdx, shard );
+		}
+		pthread_mutex_lock(&cs->lock);
+		cs->shards[contigIdx] = shard;
+		cs->done[contigIdx] = 1;
+		if( !ok ) cs->failed = true;
+		pthread_cond_broadcast(&cs->changed);
+		pthread_mutex_unlock(&cs->lock);
+	}
+	return NULL;
+}
+
+// Collect base coverage and region statistics using numThreads threads, each reading one contig at a time.
+// The region statistics collected by the threads are left in the regions owned by threadRegions,
+// which must be deleted after the statistics are written. Returns false on failure.
+static bool CreateByContig( ContigShards &cs, int numThreads, vector<RegionCoverage *> &threadRegions )
+{
+	cs.numContigs = cs.references->size();
+	cs.nextContig = cs.nextMerge = 0;
+	cs.maxAhead = 2 * numThreads;
+	cs.failed = false;
+	cs.done.assign( cs.numContigs, 0 );
+	cs.shards.assign( cs.numContigs, (BbcCreate *)NULL );
+	pthread_mutex_init( &cs.lock, NULL );
+	pthread_cond_init( &cs.changed, NULL );
+
+	if( numThreads > cs.numContigs ) numThreads = cs.numContigs;
+	vector<pthread_t> threads(numThreads);
+	int numStarted = 0;
+	for( ; numStarted < numThreads; ++numStarted ) {
+		if( pthread_create( &threads[numStarted], NULL, ContigShardThread, &cs ) ) break;
+	}
+	bool appendFailed = (numStarted == 0);
+	if( appendFailed ) {
+		cerr << "ERROR: Unable to start threads for reading BAM files by contig." << endl;
+	}
+	// append BBC shards in contig order as they are completed
+	for( int contigIdx = 0; numStarted && contigIdx < cs.numContigs; ++contigIdx ) {
+		pthread_mutex_lock(&cs.lock);
+		while( !cs.done[contigIdx] ) {
+			pthread_cond_wait( &cs.changed, &cs.lock );
+		}
+		BbcCreate *shard = cs.shards[contigIdx];
+		cs.shards[contigIdx] = NULL;
+		pthread_mutex_unlock(&cs.lock);
+
+		if( shard && !appendFailed && !cs.bbcCreate->AppendShard(*shard) ) {
+			cerr << "ERROR: Failed to write contig coverage to BBC file." << endl;
+			appendFailed = true;
+		}
+		delete shard;
+		pthread_mutex_lock(&cs.lock);
+		cs.nextMerge = contigIdx+1;
+		if( appendFailed ) cs.failed = true;
+		pthread_cond_broadcast(&cs.changed);
+		pthread_mutex_unlock(&cs.lock);
+	}
+	for( int i = 0; i < numStarted; ++i ) {
+		pthread_join( threads[i], NULL );
+	}
+	pthread_cond_destroy(&cs.changed);
+	pthread_mutex_destroy(&cs.lock);
+	threadRegions = cs.threadRegions;
+	return !cs.failed && !appendFailed;
+}
+
 //
 // Functions to handle bbctools commands
 // All return 0 (success), 1 (run time failure), or -1 (input/parsing error).
@@ -141,6 +458,7 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 
 	bool onlyOnTargetReads = optParser.getOptBoolean("onTargetReads");
 	bool onlyOnTargetBases = optParser.getOptBoolean("onTargetBases");
+	int  numThreads        = optParser.getOptInteger("threads",1);
 
 	// possible future options
 	bool invertOnTarget = false;
@@ -228,6 +546,10 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 	}
 	// check/set up target regions input regions/region statistics output
 	RegionCoverage *regions = NULL;
+	RegionOptions regionOpts;
+	regionOpts.minPcCov = minPcCov;
+	regionOpts.primerLength = primerLength;
+	regionOpts.maxE2eEndGap = maxE2eEndGap;
 	string covstatsStaticFields;
 	bool trackRegionBaseCov = !covDepths.empty();
 	if( covstatsFile.empty() ) {
@@ -243,52 +565,47 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 		}
 		// read regions for input only and/or creating sumStats
 		if( !targetRegions.empty() || explicitNoTargetRegions || !sumstatsFile.empty() ) {
-			regions = new RegionCoverage(references);
+			regions = NewRegionCoverage( references, regionOpts );
 		}
 	} else if( readType == "trgreads" || readType == "amplicon" || readType == "AmpliSeq" ) {
 		if( haveBbcFile ) {
 			cerr << "Creation of read coverage requires BAM file input." << endl;
 			return -1;
 		}
-		AmpliconRegionStatistics *ampRegionStats = new AmpliconRegionStatistics(references);
-		ampRegionStats->SetGenericReads( readType == "trgreads" );
-		ampRegionStats->SetSigFacCoverage( minPcCov/100 );
-		ampRegionStats->SetMaxUpstreamPrimerStart( primerLength );
-		ampRegionStats->SetMaxE2eEndDistance( maxE2eEndGap );
+		regionOpts.readType = readType;
+		regions = NewRegionCoverage( references, regionOpts );
 		covstatsStaticFields = "overlaps,";
 		covstatsStaticFields += (minPcCov > 0) ? "fwd_cov,rev_cov" : "fwd_e2e,rev_e2e";
 		covstatsStaticFields += ",total_reads,fwd_reads,rev_reads";
-		regions = ampRegionStats;
 	} else if( readType == "trgbases" ) {
 		if( haveBbcFile && targetRegions.empty() && !explicitNoTargetRegions ) {
 			cerr << "Warning: Assuming reference contigs for base coverage targets (=> option --regions -)" << endl;
 		}
-		RegionStatistics *regionStats = new RegionStatistics(references);
+		regionOpts.readType = readType;
+		regions = NewRegionCoverage( references, regionOpts );
 		covstatsStaticFields = "covered,uncov_5p,uncov_3p,ave_basereads,fwd_basereads,rev_basereads";
 		trackRegionBaseCov = true;
-		regions = regionStats;
 	} else if( readType == "covdepth" || readType.empty() ) {
 		// output (sorted) targets file with only covDepth stats (if any)
-		regions = new RegionCoverage(references);
+		regions = NewRegionCoverage( references, regionOpts );
 	} else {
 		cerr << "Unknown read type '" << readType << "'" << endl;
 		return -1;
 	}
 	// Load the input regions or default to whole reference contig targets
 	if( regions ) {
-		regions->SetCovAtDepths( covDepths == "-" ? "20,100,500" : covDepths );
+		regionOpts.covDepths = covDepths == "-" ? "20,100,500" : covDepths;
+		regionOpts.targetRegions = targetRegions;
+		regionOpts.auxFieldIdx = auxRegionSplit.size() ? auxRegionSplit[0] : "";
+		string errMsg = LoadRegionCoverage( regions, regionOpts );
+		if( !errMsg.empty() ) {
+			cerr << "ERROR: " + errMsg + "\n";
+			return 1;
+		}
 		if( targetRegions.empty() ) {
-			regions->SetWholeContigTargets();
 			// set contigs as explicit regions means all reads will seen as on-target
 			// for consistency these are inverted (for input from BBC)
 			invertOnTarget = true;
-		} else {
-			string auxFieldIdx = auxRegionSplit.size() ? auxRegionSplit[0] : "";
-			string errMsg = regions->Load( targetRegions, "BED", auxFieldIdx );
-			if( !errMsg.empty() ) {
-				cerr << "ERROR: " + errMsg + "\n";
-				return 1;
-			}
 		}
 		if( onlyOnTargetReads && haveBbcFile ) {
 			cerr << "Error: bbctools create --onTargetReads option is not supported for BBC source file." << endl;
@@ -308,6 +625,7 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 	}
 	bbcView.SetNoOffTargetPositions(onlyOnTargetBases);
 	// Stream input to output creators
+	vector<RegionCoverage *> threadRegions;
 	if( haveBbcFile ) {
 		// BBC reader and driver via BbcView object
 		if( bbcfileRoot != "-" || !covstatsFile.empty() ) {
@@ -332,14 +650,6 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 			cerr << "ERROR: Unable to write to read tracking file " << readOrigFile << endl;
 			return 1;
 		}
-		// BAM reader, BaseCoverage driver, dispatching to BbcCreate and BbcView objects
-		BaseCoverage baseCov(references);
-		baseCov.SetRegionCoverage(regions);
-		baseCov.SetBbcCreate(bbcCreate);
-		baseCov.SetInvertOnTarget(invertOnTarget);
-		if( bbcfileRoot == "-" ) {
-			baseCov.SetBbcView(&bbcView);
-		}
 		// Certain options require that all reads are processed, invalidating other performance options
 		bool trackAllReads = !sumstatsFile.empty() || readTracker;
 		// Implicit set of onlyOnTargetReads for performance when only these reads are required
@@ -351,9 +661,6 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 		useBaseCov |= trackRegionBaseCov;
 		// do not allow jumping if sumStats option is used - need to count all reads
 		bool bamReaderSetRegions = (s_useBamReaderJump && !trackAllReads);
-		int trgContig = 0, trgSrtPos = 0, trgEndPos = 0;
-		int minJumpLen = s_initialMinJumpLen;
-		int maxReadLen = s_initialMaxReadLen;
 		if( onlyOnTargetReads ) {
 			// load/create BAM index files for targeted reading
 			// Note: BamIndex::BAMTOOLS format performed very badly and cannot use mixed with BTI/BAI files
@@ -383,86 +690,54 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 					bamReaderSetRegions = false;
 				}
 			}
-			// cancel region filtering if there are no regions to iterate (unexpected)
-			if( !regions->GetNextRegion( trgContig, trgSrtPos, trgEndPos ) ) {
-				onlyOnTargetReads = bamReaderSetRegions = false;
-			}
-			if( bamReaderSetRegions ) {
-				bamReader.Jump( trgContig, trgSrtPos-maxReadLen );
-			}
 		}
-		BamAlignment aln;
-		while( bamReader.GetNextAlignmentCore(aln) ) {
-			// appears to be an undocumented behavior here
-			if( aln.RefID < 0 ) continue;
-			// skip filtered reads by flag, length or mapping quality
-			if( aln.AlignmentFlag & skipFlag ) continue;
-			if( aln.MapQuality < minMapQuality ) continue;
-			int32_t endPos = aln.GetEndPosition();
-			if( minAlignLength > 0 ) {
-				if( endPos - aln.Position < minAlignLength ) continue;
-			}
-			// screen for on-target reads
-			if( onlyOnTargetReads ) {
-				// find next region overlapping or beyond of current read
-				bool moreRegions = true;
-				bool setRegion = false;
-				while( aln.RefID > trgContig || (aln.RefID == trgContig && aln.Position > trgEndPos) ) {
-					if( !regions->GetNextRegion( trgContig, trgSrtPos, trgEndPos ) ) {
-						moreRegions = false;
-						break;
-					}
-					setRegion = bamReaderSetRegions;
-				}
-				if( !moreRegions ) {
-					// prevent further on-target checks and exit early if not using sumStats
-					onlyOnTargetReads = false;
-					if( trackAllReads ) {
-						// force tracking of off-target reads
-						regions->TrackReadsOnRegion(aln,endPos);
-						if( readTracker ) readTracker->Write(aln,endPos);
-						continue;
-					}
-					break;
-				}
-				if( setRegion ) {
-					// track max read length for future index jumps - just in case long reads ever used
-					if( endPos - aln.Position > maxReadLen ) {
-						maxReadLen = endPos - aln.Position;
-						if( maxReadLen > minJumpLen ) minJumpLen = maxReadLen;
-					}
-					if( aln.RefID != trgContig || trgSrtPos - aln.Position > minJumpLen ) {
-						bamReader.Jump( trgContig, trgSrtPos-maxReadLen );
-					}
-				}
-				if( aln.RefID < trgContig || endPos < trgSrtPos ) {
-					// force tracking of off-target reads
-					if( trackAllReads ) {
-						regions->TrackReadsOnRegion(aln,endPos);
-						if( readTracker ) readTracker->Write(aln,endPos);
-					}
-					continue;	// current is before next target region - fetch the next within bounds
-				}
+		StreamOptions streamOpts;
+		streamOpts.skipFlag = skipFlag;
+		streamOpts.minMapQuality = minMapQuality;
+		streamOpts.minAlignLength = minAlignLength;
+		streamOpts.onlyOnTargetReads = onlyOnTargetReads;
+		streamOpts.bamReaderSetRegions = bamReaderSetRegions;
+		streamOpts.trackAllReads = trackAllReads;
+		streamOpts.useBaseCov = useBaseCov;
+		// reading by contig requires the BAM index and is only for output not depending on read order
+		bool byContig = numThreads > 1 && !trackAllReads && bbcfileRoot != "-" && references.size() > 1;
+		if( byContig && !(onlyOnTargetReads && bamReaderSetRegions) && !bamReader.LocateIndexes() ) {
+			cerr << "Warning: BAM index file" << (cmdArgs.size() > 1 ? "s" : "") << " not located, --threads option ignored." << endl;
+			byContig = false;
+		}
+		if( byContig ) {
+			int trgContig, trgSrtPos, trgEndPos;
+			if( onlyOnTargetReads && !regions->GetFirstRegion( trgContig, trgSrtPos, trgEndPos ) ) {
+				// cancel region filtering if there are no regions to iterate (unexpected)
+				streamOpts.onlyOnTargetReads = false;
 			}
-			// record base coverage and region coverage statistics
-			if( useBaseCov ) {
-				endPos = baseCov.AddAlignment(aln,endPos);
-				if( endPos <= 0 ) {
-					if( endPos == 0 ) continue;	// read was silently ignored
-					cerr << "ERROR: BAM file is not correctly sorted vs. reference." << endl;
-					return 1;
-				}
+			ContigShards contigShards;
+			contigShards.bamFiles = &cmdArgs;
+			contigShards.references = &references;
+			contigShards.regionOpts = regionOpts;
+			contigShards.streamOpts = streamOpts;
+			contigShards.regions = regions;
+			contigShards.bbcCreate = bbcCreate;
+			contigShards.invertOnTarget = invertOnTarget;
+			contigShards.onlyOnTargetBases = onlyOnTargetBases;
+			if( !CreateByContig( contigShards, numThreads, threadRegions ) ) {
+				return 1;
 			}
-			// record read coverage and region coverage statistics
-			if( regions ) {
-				regions->TrackReadsOnRegion(aln,endPos);
+		} else {
+			// BAM reader, BaseCoverage driver, dispatching to BbcCreate and BbcView objects
+			BaseCoverage baseCov(references);
+			baseCov.SetRegionCoverage(regions);
+			baseCov.SetBbcCreate(bbcCreate);
+			baseCov.SetInvertOnTarget(invertOnTarget);
+			if( bbcfileRoot == "-" ) {
+				baseCov.SetBbcView(&bbcView);
 			}
-			if( readTracker ) {
-				readTracker->Write(aln,endPos);
+			if( StreamAlignments( bamReader, streamOpts, regions, baseCov, readTracker ) ) {
+				return 1;
 			}
+			// flush and close objects associated with output
+			baseCov.Flush();
 		}
-		// flush and close objects associated with output
-		baseCov.Flush();
 	}
 	// Output in-memory region stats file and ensure BBC file is closed
 	if( regions ) {
@@ -476,6 +751,10 @@ int bbctools_create( BbcUtils::OptParser &optParser ) {
 		}
 		delete regions;
 	}
+	// statistics written above may still be owned by the region copies used for reading by contig
+	for( size_t i = 0; i < threadRegions.size(); ++i ) {
+		delete threadRegions[i];
+	}
 	delete bbcCreate;
 
 	// Complete remaining file creation options using a BBC file input
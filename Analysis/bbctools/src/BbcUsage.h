@@ -124,6 +124,9 @@ static void Usage( string subcmd, bool verbose = false ) {
 			"  -d,--noDups               Specifies to ignore reads that are marked as duplicates in input BAM files.\n"
 			"  -r,--onTargetReads        Specifies to only output coverage for reads that overlap target regions in\n"
 			"      the --regions (-R) file. This option requires BAM input file(s).\n"
+			"  -t,--threads <int>        Number of threads reading input BAM files, one contig at a time. Output is\n"
+			"      the same as for the default value of 1. Effective only for BAM file(s) with BAI index files and for\n"
+			"      output to files, but not with the --sumStats (-S) or --readOrigin (-O) options, which read all reads.\n"
 			"  -u,--unique               Specifies to ignore non-uniquely mapped reads from input BAM files.\n"
 			"      This option is currently the same as using --minMAPQ 1.\n\n"
 			"Examples:\n"
@@ -155,7 +158,8 @@ static void Usage( string subcmd, bool verbose = false ) {
 			"  -c,--coarse               Create a coarse base coverage (CBC) file. (May use BBC file input.)\n"
 			"  -L,--minAlignLength <int> Minimum aligned read length filter for excluding reads when reading BAM files. (0)\n"
 			"  -Q,--minMAPQ <int>        Minimum MAPQ value for excluding reads when reading BAM files. (0)\n"
-			"  -d,--noDups               Ignore reads that are marked as duplicates in input BAM files.\n\n"
+			"  -d,--noDups               Ignore reads that are marked as duplicates in input BAM files.\n"
+			"  -t,--threads <int>        Number of threads reading indexed BAM files by contig. (1)\n\n"
 			"Type: 'bbctools create --help' for more options and detailed information on command arguments.\n";
 		}
 	} else if( subcmd == "report" ) {
@@ -21,6 +21,8 @@ RegionCoverage::RegionCoverage( const BamTools::RefVector& references )
 	, m_bcovRegion(NULL)
 	, m_rcovRegion(NULL)
     , m_lastRegionAssigned(NULL)
+	, m_iterContigIdx(0)
+	, m_iterRegion(NULL)
 	, m_numAuxFields(0)
 	, m_ncovDepths(0)
 {
@@ -59,6 +61,10 @@ void RegionCoverage::Clear()
 	}
 	m_bcovContigIdx = m_rcovContigIdx = m_numRefContigs;
 	m_lastRegionAssigned = NULL;
+	m_iterContigIdx = 0;
+	m_iterRegion = NULL;
+	m_regionIndex.Clear();
+	m_indexedRegions.clear();
 }
 
 uint32_t *RegionCoverage::CreateTargetBinSizes( uint32_t &numBins, uint32_t binSize,
@@ -236,32 +242,37 @@ uint32_t RegionCoverage::GetLastReadOnRegionIdx() const {
   return m_lastRegionAssigned ? m_lastRegionAssigned->trgIdx : 0;
 }
 
+bool RegionCoverage::GetFirstRegion( int &contigIdx, int &srtPosition, int &endPosition, uint32_t fromContigIdx )
+{
+	m_iterContigIdx = fromContigIdx;
+	m_iterRegion = NULL;
+	return GetNextRegion( contigIdx, srtPosition, endPosition );
+}
+
 bool RegionCoverage::GetNextRegion( int &contigIdx, int &srtPosition, int &endPosition, bool start )
 {
-    static uint32_t s_contig = 0;
-    static TargetRegion *s_region = NULL;
     // start iteration check
     if( start ) {
-    	s_contig = 0;
-    	s_region = NULL;
+    	m_iterContigIdx = 0;
+    	m_iterRegion = NULL;
     }
     // ended iteration check
-    if( s_contig >= m_numRefContigs ) {
+    if( m_iterContigIdx >= m_numRefContigs ) {
 		return false;
     }
-    if( s_region ) {
-    	s_region = s_region->next;
+    if( m_iterRegion ) {
+    	m_iterRegion = m_iterRegion->next;
     } else {
     	// first iteration only
-    	s_region = m_contigList[s_contig]->targetRegionHead;
+    	m_iterRegion = m_contigList[m_iterContigIdx]->targetRegionHead;
     }
-    while( !s_region ) {
-    	if( ++s_contig >= m_numRefContigs ) return false;
-    	s_region = m_contigList[s_contig]->targetRegionHead;
+    while( !m_iterRegion ) {
+    	if( ++m_iterContigIdx >= m_numRefContigs ) return false;
+    	m_iterRegion = m_contigList[m_iterContigIdx]->targetRegionHead;
 	}
-    contigIdx = s_contig;
-    srtPosition = s_region->trgSrt - 1;
-    endPosition = s_region->trgEnd;
+    contigIdx = m_iterContigIdx;
+    srtPosition = m_iterRegion->trgSrt - 1;
+    endPosition = m_iterRegion->trgEnd;
 	return true;
 }
 
@@ -402,6 +413,7 @@ string RegionCoverage::Load(
     	m_contigList[i]->ReverseSort(rgnIdx);
     	rgnIdx += m_contigList[i]->numRegions;
     }
+    IndexRegions();
 	return "";
 }
 
@@ -461,12 +473,10 @@ bool RegionCoverage::SetCursorOnRegion( uint32_t contigIdx, uint32_t position )
 	}
 	m_bcovContigIdx = contigIdx;
 	while( m_bcovContigIdx < m_numRefContigs ) {
-		m_bcovRegion = m_contigList[m_bcovContigIdx]->targetRegionHead;
-		for( ; m_bcovRegion; m_bcovRegion = m_bcovRegion->next ) {
-			if( position <= m_bcovRegion->trgEnd ) {
-				m_bcovRegionPos = position > m_bcovRegion->trgSrt ? position : m_bcovRegion->trgSrt;
-				return true;
-			}
+		m_bcovRegion = FirstRegionEndingFrom( m_bcovContigIdx, position );
+		if( m_bcovRegion ) {
+			m_bcovRegionPos = position > m_bcovRegion->trgSrt ? position : m_bcovRegion->trgSrt;
+			return true;
 		}
 		++m_bcovContigIdx;
 		position = 0;
@@ -485,6 +495,29 @@ void RegionCoverage::SetWholeContigTargets()
     	m_contigList[i]->AddRegion( new TargetRegion( 1, m_contigList[i]->length, auxFieldValues ) );
     	m_contigList[i]->ReverseSort(i);
     }
+    IndexRegions();
+}
+
+void RegionCoverage::SwapContigRegions( RegionCoverage &other, uint32_t contigIdx )
+{
+	if( contigIdx >= m_numRefContigs || contigIdx >= other.m_numRefContigs ) {
+		throw runtime_error("RegionCoverage::SwapContigRegions() contig index out of range.");
+	}
+	TargetContig *contig = m_contigList[contigIdx];
+	m_contigList[contigIdx] = other.m_contigList[contigIdx];
+	other.m_contigList[contigIdx] = contig;
+	// both instances index the same regions, so only the region pointers change hands
+	for( TargetRegion *cur = m_contigList[contigIdx]->targetRegionHead; cur; cur = cur->next ) {
+		m_indexedRegions[cur->trgIdx-1] = cur;
+	}
+	for( TargetRegion *cur = other.m_contigList[contigIdx]->targetRegionHead; cur; cur = cur->next ) {
+		other.m_indexedRegions[cur->trgIdx-1] = cur;
+	}
+	// this instance must not be left iterating regions now owned by the other
+	m_bcovContigIdx = m_rcovContigIdx = m_numRefContigs;
+	m_iterContigIdx = 0;
+	m_iterRegion = NULL;
+	m_lastRegionAssigned = NULL;
 }
 
 void RegionCoverage::Write( const string &filename, const string &columnTitles )
@@ -611,6 +644,30 @@ uint32_t RegionCoverage::BaseDepthOnRegion(
 	return covType;
 }
 
+void RegionCoverage::IndexRegions()
+{
+	// regions are 1-based and closed, the index takes 0-based half open intervals
+	m_regionIndex.Clear();
+	m_indexedRegions.clear();
+	for( size_t i = 0; i < m_numRefContigs; ++i ) {
+		for( TargetRegion *cur = m_contigList[i]->targetRegionHead; cur; cur = cur->next ) {
+			if( cur->trgIdx > m_indexedRegions.size() ) {
+				m_indexedRegions.resize( cur->trgIdx, NULL );
+			}
+			m_indexedRegions[cur->trgIdx-1] = cur;
+			m_regionIndex.Add( i, cur->trgSrt-1, cur->trgEnd, cur->trgIdx-1 );
+		}
+	}
+	m_regionIndex.Build();
+}
+
+RegionCoverage::TargetRegion *RegionCoverage::FirstRegionEndingFrom( uint32_t contigIdx, uint32_t position )
+{
+	// first region in list order with trgEnd >= position, which is where a walk from the head would stop
+	int id = m_regionIndex.FirstOverlap( contigIdx, (int)position-1, INT32_MAX );
+	return id < 0 ? NULL : m_indexedRegions[id];
+}
+
 void RegionCoverage::AddCovAtDepth( TargetRegion *tr, int totReads ) {
 	if( !tr->covAtReads ) {
 		tr->covAtReads = new uint32_t[m_ncovDepths];
@@ -657,7 +714,7 @@ uint32_t RegionCoverage::BaseOnRegion( uint32_t contigIdx, uint32_t position )
 {
 	if( contigIdx != m_bcovContigIdx && contigIdx < m_numRefContigs ) {
 		m_bcovContigIdx = contigIdx;
-		m_bcovRegion = m_contigList[m_bcovContigIdx]->targetRegionHead;
+		m_bcovRegion = FirstRegionEndingFrom( m_bcovContigIdx, position );
 	} else if( !position ) {
 		m_bcovRegion = m_contigList[m_bcovContigIdx]->targetRegionHead;
 	}
@@ -677,7 +734,7 @@ uint32_t RegionCoverage::ReadOnRegion( uint32_t contigIdx, uint32_t readSrt, uin
 {
 	if( contigIdx != m_rcovContigIdx && contigIdx < m_numRefContigs ) {
 		m_rcovContigIdx = contigIdx;
-		m_rcovRegion = m_contigList[m_rcovContigIdx]->targetRegionHead;
+		m_rcovRegion = FirstRegionEndingFrom( m_rcovContigIdx, readSrt );
 	} else if( !readEnd ) {
 		m_rcovRegion = m_contigList[m_rcovContigIdx]->targetRegionHead;
 	}
@@ -10,6 +10,7 @@
 #define REGIONCOVERAGE_H_
 
 #include "api/BamAlignment.h"
+#include "IntervalIndex.h"
 
 #include <string>
 #include <vector>
@@ -131,6 +132,12 @@ class RegionCoverage
         uint32_t             m_rcovContigIdx;
         TargetRegion        *m_rcovRegion;
         TargetRegion        *m_lastRegionAssigned;
+        uint32_t             m_iterContigIdx;
+        TargetRegion        *m_iterRegion;
+
+        // all regions by position, index ids are trgIdx-1
+        IntervalIndex          m_regionIndex;
+        vector<TargetRegion *> m_indexedRegions;
 
         // common optional depth at coverage stats
         size_t      m_numAuxFields;
@@ -138,6 +145,8 @@ class RegionCoverage
         vector<int> m_covAtDepth;
 
         void     AddCovAtDepth( TargetRegion *tr, int totReads );
+        void     IndexRegions(void);
+        TargetRegion *FirstRegionEndingFrom( uint32_t contigIdx, uint32_t position );
         uint32_t BaseOnRegion( uint32_t contigIdx, uint32_t position );
         uint32_t ReadOnRegion( uint32_t contigIdx, uint32_t readSrt, uint32_t readEnd );
 
@@ -168,6 +177,10 @@ class RegionCoverage
         // Note that srtPositon is returned as a 0-based integer (etc.) for intended usage with the BamMultiReader::SetRegion().
         bool GetNextRegion( int &contigIdx, int &srtPosition, int &endPosition, bool start = false );
 
+        // Reset the GetNextRegion() iterator to return the first region on or after the given contig.
+        // Returns false if there are no regions from that contig on.
+        bool GetFirstRegion( int &contigIdx, int &srtPosition, int &endPosition, uint32_t fromContigIdx = 0 );
+
         // Return the total length of targets within the given region boundaries
         uint32_t GetTargetedWindowSize(
         	uint32_t srtContig = 0, uint32_t srtPosition = 1, uint32_t endPosition = 0, uint32_t endContig = 0 );
@@ -198,6 +211,12 @@ class RegionCoverage
         // Returns false if locus is out of bounds or there is no region beyond the locus passed.
         bool SetCursorOnRegion( uint32_t contigIdx, uint32_t position );
 
+        // Exchange the regions and all statistics collected for the given contig with another instance
+        // loaded from the same targets. Only the iterators of this instance are reset, so the other should
+        // not be in use. Statistics objects stay owned by the instance that created them, so both instances
+        // must be kept until the statistics are written.
+        void SwapContigRegions( RegionCoverage &other, uint32_t contigIdx );
+
         // Set up targets as whole reference contigs.
         // Alternative to Load() method (when no targets file)
         void SetWholeContigTargets(void);
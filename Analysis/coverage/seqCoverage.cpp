@@ -4,9 +4,11 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <iostream>
+#include <algorithm>
 #include <map>
 #include "interval_tree.h"
 #include "templatestack.h"
+#include "IntervalIndex.h"
 
 #define DEFAULT_N_INTERVALTREES 1000
 
@@ -51,8 +53,12 @@ int main(int argc, char **argv) {
     }
   }
 
+  // The union only needs the intervals sorted by start, the flat IntervalIndex keeps them
+  // that way for a fraction of the memory of one tree node per interval. Depth resolution
+  // edits intervals as it goes and stays on the trees.
   unsigned int nSeq=0;
-  IntervalTree *intervalTree = new IntervalTree[nSeqAlloc];
+  IntervalIndex intervalIndex;
+  IntervalTree *intervalTree = reportDepth ? new IntervalTree[nSeqAlloc] : NULL;
 
   map<string, unsigned int, numcomp> seqIndex;
   map<string, unsigned int>::iterator seqIndexIter;
@@ -78,7 +84,7 @@ int main(int argc, char **argv) {
     if(seqIndexIter != seqIndex.end()) {
       thisIndex = seqIndexIter->second;
     } else {
-      if(nSeq >= nSeqAlloc) {
+      if(reportDepth && nSeq >= nSeqAlloc) {
         cerr << "Only have enough space allocated for " << nSeqAlloc << " IntervalTrees\n";
         exit(1);
       }
@@ -86,25 +92,30 @@ int main(int argc, char **argv) {
       thisIndex = nSeq;
       nSeq++;
     }
-    intervalTree[thisIndex].Insert(new IntInterval(start,stop,1));
+    if(reportDepth)
+      intervalTree[thisIndex].Insert(new IntInterval(start,stop,1));
+    else
+      intervalIndex.Add(thisIndex,start,stop+1,0);
   }
 
   if(!reportDepth) {
-    // Determine the union for each interval tree and use it to report the coverage
+    // Determine the union for each sequence and use it to report the coverage.
+    // Intervals are closed, ones that share a position are merged, adjacent ones are not.
+    intervalIndex.Build();
     map<string, unsigned int> seqCoverage;
     for(map<string, unsigned int>::const_iterator it = seqIndex.begin(); it != seqIndex.end(); ++it) {
-      int nInterval = 0;
-      int *start;
-      int *stop;
+      size_t nInterval = 0;
+      const IntervalIndexNode *interval = intervalIndex.ContigNodes(it->second, nInterval);
       int coverage = 0;
-      intervalTree[it->second].GetUnion(&start,&stop,&nInterval);
-      for(int i=0; i<nInterval; i++) {
+      for(size_t i=0; i<nInterval; ) {
+        int unionStart = interval[i].begin;
+        int unionStop = interval[i].end - 1;
+        for(++i; i<nInterval && interval[i].begin <= unionStop; ++i)
+          unionStop = max(unionStop, interval[i].end - 1);
         if(printBlocks)
-          cout << it->first << "\t" << start[i] << "\t" << stop[i] << "\n";
-        coverage += (stop[i]-start[i]+1);
+          cout << it->first << "\t" << unionStart << "\t" << unionStop << "\n";
+        coverage += (unionStop-unionStart+1);
       }
-      delete start;
-      delete stop;
       seqCoverage.insert(pair<string, unsigned int>(it->first,coverage));
     }
   
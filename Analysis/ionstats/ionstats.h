@@ -11,6 +11,7 @@
 #include <math.h>
 #include "json/json.h"
 #include "OptArgs.h"
+#include "api/BamAlignment.h"
 
 #define IONSTATS_BIGGEST_PHRED 47
 #define TYPICAL_FLOWS_PER_BASE 2
@@ -487,6 +488,108 @@ private:
 };
 
 
+// =================================================================================
+// Everything "ionstats basecaller" collects from an unmapped BAM. BaseCaller feeds
+// the reads it writes into the same class, so its json is identical to a second pass.
+
+class IonstatsBasecallerStats {
+public:
+  IonstatsBasecallerStats() {
+    for (int qv = 0; qv < 256; qv++)
+      qv_to_error_rate_[qv] = pow(10.0,-0.1*(double)qv);
+  }
+
+  void Initialize(int histogram_length, const string& key, const string& flow_order) {
+    key_ = key;
+    flow_order_ = flow_order;
+    total_full_histo_.Initialize(histogram_length);
+    total_insert_histo_.Initialize(histogram_length);
+    total_Q17_histo_.Initialize(histogram_length);
+    total_Q20_histo_.Initialize(histogram_length);
+  }
+
+  void AddRead(const BamTools::BamAlignment& alignment) {
+
+    // Record read length
+    unsigned int full_length = alignment.QueryBases.length();
+    total_full_histo_.Add(full_length);
+
+    // Record insert length
+    int insert_length = 0;
+    if (alignment.GetTag("ZA",insert_length))
+      total_insert_histo_.Add(insert_length);
+
+    // Compute and record Q17 and Q20
+    int Q17_length = 0;
+    int Q20_length = 0;
+    double num_accumulated_errors = 0.0;
+    for(int pos = 0; pos < (int)full_length; ++pos) {
+      num_accumulated_errors += qv_to_error_rate_[(int)alignment.Qualities[pos] - 33];
+      if (num_accumulated_errors / (pos + 1) <= 0.02)
+        Q17_length = pos + 1;
+      if (num_accumulated_errors / (pos + 1) <= 0.01)
+        Q20_length = pos + 1;
+    }
+    total_Q17_histo_.Add(Q17_length);
+    total_Q20_histo_.Add(Q20_length);
+
+    // Record data for system snr
+    if(alignment.GetTag("ZM", flow_signal_zm_))
+      system_snr_.Add(flow_signal_zm_, key_, flow_order_);
+    else if(alignment.GetTag("FZ", flow_signal_fz_))
+      system_snr_.Add(flow_signal_fz_, key_, flow_order_);
+
+    // Record qv histogram
+    qv_histogram_.Add(alignment.Qualities);
+  }
+
+  void MergeFrom(const IonstatsBasecallerStats& other) {
+    qv_histogram_.MergeFrom(other.qv_histogram_);
+    system_snr_.MergeFrom(other.system_snr_);
+    total_full_histo_.MergeFrom(other.total_full_histo_);
+    total_insert_histo_.MergeFrom(other.total_insert_histo_);
+    total_Q17_histo_.MergeFrom(other.total_Q17_histo_);
+    total_Q20_histo_.MergeFrom(other.total_Q20_histo_);
+  }
+
+  void LoadFromJson(const Json::Value& json_value) {
+    qv_histogram_.LoadFromJson(json_value);
+    system_snr_.LoadFromJson(json_value);
+    total_full_histo_.LoadFromJson(json_value["full"]);
+    total_insert_histo_.LoadFromJson(json_value["insert"]);
+    total_Q17_histo_.LoadFromJson(json_value["Q17"]);
+    total_Q20_histo_.LoadFromJson(json_value["Q20"]);
+  }
+
+  void SaveToJson(Json::Value& json_value) {
+    //json_value["meta"]["creation_date"] = get_time_iso_string(time(NULL));
+    json_value["meta"]["format_name"] = "ionstats_basecaller";
+    json_value["meta"]["format_version"] = "1.0";
+
+    system_snr_.SaveToJson(json_value);
+    qv_histogram_.SaveToJson(json_value);
+    total_full_histo_.SaveToJson(json_value["full"]);
+    total_insert_histo_.SaveToJson(json_value["insert"]);
+    total_Q17_histo_.SaveToJson(json_value["Q17"]);
+    total_Q20_histo_.SaveToJson(json_value["Q20"]);
+  }
+
+private:
+  string                key_;
+  string                flow_order_;
+  double                qv_to_error_rate_[256];
+  vector<uint16_t>      flow_signal_fz_;
+  vector<int16_t>       flow_signal_zm_;
+
+  ReadLengthHistogram   total_full_histo_;
+  ReadLengthHistogram   total_insert_histo_;
+  ReadLengthHistogram   total_Q17_histo_;
+  ReadLengthHistogram   total_Q20_histo_;
+  MetricGeneratorSNR    system_snr_;
+  BaseQVHistogram       qv_histogram_;
+};
+
+
 // =================================================================================
 
 class SimpleHistogram {
@@ -48,6 +48,11 @@ typedef struct ProcessAlignmentContext {
   pthread_mutex_t  *results_mutex;
 } ProcessAlignmentContext;
 
+typedef struct AlignmentSummaryMergeContext {
+  AlignmentSummary *dest;
+  AlignmentSummary *src;
+} AlignmentSummaryMergeContext;
+
 typedef struct hp_data_merge_t {
   map< string, HpData > hp_data;
   bool merge_proton_blocks;
@@ -185,6 +190,7 @@ void IonstatsAlignmentOptions::WriteHelp(void)
   cerr << "  --max-subregion-hp           INT       max HP length for regional summary [" << DEFAULT_SUBREGION_MAX_HP << "]" << endl;
   cerr << "  --n-threads                  INT       number of threads for analysis, set to 0 to use numCores() [" << DEFAULT_N_THREADS << "]" << endl;
   cerr << "  --threads-share-memory       BOOL      controls whether threads write results to private or common mem [" << DEFAULT_THREADS_SHARE_MEMORY << "]" << endl;
+  cerr << "  --read-batch-size            INT       number of alignments a thread takes from the input at a time [" << DEFAULT_READ_BATCH_SIZE << "]" << endl;
   cerr << endl;
   cerr << "Options for spatial stratification of results.  All 3 options must be used together." << endl;
   cerr << "  Each option specifies two comma-separated values in the form x,y" << endl;
@@ -250,6 +256,7 @@ void IonstatsAlignmentOptions::InitializeFromOptArgs(OptArgs &opts, const string
   debug_positive_ref_flow_     = opts.GetFirstInt    ('-', "debug-positive-ref-flow",    DEFAULT_DEBUG_POSITIVE_REF_FLOW);
   n_threads_                   = opts.GetFirstInt    ('-', "n-threads",                  DEFAULT_N_THREADS);
   threads_share_memory_        = opts.GetFirstBoolean('-', "threads-share-memory",       DEFAULT_THREADS_SHARE_MEMORY);
+  int read_batch_size          = opts.GetFirstInt    ('-', "read-batch-size",            DEFAULT_READ_BATCH_SIZE);
 
 
   if(evaluate_per_read_per_flow_) {
@@ -310,6 +317,11 @@ void IonstatsAlignmentOptions::InitializeFromOptArgs(OptArgs &opts, const string
   if(n_threads_ == 0) {
     n_threads_ = numCores();
   } 
+  if(read_batch_size <= 0) {
+    cerr << "ERROR: " << program_ << ": read batch size must be positive" << endl;
+    exit(EXIT_FAILURE);
+  }
+  read_batch_size_ = read_batch_size;
 }
 
 
@@ -402,8 +414,22 @@ int IonstatsAlignmentBamReader::Initialize(const vector<string> &input_bam_filen
 }
 
 bool IonstatsAlignmentBamReader::GetNextAlignment(BamAlignment &alignment, string &program) {
+  if(!GetNextAlignmentCore(alignment, program))
+    return(false);
+  alignment.BuildCharData();
+  return(true);
+}
+
+unsigned int IonstatsAlignmentBamReader::GetNextAlignmentBatch(vector<BamAlignment> &alignment_batch, string &program) {
+  unsigned int n_read=0;
+  while(n_read < alignment_batch.size() && GetNextAlignmentCore(alignment_batch[n_read], program))
+    ++n_read;
+  return(n_read);
+}
+
+bool IonstatsAlignmentBamReader::GetNextAlignmentCore(BamAlignment &alignment, string &program) {
   
-  if (input_bam_.GetNextAlignment(alignment)) {
+  if (input_bam_.GetNextAlignmentCore(alignment)) {
     // We got another read from the currently open BAM
     return(true);
   } else if(input_bam_filename_it_ == input_bam_filename_.end()) {
@@ -420,7 +446,7 @@ bool IonstatsAlignmentBamReader::GetNextAlignment(BamAlignment &alignment, strin
         cerr << program << ": ERROR: cannot open " << *input_bam_filename_it_ << " for read" << endl;
         exit(EXIT_FAILURE);
       }
-      if (input_bam_.GetNextAlignment(alignment)) {
+      if (input_bam_.GetNextAlignmentCore(alignment)) {
         return_status=true;
         break;
       }
@@ -429,6 +455,35 @@ bool IonstatsAlignmentBamReader::GetNextAlignment(BamAlignment &alignment, strin
   }
 }
 
+void * mergeAlignmentSummary(void *in) {
+  AlignmentSummaryMergeContext *context = static_cast<AlignmentSummaryMergeContext*>(in);
+  context->dest->MergeFrom(*(context->src));
+  return(NULL);
+}
+
+// Merges the per-thread results into alignment_summary[0] as a binary tree: each round merges disjoint
+// pairs in parallel, so no locks are needed and the merge takes log2(n) rounds instead of n-1 merges.
+void mergeAlignmentSummaries(vector< AlignmentSummary > &alignment_summary, const string &program) {
+  for(unsigned int step=1; step < alignment_summary.size(); step *= 2) {
+    vector< AlignmentSummaryMergeContext > context;
+    for(unsigned int i=0; i+step < alignment_summary.size(); i += 2*step) {
+      AlignmentSummaryMergeContext pair_context;
+      pair_context.dest = &(alignment_summary[i]);
+      pair_context.src  = &(alignment_summary[i+step]);
+      context.push_back(pair_context);
+    }
+    vector<pthread_t> merge_id(context.size());
+    for(unsigned int i=0; i < context.size(); ++i) {
+      if (pthread_create(&merge_id[i], NULL, mergeAlignmentSummary, &(context[i]))) {
+        cerr << "ERROR: " << program << ": problem starting thread" << endl;
+        exit (EXIT_FAILURE);
+      }
+    }
+    for(unsigned int i=0; i < context.size(); ++i)
+      pthread_join(merge_id[i], NULL);
+  }
+}
+
 int IonstatsAlignment(OptArgs &opts, const string &program_str)
 {
   IonstatsAlignmentOptions opt;
@@ -515,8 +570,7 @@ int IonstatsAlignment(OptArgs &opts, const string &program_str)
   pthread_mutex_destroy(&results_mutex);
 
   if(!opt.ThreadsShareMemory())
-    for(unsigned int i=1; i<opt.NThreads(); ++i)
-      alignment_summary[0].MergeFrom(alignment_summary[i]);
+    mergeAlignmentSummaries(alignment_summary, opt.Program());
 
   if(opt.OutputBamFilename() != "")
     output_bam.Close();
@@ -2402,16 +2456,24 @@ void * processAlignments(void *in) {
   aq_length.reserve(pac->opt->NErrorRates());
 
   // Loop over mapped reads in the input BAM
-  BamAlignment alignment;
+  vector<BamAlignment> alignment_batch(pac->opt->ReadBatchSize());
+  unsigned int batch_size=0;
+  unsigned int batch_idx=0;
   bool done=false;
   while(!done) {
-    // Lock the read_mutex while we get the next alignment
-    pthread_mutex_lock(pac->read_mutex);
-    if(!pac->input_bam->GetNextAlignment(alignment,pac->opt->Program()))
-      done=true;
-    pthread_mutex_unlock(pac->read_mutex);
-    if(done)
-      continue;
+    if(batch_idx == batch_size) {
+      // Lock the read_mutex only while we take the next batch of alignments off the input
+      pthread_mutex_lock(pac->read_mutex);
+      batch_size = pac->input_bam->GetNextAlignmentBatch(alignment_batch,pac->opt->Program());
+      pthread_mutex_unlock(pac->read_mutex);
+      batch_idx = 0;
+      if(batch_size == 0) {
+        done=true;
+        continue;
+      }
+    }
+    BamAlignment &alignment = alignment_batch[batch_idx++];
+    alignment.BuildCharData();
 
     // Optionally replicate input to output
     if(pac->opt->OutputBamFilename() != "") {
@@ -134,7 +134,7 @@ void AlignmentSummary::MergeFrom(AlignmentSummary &other) {
     exit(EXIT_FAILURE);
   } else {
     for(unsigned int i=0; i<aq_histogram_bc_.size(); ++i)
-      aq_histogram_bc_[i] = other.AqHistogramBc()[i];
+      aq_histogram_bc_[i].MergeFrom(other.AqHistogramBc()[i]);
   }
   // Per-base and per-flow error data
   base_position_error_count_.MergeFrom(other.BasePositionErrorCount());
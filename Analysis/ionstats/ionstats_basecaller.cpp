@@ -63,19 +63,6 @@ int IonstatsBasecaller(OptArgs &opts)
   }
 
 
-  ReadLengthHistogram total_full_histo;
-  ReadLengthHistogram total_insert_histo;
-  ReadLengthHistogram total_Q17_histo;
-  ReadLengthHistogram total_Q20_histo;
-
-  total_full_histo.Initialize(histogram_length);
-  total_insert_histo.Initialize(histogram_length);
-  total_Q17_histo.Initialize(histogram_length);
-  total_Q20_histo.Initialize(histogram_length);
-
-  MetricGeneratorSNR system_snr;
-  BaseQVHistogram qv_histogram;
-
   string flow_order;
   string key;
   for (SamReadGroupIterator rg = sam_header.ReadGroups.Begin(); rg != sam_header.ReadGroups.End(); ++rg) {
@@ -85,67 +72,18 @@ int IonstatsBasecaller(OptArgs &opts)
       key = rg->KeySequence;
   }
 
-  double qv_to_error_rate[256];
-  for (int qv = 0; qv < 256; qv++)
-    qv_to_error_rate[qv] =  pow(10.0,-0.1*(double)qv);
-
+  IonstatsBasecallerStats basecaller_stats;
+  basecaller_stats.Initialize(histogram_length, key, flow_order);
 
   BamAlignment alignment;
-  string read_group;
-  vector<uint16_t> flow_signal_fz(flow_order.length());
-  vector<int16_t> flow_signal_zm(flow_order.length());
-
-  while(input_bam.GetNextAlignment(alignment)) {
-
-    // Record read length
-    unsigned int full_length = alignment.Length;
-    total_full_histo.Add(full_length);
-
-    // Record insert length
-    int insert_length = 0;
-    if (alignment.GetTag("ZA",insert_length))
-      total_insert_histo.Add(insert_length);
-
-    // Compute and record Q17 and Q20
-    int Q17_length = 0;
-    int Q20_length = 0;
-    double num_accumulated_errors = 0.0;
-    for(int pos = 0; pos < alignment.Length; ++pos) {
-      num_accumulated_errors += qv_to_error_rate[(int)alignment.Qualities[pos] - 33];
-      if (num_accumulated_errors / (pos + 1) <= 0.02)
-        Q17_length = pos + 1;
-      if (num_accumulated_errors / (pos + 1) <= 0.01)
-        Q20_length = pos + 1;
-    }
-    total_Q17_histo.Add(Q17_length);
-    total_Q20_histo.Add(Q20_length);
-
-    // Record data for system snr
-    if(alignment.GetTag("ZM", flow_signal_zm))
-      system_snr.Add(flow_signal_zm, key.c_str(), flow_order);
-    else if(alignment.GetTag("FZ", flow_signal_fz))
-      system_snr.Add(flow_signal_fz, key.c_str(), flow_order);
-
-    // Record qv histogram
-    qv_histogram.Add(alignment.Qualities);
-  }
+  while(input_bam.GetNextAlignment(alignment))
+    basecaller_stats.AddRead(alignment);
 
   input_bam.Close();
 
 
-
   Json::Value output_json(Json::objectValue);
-  //output_json["meta"]["creation_date"] = get_time_iso_string(time(NULL));
-  output_json["meta"]["format_name"] = "ionstats_basecaller";
-  output_json["meta"]["format_version"] = "1.0";
-
-  system_snr.SaveToJson(output_json);
-  qv_histogram.SaveToJson(output_json);
-  total_full_histo.SaveToJson(output_json["full"]);
-  total_insert_histo.SaveToJson(output_json["insert"]);
-  total_Q17_histo.SaveToJson(output_json["Q17"]);
-  total_Q20_histo.SaveToJson(output_json["Q20"]);
-
+  basecaller_stats.SaveToJson(output_json);
 
   ofstream out(output_json_filename.c_str(), ios::out);
   if (out.good()) {
@@ -162,12 +100,7 @@ int IonstatsBasecaller(OptArgs &opts)
 
 int IonstatsBasecallerReduce(const string& output_json_filename, const vector<string>& input_jsons)
 {
-  BaseQVHistogram qv_histogram;
-  MetricGeneratorSNR system_snr;
-  ReadLengthHistogram total_full_histo;
-  ReadLengthHistogram total_insert_histo;
-  ReadLengthHistogram total_Q17_histo;
-  ReadLengthHistogram total_Q20_histo;
+  IonstatsBasecallerStats basecaller_stats;
 
   for (unsigned int input_idx = 0; input_idx < input_jsons.size(); ++input_idx) {
 
@@ -180,42 +113,13 @@ int IonstatsBasecallerReduce(const string& output_json_filename, const vector<st
     in >> current_input_json;
     in.close();
 
-    BaseQVHistogram current_qv_histogram;
-    current_qv_histogram.LoadFromJson(current_input_json);
-    qv_histogram.MergeFrom(current_qv_histogram);
-
-    MetricGeneratorSNR current_system_snr;
-    current_system_snr.LoadFromJson(current_input_json);
-    system_snr.MergeFrom(current_system_snr);
-
-    ReadLengthHistogram current_total_full_histo;
-    current_total_full_histo.LoadFromJson(current_input_json["full"]);
-    total_full_histo.MergeFrom(current_total_full_histo);
-
-    ReadLengthHistogram current_total_insert_histo;
-    current_total_insert_histo.LoadFromJson(current_input_json["insert"]);
-    total_insert_histo.MergeFrom(current_total_insert_histo);
-
-    ReadLengthHistogram current_total_Q17_histo;
-    current_total_Q17_histo.LoadFromJson(current_input_json["Q17"]);
-    total_Q17_histo.MergeFrom(current_total_Q17_histo);
-
-    ReadLengthHistogram current_total_Q20_histo;
-    current_total_Q20_histo.LoadFromJson(current_input_json["Q20"]);
-    total_Q20_histo.MergeFrom(current_total_Q20_histo);
+    IonstatsBasecallerStats current_basecaller_stats;
+    current_basecaller_stats.LoadFromJson(current_input_json);
+    basecaller_stats.MergeFrom(current_basecaller_stats);
   }
 
   Json::Value output_json(Json::objectValue);
-  //output_json["meta"]["creation_date"] = get_time_iso_string(time(NULL));
-  output_json["meta"]["format_name"] = "ionstats_basecaller";
-  output_json["meta"]["format_version"] = "1.0";
-
-  system_snr.SaveToJson(output_json);
-  qv_histogram.SaveToJson(output_json);
-  total_full_histo.SaveToJson(output_json["full"]);
-  total_insert_histo.SaveToJson(output_json["insert"]);
-  total_Q17_histo.SaveToJson(output_json["Q17"]);
-  total_Q20_histo.SaveToJson(output_json["Q20"]);
+  basecaller_stats.SaveToJson(output_json);
 
   ofstream out(output_json_filename.c_str(), ios::out);
   if (out.good()) {
@@ -0,0 +1,117 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "DiffEqModel.h"
+#include "DiffEqModelVec.h"
+
+using namespace std;
+
+/* Random hydrogen traces for a flow block with a per-flow tauB and etbR. Every vector
+   width this CPU can run has to agree with the scalar model, flow by flow, and be bit
+   identical to the 4-wide kernel, which keeps the operation order of the original SSE code.
+   Block sizes that are not a multiple of any width exercise the partially filled vectors. */
+class DiffEqModelVecTest : public ::testing::TestWithParam<int> {
+protected :
+
+  static const int kLen = 60;
+
+  virtual void SetUp() {
+    flow_block_size_ = GetParam();
+    srand(11);
+    delta_frame_.resize(kLen);
+    for (int i = 0; i < kLen; ++i)
+      delta_frame_[i] = i < 20 ? 1.0f : (i < 40 ? 2.0f : 4.0f);
+    tauB_.resize(flow_block_size_);
+    etbR_.resize(flow_block_size_);
+    red_.assign(flow_block_size_, vector<float>(kLen));
+    blue_.assign(flow_block_size_, vector<float>(kLen));
+    for (int fb = 0; fb < flow_block_size_; ++fb) {
+      tauB_[fb] = 2.0f + 10.0f * rand() / RAND_MAX;
+      etbR_[fb] = 0.5f + 0.5f * rand() / RAND_MAX;
+      for (int i = 0; i < kLen; ++i) {
+        red_[fb][i] = (i > 0 ? red_[fb][i-1] : 0.0f) + 2.0f * rand() / RAND_MAX;
+        blue_[fb][i] = 50.0f * sin(i * 0.1f + fb) + 5.0f * rand() / RAND_MAX;
+      }
+    }
+  }
+
+  void Rows(vector<vector<float> >& data, vector<float *>& rows) {
+    rows.resize(data.size());
+    for (size_t fb = 0; fb < data.size(); ++fb)
+      rows[fb] = &data[fb][0];
+  }
+
+  void ExpectClose(const vector<float>& reference, const float *vec, int fb, int width) {
+    for (int i = 0; i < kLen; ++i)
+      EXPECT_NEAR(reference[i], vec[i], 1e-4f * (1.0f + fabsf(reference[i])))
+          << "width " << width << " flow " << fb << " frame " << i;
+  }
+
+  // every width has to reproduce the 4-wide results exactly
+  void ExpectIdentical(vector<vector<float> >& baseline, const vector<float *>& out_rows, int width) {
+    if (width == 4) {
+      for (int fb = 0; fb < flow_block_size_; ++fb)
+        baseline[fb].assign(out_rows[fb], out_rows[fb] + kLen);
+      return;
+    }
+    for (int fb = 0; fb < flow_block_size_; ++fb)
+      for (int i = 0; i < kLen; ++i)
+        EXPECT_EQ(0, memcmp(&baseline[fb][i], &out_rows[fb][i], sizeof(float)))
+            << "width " << width << " flow " << fb << " frame " << i << ": "
+            << baseline[fb][i] << " != " << out_rows[fb][i];
+  }
+
+  int                     flow_block_size_;
+  vector<float>           delta_frame_;
+  vector<float>           tauB_;
+  vector<float>           etbR_;
+  vector<vector<float> >  red_;
+  vector<vector<float> >  blue_;
+};
+
+TEST_P(DiffEqModelVecTest, MatchesScalarModel) {
+  vector<float *> red_rows, blue_rows, out_rows;
+  Rows(red_, red_rows);
+  Rows(blue_, blue_rows);
+  vector<vector<float> > out(flow_block_size_, vector<float>(kLen));
+  Rows(out, out_rows);
+  vector<float> reference(kLen);
+  vector<vector<float> > total_4(flow_block_size_), blue_4(flow_block_size_), red_4(flow_block_size_);
+
+  static const int widths[3] = { 4, 8, 16 };
+  for (int w = 0; w < 3; ++w) {
+    if (not MathModel::SetDiffEqVecWidth(widths[w]))
+      continue;
+    ASSERT_EQ(widths[w], MathModel::DiffEqVecWidth());
+
+    MathModel::PurpleSolveTotalTrace_Vec(&out_rows[0], &blue_rows[0], &red_rows[0], kLen, &delta_frame_[0],
+        &tauB_[0], &etbR_[0], 1.0f, flow_block_size_);
+    for (int fb = 0; fb < flow_block_size_; ++fb) {
+      MathModel::PurpleSolveTotalTrace(&reference[0], &blue_[fb][0], &red_[fb][0], kLen, &delta_frame_[0], tauB_[fb], etbR_[fb]);
+      ExpectClose(reference, out_rows[fb], fb, widths[w]);
+    }
+    ExpectIdentical(total_4, out_rows, widths[w]);
+
+    MathModel::BlueSolveBackgroundTrace_Vec(&out_rows[0], &blue_rows[0], kLen, &delta_frame_[0],
+        &tauB_[0], &etbR_[0], flow_block_size_);
+    for (int fb = 0; fb < flow_block_size_; ++fb) {
+      MathModel::BlueSolveBackgroundTrace(&reference[0], &blue_[fb][0], kLen, &delta_frame_[0], tauB_[fb], etbR_[fb]);
+      ExpectClose(reference, out_rows[fb], fb, widths[w]);
+    }
+    ExpectIdentical(blue_4, out_rows, widths[w]);
+
+    MathModel::RedSolveHydrogenFlowInWell_Vec(&out_rows[0], &red_rows[0], kLen, &delta_frame_[0],
+        &tauB_[0], flow_block_size_);
+    for (int fb = 0; fb < flow_block_size_; ++fb) {
+      MathModel::RedSolveHydrogenFlowInWell(&reference[0], &red_[fb][0], kLen, 0, &delta_frame_[0], tauB_[fb]);
+      ExpectClose(reference, out_rows[fb], fb, widths[w]);
+    }
+    ExpectIdentical(red_4, out_rows, widths[w]);
+  }
+  MathModel::SetDiffEqVecWidth(0);
+}
+
+INSTANTIATE_TEST_CASE_P(FlowBlockSizes, DiffEqModelVecTest, ::testing::Values(1, 4, 7, 20, 32, 37));
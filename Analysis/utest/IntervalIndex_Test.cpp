@@ -0,0 +1,150 @@
+/* Copyright (C) 2016 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "IntervalIndex.h"
+
+using namespace std;
+
+/* Random intervals on a few contigs, some of them long enough to contain many others,
+   checked against a linear scan of the same intervals in (contig, begin, id) order. */
+class IntervalIndexTest : public ::testing::Test {
+protected :
+
+  static const int kContigs = 4;
+
+  virtual void SetUp() {
+    srand(7);
+    for (int id = 0; id < 3000; ++id) {
+      IntervalIndexNode node;
+      node.contig = rand() % kContigs;
+      node.begin = rand() % 100000;
+      node.end = node.begin + (id % 50 == 0 ? rand() % 20000 : rand() % 300);
+      node.id = id;
+      intervals_.push_back(node);
+      index_.Add(node.contig, node.begin, node.end, node.id);
+    }
+    index_.Build();
+    sorted_ = intervals_;
+    sort(sorted_.begin(), sorted_.end(), SortedOrder);
+  }
+
+  static bool SortedOrder(const IntervalIndexNode& a, const IntervalIndexNode& b) {
+    if (a.contig != b.contig)
+      return a.contig < b.contig;
+    if (a.begin != b.begin)
+      return a.begin < b.begin;
+    return a.id < b.id;
+  }
+
+  vector<int> Scan(int contig, int begin, int end) {
+    vector<int> ids;
+    for (size_t i = 0; i < sorted_.size(); ++i)
+      if (sorted_[i].contig == contig and sorted_[i].begin < end and begin < sorted_[i].end)
+        ids.push_back(sorted_[i].id);
+    return ids;
+  }
+
+  void ExpectSameAnswers(const IntervalIndex& index) {
+    srand(11);
+    for (int q = 0; q < 500; ++q) {
+      int contig = rand() % (kContigs + 1);
+      int begin = rand() % 110000;
+      int end = begin + rand() % (q % 10 == 0 ? 5000 : 200);
+      vector<int> expected = Scan(contig, begin, end);
+      vector<int> ids;
+      EXPECT_EQ((int)expected.size(), index.Overlaps(contig, begin, end, ids));
+      EXPECT_EQ(expected, ids) << contig << ":" << begin << "-" << end;
+      EXPECT_EQ(expected.empty() ? -1 : expected[0], index.FirstOverlap(contig, begin, end));
+    }
+  }
+
+  vector<IntervalIndexNode> intervals_;
+  vector<IntervalIndexNode> sorted_;
+  IntervalIndex             index_;
+};
+
+TEST_F(IntervalIndexTest, MatchesLinearScan) {
+  ExpectSameAnswers(index_);
+}
+
+TEST_F(IntervalIndexTest, ContigNodesAreSorted) {
+  size_t total = 0;
+  for (int contig = 0; contig < index_.num_contigs(); ++contig) {
+    size_t count = 0;
+    const IntervalIndexNode *node = index_.ContigNodes(contig, count);
+    for (size_t i = 0; i < count; ++i, ++total) {
+      EXPECT_EQ(sorted_[total].id, node[i].id);
+      EXPECT_EQ(contig, node[i].contig);
+    }
+  }
+  EXPECT_EQ(sorted_.size(), total);
+  size_t count = 1;
+  EXPECT_TRUE(index_.ContigNodes(kContigs, count) == NULL);
+  EXPECT_EQ(0u, count);
+}
+
+TEST_F(IntervalIndexTest, BatchedQueries) {
+  vector<IntervalIndexQuery> queries;
+  for (int q = 0; q < 100; ++q) {
+    IntervalIndexQuery query;
+    query.contig = q % kContigs;
+    query.begin = q * 1000;
+    query.end = q * 1000 + 250;
+    queries.push_back(query);
+  }
+  vector<int> ids;
+  vector<size_t> offsets;
+  index_.Overlaps(queries, ids, offsets);
+  ASSERT_EQ(queries.size() + 1, offsets.size());
+  for (size_t q = 0; q < queries.size(); ++q) {
+    vector<int> expected = Scan(queries[q].contig, queries[q].begin, queries[q].end);
+    vector<int> got(ids.begin() + offsets[q], ids.begin() + offsets[q+1]);
+    EXPECT_EQ(expected, got);
+  }
+}
+
+TEST_F(IntervalIndexTest, SaveLoadAndAttach) {
+  char path[] = "/tmp/IntervalIndex_TestXXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  ASSERT_TRUE(index_.Save(path));
+
+  IntervalIndex loaded;
+  ASSERT_TRUE(loaded.Load(path));
+  unlink(path);
+  ASSERT_EQ(index_.num_nodes(), loaded.num_nodes());
+  ExpectSameAnswers(loaded);
+
+  vector<IntervalIndexNode> copy(index_.nodes(), index_.nodes() + index_.num_nodes());
+  IntervalIndex attached;
+  attached.Attach(&copy[0], copy.size());
+  ExpectSameAnswers(attached);
+
+  EXPECT_FALSE(loaded.Load("/dev/null"));
+  EXPECT_EQ(0u, loaded.num_nodes());
+}
+
+TEST(IntervalIndex_Test, SmallAndEmpty) {
+  IntervalIndex index;
+  index.Build();
+  vector<int> ids;
+  EXPECT_EQ(-1, index.FirstOverlap(0, 0, 100));
+  EXPECT_EQ(0, index.Overlaps(0, 0, 100, ids));
+
+  // touching intervals do not overlap a half open query
+  index.Add(1, 10, 20, 0);
+  index.Add(1, 20, 30, 1);
+  index.Build();
+  EXPECT_EQ(-1, index.FirstOverlap(0, 0, 100));
+  EXPECT_EQ(0, index.FirstOverlap(1, 19, 20));
+  EXPECT_EQ(1, index.FirstOverlap(1, 20, 21));
+  EXPECT_EQ(-1, index.FirstOverlap(1, 30, 40));
+  EXPECT_EQ(2, index.Overlaps(1, 0, 100, ids));
+  EXPECT_EQ(0, ids[0]);
+  EXPECT_EQ(1, ids[1]);
+}
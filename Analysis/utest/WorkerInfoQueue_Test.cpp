@@ -0,0 +1,112 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+#include "WorkerInfoQueue.h"
+
+static const int kItemsPerProducer = 20000;
+
+struct QueueTestArgs {
+  WorkerInfoQueue *q;
+  int id;
+  long sum;
+  long count;
+};
+
+static void *Producer(void *arg)
+{
+  QueueTestArgs *args = (QueueTestArgs *)arg;
+  for (int i = 1; i <= kItemsPerProducer; i++) {
+    WorkerInfoQueueItem item;
+    item.private_data = (void *)(intptr_t)(args->id * kItemsPerProducer + i);
+    args->q->PutItem(item);
+  }
+  return NULL;
+}
+
+static void *Consumer(void *arg)
+{
+  QueueTestArgs *args = (QueueTestArgs *)arg;
+  while (true) {
+    WorkerInfoQueueItem item = args->q->GetItem();
+    if (item.finished) {
+      args->q->DecrementDone();
+      break;
+    }
+    args->sum += (intptr_t)item.private_data;
+    args->count++;
+    args->q->DecrementDone();
+  }
+  return NULL;
+}
+
+TEST(WorkerInfoQueue_Test, SingleThreadFifo) {
+  WorkerInfoQueue q(4, "SingleThreadFifo");
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 4; i++) {
+      WorkerInfoQueueItem item;
+      item.private_data = (void *)(intptr_t)(i + 1);
+      q.PutItem(item);
+    }
+    for (int i = 0; i < 4; i++) {
+      WorkerInfoQueueItem item = q.GetItem();
+      ASSERT_EQ(i + 1, (intptr_t)item.private_data);
+      q.DecrementDone();
+    }
+    ASSERT_TRUE(q.TryGetItem().private_data == NULL);
+    ASSERT_TRUE(q.empty());
+  }
+  WorkerInfoQueueMetrics metrics = q.GetMetrics();
+  EXPECT_EQ(12, metrics.items);
+  EXPECT_EQ(4, metrics.max_in_flight);
+  EXPECT_EQ(0, metrics.in_flight);
+}
+
+/* Several producers and consumers on a small queue, so that both sides have to wait.
+   Every item has to arrive exactly once. */
+TEST(WorkerInfoQueue_Test, MultiProducerMultiConsumer) {
+  const int num_producers = 4;
+  const int num_consumers = 6;
+  WorkerInfoQueue q(8, "MultiProducerMultiConsumer");
+
+  std::vector<QueueTestArgs> producers(num_producers), consumers(num_consumers);
+  std::vector<pthread_t> threads;
+  for (int c = 0; c < num_consumers; c++) {
+    consumers[c].q = &q;
+    consumers[c].sum = consumers[c].count = 0;
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, NULL, Consumer, &consumers[c]));
+    threads.push_back(t);
+  }
+  for (int p = 0; p < num_producers; p++) {
+    producers[p].q = &q;
+    producers[p].id = p;
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, NULL, Producer, &producers[p]));
+    threads.push_back(t);
+  }
+  for (int p = 0; p < num_producers; p++)
+    pthread_join(threads[num_consumers + p], NULL);
+
+  q.WaitTillDone();
+  for (int c = 0; c < num_consumers; c++) {
+    WorkerInfoQueueItem item;
+    item.finished = true;
+    q.PutItem(item);
+  }
+  q.WaitTillDone();
+  for (int c = 0; c < num_consumers; c++)
+    pthread_join(threads[c], NULL);
+
+  long total = (long)num_producers * kItemsPerProducer;
+  long sum = 0, count = 0;
+  for (int c = 0; c < num_consumers; c++) {
+    sum += consumers[c].sum;
+    count += consumers[c].count;
+  }
+  EXPECT_EQ(total, count);
+  EXPECT_EQ(total * (total + 1) / 2, sum);
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(total + num_consumers, q.GetMetrics().items);
+}